@@ -0,0 +1,214 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Bench.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace Snippet
+{
+namespace Bench
+{
+
+static void WriteJsonString(std::FILE* File, const std::string& Value)
+{
+    std::fputc('"', File);
+
+    for (const char Char : Value)
+    {
+        if (Char == '"' || Char == '\\')
+        {
+            std::fprintf(File, "\\%c", Char);
+        }
+        else if (static_cast<unsigned char>(Char) < 0x20)
+        {
+            std::fprintf(File, "\\u%04x", static_cast<unsigned int>(Char));
+        }
+        else
+        {
+            std::fputc(Char, File);
+        }
+    }
+
+    std::fputc('"', File);
+}
+
+//
+// Reporter
+//
+
+Reporter& Reporter::SetFormat(Format Format_)
+{
+    m_Format = Format_;
+    return *this;
+}
+
+Reporter& Reporter::SetLabel(const std::string& Label)
+{
+    m_Label = Label;
+    return *this;
+}
+
+Reporter& Reporter::Add(const std::string& Suite, const std::string& Name, double Value, const char* Unit)
+{
+    m_Results.push_back({ Suite, Name, Value, Unit });
+
+    std::FILE* Progress { m_Format == Format::Text ? stdout : stderr };
+    fprintf(Progress, "%-12s %-40s %16.3f %s\n", Suite.c_str(), Name.c_str(), Value, Unit);
+    fflush(Progress);
+    return *this;
+}
+
+void Reporter::Print() const
+{
+    fprintf(m_Format == Format::Text ? stdout : stderr, "%zu result(s).\n", m_Results.size());
+}
+
+bool Reporter::Write(const std::string& Path, std::string* Error) const
+{
+    std::FILE* File { Path.empty() ? stdout : std::fopen(Path.c_str(), "wb") };
+
+    if (File == nullptr)
+    {
+        if (Error != nullptr)
+        {
+            *Error = "failed to create '" + Path + "'";
+        }
+
+        return false;
+    }
+
+    switch (m_Format)
+    {
+    case Format::Json: WriteJson(File); break;
+    case Format::Csv: WriteCsv(File); break;
+    case Format::Text:
+    default:
+        for (const Result& Item : m_Results)
+        {
+            fprintf(File, "%-12s %-40s %16.3f %s\n", Item.Suite.c_str(), Item.Name.c_str(), Item.Value, Item.Unit.c_str());
+        }
+        break;
+    }
+
+    bool Success { std::ferror(File) == 0 };
+
+    if (File == stdout)
+    {
+        fflush(File);
+    }
+    else
+    {
+        Success = std::fclose(File) == 0 && Success;
+    }
+
+    if (!Success && Error != nullptr)
+    {
+        *Error = "failed to write results";
+    }
+
+    return Success;
+}
+
+void Reporter::WriteJson(std::FILE* File) const
+{
+    std::fputs("{\n  \"label\": ", File);
+    WriteJsonString(File, m_Label);
+    std::fprintf(File, ",\n  \"threads\": %u,\n  \"results\": [", std::thread::hardware_concurrency());
+
+    for (size_t I = 0; I < m_Results.size(); I++)
+    {
+        const Result& Item { m_Results[I] };
+        std::fputs(I == 0 ? "\n    {\"suite\": " : ",\n    {\"suite\": ", File);
+        WriteJsonString(File, Item.Suite);
+        std::fputs(", \"name\": ", File);
+        WriteJsonString(File, Item.Name);
+        std::fprintf(File, ", \"value\": %.9g, \"unit\": ", Item.Value);
+        WriteJsonString(File, Item.Unit);
+        std::fputc('}', File);
+    }
+
+    std::fputs("\n  ]\n}\n", File);
+}
+
+void Reporter::WriteCsv(std::FILE* File) const
+{
+    // Names and units never contain commas or quotes. The label is quoted in case it does.
+    std::string Label { "\"" };
+    for (const char Char : m_Label)
+    {
+        Label += Char == '"' ? std::string { "\"\"" } : std::string { Char };
+    }
+    Label += "\"";
+
+    std::fputs("label,suite,name,value,unit\n", File);
+
+    for (const Result& Item : m_Results)
+    {
+        std::fprintf(File, "%s,%s,%s,%.9g,%s\n", Label.c_str(), Item.Suite.c_str(), Item.Name.c_str(), Item.Value, Item.Unit.c_str());
+    }
+}
+
+//
+// Stopwatch
+//
+
+Stopwatch::Stopwatch()
+    : m_Start(std::chrono::steady_clock::now())
+{
+}
+
+Stopwatch& Stopwatch::Reset()
+{
+    m_Start = std::chrono::steady_clock::now();
+    return *this;
+}
+
+double Stopwatch::Seconds() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count();
+}
+
+double Stopwatch::Microseconds() const
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_Start).count();
+}
+
+double Percentile(std::vector<double>& Samples, double Fraction)
+{
+    if (Samples.empty())
+    {
+        return 0.0;
+    }
+
+    const size_t Index { std::min(Samples.size() - 1, static_cast<size_t>(Fraction * static_cast<double>(Samples.size()))) };
+    std::nth_element(Samples.begin(), Samples.begin() + Index, Samples.end());
+    return Samples[Index];
+}
+
+}
+}
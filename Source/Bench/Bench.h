@@ -0,0 +1,114 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace Snippet
+{
+namespace Bench
+{
+
+enum class Format
+{
+    Text,
+    Json,
+    Csv,
+};
+
+//
+// Collects results as suites report them. Progress is printed as each result comes in,
+// to stderr when the results are written in a machine-readable format so that stdout only
+// carries the results themselves.
+//
+
+class Reporter
+{
+public:
+    Reporter& SetFormat(Format Format_);
+    // Tags the results, e.g. with the commit they were measured at.
+    Reporter& SetLabel(const std::string& Label);
+
+    Reporter& Add(const std::string& Suite, const std::string& Name, double Value, const char* Unit);
+    void Print() const;
+
+    // Writes every result in the chosen format to Path, or to stdout if Path is empty.
+    bool Write(const std::string& Path, std::string* Error = nullptr) const;
+
+private:
+    struct Result
+    {
+        std::string Suite {};
+        std::string Name {};
+        double Value { 0.0 };
+        std::string Unit {};
+    };
+
+    void WriteJson(std::FILE* File) const;
+    void WriteCsv(std::FILE* File) const;
+
+    Format m_Format { Format::Text };
+    std::string m_Label {};
+    std::vector<Result> m_Results {};
+};
+
+class Stopwatch
+{
+public:
+    Stopwatch();
+
+    Stopwatch& Reset();
+    double Seconds() const;
+    double Microseconds() const;
+
+private:
+    std::chrono::steady_clock::time_point m_Start {};
+};
+
+double Percentile(std::vector<double>& Samples, double Fraction);
+
+// Graph sizes above Nodes are skipped by the graph suite.
+void SetGraphMaxNodes(uint32_t Nodes);
+
+void RunEdges(Reporter& Results);
+void RunGraph(Reporter& Results);
+void RunHighlight(Reporter& Results);
+void RunJournal(Reporter& Results);
+void RunProject(Reporter& Results);
+void RunProtocol(Reporter& Results);
+void RunRoom(Reporter& Results);
+void RunServer(Reporter& Results);
+void RunText(Reporter& Results);
+void RunTrace(Reporter& Results);
+void RunTransport(Reporter& Results);
+
+}
+}
@@ -0,0 +1,170 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Bench.h"
+#include "../Common/Graph/EdgeCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+namespace Snippet
+{
+namespace Bench
+{
+
+static constexpr uint32_t EdgeColumns { 250 };
+static constexpr uint32_t EdgeRows { 100 };
+static constexpr uint32_t EdgesPerNode { 2 };
+static constexpr uint32_t EdgeDragNodes { 5000 };
+static constexpr uint32_t EdgeDragFrames { 60 };
+static constexpr uint32_t EdgeHitTests { 200000 };
+
+void RunEdges(Reporter& Results)
+{
+    // A grid of nodes, each feeding a couple of nodes in the next few columns, which is
+    // roughly how a large data flow graph is laid out.
+    Common::Graph Model;
+    std::vector<Common::NodeHandle> Nodes {};
+    Model.Reserve(EdgeColumns * EdgeRows);
+
+    for (uint32_t Y = 0; Y < EdgeRows; Y++)
+    {
+        for (uint32_t X = 0; X < EdgeColumns; X++)
+        {
+            const Common::NodeHandle ID { Model.AddSnippet() };
+            Model
+                .SetPosition(ID, { static_cast<float>(X * 300), static_cast<float>(Y * 150) })
+                .SetSize(ID, { 200.0f, 80.0f });
+            Nodes.push_back(ID);
+        }
+    }
+
+    std::mt19937 Random { 1357 };
+    for (uint32_t Y = 0; Y < EdgeRows; Y++)
+    {
+        for (uint32_t X = 0; X + 4 < EdgeColumns; X++)
+        {
+            for (uint32_t I = 0; I < EdgesPerNode; I++)
+            {
+                const uint32_t ToX { X + 1 + static_cast<uint32_t>(Random() % 3) };
+                const uint32_t ToY { std::min(EdgeRows - 1, Y + static_cast<uint32_t>(Random() % 3)) };
+                const Common::NodeHandle From { Nodes[Y * EdgeColumns + X] };
+                const Common::NodeHandle To { Nodes[ToY * EdgeColumns + ToX] };
+                Model.Connect(Model.GetPorts(From)[1], Model.GetPorts(To)[0]);
+            }
+        }
+    }
+
+    Common::EdgeCache Edges;
+    Stopwatch Timer;
+    Edges.Rebuild(Model);
+    const double Build { Timer.Seconds() };
+
+    // Dragging a selection: every frame moves the same nodes and updates only the edges
+    // attached to them.
+    size_t Tessellated { 0 };
+    Timer.Reset();
+    for (uint32_t Frame = 0; Frame < EdgeDragFrames; Frame++)
+    {
+        for (uint32_t I = 0; I < EdgeDragNodes; I++)
+        {
+            const Common::NodeHandle ID { Nodes[I] };
+            const Common::Point Position { Model.GetPosition(ID) };
+            Model.SetPosition(ID, { Position.X + 1.0f, Position.Y + 1.0f });
+            Edges.Invalidate(Model, ID);
+        }
+
+        Tessellated += Edges.Update(Model);
+    }
+
+    const double Drag { Timer.Seconds() / EdgeDragFrames };
+
+    // One frame's worth of drawing for a 1080p view in the middle of the graph.
+    const Common::Bounds View { 30000.0f, 5000.0f, 31920.0f, 6080.0f };
+    size_t Segments { 0 };
+    Timer.Reset();
+    for (uint32_t Frame = 0; Frame < EdgeDragFrames; Frame++)
+    {
+        Edges.Query(View, [&Segments](Common::ConnectionHandle, const Common::Point*, uint32_t Count) -> void
+            {
+                Segments += Count - 1;
+            });
+    }
+
+    const double Paint { Timer.Microseconds() / EdgeDragFrames };
+    Segments /= EdgeDragFrames;
+
+    // Half of the hit tests land on a point of an edge and must find one.
+    std::vector<Common::ConnectionHandle> Connections {};
+    Model.ForEachConnection([&Connections](Common::ConnectionHandle ID, const Common::Graph::Connection&) -> void
+        {
+            Connections.push_back(ID);
+        });
+
+    uint32_t Hits { 0 };
+    uint32_t Missed { 0 };
+    Timer.Reset();
+    for (uint32_t I = 0; I < EdgeHitTests; I++)
+    {
+        if (I % 2 == 0)
+        {
+            const Common::Point* Points { Edges.GetPoints(Connections[Random() % Connections.size()]) };
+            const Common::Point& Target { Points[Random() % Common::EdgeCache::PointsPerEdge] };
+            if (Edges.HitTest(Target.X, Target.Y, 6.0f).IsValid())
+            {
+                Hits++;
+            }
+            else
+            {
+                Missed++;
+            }
+        }
+        else if (Edges.HitTest(static_cast<float>(Random() % 75000), static_cast<float>(Random() % 15000), 6.0f).IsValid())
+        {
+            Hits++;
+        }
+    }
+
+    const double HitTest { Timer.Seconds() };
+
+    if (Missed > 0 || Edges.Size() != Model.ConnectionCount() || Tessellated == 0)
+    {
+        printf("Edge cache mismatch.\n");
+    }
+
+    Results
+        .Add("edges", "edges", static_cast<double>(Edges.Size()), "")
+        .Add("edges", "build", Build * 1000.0, "ms")
+        .Add("edges", "drag_frame", Drag * 1000.0, "ms")
+        .Add("edges", "drag_edges", static_cast<double>(Tessellated) / EdgeDragFrames, "edge/frame")
+        .Add("edges", "paint_query", Paint, "us")
+        .Add("edges", "paint_segments", static_cast<double>(Segments), "")
+        .Add("edges", "hit_test", static_cast<double>(EdgeHitTests) / HitTest, "query/s");
+}
+
+}
+}
@@ -0,0 +1,129 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Generators.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace Snippet
+{
+namespace Bench
+{
+
+static constexpr uint32_t GeneratorColumns { 400 };
+static constexpr float GeneratorSpacingX { 220.0f };
+static constexpr float GeneratorSpacingY { 90.0f };
+static constexpr float GeneratorWidth { 200.0f };
+static constexpr float GeneratorHeight { 60.0f };
+static constexpr uint32_t RandomWindow { 256 };
+static constexpr uint32_t RandomMaxInputs { 3 };
+
+// Counts its inputs, so a run's outputs depend on the shape of the graph.
+static const char* GeneratorSource { "return select('#', ...)" };
+
+const char* GetName(GraphShape Shape)
+{
+    switch (Shape)
+    {
+    case GraphShape::Linear: return "linear";
+    case GraphShape::Fanout: return "fanout";
+    case GraphShape::Random: return "random";
+    default: break;
+    }
+
+    return "unknown";
+}
+
+void Generate(Common::Graph& Model, GraphShape Shape, uint32_t Nodes, uint32_t Seed)
+{
+    std::mt19937 Random { Seed };
+    std::vector<Common::PortHandle> Outputs {};
+    Outputs.reserve(Nodes);
+    Model.Reserve(Model.NodeCount() + Nodes);
+
+    for (uint32_t I = 0; I < Nodes; I++)
+    {
+        const Common::NodeHandle ID { Model.AddSnippet() };
+        Model
+            .SetPosition(ID, { static_cast<float>(I % GeneratorColumns) * GeneratorSpacingX, static_cast<float>(I / GeneratorColumns) * GeneratorSpacingY })
+            .SetSize(ID, { GeneratorWidth, GeneratorHeight })
+            .SetName(ID, U"Node")
+            .SetSource(ID, GeneratorSource);
+
+        const std::vector<Common::PortHandle>& Ports { Model.GetPorts(ID) };
+        const Common::PortHandle Input { Ports[0] };
+        Outputs.push_back(Ports[1]);
+
+        if (I == 0)
+        {
+            continue;
+        }
+
+        switch (Shape)
+        {
+        case GraphShape::Linear: Model.Connect(Outputs[I - 1], Input); break;
+        case GraphShape::Fanout: Model.Connect(Outputs[(I - 1) / FanoutWidth], Input); break;
+        case GraphShape::Random:
+        {
+            const uint32_t Window { std::min(I, RandomWindow) };
+            const uint32_t Count { std::min(Window, 1 + static_cast<uint32_t>(Random() % RandomMaxInputs)) };
+            uint32_t Picked[RandomMaxInputs] {};
+
+            for (uint32_t J = 0; J < Count; J++)
+            {
+                // Window is at least Count, so this always finds an unused node.
+                uint32_t From { I - 1 - static_cast<uint32_t>(Random() % Window) };
+                while (std::find(Picked, Picked + J, From) != Picked + J)
+                {
+                    From = I - 1 - static_cast<uint32_t>(Random() % Window);
+                }
+
+                Picked[J] = From;
+                Model.Connect(Outputs[From], Input);
+            }
+        }
+        break;
+        default: break;
+        }
+    }
+}
+
+Common::Bounds GetExtent(uint32_t Nodes)
+{
+    const uint32_t Columns { std::min(Nodes, GeneratorColumns) };
+    const uint32_t Rows { (Nodes + GeneratorColumns - 1) / GeneratorColumns };
+    return {
+        0.0f,
+        0.0f,
+        static_cast<float>(Columns) * GeneratorSpacingX,
+        static_cast<float>(Rows) * GeneratorSpacingY
+    };
+}
+
+}
+}
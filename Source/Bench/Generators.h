@@ -0,0 +1,63 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "../Common/Geometry.h"
+#include "../Common/Graph/Graph.h"
+
+#include <cstdint>
+
+namespace Snippet
+{
+namespace Bench
+{
+
+enum class GraphShape
+{
+    // Every node feeds the next one.
+    Linear,
+    // A tree where every node feeds FanoutWidth others.
+    Fanout,
+    // Every node takes one to three inputs from nodes shortly before it.
+    Random,
+};
+
+static constexpr uint32_t FanoutWidth { 1024 };
+
+const char* GetName(GraphShape Shape);
+
+// Adds Nodes snippets to Model, laid out row by row on a grid, and connects them into an
+// acyclic graph of the given shape. Every node has one input and one output port and a
+// source that runs without error on any number of inputs. The same Seed always produces
+// the same graph.
+void Generate(Common::Graph& Model, GraphShape Shape, uint32_t Nodes, uint32_t Seed = 1234);
+
+// The area covered by the first Nodes nodes of a generated graph.
+Common::Bounds GetExtent(uint32_t Nodes);
+
+}
+}
@@ -0,0 +1,243 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Bench.h"
+#include "../Common/Execution/Engine.h"
+#include "../Common/Execution/Executor.h"
+#include "../Common/Execution/Memo.h"
+#include "../Common/Execution/ThreadPool.h"
+#include "../Common/Graph/HandleSet.h"
+#include "../Common/SpatialGrid.h"
+#include "../Common/Storage/ProjectFile.h"
+#include "Generators.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Snippet
+{
+namespace Bench
+{
+
+static constexpr uint32_t GraphSizes[] { 1000, 10000, 100000, 1000000 };
+static constexpr GraphShape GraphShapes[] { GraphShape::Linear, GraphShape::Fanout, GraphShape::Random };
+static constexpr uint32_t GraphHitTests { 200000 };
+static constexpr uint32_t GraphMoveFrames { 10 };
+
+static uint32_t GraphMaxNodes { 1000000 };
+
+using GraphIndex = Common::SpatialGrid<Common::NodeHandle>;
+
+static std::string GetSizeName(uint32_t Nodes)
+{
+    if (Nodes >= 1000000 && Nodes % 1000000 == 0)
+    {
+        return std::to_string(Nodes / 1000000) + "m";
+    }
+
+    if (Nodes >= 1000 && Nodes % 1000 == 0)
+    {
+        return std::to_string(Nodes / 1000) + "k";
+    }
+
+    return std::to_string(Nodes);
+}
+
+static Common::Bounds GetBounds(const Common::Graph& Model, Common::NodeHandle Handle)
+{
+    const Common::Point Position { Model.GetPosition(Handle) };
+    const Common::Point Size { Model.GetSize(Handle) };
+    return { Position.X, Position.Y, Position.X + Size.X, Position.Y + Size.Y };
+}
+
+static bool Succeeded(const Common::ExecutionReport& Report, size_t Nodes)
+{
+    if (!Report.Valid || Report.Nodes.size() != Nodes)
+    {
+        return false;
+    }
+
+    for (const Common::NodeReport& Node : Report.Nodes)
+    {
+        if (Node.Status != Common::NodeStatus::Succeeded)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void RunShape(Reporter& Results, Common::ThreadPool& Pool, GraphShape Shape, uint32_t Nodes)
+{
+    const std::string Name { std::string { GetName(Shape) } + "." + GetSizeName(Nodes) };
+    const std::string Prefix { Name + "." };
+    const Common::Bounds Extent { GetExtent(Nodes) };
+    std::mt19937 Random { Nodes };
+    bool Valid { true };
+
+    Common::Graph Model;
+    Stopwatch Timer;
+    Generate(Model, Shape, Nodes);
+    const double Generation { Timer.Seconds() };
+
+    // The same index the canvas keeps, including its map from node to index entry.
+    GraphIndex Index;
+    std::unordered_map<uint64_t, GraphIndex::Handle> IndexHandles;
+    IndexHandles.reserve(Nodes);
+    Timer.Reset();
+    Model.ForEachNode([&](Common::NodeHandle Handle, const Common::Graph::Node&) -> void
+        {
+            IndexHandles.emplace(Handle.Key(), Index.Insert(Handle, GetBounds(Model, Handle)));
+        });
+    const double Indexing { Timer.Seconds() };
+
+    size_t Hits { 0 };
+    Timer.Reset();
+    for (uint32_t I = 0; I < GraphHitTests; I++)
+    {
+        const float X { static_cast<float>(Random() % static_cast<uint32_t>(Extent.MaxX)) };
+        const float Y { static_cast<float>(Random() % static_cast<uint32_t>(Extent.MaxY)) };
+        Hits += Index.Query(X, Y) != GraphIndex::InvalidHandle ? 1 : 0;
+    }
+    const double HitTest { Timer.Seconds() };
+    Valid = Valid && Hits > 0;
+
+    // A box over the top left quarter of the graph, which grows with it.
+    const Common::Bounds Box { 0.0f, 0.0f, Extent.MaxX * 0.5f, Extent.MaxY * 0.5f };
+    Common::HandleSet<Common::NodeTag> Selected;
+    Timer.Reset();
+    Index.Query(Box, [&Selected](GraphIndex::Handle, Common::NodeHandle Handle) -> void
+        {
+            Selected.Insert(Handle);
+        });
+    const double SelectBox { Timer.Seconds() };
+    const size_t BoxSize { Selected.Size() };
+
+    Common::HandleSet<Common::NodeTag> All;
+    Timer.Reset();
+    Model.ForEachNode([&All](Common::NodeHandle Handle, const Common::Graph::Node&) -> void
+        {
+            All.Insert(Handle);
+        });
+    const double SelectAll { Timer.Seconds() };
+    Valid = Valid && All.Size() == Nodes;
+
+    // Dragging the boxed selection, moving each node in the model and the index per frame.
+    Timer.Reset();
+    for (uint32_t Frame = 0; Frame < GraphMoveFrames; Frame++)
+    {
+        Selected.ForEach([&](Common::NodeHandle Handle) -> void
+            {
+                const Common::Point Position { Model.GetPosition(Handle) };
+                Model.SetPosition(Handle, { Position.X + 5.0f, Position.Y + 3.0f });
+                Index.Update(IndexHandles[Handle.Key()], GetBounds(Model, Handle));
+            });
+    }
+    const double Move { Timer.Seconds() / GraphMoveFrames };
+
+    const std::string Path { (std::filesystem::temp_directory_path() / "SnippetBench.graph").string() };
+    std::string Error;
+    Timer.Reset();
+    Valid = Valid && Common::ProjectFile::Save(Model, Path.c_str(), nullptr, &Error);
+    const double Save { Timer.Seconds() };
+    const double FileSize { Valid ? static_cast<double>(std::filesystem::file_size(Path)) : 0.0 };
+
+    Common::Graph Loaded;
+    Common::ProjectFile File;
+    Timer.Reset();
+    Valid = Valid && File.Open(Path.c_str(), &Error) && File.Load(Loaded);
+    const double Load { Timer.Seconds() };
+    Valid = Valid && Loaded.NodeCount() == Model.NodeCount() && Loaded.ConnectionCount() == Model.ConnectionCount();
+    File.Close();
+    std::filesystem::remove(Path);
+
+    // A fresh engine per graph, so the first run compiles every node. The second run
+    // reuses every result and is left with planning and scheduling.
+    Common::Engine Engine_;
+    Common::Executor Executor_ { Engine_, Pool };
+    Timer.Reset();
+    const Common::ExecutionReport Cold { Executor_.Run(Model) };
+    const double Execute { Timer.Seconds() };
+    Valid = Valid && Succeeded(Cold, Nodes);
+
+    Common::Memo Previous;
+    Previous.Update(Cold);
+    Timer.Reset();
+    const Common::ExecutionReport Warm { Executor_.Run(Model, &Previous) };
+    const double Scheduling { Timer.Seconds() };
+    Valid = Valid && Succeeded(Warm, Nodes) && Warm.Reused == Nodes;
+
+    if (!Valid)
+    {
+        printf("Graph %s mismatch. %s\n", Name.c_str(), Error.c_str());
+    }
+
+    Results
+        .Add("graph", Prefix + "connections", static_cast<double>(Model.ConnectionCount()), "")
+        .Add("graph", Prefix + "generate", Generation * 1000.0, "ms")
+        .Add("graph", Prefix + "index", Indexing * 1000.0, "ms")
+        .Add("graph", Prefix + "hit_test", static_cast<double>(GraphHitTests) / HitTest, "query/s")
+        .Add("graph", Prefix + "select_box", SelectBox * 1000.0, "ms")
+        .Add("graph", Prefix + "select_box.nodes", static_cast<double>(BoxSize), "")
+        .Add("graph", Prefix + "select_all", SelectAll * 1000.0, "ms")
+        .Add("graph", Prefix + "move_frame", Move * 1000.0, "ms")
+        .Add("graph", Prefix + "save", Save * 1000.0, "ms")
+        .Add("graph", Prefix + "file_size", FileSize / (1024.0 * 1024.0), "MB")
+        .Add("graph", Prefix + "load", Load * 1000.0, "ms")
+        .Add("graph", Prefix + "execute", Execute * 1000.0, "ms")
+        .Add("graph", Prefix + "execute.memoized", Scheduling * 1000.0, "ms");
+}
+
+void SetGraphMaxNodes(uint32_t Nodes)
+{
+    GraphMaxNodes = Nodes;
+}
+
+void RunGraph(Reporter& Results)
+{
+    Common::ThreadPool Pool;
+
+    for (uint32_t Nodes : GraphSizes)
+    {
+        if (Nodes > GraphMaxNodes)
+        {
+            continue;
+        }
+
+        for (GraphShape Shape : GraphShapes)
+        {
+            RunShape(Results, Pool, Shape, Nodes);
+        }
+    }
+}
+
+}
+}
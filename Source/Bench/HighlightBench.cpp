@@ -0,0 +1,122 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Bench.h"
+#include "../Common/Execution/Engine.h"
+#include "../Common/Text/Highlighter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace Snippet
+{
+namespace Bench
+{
+
+static constexpr uint32_t HighlightLines { 100000 };
+static constexpr uint32_t HighlightKeystrokes { 2000 };
+
+void RunHighlight(Reporter& Results)
+{
+    std::string Source {};
+    for (uint32_t I = 0; I < HighlightLines; I++)
+    {
+        switch (I % 4)
+        {
+        case 0: Source += "local Value" + std::to_string(I) + " = " + std::to_string(I) + " * 2 -- double it\n"; break;
+        case 1: Source += "if Value" + std::to_string(I - 1) + " > 10 then print(\"large\") end\n"; break;
+        case 2: Source += "--[[ block comment " + std::to_string(I) + " ]]\n"; break;
+        default: Source += "Table[" + std::to_string(I) + "] = 'row'\n"; break;
+        }
+    }
+
+    Common::TextBuffer Buffer { Source };
+    Common::Highlighter Highlighter;
+    Highlighter.SetCheck([](std::string_view Text, std::string& Error) -> bool
+        {
+            return Common::Engine::Check("bench", Text, &Error);
+        });
+
+    Stopwatch Timer;
+    Highlighter.Reset(Buffer).Wait();
+    const double Full { Timer.Seconds() };
+    const size_t Spans { Highlighter.Latest()->Spans.size() };
+
+    // What Document does on every keystroke. This is all the editor waits for.
+    std::mt19937 Random { 1357 };
+    std::vector<double> Keystrokes {};
+    Keystrokes.reserve(HighlightKeystrokes);
+    size_t Cursor { Buffer.LineStart(HighlightLines / 2) };
+
+    Timer.Reset();
+    for (uint32_t I = 0; I < HighlightKeystrokes; I++)
+    {
+        if (I % 200 == 0)
+        {
+            Cursor = Buffer.LineStart(Random() % HighlightLines);
+        }
+
+        Stopwatch Keystroke;
+        const Common::TextBuffer::Splice Edit { Cursor++, 0, I % 50 == 49 ? "\n" : "x" };
+        const Common::Highlighter::LineEdit Lines { Common::Highlighter::Measure(Buffer, Edit) };
+        Buffer.Apply(Edit);
+        Highlighter.Submit(Buffer, Lines);
+        Keystrokes.push_back(Keystroke.Microseconds());
+    }
+
+    Highlighter.Wait();
+    const double Typing { Timer.Seconds() };
+
+    // Opening a long comment that nothing closes changes the state of every line after it.
+    Timer.Reset();
+    const Common::TextBuffer::Splice Open { 0, 0, "--[==[\n" };
+    const Common::Highlighter::LineEdit Lines { Common::Highlighter::Measure(Buffer, Open) };
+    Buffer.Apply(Open);
+    Highlighter.Submit(Buffer, Lines).Wait();
+    const double Cascade { Timer.Seconds() };
+    const size_t Relexed { Highlighter.Latest()->Relexed };
+
+    if (Highlighter.Latest()->Lines != Buffer.LineCount())
+    {
+        printf("Highlighter line count mismatch.\n");
+    }
+
+    Results
+        .Add("highlight", "lines", static_cast<double>(HighlightLines), "")
+        .Add("highlight", "spans", static_cast<double>(Spans), "")
+        .Add("highlight", "full", Full * 1000.0, "ms")
+        .Add("highlight", "keystroke.p50", Percentile(Keystrokes, 0.5), "us")
+        .Add("highlight", "keystroke.p99", Percentile(Keystrokes, 0.99), "us")
+        .Add("highlight", "keystroke.max", *std::max_element(Keystrokes.begin(), Keystrokes.end()), "us")
+        .Add("highlight", "typing_to_idle", Typing * 1000.0, "ms")
+        .Add("highlight", "cascade", Cascade * 1000.0, "ms")
+        .Add("highlight", "cascade.relexed", static_cast<double>(Relexed), "line");
+}
+
+}
+}
@@ -0,0 +1,192 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Bench.h"
+#include "../Common/Storage/Journal.h"
+#include "../Common/Storage/ProjectFile.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+namespace Snippet
+{
+namespace Bench
+{
+
+static constexpr uint32_t JournalNodes { 10000 };
+static constexpr uint32_t JournalRecords { 200000 };
+
+// Sums everything recovery is expected to restore, node IDs included, so the live and
+// recovered graphs can be compared without matching up handles.
+static uint64_t Digest(const Common::Graph& Model)
+{
+    uint64_t Result { 0 };
+    Model.ForEachNode([&Result](Common::NodeHandle, const Common::Graph::Node& Node) -> void
+        {
+            Result += static_cast<uint64_t>(Node.Position.X) + static_cast<uint64_t>(Node.Position.Y) * 3 + Node.Name.size() * 7 + Node.SourceHash + Node.ID;
+        });
+    return Result;
+}
+
+void RunJournal(Reporter& Results)
+{
+    const std::filesystem::path Directory { std::filesystem::temp_directory_path() };
+    const std::string SnapshotPath { (Directory / "SnippetBench.autosave").string() };
+    const std::string JournalPath { (Directory / "SnippetBench.journal").string() };
+    std::filesystem::remove(JournalPath);
+
+    Common::Graph Live;
+    std::vector<Common::NodeHandle> Nodes {};
+    for (uint32_t I = 0; I < JournalNodes; I++)
+    {
+        const Common::NodeHandle ID { Live.AddNode() };
+        Live
+            .SetPosition(ID, { static_cast<float>((I % 100) * 220), static_cast<float>((I / 100) * 90) })
+            .SetName(ID, U"Snippet")
+            .SetSource(ID, "return " + std::to_string(I) + "\n");
+        Nodes.push_back(ID);
+    }
+
+    std::string Error;
+
+    Common::Journal Journal;
+    if (!Common::ProjectFile::Save(Live, SnapshotPath.c_str(), nullptr, &Error)
+        || !Journal.Open(JournalPath.c_str(), &Error)
+        || !Journal.Rebase(SnapshotPath, &Error))
+    {
+        printf("Failed to start journal: %s\n", Error.c_str());
+        return;
+    }
+
+    // A session's worth of edits: mostly typing, then dragging, renaming, and the odd node
+    // created or deleted. The model is edited alongside so recovery can be checked.
+    std::mt19937 Random { 4321 };
+    Stopwatch Timer;
+    double Appending { 0.0 };
+
+    for (uint32_t I = 0; I < JournalRecords; I++)
+    {
+        const uint32_t Choice { static_cast<uint32_t>(Random() % 100) };
+        const size_t Index { Random() % Nodes.size() };
+        const Common::NodeHandle ID { Nodes[Index] };
+        Common::JournalRecord Record {};
+        Record.Node = Live.GetID(ID);
+        std::string Text {};
+
+        if (Choice < 70)
+        {
+            const std::string Before { Live.GetSource(ID) };
+            std::string After { Before };
+            After.insert(Random() % (After.size() + 1), 1, static_cast<char>('a' + Random() % 26));
+            Live.SetSource(ID, After);
+
+            Timer.Reset();
+            Journal.Append(Common::Journal::Edit(Record.Node, Before, After));
+            Appending += Timer.Seconds();
+            continue;
+        }
+
+        if (Choice < 90)
+        {
+            Record.Kind = Common::JournalKind::MoveNode;
+            Record.Position = { static_cast<float>(Random() % 20000), static_cast<float>(Random() % 20000) };
+            Live.SetPosition(ID, Record.Position);
+        }
+        else if (Choice < 96)
+        {
+            Record.Kind = Common::JournalKind::RenameNode;
+            Text = "Snippet " + std::to_string(I);
+            Record.Text = Text;
+            Live.SetName(ID, std::u32string(Text.begin(), Text.end()));
+        }
+        else if (Choice < 98 || Nodes.size() < 2)
+        {
+            const Common::NodeHandle Created { Live.AddNode() };
+            Record.Kind = Common::JournalKind::CreateNode;
+            Record.Node = Live.GetID(Created);
+            Record.Position = { 1.0f, 2.0f };
+            Text = "New Snippet";
+            Record.Text = Text;
+            Live
+                .SetPosition(Created, Record.Position)
+                .SetName(Created, U"New Snippet");
+            Nodes.push_back(Created);
+        }
+        else
+        {
+            Record.Kind = Common::JournalKind::DeleteNode;
+            Live.RemoveNode(ID);
+            Nodes[Index] = Nodes.back();
+            Nodes.pop_back();
+        }
+
+        Timer.Reset();
+        Journal.Append(Record);
+        Appending += Timer.Seconds();
+    }
+
+    Timer.Reset();
+    Journal.Flush();
+    const double Flush { Timer.Seconds() };
+
+    const Common::Journal::Stats Stats { Journal.GetStats() };
+    const double Size { static_cast<double>(Journal.Size()) };
+    Journal.Close();
+
+    Common::Graph Recovered;
+    Timer.Reset();
+    if (!Common::Journal::Recover(JournalPath.c_str(), Recovered, &Error))
+    {
+        printf("Failed to recover journal: %s\n", Error.c_str());
+        return;
+    }
+
+    const double Recover { Timer.Seconds() };
+
+    if (Recovered.NodeCount() != Live.NodeCount() || Digest(Recovered) != Digest(Live))
+    {
+        printf("Journal recovery mismatch.\n");
+    }
+
+    std::filesystem::remove(JournalPath);
+    std::filesystem::remove(SnapshotPath);
+
+    Results
+        .Add("journal", "snapshot_nodes", static_cast<double>(JournalNodes), "")
+        .Add("journal", "records", static_cast<double>(Stats.Records), "")
+        .Add("journal", "size", Size / (1024.0 * 1024.0), "MB")
+        .Add("journal", "append", static_cast<double>(JournalRecords) / Appending, "record/s")
+        .Add("journal", "syncs", static_cast<double>(Stats.Syncs), "")
+        .Add("journal", "flush", Flush * 1000.0, "ms")
+        .Add("journal", "recover", Recover * 1000.0, "ms")
+        .Add("journal", "replay", static_cast<double>(JournalRecords) / Recover, "record/s");
+}
+
+}
+}
@@ -0,0 +1,174 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Bench.h"
+#include "../Common/Network/Socket.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct Suite
+{
+    const char* Name { nullptr };
+    void (*Run)(Snippet::Bench::Reporter&) { nullptr };
+};
+
+static const Suite Suites[] {
+    { "edges", Snippet::Bench::RunEdges },
+    { "graph", Snippet::Bench::RunGraph },
+    { "highlight", Snippet::Bench::RunHighlight },
+    { "journal", Snippet::Bench::RunJournal },
+    { "project", Snippet::Bench::RunProject },
+    { "protocol", Snippet::Bench::RunProtocol },
+    { "room", Snippet::Bench::RunRoom },
+    { "server", Snippet::Bench::RunServer },
+    { "text", Snippet::Bench::RunText },
+    { "trace", Snippet::Bench::RunTrace },
+    { "transport", Snippet::Bench::RunTransport },
+};
+
+static const Suite* FindSuite(const char* Name)
+{
+    for (const Suite& Item : Suites)
+    {
+        if (std::strcmp(Name, Item.Name) == 0)
+        {
+            return &Item;
+        }
+    }
+
+    return nullptr;
+}
+
+static int Usage(const char* Program)
+{
+    fprintf(stderr, "Usage: %s [--format text|json|csv] [--output Path] [--label Text]\n", Program);
+    fprintf(stderr, "       [--max-nodes Count] [Suite...]\n");
+    fprintf(stderr, "Suites:");
+    for (const Suite& Item : Suites)
+    {
+        fprintf(stderr, " %s", Item.Name);
+    }
+    fprintf(stderr, "\n");
+    return 1;
+}
+
+int main(int argc, char** argv)
+{
+    Snippet::Bench::Reporter Results;
+    std::vector<const char*> Names;
+    std::string Output;
+    bool Machine { false };
+
+    for (int I = 1; I < argc; I++)
+    {
+        const bool HasValue { I + 1 < argc };
+
+        if (std::strcmp(argv[I], "--format") == 0 && HasValue)
+        {
+            const char* Format { argv[++I] };
+            if (std::strcmp(Format, "text") != 0 && std::strcmp(Format, "json") != 0 && std::strcmp(Format, "csv") != 0)
+            {
+                fprintf(stderr, "Unknown format '%s'.\n", Format);
+                return Usage(argv[0]);
+            }
+
+            Machine = std::strcmp(Format, "json") == 0 || std::strcmp(Format, "csv") == 0;
+            Results.SetFormat(std::strcmp(Format, "json") == 0 ? Snippet::Bench::Format::Json
+                    : std::strcmp(Format, "csv") == 0          ? Snippet::Bench::Format::Csv
+                                                               : Snippet::Bench::Format::Text);
+        }
+        else if (std::strcmp(argv[I], "--output") == 0 && HasValue)
+        {
+            Output = argv[++I];
+        }
+        else if (std::strcmp(argv[I], "--label") == 0 && HasValue)
+        {
+            Results.SetLabel(argv[++I]);
+        }
+        else if (std::strcmp(argv[I], "--max-nodes") == 0 && HasValue)
+        {
+            Snippet::Bench::SetGraphMaxNodes(static_cast<uint32_t>(std::strtoul(argv[++I], nullptr, 10)));
+        }
+        else if (argv[I][0] == '-')
+        {
+            const bool Known { std::strcmp(argv[I], "--format") == 0 || std::strcmp(argv[I], "--output") == 0
+                || std::strcmp(argv[I], "--label") == 0 || std::strcmp(argv[I], "--max-nodes") == 0 };
+            fprintf(stderr, Known ? "Option '%s' needs a value.\n" : "Unknown option '%s'.\n", argv[I]);
+            return Usage(argv[0]);
+        }
+        else if (FindSuite(argv[I]) == nullptr)
+        {
+            fprintf(stderr, "Unknown suite '%s'.\n", argv[I]);
+            return Usage(argv[0]);
+        }
+        else
+        {
+            Names.push_back(argv[I]);
+        }
+    }
+
+    if (!Snippet::Common::Socket::Initialize())
+    {
+        printf("Failed to initialize sockets.\n");
+        return 1;
+    }
+
+    for (const Suite& Item : Suites)
+    {
+        bool Selected { Names.empty() };
+
+        for (const char* Name : Names)
+        {
+            if (std::strcmp(Name, Item.Name) == 0)
+            {
+                Selected = true;
+            }
+        }
+
+        if (Selected)
+        {
+            Item.Run(Results);
+        }
+    }
+
+    Results.Print();
+
+    // Text results have already been printed as they came in.
+    int Result { 0 };
+    std::string Error;
+    if ((Machine || !Output.empty()) && !Results.Write(Output, &Error))
+    {
+        fprintf(stderr, "Failed to write results: %s\n", Error.c_str());
+        Result = 1;
+    }
+
+    Snippet::Common::Socket::Shutdown();
+    return Result;
+}
@@ -0,0 +1,141 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Bench.h"
+#include "../Common/Storage/ProjectFile.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+
+namespace Snippet
+{
+namespace Bench
+{
+
+static constexpr uint32_t ProjectNodes { 100000 };
+static constexpr uint32_t ProjectSamples { 10000 };
+
+static void MakeProject(Common::Graph& Model)
+{
+    std::mt19937 Random { 1234 };
+    std::vector<Common::PortHandle> Outputs {};
+    Outputs.reserve(ProjectNodes);
+    Model.Reserve(ProjectNodes);
+
+    for (uint32_t I = 0; I < ProjectNodes; I++)
+    {
+        const Common::NodeHandle ID { Model.AddNode() };
+        const std::string Index { std::to_string(I) };
+
+        Model
+            .SetPosition(ID, { static_cast<float>((I % 400) * 220), static_cast<float>((I / 400) * 90) })
+            .SetSize(ID, { 200.0f, 60.0f })
+            .SetName(ID, U"Snippet")
+            .SetSource(ID, "-- Snippet " + Index + "\nlocal Input = ...\nlocal Result = (tonumber(Input) or 0) * 2 + " + Index + "\nreturn tostring(Result)\n");
+
+        const Common::PortHandle Input { Model.AddPort(ID, Common::PortKind::Input, "In") };
+        Outputs.push_back(Model.AddPort(ID, Common::PortKind::Output, "Out"));
+
+        if (I > 0)
+        {
+            Model.Connect(Outputs[Random() % I], Input);
+        }
+    }
+}
+
+void RunProject(Reporter& Results)
+{
+    const std::string Path { (std::filesystem::temp_directory_path() / "SnippetBench.project").string() };
+
+    Common::Graph Source;
+    MakeProject(Source);
+
+    Stopwatch Timer;
+    std::string Error;
+    if (!Common::ProjectFile::Save(Source, Path.c_str(), nullptr, &Error))
+    {
+        printf("Failed to save project: %s\n", Error.c_str());
+        return;
+    }
+
+    const double Save { Timer.Seconds() };
+    const double Size { static_cast<double>(std::filesystem::file_size(Path)) };
+
+    // Opening only maps the file and checks the header, independent of project size.
+    Common::ProjectFile File;
+    Timer.Reset();
+    if (!File.Open(Path.c_str(), &Error))
+    {
+        printf("Failed to open project: %s\n", Error.c_str());
+        return;
+    }
+
+    const double Open { Timer.Microseconds() };
+
+    // What the canvas does for nodes scrolled into view.
+    std::mt19937 Random { 5678 };
+    size_t Checksum { 0 };
+    Timer.Reset();
+    for (uint32_t I = 0; I < ProjectSamples; I++)
+    {
+        const Common::ProjectFile::NodeView Node { File.GetNode(Random() % File.NodeCount()) };
+        Checksum += Node.Name.size() + Node.Source.size();
+    }
+
+    const double Access { Timer.Seconds() };
+
+    Common::Graph Lazy;
+    Timer.Reset();
+    File.Load(Lazy, nullptr, false);
+    const double LoadLazy { Timer.Seconds() };
+
+    Common::Graph Full;
+    Timer.Reset();
+    File.Load(Full, nullptr, true);
+    const double LoadFull { Timer.Seconds() };
+
+    if (Full.NodeCount() != Source.NodeCount() || Full.ConnectionCount() != Source.ConnectionCount() || Checksum == 0)
+    {
+        printf("Project round trip mismatch.\n");
+    }
+
+    File.Close();
+    std::filesystem::remove(Path);
+
+    Results
+        .Add("project", "nodes", static_cast<double>(ProjectNodes), "")
+        .Add("project", "file_size", Size / (1024.0 * 1024.0), "MB")
+        .Add("project", "save", Save * 1000.0, "ms")
+        .Add("project", "open", Open, "us")
+        .Add("project", "random_node_access", static_cast<double>(ProjectSamples) / Access, "node/s")
+        .Add("project", "load.without_sources", LoadLazy * 1000.0, "ms")
+        .Add("project", "load.with_sources", LoadFull * 1000.0, "ms");
+}
+
+}
+}
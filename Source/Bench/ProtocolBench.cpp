@@ -0,0 +1,247 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Bench.h"
+#include "../Common/Network/Protocol.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace Snippet
+{
+namespace Bench
+{
+
+static constexpr size_t MessageCount { 200000 };
+
+//
+// JSON baseline. This is a minimal hand-written encoder and flat object parser, which is
+// a lower bound on what a general purpose JSON library would cost for the same data.
+//
+
+static void EncodeJson(std::string& Out, const Common::Protocol::GraphEdit& Edit)
+{
+    char Buffer[160];
+    const int Length { snprintf(Buffer, sizeof(Buffer), "{\"kind\":%u,\"node\":%llu,\"target\":%llu,\"x\":%.9g,\"y\":%.9g,\"text\":\"",
+        static_cast<unsigned int>(Edit.Kind),
+        static_cast<unsigned long long>(Edit.Node),
+        static_cast<unsigned long long>(Edit.Target),
+        static_cast<double>(Edit.X),
+        static_cast<double>(Edit.Y)) };
+
+    Out.append(Buffer, static_cast<size_t>(Length));
+
+    for (char Ch : Edit.Text)
+    {
+        if (Ch == '"' || Ch == '\\')
+        {
+            Out.push_back('\\');
+        }
+
+        Out.push_back(Ch);
+    }
+
+    Out.append("\"}\n");
+}
+
+static const char* DecodeJson(const char* It, Common::Protocol::GraphEdit& Edit, std::string& Text)
+{
+    It = std::strchr(It, '{');
+    if (It == nullptr)
+    {
+        return nullptr;
+    }
+
+    It++;
+    while (*It != '}' && *It != '\0')
+    {
+        const char* KeyStart { std::strchr(It, '"') + 1 };
+        const char* KeyEnd { std::strchr(KeyStart, '"') };
+        const std::string_view Key { KeyStart, static_cast<size_t>(KeyEnd - KeyStart) };
+        It = KeyEnd + 2;
+
+        if (*It == '"')
+        {
+            Text.clear();
+            It++;
+
+            while (*It != '"')
+            {
+                if (*It == '\\')
+                {
+                    It++;
+                }
+
+                Text.push_back(*It++);
+            }
+
+            It++;
+        }
+        else
+        {
+            char* End { nullptr };
+            if (Key == "x" || Key == "y")
+            {
+                const float Value { std::strtof(It, &End) };
+                (Key == "x" ? Edit.X : Edit.Y) = Value;
+            }
+            else
+            {
+                const unsigned long long Value { std::strtoull(It, &End, 10) };
+                if (Key == "kind")
+                {
+                    Edit.Kind = static_cast<Common::Protocol::EditKind>(Value);
+                }
+                else if (Key == "node")
+                {
+                    Edit.Node = Value;
+                }
+                else
+                {
+                    Edit.Target = Value;
+                }
+            }
+
+            It = End;
+        }
+
+        if (*It == ',')
+        {
+            It++;
+        }
+    }
+
+    Edit.Text = Text;
+    return *It == '}' ? It + 1 : nullptr;
+}
+
+static std::vector<Common::Protocol::GraphEdit> MakeEdits(std::vector<std::string>& Names)
+{
+    std::vector<Common::Protocol::GraphEdit> Result;
+    Result.reserve(MessageCount);
+    Names.reserve(MessageCount / 16 + 1);
+
+    for (size_t I = 0; I < MessageCount; I++)
+    {
+        Common::Protocol::GraphEdit Edit {};
+        Edit.Node = I % 4096;
+        Edit.X = static_cast<float>(I % 1920) + 0.5f;
+        Edit.Y = static_cast<float>(I % 1080) + 0.25f;
+
+        if (I % 16 == 0)
+        {
+            Names.push_back("Snippet " + std::to_string(I));
+            Edit.Kind = Common::Protocol::EditKind::RenameNode;
+            Edit.Text = Names.back();
+        }
+        else
+        {
+            Edit.Kind = Common::Protocol::EditKind::MoveNode;
+        }
+
+        Result.push_back(Edit);
+    }
+
+    return Result;
+}
+
+void RunProtocol(Reporter& Results)
+{
+    std::vector<std::string> Names;
+    const std::vector<Common::Protocol::GraphEdit> Edits { MakeEdits(Names) };
+
+    // Binary
+    Common::Protocol::MessageWriter Writer;
+    Writer.Buffer().reserve(MessageCount * 48);
+    Stopwatch Timer;
+
+    for (const Common::Protocol::GraphEdit& Edit : Edits)
+    {
+        Writer.Write(Edit);
+    }
+
+    const double BinaryEncode { Timer.Seconds() };
+    const size_t BinaryBytes { Writer.Size() };
+
+    uint64_t Checksum { 0 };
+    Timer.Reset();
+
+    Common::Protocol::MessageReader Reader { Writer.Buffer().data(), Writer.Size() };
+    Common::Protocol::MessageView Message {};
+    while (Reader.Next(Message) == Common::Protocol::ParseStatus::Ok)
+    {
+        Common::Protocol::GraphEdit Edit {};
+        if (Common::Protocol::Decode(Message, Edit))
+        {
+            Checksum += Edit.Node + Edit.Text.size();
+        }
+    }
+
+    const double BinaryDecode { Timer.Seconds() };
+
+    // JSON
+    std::string Json;
+    Json.reserve(MessageCount * 96);
+    Timer.Reset();
+
+    for (const Common::Protocol::GraphEdit& Edit : Edits)
+    {
+        EncodeJson(Json, Edit);
+    }
+
+    const double JsonEncode { Timer.Seconds() };
+    uint64_t JsonChecksum { 0 };
+    std::string Text;
+    Timer.Reset();
+
+    const char* It { Json.c_str() };
+    Common::Protocol::GraphEdit Edit {};
+    while (It != nullptr && *It != '\0' && (It = DecodeJson(It, Edit, Text)) != nullptr)
+    {
+        JsonChecksum += Edit.Node + Edit.Text.size();
+    }
+
+    const double JsonDecode { Timer.Seconds() };
+
+    if (Checksum != JsonChecksum)
+    {
+        printf("Protocol checksum mismatch: %llu != %llu\n", static_cast<unsigned long long>(Checksum), static_cast<unsigned long long>(JsonChecksum));
+    }
+
+    const double Count { static_cast<double>(MessageCount) };
+    Results
+        .Add("protocol", "binary.encode", Count / BinaryEncode, "msg/s")
+        .Add("protocol", "binary.decode", Count / BinaryDecode, "msg/s")
+        .Add("protocol", "binary.bytes_per_message", static_cast<double>(BinaryBytes) / Count, "B")
+        .Add("protocol", "json.encode", Count / JsonEncode, "msg/s")
+        .Add("protocol", "json.decode", Count / JsonDecode, "msg/s")
+        .Add("protocol", "json.bytes_per_message", static_cast<double>(Json.size()) / Count, "B");
+}
+
+}
+}
@@ -0,0 +1,752 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Bench.h"
+#include "../Client/Network/Connection.h"
+#include "../Client/Network/Remote.h"
+#include "../Common/Text/TextOp.h"
+#include "../Common/Unicode.h"
+#include "../Server/Server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Snippet
+{
+namespace Bench
+{
+
+// The room is expected to keep this many people in step, each seeing the others' edits
+// within the target latency.
+static constexpr int Members { 20 };
+static constexpr double TargetMilliseconds { 50.0 };
+static constexpr int FrameMilliseconds { 16 };
+static constexpr double JoinSeconds { 10.0 };
+static constexpr double EditSeconds { 2.0 };
+static constexpr double SettleSeconds { 1.0 };
+static constexpr double ProbeSeconds { 2.0 };
+static constexpr int StartingNodes { 8 };
+static constexpr size_t MaxProbes { 1024 };
+static constexpr double RunSeconds { 10.0 };
+// Long enough that the member who starts the run is gone before it finishes.
+static constexpr const char* SlowSource { "local Sum = 0 for I = 1, 50000000 do Sum = Sum + I end return Sum" };
+
+enum class Phase
+{
+    Joining,
+    Editing,
+    Settling,
+    Probing,
+    Done,
+};
+
+//
+// Each member runs the way the client does: once per frame it sends what it has edited
+// and applies what the room relayed, through the same Remote the canvas uses.
+//
+
+struct Member
+{
+    int Index { 0 };
+    std::shared_ptr<Client::Connection> Link { nullptr };
+    std::unique_ptr<Client::Remote> Remote { nullptr };
+    Common::Graph Graph {};
+    std::mt19937 Random {};
+    bool Joined { false };
+};
+
+// Member 0 drags one node while everyone else watches for it. The sample number is the
+// node's X, so each arrival is matched to the moment it was sent.
+struct Probe
+{
+    Common::NodeID Node { Common::InvalidNodeID };
+    std::unique_ptr<std::atomic<int64_t>[]> Sent { new std::atomic<int64_t>[MaxProbes] {} };
+    std::atomic<size_t> Count { 0 };
+    std::mutex Mutex {};
+    std::vector<double> Latencies {};
+};
+
+struct TransformCase
+{
+    const char* Name { nullptr };
+    const char* Text { nullptr };
+    Common::TextOp First {};
+    Common::TextOp Second {};
+    const char* Expected { nullptr };
+};
+
+static int64_t Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static Common::ConnectionHandle FindConnection(const Common::Graph& Graph, Common::PortHandle From, Common::PortHandle To)
+{
+    const Common::Graph::Port* Output { Graph.GetPort(From) };
+
+    if (Output == nullptr)
+    {
+        return {};
+    }
+
+    for (Common::ConnectionHandle ID : Output->Connections)
+    {
+        const Common::Graph::Connection* Item { Graph.GetConnection(ID) };
+
+        if (Item != nullptr && Item->To == To)
+        {
+            return ID;
+        }
+    }
+
+    return {};
+}
+
+// Applies an edit relayed by the room, as Canvas::ApplyRemote does.
+static void Apply(Member& Self, Probe& Probe_, const Common::JournalRecord& Record)
+{
+    Common::Graph& Graph { Self.Graph };
+    const Common::NodeHandle Handle { Graph.Find(Record.Node) };
+
+    switch (Record.Kind)
+    {
+    case Common::JournalKind::Base: Graph.Clear(); break;
+
+    case Common::JournalKind::CreateNode:
+    {
+        if (!Handle.IsValid())
+        {
+            const Common::NodeHandle Created { Graph.AddSnippet(Record.Node) };
+            Graph
+                .SetPosition(Created, Record.Position)
+                .SetName(Created, Common::ToUTF32(Record.Text));
+        }
+    }
+    break;
+
+    case Common::JournalKind::DeleteNode:
+    {
+        if (Handle.IsValid())
+        {
+            Graph.RemoveNode(Handle);
+        }
+    }
+    break;
+
+    case Common::JournalKind::MoveNode:
+    {
+        if (!Handle.IsValid())
+        {
+            break;
+        }
+
+        Graph.SetPosition(Handle, Record.Position);
+
+        const size_t Sample { static_cast<size_t>(Record.Position.X) };
+        if (Record.Node == Probe_.Node && Sample < MaxProbes)
+        {
+            const int64_t Sent { Probe_.Sent[Sample].load() };
+
+            if (Sent != 0)
+            {
+                std::lock_guard<std::mutex> Lock { Probe_.Mutex };
+                Probe_.Latencies.push_back(static_cast<double>(Now() - Sent) / 1.0e6);
+            }
+        }
+    }
+    break;
+
+    case Common::JournalKind::RenameNode:
+    {
+        if (Handle.IsValid())
+        {
+            Graph.SetName(Handle, Common::ToUTF32(Record.Text));
+        }
+    }
+    break;
+
+    case Common::JournalKind::EditSource:
+    {
+        if (!Handle.IsValid())
+        {
+            break;
+        }
+
+        std::string Source { Graph.GetSource(Handle) };
+        if (Record.Offset <= Source.size() && Record.Removed <= Source.size() - Record.Offset)
+        {
+            Source.replace(Record.Offset, Record.Removed, Record.Text);
+            Graph.SetSource(Handle, Source);
+        }
+    }
+    break;
+
+    case Common::JournalKind::Connect:
+    case Common::JournalKind::Disconnect:
+    {
+        const Common::NodeHandle Target { Graph.Find(Record.Target) };
+        const std::vector<Common::PortHandle>& Outputs { Graph.GetPorts(Handle) };
+        const std::vector<Common::PortHandle>& Inputs { Graph.GetPorts(Target) };
+
+        if (Record.Port >= Outputs.size() || Record.TargetPort >= Inputs.size())
+        {
+            break;
+        }
+
+        const Common::PortHandle From { Outputs[Record.Port] };
+        const Common::PortHandle To { Inputs[Record.TargetPort] };
+        const Common::ConnectionHandle Existing { FindConnection(Graph, From, To) };
+
+        if (Record.Kind == Common::JournalKind::Connect && !Existing.IsValid())
+        {
+            Graph.Connect(From, To);
+        }
+        else if (Record.Kind == Common::JournalKind::Disconnect && Existing.IsValid())
+        {
+            Graph.Disconnect(Existing);
+        }
+    }
+    break;
+
+    default: break;
+    }
+}
+
+// Makes one edit of the kind people make, weighted toward moves and typing. The probe
+// node is left alone so the latency samples are not mixed up with anyone else's moves.
+static void Edit(Member& Self, Common::NodeID Skip)
+{
+    Common::Graph& Graph { Self.Graph };
+    std::vector<Common::NodeHandle> Nodes {};
+    Graph.ForEachNode([&](Common::NodeHandle Handle, const Common::Graph::Node& Node) -> void
+        {
+            if (Node.ID != Skip)
+            {
+                Nodes.push_back(Handle);
+            }
+        });
+
+    const uint32_t Roll { static_cast<uint32_t>(Self.Random() % 100) };
+    Common::JournalRecord Record {};
+
+    if (Nodes.size() < 2 || Roll < 6)
+    {
+        const std::string Name { "Node " + std::to_string(Self.Index) };
+        const Common::Point Position { static_cast<float>(Self.Random() % 2000), static_cast<float>(Self.Random() % 2000) };
+        const Common::NodeHandle Created { Graph.AddSnippet() };
+        Graph
+            .SetPosition(Created, Position)
+            .SetName(Created, Common::ToUTF32(Name));
+
+        Record.Kind = Common::JournalKind::CreateNode;
+        Record.Node = Graph.GetID(Created);
+        Record.Position = Position;
+        Record.Text = Name;
+        Self.Remote->Forward(Record);
+        return;
+    }
+
+    const Common::NodeHandle Handle { Nodes[Self.Random() % Nodes.size()] };
+    const Common::NodeID ID { Graph.GetID(Handle) };
+    Record.Node = ID;
+
+    if (Roll < 9)
+    {
+        Graph.RemoveNode(Handle);
+        Record.Kind = Common::JournalKind::DeleteNode;
+        Self.Remote->Forward(Record);
+    }
+    else if (Roll < 45)
+    {
+        const Common::Point Position { static_cast<float>(Self.Random() % 2000), static_cast<float>(Self.Random() % 2000) };
+        Graph.SetPosition(Handle, Position);
+        Self.Remote->Move(ID, Position);
+    }
+    else if (Roll < 52)
+    {
+        const std::string Name { "Node " + std::to_string(Self.Index) + "." + std::to_string(Self.Random() % 100) };
+        Graph.SetName(Handle, Common::ToUTF32(Name));
+        Record.Kind = Common::JournalKind::RenameNode;
+        Record.Text = Name;
+        Self.Remote->Forward(Record);
+    }
+    else if (Roll < 90)
+    {
+        // Sources are kept short by deleting once they grow, as people do as much as type.
+        std::string Source { Graph.GetSource(Handle) };
+        const size_t Offset { Self.Random() % (Source.size() + 1) };
+        const size_t Removed { Source.size() > 256 ? std::min<size_t>(Source.size() - Offset, 32) : std::min<size_t>(Source.size() - Offset, Self.Random() % 3) };
+        const std::string Inserted(Source.size() > 256 ? 0 : Self.Random() % 4, static_cast<char>('a' + Self.Index % 26));
+        Source.replace(Offset, Removed, Inserted);
+        Graph.SetSource(Handle, Source);
+
+        Record.Kind = Common::JournalKind::EditSource;
+        Record.Offset = static_cast<uint32_t>(Offset);
+        Record.Removed = static_cast<uint32_t>(Removed);
+        Record.Text = Inserted;
+        Self.Remote->Forward(Record);
+    }
+    else
+    {
+        const Common::NodeHandle Target { Nodes[Self.Random() % Nodes.size()] };
+        if (Target == Handle)
+        {
+            return;
+        }
+
+        const Common::PortHandle From { Graph.GetPorts(Handle)[1] };
+        const Common::PortHandle To { Graph.GetPorts(Target)[0] };
+        const Common::ConnectionHandle Existing { FindConnection(Graph, From, To) };
+
+        if (Existing.IsValid())
+        {
+            Graph.Disconnect(Existing);
+            Record.Kind = Common::JournalKind::Disconnect;
+        }
+        else
+        {
+            Graph.Connect(From, To);
+            Record.Kind = Common::JournalKind::Connect;
+        }
+
+        Record.Target = Graph.GetID(Target);
+        Record.Port = 1;
+        Record.TargetPort = 0;
+        Self.Remote->Forward(Record);
+    }
+}
+
+// Everything the members are expected to agree on, in an order that does not depend on
+// how each one's graph was built.
+static std::string Digest(const Common::Graph& Graph)
+{
+    std::map<Common::NodeID, std::string> Nodes {};
+    Graph.ForEachNode([&](Common::NodeHandle, const Common::Graph::Node& Node) -> void
+        {
+            Nodes[Node.ID] = std::to_string(Node.Position.X) + "," + std::to_string(Node.Position.Y) + "|" + Common::ToUTF8(Node.Name) + "|" + Node.Source;
+        });
+
+    std::set<std::pair<Common::NodeID, Common::NodeID>> Edges {};
+    Graph.ForEachConnection([&](Common::ConnectionHandle, const Common::Graph::Connection& Item) -> void
+        {
+            const Common::Graph::Port* From { Graph.GetPort(Item.From) };
+            const Common::Graph::Port* To { Graph.GetPort(Item.To) };
+
+            if (From != nullptr && To != nullptr)
+            {
+                Edges.insert({ Graph.GetID(From->Owner), Graph.GetID(To->Owner) });
+            }
+        });
+
+    std::string Result {};
+    for (const std::pair<const Common::NodeID, std::string>& Item : Nodes)
+    {
+        Result += std::to_string(Item.first) + ":" + Item.second + "\n";
+    }
+
+    for (const std::pair<Common::NodeID, Common::NodeID>& Item : Edges)
+    {
+        Result += std::to_string(Item.first) + ">" + std::to_string(Item.second) + "\n";
+    }
+
+    return Result;
+}
+
+static bool WaitFor(const std::atomic<int>& Value, int Expected, double Seconds)
+{
+    const Stopwatch Timer;
+
+    while (Value.load() < Expected)
+    {
+        if (Timer.Seconds() > Seconds)
+        {
+            return false;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(FrameMilliseconds));
+    }
+
+    return true;
+}
+
+static void Sleep(double Seconds)
+{
+    std::this_thread::sleep_for(std::chrono::duration<double>(Seconds));
+}
+
+static void RunMembers(Reporter& Results, uint16_t Port)
+{
+    std::vector<std::unique_ptr<Member>> Room {};
+    std::vector<std::thread> Threads {};
+    std::atomic<Phase> Current { Phase::Joining };
+    std::atomic<int> Joined { 0 };
+    std::atomic<uint64_t> Edits { 0 };
+    Probe Probe_ {};
+
+    for (int Index = 0; Index < Members; Index++)
+    {
+        std::unique_ptr<Member> Self { std::make_unique<Member>() };
+        Member* Target { Self.get() };
+        Self->Index = Index;
+        Self->Random.seed(static_cast<uint32_t>(Index) * 7919u + 1u);
+        Self->Link = std::make_shared<Client::Connection>();
+        Self->Remote = std::make_unique<Client::Remote>(Self->Link);
+        Self->Remote
+            ->SetOnEdit([Target, &Probe_](const Common::JournalRecord& Record) -> void
+                {
+                    Apply(*Target, Probe_, Record);
+                })
+            .SetOnJoined([Target, &Joined](const Common::Protocol::Joined& Reply) -> void
+                {
+                    if (Reply.Member == 0)
+                    {
+                        return;
+                    }
+
+                    Target->Graph.SetSite(Reply.Site);
+                    if (Reply.Fresh)
+                    {
+                        Target->Remote->Publish(Target->Graph);
+                    }
+
+                    if (!Target->Joined)
+                    {
+                        Target->Joined = true;
+                        Joined++;
+                    }
+                });
+        Room.push_back(std::move(Self));
+    }
+
+    // The first member fills the room with a graph of its own, the probe node included.
+    Member& First { *Room[0] };
+    for (int Index = 0; Index < StartingNodes; Index++)
+    {
+        const Common::NodeHandle Node { First.Graph.AddSnippet() };
+        First.Graph
+            .SetPosition(Node, { static_cast<float>(Index * 200), 0.0f })
+            .SetName(Node, U"Node")
+            .SetSource(Node, "return " + std::to_string(Index));
+    }
+    First.Graph.ForEachNode([&](Common::NodeHandle, const Common::Graph::Node& Node) -> void
+        {
+            Probe_.Node = Probe_.Node == Common::InvalidNodeID ? Node.ID : Probe_.Node;
+        });
+
+    // Each member is driven by its own thread from the moment it asks to join. The first
+    // joins alone, so the room is only fresh to one of them.
+    const auto Start { [&](Member& Self) -> void
+        {
+            Self.Link->Connect("127.0.0.1", Port);
+            Self.Remote->Join("bench");
+            Threads.emplace_back([Target = &Self, &Current, &Edits, &Probe_]() -> void
+                {
+                    while (Current.load() != Phase::Done)
+                    {
+                        const Phase Now_ { Current.load() };
+
+                        if (Now_ == Phase::Probing && Target->Index == 0)
+                        {
+                            const size_t Sample { ++Probe_.Count };
+
+                            if (Sample < MaxProbes)
+                            {
+                                const Common::Point Position { static_cast<float>(Sample), 0.0f };
+                                Target->Graph.SetPosition(Target->Graph.Find(Probe_.Node), Position);
+                                Probe_.Sent[Sample].store(Now());
+                                Target->Remote->Move(Probe_.Node, Position);
+                            }
+                        }
+
+                        Target->Remote->Update();
+
+                        if (Now_ == Phase::Editing && Target->Joined)
+                        {
+                            Edit(*Target, Probe_.Node);
+                            Edits++;
+                        }
+
+                        std::this_thread::sleep_for(std::chrono::milliseconds(FrameMilliseconds));
+                    }
+                });
+        } };
+
+    Start(First);
+    const bool FirstJoined { WaitFor(Joined, 1, JoinSeconds) };
+
+    for (size_t Index = 1; Index < Room.size() && FirstJoined; Index++)
+    {
+        Start(*Room[Index]);
+    }
+
+    const bool AllJoined { FirstJoined && WaitFor(Joined, Members, JoinSeconds) };
+
+    if (AllJoined)
+    {
+        Current = Phase::Editing;
+        Sleep(EditSeconds);
+        Current = Phase::Settling;
+        Sleep(SettleSeconds);
+        Current = Phase::Probing;
+        Sleep(ProbeSeconds);
+        Current = Phase::Settling;
+        Sleep(SettleSeconds);
+    }
+
+    Current = Phase::Done;
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+
+    if (!AllJoined)
+    {
+        printf("Only %d of %d room members joined.\n", Joined.load(), Members);
+        return;
+    }
+
+    const std::string Expected { Digest(First.Graph) };
+    int Diverged { 0 };
+    for (const std::unique_ptr<Member>& Self : Room)
+    {
+        Diverged += Digest(Self->Graph) != Expected ? 1 : 0;
+    }
+
+    if (Diverged > 0)
+    {
+        printf("Room members diverged: %d of %d.\n", Diverged, Members);
+    }
+
+    const double P99 { Percentile(Probe_.Latencies, 0.99) };
+    if (P99 > TargetMilliseconds)
+    {
+        printf("Room fan-out p99 of %.1f ms is above the %.0f ms target.\n", P99, TargetMilliseconds);
+    }
+
+    Results
+        .Add("room", "members", static_cast<double>(Members), "")
+        .Add("room", "edits", static_cast<double>(Edits.load()) / EditSeconds, "edit/s")
+        .Add("room", "nodes", static_cast<double>(First.Graph.NodeCount()), "")
+        .Add("room", "diverged", static_cast<double>(Diverged), "")
+        .Add("room", "fanout.samples", static_cast<double>(Probe_.Latencies.size()), "")
+        .Add("room", "fanout.p50", Percentile(Probe_.Latencies, 0.50), "ms")
+        .Add("room", "fanout.p99", P99, "ms");
+
+    for (const std::unique_ptr<Member>& Self : Room)
+    {
+        Self->Link->Disconnect();
+    }
+}
+
+// Both orders of applying a pair of concurrent edits must end up with the same text.
+static void RunTransforms(Reporter& Results)
+{
+    const TransformCase Cases[] {
+        { "insert.same_place", "abcdefgh", { 3, 0, "X" }, { 3, 0, "Y" }, "abcXYdefgh" },
+        { "touching.after", "abcdefgh", { 2, 2, "X" }, { 4, 0, "Y" }, "abXYefgh" },
+        { "touching.before", "abcdefgh", { 2, 0, "X" }, { 0, 2, "Y" }, "YXcdefgh" },
+        { "nested.inner_first", "abcdefgh", { 2, 2, "X" }, { 1, 4, "Y" }, "aYfgh" },
+        { "nested.outer_first", "abcdefgh", { 1, 4, "Y" }, { 2, 2, "X" }, "aYfgh" },
+        { "overlap.left_first", "abcdefgh", { 1, 3, "X" }, { 3, 3, "Y" }, "aXYgh" },
+        { "overlap.right_first", "abcdefgh", { 3, 3, "Y" }, { 1, 3, "X" }, "aXYgh" },
+        { "same_range", "abcdefgh", { 2, 2, "X" }, { 2, 2, "Y" }, "abXYefgh" },
+    };
+
+    int Failed { 0 };
+    for (const TransformCase& Case : Cases)
+    {
+        Common::TextOp First { Case.First };
+        Common::TextOp Second { Case.Second };
+        Common::TextOp::Transform(First, Second);
+
+        std::string FirstThenSecond { Case.Text };
+        std::string SecondThenFirst { Case.Text };
+        const bool Applied { Case.First.Apply(FirstThenSecond) && Second.Apply(FirstThenSecond)
+            && Case.Second.Apply(SecondThenFirst) && First.Apply(SecondThenFirst) };
+
+        if (!Applied || FirstThenSecond != Case.Expected || SecondThenFirst != Case.Expected)
+        {
+            printf("Text transform %s mismatch: '%s' and '%s', expected '%s'.\n", Case.Name, FirstThenSecond.c_str(), SecondThenFirst.c_str(), Case.Expected);
+            Failed++;
+        }
+    }
+
+    Results
+        .Add("room", "transform.cases", static_cast<double>(sizeof(Cases) / sizeof(Cases[0])), "")
+        .Add("room", "transform.failed", static_cast<double>(Failed), "");
+}
+
+static void Frame(const std::vector<Client::Remote*>& Remotes)
+{
+    for (Client::Remote* Remote : Remotes)
+    {
+        Remote->Update();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(FrameMilliseconds));
+}
+
+// A run started by a member that leaves before it finishes must still leave the room free
+// to run again, with what the run computed remembered.
+static void RunAfterLeaving(Reporter& Results, uint16_t Port)
+{
+    const std::shared_ptr<Client::Connection> StarterLink { std::make_shared<Client::Connection>() };
+    const std::shared_ptr<Client::Connection> OtherLink { std::make_shared<Client::Connection>() };
+    Client::Remote Starter { StarterLink };
+    Client::Remote Other { OtherLink };
+    Common::Graph Graph {};
+    bool StarterJoined { false };
+    bool OtherJoined { false };
+    bool Started { false };
+    bool Finished { false };
+    std::string Error {};
+    Common::Protocol::ExecutionSummary Summary {};
+
+    const Common::NodeHandle Fast { Graph.AddSnippet() };
+    const Common::NodeHandle Slow { Graph.AddSnippet() };
+    Graph
+        .SetSource(Fast, "return 1")
+        .SetSource(Slow, SlowSource)
+        .Connect(Graph.GetPorts(Fast)[1], Graph.GetPorts(Slow)[0]);
+
+    Starter
+        .SetOnJoined([&](const Common::Protocol::Joined& Reply) -> void
+            {
+                if (Reply.Fresh)
+                {
+                    Starter.Publish(Graph);
+                }
+
+                StarterJoined = Reply.Member != 0;
+            })
+        .SetOnResult([&](const Client::Remote::Result&) -> void
+            {
+                Started = true;
+            });
+    Other
+        .SetOnJoined([&](const Common::Protocol::Joined& Reply) -> void
+            {
+                OtherJoined = Reply.Member != 0;
+            })
+        .SetOnFinished([&](const Common::Protocol::ExecutionSummary* Result, const std::string& Reason) -> void
+            {
+                Finished = Result != nullptr;
+                Summary = Result != nullptr ? *Result : Summary;
+                Error = Reason;
+            });
+
+    StarterLink->Connect("127.0.0.1", Port);
+    Starter.Join("rerun");
+    for (const Stopwatch Timer; !StarterJoined && Timer.Seconds() < JoinSeconds;)
+    {
+        Frame({ &Starter });
+    }
+
+    OtherLink->Connect("127.0.0.1", Port);
+    Other.Join("rerun");
+    for (const Stopwatch Timer; !OtherJoined && Timer.Seconds() < JoinSeconds;)
+    {
+        Frame({ &Starter, &Other });
+    }
+
+    // The starter leaves as soon as the server has started on its run.
+    std::string Reason {};
+    if (!StarterJoined || !OtherJoined || !Starter.Execute(Graph, nullptr, &Reason))
+    {
+        printf("Room run could not be started: %s\n", Reason.c_str());
+        return;
+    }
+
+    for (const Stopwatch Timer; !Started && Timer.Seconds() < RunSeconds;)
+    {
+        Frame({ &Starter, &Other });
+    }
+
+    StarterLink->Disconnect();
+
+    // Asked again every frame while the server says a run is still in progress.
+    const Stopwatch Timer;
+    while (!Finished && Timer.Seconds() < RunSeconds)
+    {
+        if (!Other.IsRunning())
+        {
+            Other.Execute(Graph);
+        }
+
+        Frame({ &Other });
+    }
+
+    if (!Finished)
+    {
+        printf("Room could not run again after the member running it left: %s\n", Error.c_str());
+        return;
+    }
+
+    Results
+        .Add("room", "rerun_after_leave", Timer.Seconds() * 1000.0, "ms")
+        .Add("room", "rerun_after_leave.reused", static_cast<double>(Summary.Reused), "");
+
+    OtherLink->Disconnect();
+}
+
+void RunRoom(Reporter& Results)
+{
+    RunTransforms(Results);
+
+    Server::Server::Options Options;
+    Options.Host = "127.0.0.1";
+    Options.Port = 0;
+    Options.Threads = 4;
+
+    Server::Server Instance { Options };
+    if (!Instance.Start())
+    {
+        return;
+    }
+
+    std::thread Thread([&Instance]() -> void
+        {
+            Instance.Run();
+        });
+
+    RunMembers(Results, Instance.Port());
+    RunAfterLeaving(Results, Instance.Port());
+
+    Instance.Stop();
+    Thread.join();
+}
+
+}
+}
@@ -0,0 +1,218 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Bench.h"
+#include "../Common/Network/Protocol.h"
+#include "../Common/Network/Socket.h"
+#include "../Server/Server.h"
+
+#include <string>
+#include <thread>
+
+#if !defined(_WIN32)
+    #include <unistd.h>
+#endif
+
+namespace Snippet
+{
+namespace Bench
+{
+
+static constexpr double ConnectSeconds { 1.0 };
+static constexpr int Clients { 8 };
+static constexpr int RequestsPerClient { 5000 };
+
+static bool SendAll(const Common::Socket& Connection, const uint8_t* Data, size_t Size)
+{
+    while (Size > 0)
+    {
+        const Common::IOResult Result { Connection.Send(Data, Size) };
+        if (Result.Status != Common::IOStatus::Ok)
+        {
+            return false;
+        }
+
+        Data += Result.Bytes;
+        Size -= Result.Bytes;
+    }
+
+    return true;
+}
+
+static bool ReceiveAll(const Common::Socket& Connection, uint8_t* Data, size_t Size)
+{
+    while (Size > 0)
+    {
+        const Common::IOResult Result { Connection.Receive(Data, Size) };
+        if (Result.Status != Common::IOStatus::Ok)
+        {
+            return false;
+        }
+
+        Data += Result.Bytes;
+        Size -= Result.Bytes;
+    }
+
+    return true;
+}
+
+static bool RoundTrip(const Common::Socket& Connection, uint32_t Sequence)
+{
+    Common::Protocol::MessageWriter Request;
+    Request
+        .Begin(Common::Protocol::MessageType::Heartbeat, Sequence)
+        .U64(Sequence)
+        .End();
+
+    uint8_t Response[Common::Protocol::HeaderSize + sizeof(uint64_t)] {};
+    if (!SendAll(Connection, Request.Buffer().data(), Request.Size()) || !ReceiveAll(Connection, Response, sizeof(Response)))
+    {
+        return false;
+    }
+
+    Common::Protocol::MessageReader Reader { Response, sizeof(Response) };
+    Common::Protocol::MessageView Message {};
+    return Reader.Next(Message) == Common::Protocol::ParseStatus::Ok
+        && Message.Type == Common::Protocol::MessageType::HeartbeatAck
+        && Message.Sequence == Sequence;
+}
+
+static Common::Socket Connect(const std::string& UnixPath, uint16_t Port)
+{
+    if (!UnixPath.empty())
+    {
+        return Common::Socket::ConnectUnix(UnixPath.c_str());
+    }
+
+    return Common::Socket::ConnectTCP("127.0.0.1", Port);
+}
+
+static void RunConnections(Reporter& Results, const std::string& Transport, const std::string& UnixPath, uint16_t Port)
+{
+    uint64_t Count { 0 };
+    const Stopwatch Timer;
+
+    while (Timer.Seconds() < ConnectSeconds)
+    {
+        const Common::Socket Connection { Connect(UnixPath, Port) };
+
+        if (!Connection.IsValid() || !RoundTrip(Connection, static_cast<uint32_t>(Count)))
+        {
+            break;
+        }
+
+        Count++;
+    }
+
+    Results.Add("server", Transport + ".connections", static_cast<double>(Count) / Timer.Seconds(), "conn/s");
+}
+
+static void RunRequests(Reporter& Results, const std::string& Transport, const std::string& UnixPath, uint16_t Port)
+{
+    std::vector<std::vector<double>> Latencies(Clients);
+    std::vector<std::thread> Threads;
+    const Stopwatch Timer;
+
+    for (int Client = 0; Client < Clients; Client++)
+    {
+        Threads.emplace_back([&Latencies, &UnixPath, Port, Client]() -> void
+            {
+                const Common::Socket Connection { Connect(UnixPath, Port) };
+                std::vector<double>& Samples { Latencies[Client] };
+                Samples.reserve(RequestsPerClient);
+
+                for (int Request = 0; Request < RequestsPerClient && Connection.IsValid(); Request++)
+                {
+                    const Stopwatch Latency;
+
+                    if (!RoundTrip(Connection, static_cast<uint32_t>(Request)))
+                    {
+                        break;
+                    }
+
+                    Samples.push_back(Latency.Microseconds());
+                }
+            });
+    }
+
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+
+    const double Elapsed { Timer.Seconds() };
+    std::vector<double> All;
+    for (const std::vector<double>& Samples : Latencies)
+    {
+        All.insert(All.end(), Samples.begin(), Samples.end());
+    }
+
+    Results
+        .Add("server", Transport + ".requests", static_cast<double>(All.size()) / Elapsed, "req/s")
+        .Add("server", Transport + ".latency.p50", Percentile(All, 0.50), "us")
+        .Add("server", Transport + ".latency.p99", Percentile(All, 0.99), "us");
+}
+
+void RunServer(Reporter& Results)
+{
+    Server::Server::Options Options;
+    Options.Host = "127.0.0.1";
+    Options.Port = 0;
+
+#if !defined(_WIN32)
+    Options.UnixPath = "/tmp/SnippetBench-" + std::to_string(getpid()) + ".sock";
+#endif
+
+    Server::Server Instance { Options };
+    if (!Instance.Start())
+    {
+        return;
+    }
+
+    std::thread Thread([&Instance]() -> void
+        {
+            Instance.Run();
+        });
+
+    RunConnections(Results, "tcp", "", Instance.Port());
+    RunRequests(Results, "tcp", "", Instance.Port());
+
+    if (!Options.UnixPath.empty())
+    {
+        RunConnections(Results, "unix", Options.UnixPath, Instance.Port());
+        RunRequests(Results, "unix", Options.UnixPath, Instance.Port());
+    }
+
+    Instance.Stop();
+    Thread.join();
+
+#if !defined(_WIN32)
+    unlink(Options.UnixPath.c_str());
+#endif
+}
+
+}
+}
@@ -0,0 +1,131 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Bench.h"
+#include "../Common/Text/TextBuffer.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace Snippet
+{
+namespace Bench
+{
+
+static constexpr size_t TextSize { 10 * 1024 * 1024 };
+static constexpr uint32_t TextKeystrokes { 200000 };
+static constexpr uint32_t TextBaselineKeystrokes { 2000 };
+static constexpr uint32_t TextLineLookups { 100000 };
+
+static std::string MakeSource()
+{
+    std::string Result {};
+    Result.reserve(TextSize + 64);
+
+    for (uint32_t I = 0; Result.size() < TextSize; I++)
+    {
+        Result += "Table[" + std::to_string(I) + "] = { Id = " + std::to_string(I * 7) + ", Name = \"Row\" }\n";
+    }
+
+    return Result;
+}
+
+void RunText(Reporter& Results)
+{
+    const std::string Source { MakeSource() };
+    std::mt19937 Random { 2468 };
+
+    Stopwatch Timer;
+    Common::TextBuffer Buffer { Source };
+    const double Load { Timer.Seconds() };
+
+    // Typing moves the cursor now and then and otherwise inserts one character after
+    // another at the same place.
+    size_t Cursor { 0 };
+    Timer.Reset();
+    for (uint32_t I = 0; I < TextKeystrokes; I++)
+    {
+        if (I % 100 == 0)
+        {
+            Cursor = Random() % Buffer.Size();
+        }
+
+        Buffer.Insert(Cursor++, "x");
+    }
+
+    const double Typing { Timer.Seconds() };
+
+    // The same keystrokes against one contiguous string, which moves everything after the
+    // cursor on every insert.
+    std::string Contiguous { Source };
+    Timer.Reset();
+    for (uint32_t I = 0; I < TextBaselineKeystrokes; I++)
+    {
+        if (I % 100 == 0)
+        {
+            Cursor = Random() % Contiguous.size();
+        }
+
+        Contiguous.insert(Cursor++, 1, 'x');
+    }
+
+    const double Baseline { Timer.Seconds() };
+
+    size_t Checksum { 0 };
+    Timer.Reset();
+    for (uint32_t I = 0; I < TextLineLookups; I++)
+    {
+        Checksum += Buffer.LineStart(Random() % Buffer.LineCount());
+    }
+
+    const double Lines { Timer.Seconds() };
+
+    Timer.Reset();
+    const Common::TextBuffer Snapshot { Buffer.Snapshot() };
+    const double Snap { Timer.Microseconds() };
+
+    Timer.Reset();
+    const std::string Flattened { Snapshot.ToString() };
+    const double Flatten { Timer.Seconds() };
+
+    if (Flattened.size() != Source.size() + TextKeystrokes || Checksum == 0)
+    {
+        printf("Text buffer size mismatch.\n");
+    }
+
+    Results
+        .Add("text", "size", static_cast<double>(Source.size()) / (1024.0 * 1024.0), "MB")
+        .Add("text", "load", Load * 1000.0, "ms")
+        .Add("text", "typing.piece_table", static_cast<double>(TextKeystrokes) / Typing, "key/s")
+        .Add("text", "typing.contiguous", static_cast<double>(TextBaselineKeystrokes) / Baseline, "key/s")
+        .Add("text", "line_start", static_cast<double>(TextLineLookups) / Lines, "lookup/s")
+        .Add("text", "snapshot", Snap, "us")
+        .Add("text", "flatten", Flatten * 1000.0, "ms");
+}
+
+}
+}
@@ -0,0 +1,104 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Bench.h"
+#include "../Common/Trace.h"
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace Snippet
+{
+namespace Bench
+{
+
+static constexpr uint32_t TraceTimers { 2000000 };
+static constexpr uint32_t TraceThreads { 4 };
+
+static double TimeScopes(uint32_t Count)
+{
+    Stopwatch Timer;
+    for (uint32_t I = 0; I < Count; I++)
+    {
+        const Common::ScopedTimer Scope { "Bench" };
+    }
+
+    return Timer.Seconds();
+}
+
+void RunTrace(Reporter& Results)
+{
+    Common::Trace& Tracer { Common::Trace::Get() };
+    const bool WasEnabled { Tracer.IsEnabled() };
+
+    // What every instrumented function pays when tracing is off.
+    Tracer.SetEnabled(false);
+    const double Disabled { TimeScopes(TraceTimers) };
+
+    Tracer.SetEnabled(true);
+    const double Enabled { TimeScopes(TraceTimers) };
+
+    // Writers on several threads share the ring's head.
+    std::vector<std::thread> Threads {};
+    Stopwatch Timer;
+    for (uint32_t I = 0; I < TraceThreads; I++)
+    {
+        Threads.emplace_back([]() -> void
+            {
+                TimeScopes(TraceTimers / TraceThreads);
+            });
+    }
+
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+
+    const double Contended { Timer.Seconds() };
+
+    Timer.Reset();
+    const Common::Trace::Summary Summary { Tracer.Summarize("Bench") };
+    const double Summarize { Timer.Microseconds() };
+
+    Tracer.SetEnabled(WasEnabled);
+
+    // A writer lapped by the whole ring can finish last and leave a slot readers skip, so
+    // the ring may come back a few samples short of full.
+    if (Summary.Count == 0 || Summary.Count > Common::Trace::Capacity)
+    {
+        printf("Trace sample count mismatch.\n");
+    }
+
+    Results
+        .Add("trace", "timer.disabled", Disabled * 1e9 / TraceTimers, "ns")
+        .Add("trace", "timer.enabled", Enabled * 1e9 / TraceTimers, "ns")
+        .Add("trace", "timer.contended", Contended * 1e9 / TraceTimers, "ns")
+        .Add("trace", "summarize", Summarize / 1000.0, "ms");
+}
+
+}
+}
@@ -0,0 +1,297 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Bench.h"
+#include "../Common/Network/Protocol.h"
+#include "../Common/Network/Reactor.h"
+#include "../Common/Network/SharedChannel.h"
+#include "../Common/Network/Socket.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#if !defined(_WIN32)
+    #include <unistd.h>
+#endif
+
+namespace Snippet
+{
+namespace Bench
+{
+
+// Every size moves about this much data through each transport.
+static constexpr size_t BytesPerSize { 256 * 1024 * 1024 };
+static constexpr size_t MaxMessages { 200000 };
+// Small messages are written in batches of about this size, the way sessions flush them.
+static constexpr size_t BatchSize { 64 * 1024 };
+static constexpr size_t ReadSize { 64 * 1024 };
+
+static const size_t PayloadSizes[] { 64, 4 * 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024 };
+
+static std::string SizeName(size_t Size)
+{
+    if (Size >= 1024 * 1024)
+    {
+        return std::to_string(Size / (1024 * 1024)) + "mb";
+    }
+
+    if (Size >= 1024)
+    {
+        return std::to_string(Size / 1024) + "kb";
+    }
+
+    return std::to_string(Size) + "b";
+}
+
+// As many ExecutionResult messages with a payload of Size as fit in one batch.
+static std::vector<uint8_t> MakeBatch(size_t Size, size_t& Messages)
+{
+    const std::string Output(Size, 'x');
+    Common::Protocol::MessageWriter Writer {};
+    Messages = 0;
+
+    do
+    {
+        Common::Protocol::ExecutionResult Result {};
+        Result.Node = static_cast<Common::NodeID>(Messages + 1);
+        Result.Output = Output;
+        Writer.Write(Result);
+        Messages++;
+    } while (Writer.Size() < BatchSize);
+
+    return std::move(Writer.Buffer());
+}
+
+static bool Check(const Common::Protocol::MessageView& Message, size_t Size)
+{
+    Common::Protocol::ExecutionResult Result {};
+    return Common::Protocol::Decode(Message, Result) && Result.Output.size() == Size;
+}
+
+static void Report(Reporter& Results, const std::string& Transport, size_t Size, size_t Messages, double Seconds)
+{
+    const std::string Name { Transport + "." + SizeName(Size) };
+    Results
+        .Add("transport", Name + ".throughput", static_cast<double>(Messages * Size) / (1024.0 * 1024.0) / Seconds, "MB/s")
+        .Add("transport", Name + ".messages", static_cast<double>(Messages) / Seconds, "msg/s");
+}
+
+static void RunTCP(Reporter& Results, size_t Size, size_t Batches)
+{
+    const Common::Socket Listener { Common::Socket::ListenTCP("127.0.0.1", 0) };
+    const Common::Socket Writer { Common::Socket::ConnectTCP("127.0.0.1", Listener.LocalPort()) };
+    const Common::Socket Reader { Listener.Accept() };
+
+    if (!Writer.IsValid() || !Reader.IsValid())
+    {
+        printf("transport: failed to connect over loopback TCP.\n");
+        return;
+    }
+
+    size_t PerBatch { 0 };
+    const std::vector<uint8_t> Batch { MakeBatch(Size, PerBatch) };
+    const size_t Expected { Batches * PerBatch };
+
+    Stopwatch Timer {};
+    std::thread Producer([&]() -> void
+        {
+            for (size_t I = 0; I < Batches; I++)
+            {
+                size_t Offset { 0 };
+                while (Offset < Batch.size())
+                {
+                    const Common::IOResult Result { Writer.Send(Batch.data() + Offset, Batch.size() - Offset) };
+                    if (Result.Status != Common::IOStatus::Ok)
+                    {
+                        return;
+                    }
+
+                    Offset += Result.Bytes;
+                }
+            }
+        });
+
+    // Read the way a session does: append to a buffer, parse in place, drop what was used.
+    std::vector<uint8_t> Input {};
+    size_t Received { 0 };
+    bool Valid { true };
+
+    while (Valid && Received < Expected)
+    {
+        const size_t Offset { Input.size() };
+        Input.resize(Offset + ReadSize);
+
+        const Common::IOResult Result { Reader.Receive(Input.data() + Offset, ReadSize) };
+        Input.resize(Offset + Result.Bytes);
+
+        if (Result.Status != Common::IOStatus::Ok)
+        {
+            break;
+        }
+
+        Common::Protocol::MessageReader Parser { Input.data(), Input.size() };
+        Common::Protocol::MessageView Message {};
+        while (Parser.Next(Message) == Common::Protocol::ParseStatus::Ok)
+        {
+            Valid = Check(Message, Size) && Valid;
+            Received++;
+        }
+
+        Input.erase(Input.begin(), Input.begin() + Parser.Consumed());
+    }
+
+    Producer.join();
+    const double Seconds { Timer.Seconds() };
+
+    if (!Valid || Received != Expected)
+    {
+        printf("transport: tcp received %zu of %zu messages of %zu bytes.\n", Received, Expected, Size);
+        return;
+    }
+
+    Report(Results, "tcp", Size, Received, Seconds);
+}
+
+static void RunShared(Reporter& Results, size_t Size, size_t Batches)
+{
+#if defined(_WIN32)
+    (void)Results;
+    (void)Size;
+    (void)Batches;
+#else
+    Common::SharedChannel Writer { Common::SharedChannel::Create() };
+    if (!Writer.IsValid())
+    {
+        printf("transport: failed to create a shared channel.\n");
+        return;
+    }
+
+    // Both ends live in this process, so the reader opens duplicates of the handles a
+    // client would have received over the socket.
+    int Handles[Common::SharedChannel::HandleCount] {};
+    for (size_t I = 0; I < Common::SharedChannel::HandleCount; I++)
+    {
+        Handles[I] = dup(Writer.Handles()[I]);
+    }
+
+    Common::SharedChannel Reader { Common::SharedChannel::Open(Handles, Common::SharedChannel::HandleCount) };
+    if (!Reader.IsValid())
+    {
+        printf("transport: failed to open a shared channel.\n");
+        return;
+    }
+
+    size_t PerBatch { 0 };
+    const std::vector<uint8_t> Batch { MakeBatch(Size, PerBatch) };
+    const size_t Expected { Batches * PerBatch };
+    std::atomic<bool> Done { false };
+
+    Stopwatch Timer {};
+    std::thread Producer([&]() -> void
+        {
+            Common::Reactor Waiter {};
+            Waiter.Add(Writer.Doorbell(), Common::Reactor::Readable, [&Writer](uint32_t) -> void
+                {
+                    Writer.ClearDoorbell();
+                });
+
+            for (size_t I = 0; I < Batches && !Done; I++)
+            {
+                size_t Offset { 0 };
+                while (Offset < Batch.size() && !Done)
+                {
+                    Offset += Writer.Send(Batch.data() + Offset, Batch.size() - Offset);
+                    if (Offset < Batch.size())
+                    {
+                        Waiter.Poll(100);
+                    }
+                }
+            }
+
+            Waiter.Remove(Writer.Doorbell());
+        });
+
+    Common::Reactor Waiter {};
+    Waiter.Add(Reader.Doorbell(), Common::Reactor::Readable, [&Reader](uint32_t) -> void
+        {
+            Reader.ClearDoorbell();
+        });
+
+    size_t Received { 0 };
+    bool Valid { true };
+
+    while (Valid && Received < Expected)
+    {
+        Valid = Reader.Receive([&](const Common::Protocol::MessageView& Message) -> void
+            {
+                Valid = Check(Message, Size) && Valid;
+                Received++;
+            }) && Valid;
+
+        if (Received < Expected)
+        {
+            Waiter.Poll(100);
+        }
+    }
+
+    Done = true;
+    Producer.join();
+    Waiter.Remove(Reader.Doorbell());
+    const double Seconds { Timer.Seconds() };
+
+    if (!Valid || Received != Expected)
+    {
+        printf("transport: shm received %zu of %zu messages of %zu bytes.\n", Received, Expected, Size);
+        return;
+    }
+
+    Report(Results, "shm", Size, Received, Seconds);
+#endif
+}
+
+void RunTransport(Reporter& Results)
+{
+    for (size_t Size : PayloadSizes)
+    {
+        size_t PerBatch { 0 };
+        MakeBatch(Size, PerBatch);
+
+        const size_t Messages { std::min(MaxMessages, std::max<size_t>(16, BytesPerSize / Size)) };
+        const size_t Batches { std::max<size_t>(1, Messages / PerBatch) };
+
+        RunTCP(Results, Size, Batches);
+
+        if (Common::SharedChannel::IsSupported())
+        {
+            RunShared(Results, Size, Batches);
+        }
+    }
+}
+
+}
+}
@@ -25,36 +25,98 @@ SOFTWARE.
 */
 
 #include "Canvas.h"
+#include "../../Common/Trace.h"
+#include "../../Common/Unicode.h"
+#include "../Network/Remote.h"
 #include "Document.h"
 #include "Node.h"
 #include "OctaneGUI/OctaneGUI.h"
+#include "Registry.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
 
 namespace Snippet
 {
 namespace Controls
 {
 
+// Nodes smaller than this on screen, or any node when more than MaxDetailNodes are
+// visible, are drawn as a single filled rectangle.
+static constexpr float MinDetailHeight { 12.0f };
+static constexpr size_t MaxDetailNodes { 2000 };
+
+// How close, in content units, the mouse has to be to a port or an edge to grab it.
+static constexpr float PortRadius { 8.0f };
+static constexpr float EdgeTolerance { 6.0f };
+
+// The journal is folded into a fresh snapshot once it grows past this many bytes.
+static constexpr uint64_t CompactSize { 4 << 20 };
+
+static Common::Bounds GetBounds(const Common::Graph& Model, Common::NodeHandle Handle)
+{
+    const Common::Point Position { Model.GetPosition(Handle) };
+    const Common::Point Size { Model.GetSize(Handle) };
+    return { Position.X, Position.Y, Position.X + Size.X, Position.Y + Size.Y };
+}
+
 Canvas::Canvas(OctaneGUI::Window* Window)
     : OctaneGUI::Canvas(Window)
+    , m_Graph(std::make_shared<Common::Graph>())
 {
+    m_Anchor = Scrollable()->AddControl<OctaneGUI::Container>();
+
     SetOnCreateContextMenu([this](OctaneGUI::Control&, const std::shared_ptr<OctaneGUI::Menu>& ContextMenu) -> void
         {
             if (m_Hovered.expired())
             {
                 ContextMenu->AddItem("New Snippet", [this]() -> void
                     {
-                        const std::shared_ptr<Node> Node_ = Scrollable()->AddControl<Node>();
-                        Node_
-                            ->EditName()
-                            .SetPosition(GetWindow()->GetMousePosition());
-                        
-                        m_Nodes.push_back(Node_);
+                        const Common::ScopedTimer Timer { "Canvas::CreateNode" };
+                        const OctaneGUI::Vector2 Position { GetWindow()->GetMousePosition() };
+                        const Common::NodeHandle Handle { m_Graph->AddSnippet() };
+                        m_Graph->SetPosition(Handle, { Position.X, Position.Y });
+
+                        AddToIndex(Handle);
+                        const std::shared_ptr<Node> Item { Materialize(Handle) };
+                        Item->EditName();
+
+                        Common::JournalRecord Created {};
+                        Created.Kind = Common::JournalKind::CreateNode;
+                        Created.Node = Item->GetID();
+                        Created.Position = { Position.X, Position.Y };
+                        const std::string Name { OctaneGUI::String::ToMultiByte(Item->Name()) };
+                        Created.Text = Name;
+                        Record(Created);
                     });
+
+                if (m_Remote != nullptr && m_Remote->IsAvailable() && !m_Remote->IsRunning())
+                {
+                    ContextMenu->AddItem("Run Graph on Server", [this]() -> void
+                        {
+                            RunRemote();
+                        });
+                }
+
+                const OctaneGUI::Vector2 Mouse { ToContent(GetWindow()->GetMousePosition()) };
+                const Common::ConnectionHandle Edge { m_Edges.HitTest(Mouse.X, Mouse.Y, EdgeTolerance) };
+                if (Edge.IsValid())
+                {
+                    ContextMenu->AddItem("Disconnect", [this, Edge]() -> void
+                        {
+                            Disconnect(Edge);
+                        });
+                }
             }
             else
             {
                 ContextMenu
-                    ->AddItem("Rename", [this]() -> void
+                    ->AddItem("Run", [this]() -> void
+                        {
+                            Run(m_Hovered.lock());
+                        })
+                    .AddItem("Rename", [this]() -> void
                         {
                             m_Hovered.lock()->EditName();
                         })
@@ -68,25 +130,338 @@ Canvas::Canvas(OctaneGUI::Window* Window)
     Interaction()->SetAlwaysFocus(true);
 }
 
+bool Canvas::Save(const char* Path, std::string* Error)
+{
+    Document::Flush();
+
+    if (!Write(Path, Error))
+    {
+        return false;
+    }
+
+    // The saved project is as good a snapshot as any for the journal to start over from.
+    return !m_Journal.IsOpen() || m_Journal.Rebase(Path, Error);
+}
+
+bool Canvas::Write(const char* Path, std::string* Error)
+{
+    // Saving over the project that unopened nodes still read their sources from is fine:
+    // the new file is renamed into place, and the existing mapping keeps reading the old one.
+    const Common::ProjectFile::SourceSignature Source { [this](Common::NodeHandle Handle) -> std::string_view
+        {
+            return GetSource(Handle);
+        } };
+
+    return Common::ProjectFile::Save(*m_Graph, Path, Source, Error);
+}
+
+std::string_view Canvas::GetSource(Common::NodeHandle Handle) const
+{
+    // Nodes that were never opened still have their source in the project they were
+    // loaded from.
+    const std::unordered_map<uint64_t, uint32_t>::const_iterator It { m_Unloaded.find(Handle.Key()) };
+
+    if (It != m_Unloaded.end() && m_Project != nullptr)
+    {
+        return m_Project->GetNode(It->second).Source;
+    }
+
+    return m_Graph->GetSource(Handle);
+}
+
+bool Canvas::Load(const char* Path, std::string* Error)
+{
+    const std::shared_ptr<Common::ProjectFile> Project { std::make_shared<Common::ProjectFile>() };
+
+    if (!Project->Open(Path, Error))
+    {
+        return false;
+    }
+
+    // In a room, opening a project replaces the room's graph for everyone in it.
+    const bool Shared { m_Remote != nullptr && m_Remote->IsJoined() };
+    if (Shared)
+    {
+        m_Graph->ForEachNode([this](Common::NodeHandle, const Common::Graph::Node& Item) -> void
+            {
+                Common::JournalRecord Deleted {};
+                Deleted.Kind = Common::JournalKind::DeleteNode;
+                Deleted.Node = Item.ID;
+                m_Remote->Forward(Deleted);
+            });
+    }
+
+    Clear();
+
+    std::vector<Common::NodeHandle> Handles {};
+    Project->Load(*m_Graph, &Handles, false);
+    m_Edges.Rebuild(*m_Graph);
+
+    m_Project = Project;
+    for (uint32_t I = 0; I < Handles.size(); I++)
+    {
+        if (!m_Project->GetNode(I).Source.empty())
+        {
+            m_Unloaded[Handles[I].Key()] = I;
+        }
+
+        AddToIndex(Handles[I]);
+    }
+
+    // One widget is needed up front to find the content origin. The rest are created as
+    // they come into view.
+    if (!Handles.empty())
+    {
+        Materialize(Handles.front());
+    }
+
+    if (Shared)
+    {
+        m_Remote->Publish(*m_Graph, Sources());
+    }
+
+    Invalidate();
+    return !m_Journal.IsOpen() || m_Journal.Rebase(Path, Error);
+}
+
+bool Canvas::EnableAutosave(const std::string& Path, std::string* Error)
+{
+    const std::string JournalPath { Path + ".journal" };
+    m_Snapshot = Path + ".autosave";
+
+    size_t Valid { 0 };
+    Common::Journal::Read(JournalPath.c_str(), nullptr, &Valid);
+
+    if (Valid > 0)
+    {
+        Clear();
+
+        if (!Common::Journal::Recover(JournalPath.c_str(), *m_Graph, Error))
+        {
+            return false;
+        }
+
+        std::vector<Common::NodeHandle> Handles {};
+        m_Graph->ForEachNode([&Handles](Common::NodeHandle Handle, const Common::Graph::Node&) -> void
+            {
+                Handles.push_back(Handle);
+            });
+
+        for (Common::NodeHandle Handle : Handles)
+        {
+            AddToIndex(Handle);
+        }
+
+        m_Edges.Rebuild(*m_Graph);
+
+        if (!Handles.empty())
+        {
+            Materialize(Handles.front());
+        }
+
+        Invalidate();
+    }
+
+    if (!m_Journal.Open(JournalPath.c_str(), Error))
+    {
+        return false;
+    }
+
+    // Start the journal over from a snapshot of whatever was recovered.
+    return Compact(Error);
+}
+
+Canvas& Canvas::SetRemote(const std::shared_ptr<Client::Remote>& Remote)
+{
+    m_Remote = Remote;
+
+    if (m_Remote == nullptr)
+    {
+        return *this;
+    }
+
+    m_Remote
+        ->SetOnResult([this](const Client::Remote::Result& Result) -> void
+            {
+                switch (Result.Status)
+                {
+                case Common::Protocol::ResultStatus::Running: SetOutput(Result.Node, "Running...", false, true); break;
+                case Common::Protocol::ResultStatus::Success: SetOutput(Result.Node, Result.Log + Result.Output, false, false); break;
+                default: SetOutput(Result.Node, Result.Output, true, false); break;
+                }
+            })
+        .SetOnFinished([this](const Common::Protocol::ExecutionSummary* Summary, const std::string& Error) -> void
+            {
+                if (Summary != nullptr)
+                {
+                    char Buffer[128] {};
+                    snprintf(Buffer, sizeof(Buffer), "Ran %u nodes on the server in %.3f s: %u reused, %u failed, %u skipped.",
+                        Summary->Nodes, Summary->Seconds, Summary->Reused, Summary->Failed, Summary->Skipped);
+                    SetStatus(Buffer);
+                    return;
+                }
+
+                SetStatus("Run on the server failed: " + Error);
+
+                // Nodes that never got a result are left showing why.
+                std::vector<Common::NodeID> Unfinished {};
+                for (const std::pair<const Common::NodeID, Output>& Item : m_Outputs)
+                {
+                    if (Item.second.Running)
+                    {
+                        Unfinished.push_back(Item.first);
+                    }
+                }
+
+                for (Common::NodeID ID : Unfinished)
+                {
+                    SetOutput(ID, Error, true, false);
+                }
+            })
+        .SetOnEdit([this](const Common::JournalRecord& Record) -> void
+            {
+                ApplyRemote(Record);
+            })
+        .SetOnJoined([this](const Common::Protocol::Joined& Reply) -> void
+            {
+                if (Reply.Member == 0)
+                {
+                    SetStatus("Left the room.");
+                    return;
+                }
+
+                // Nodes made from here on cannot collide with those of the room's other members.
+                m_Graph->SetSite(Reply.Site);
+
+                char Buffer[64] {};
+                snprintf(Buffer, sizeof(Buffer), "Joined the room as member %u of %u.", Reply.Member, Reply.Members);
+                SetStatus(Buffer);
+
+                // A room nobody has put anything in yet takes this canvas's graph.
+                if (Reply.Fresh)
+                {
+                    Document::Flush();
+                    m_Remote->Publish(*m_Graph, Sources());
+                }
+            })
+        .SetOnStatus([this](const std::string& Status) -> void
+            {
+                SetStatus(Status);
+            });
+
+    return *this;
+}
+
+Canvas& Canvas::SetOnStatus(OnStatusSignature&& Fn)
+{
+    m_OnStatus = std::move(Fn);
+    return *this;
+}
+
 std::weak_ptr<OctaneGUI::Control> Canvas::GetControl(const OctaneGUI::Vector2&) const
 {
     return Interaction();
 }
 
+void Canvas::Update()
+{
+    // The canvas is updated once per frame, so the time between updates is the frame time.
+    Common::Trace& Tracer { Common::Trace::Get() };
+    if (Tracer.IsEnabled())
+    {
+        const uint64_t Now { Common::Trace::Now() };
+        if (m_LastFrame != 0)
+        {
+            Tracer.Record("Frame", m_LastFrame, Now - m_LastFrame);
+        }
+        m_LastFrame = Now;
+    }
+
+    OctaneGUI::Canvas::Update();
+    ApplyDrag();
+
+    if (m_Remote != nullptr)
+    {
+        m_Remote->Update();
+    }
+
+    UpdateVisible();
+
+    if (m_Edges.Update(*m_Graph) > 0)
+    {
+        Invalidate();
+    }
+
+    if (m_CompactPending)
+    {
+        std::string Error {};
+        if (!Compact(&Error))
+        {
+            SetStatus("Failed to compact journal: " + Error);
+        }
+    }
+}
+
 void Canvas::OnPaint(OctaneGUI::Paint& Brush) const
 {
+    const Common::ScopedTimer Timer { "Canvas::OnPaint" };
     OctaneGUI::Canvas::OnPaint(Brush);
 
+    PaintEdges(Brush);
     PaintSelected(Brush, m_Hovered.lock());
 
-    for (const std::weak_ptr<Node>& Selected : m_Selected)
+    // Only nodes on screen can show a highlight, so the visible ones are checked against
+    // the selection rather than the other way around. While dragging out a box, nodes it
+    // touches are highlighted as if they were already selected.
+    const bool Boxing { m_Action == Action::BoxSelect };
+    const Common::Bounds Box { Boxing ? GetBox() : Common::Bounds {} };
+
+    for (const std::weak_ptr<Node>& Item : m_Visible)
+    {
+        const std::shared_ptr<Node> Node_ { Item.lock() };
+
+        if (Node_ == nullptr)
+        {
+            continue;
+        }
+
+        const Common::NodeHandle Handle { Node_->GetHandle() };
+        if (m_Selected.Contains(Handle) || (Boxing && Box.Intersects(GetBounds(*m_Graph, Handle))))
+        {
+            PaintSelected(Brush, Node_);
+        }
+    }
+
+    if (Boxing)
+    {
+        const OctaneGUI::Rect Area {
+            std::min(m_BoxStart.X, m_BoxEnd.X),
+            std::min(m_BoxStart.Y, m_BoxEnd.Y),
+            std::max(m_BoxStart.X, m_BoxEnd.X),
+            std::max(m_BoxStart.Y, m_BoxEnd.Y)
+        };
+
+        Brush.Rectangle(Area, { 255, 255, 0, 32 });
+        Brush.RectangleOutline(Area, { 255, 255, 0, 255 }, 1.0f);
+    }
+
+    // Input latency is measured from the first mouse movement since the last paint to the
+    // paint that shows it.
+    if (m_InputPending != 0)
     {
-        PaintSelected(Brush, Selected.lock());
+        Common::Trace::Get().Record("Input", m_InputPending, Common::Trace::Now() - m_InputPending);
+        m_InputPending = 0;
     }
 }
 
 void Canvas::OnMouseMove(const OctaneGUI::Vector2& Position)
 {
+    const Common::ScopedTimer Timer { "Canvas::OnMouseMove" };
+    if (m_InputPending == 0 && Common::Trace::Get().IsEnabled())
+    {
+        m_InputPending = Common::Trace::Now();
+    }
+
     OctaneGUI::Canvas::OnMouseMove(Position);
 
     const OctaneGUI::Vector2 Delta { Position - m_LastMousePos };
@@ -96,7 +471,16 @@ void Canvas::OnMouseMove(const OctaneGUI::Vector2& Position)
     {
     case Action::MoveNodes:
     {
-        MoveSelected(Delta);
+        // Applied once per frame in Update, however many mouse events arrive in between.
+        m_DragDelta += Delta;
+    }
+    break;
+
+    case Action::BoxSelect:
+    case Action::Connect:
+    {
+        m_BoxEnd = Position;
+        Invalidate();
     }
     break;
 
@@ -104,17 +488,7 @@ void Canvas::OnMouseMove(const OctaneGUI::Vector2& Position)
     {
         if (GetAction() == OctaneGUI::Canvas::Action::None)
         {
-            std::shared_ptr<Node> Hovered { nullptr };
-
-            for (const std::shared_ptr<Node>& Node_ : m_Nodes)
-            {
-                if (Node_->Contains(Position))
-                {
-                    Hovered = Node_;
-                }
-            }
-
-            SetHovered(Hovered);
+            SetHovered(GetNode(Position));
         }
     }
     break;
@@ -131,27 +505,65 @@ bool Canvas::OnMousePressed(const OctaneGUI::Vector2& Position, OctaneGUI::Mouse
     {
     case OctaneGUI::Mouse::Button::Left:
     {
-        ClearSelected();
-
         const std::shared_ptr<Node> Hovered { m_Hovered.lock() };
         if (Count == OctaneGUI::Mouse::Count::Single)
         {
-            if (Hovered != nullptr)
+            const Common::PortHandle Output { Hovered != nullptr ? GetPort(*Hovered, Position, Common::PortKind::Output) : Common::PortHandle {} };
+            m_SelectedEdge = {};
+
+            if (Output.IsValid())
+            {
+                // Dragging from an output port draws a new connection.
+                m_ConnectFrom = Output;
+                m_BoxEnd = Position;
+                SetAction(Action::Connect);
+                OctaneGUI::Canvas::SetAction(OctaneGUI::Canvas::Action::None);
+            }
+            else if (Hovered != nullptr)
+            {
+                // Shift-click toggles a node. A plain click on a selected node drags the
+                // whole selection, and on any other node selects just that one.
+                const Common::NodeHandle Handle { Hovered->GetHandle() };
+                if (IsExtending())
+                {
+                    if (!m_Selected.Remove(Handle))
+                    {
+                        m_Selected.Insert(Handle);
+                    }
+                }
+                else if (!m_Selected.Contains(Handle))
+                {
+                    ClearSelected();
+                    m_Selected.Insert(Handle);
+                }
+
+                SetAction(m_Selected.Contains(Handle) ? Action::MoveNodes : Action::None);
+                OctaneGUI::Canvas::SetAction(OctaneGUI::Canvas::Action::None);
+                Invalidate();
+            }
+            else if (IsExtending())
             {
-                SetAction(Action::MoveNodes);
-                AddSelected(m_Hovered.lock());
+                // Shift-dragging on empty space draws a selection box instead of panning.
+                m_BoxStart = Position;
+                m_BoxEnd = Position;
+                SetAction(Action::BoxSelect);
                 OctaneGUI::Canvas::SetAction(OctaneGUI::Canvas::Action::None);
             }
             else
             {
+                ClearSelected();
                 SetAction(Action::None);
+
+                const OctaneGUI::Vector2 Local { ToContent(Position) };
+                m_SelectedEdge = m_Edges.HitTest(Local.X, Local.Y, EdgeTolerance);
             }
         }
         else if (Count == OctaneGUI::Mouse::Count::Double)
         {
+            ClearSelected();
             SetAction(Action::None);
             OctaneGUI::Canvas::SetAction(OctaneGUI::Canvas::Action::None);
-            Document::Open(GetWindow()->App(), m_Hovered.lock());
+            Open(m_Hovered.lock());
         }
     }
     break;
@@ -165,6 +577,49 @@ bool Canvas::OnMousePressed(const OctaneGUI::Vector2& Position, OctaneGUI::Mouse
 void Canvas::OnMouseReleased(const OctaneGUI::Vector2& Position, OctaneGUI::Mouse::Button Button)
 {
     OctaneGUI::Canvas::OnMouseReleased(Position, Button);
+
+    // A drag is journaled once, with where the nodes ended up. Widgets that were off
+    // screen during the drag are only moved now.
+    if (m_Action == Action::MoveNodes)
+    {
+        ApplyDrag();
+
+        if (m_Moved)
+        {
+            m_Selected.ForEach([this](Common::NodeHandle Handle) -> void
+                {
+                    const std::shared_ptr<Node> Item { Registry::Get().Find(m_Graph->GetID(Handle)) };
+                    if (Item != nullptr)
+                    {
+                        SyncPosition(*Item);
+                    }
+
+                    Common::JournalRecord Moved {};
+                    Moved.Kind = Common::JournalKind::MoveNode;
+                    Moved.Node = m_Graph->GetID(Handle);
+                    Moved.Position = m_Graph->GetPosition(Handle);
+                    Record(Moved);
+                });
+        }
+    }
+    else if (m_Action == Action::BoxSelect)
+    {
+        m_BoxEnd = Position;
+        SelectBox();
+    }
+    else if (m_Action == Action::Connect)
+    {
+        const std::shared_ptr<Node> Target { GetNode(Position) };
+        if (Target != nullptr)
+        {
+            Connect(m_ConnectFrom, GetPort(*Target, Position, Common::PortKind::Input, true));
+        }
+
+        m_ConnectFrom = {};
+        Invalidate();
+    }
+
+    m_Moved = false;
     SetAction(Action::None);
 }
 
@@ -191,101 +646,812 @@ Canvas& Canvas::SetAction(Canvas::Action Action)
     return *this;
 }
 
-Canvas& Canvas::AddSelected(const std::shared_ptr<Node>& Node_)
+Canvas& Canvas::ClearSelected()
 {
-    if (Node_ == nullptr)
-    {
-        return *this;
-    }
-
-    bool Found { false };
-
-    for (const std::weak_ptr<Node>& Item : m_Selected)
-    {
-        if (Item.lock() == Node_)
-        {
-            Found = true;
-            break;
-        }
-    }
-
-    if (!Found)
-    {
-        m_Selected.push_back(Node_);
-        Invalidate();
-    }
-
+    m_Selected.Clear();
+    Invalidate();
     return *this;
 }
 
-Canvas& Canvas::ClearSelected()
+Canvas& Canvas::SelectBox()
 {
-    m_Selected.clear();
+    // The box adds to the selection, which is what holding shift to draw it implies.
+    m_Index.Query(GetBox(), [this](NodeIndex::Handle, Common::NodeHandle Handle) -> void
+        {
+            m_Selected.Insert(Handle);
+        });
+
     Invalidate();
     return *this;
 }
 
 Canvas& Canvas::MoveSelected(const OctaneGUI::Vector2& Delta)
 {
-    if (m_Selected.empty())
+    const Common::ScopedTimer Timer { "Canvas::MoveSelected" };
+
+    if (m_Selected.Empty())
     {
         return *this;
     }
 
-    for (std::vector<std::weak_ptr<Node>>::iterator It = m_Selected.begin(); It != m_Selected.end();)
+    // The whole selection is translated in the model and the index. Widgets are only moved
+    // if they are on screen; the rest are synced when they come into view or the drag ends,
+    // so a frame of dragging never lays out more widgets than are visible.
+    // Everyone else in a room sees the selection move while it is dragged.
+    const bool Shared { m_Remote != nullptr && m_Remote->IsJoined() };
+    m_Selected.ForEach([this, &Delta, Shared](Common::NodeHandle Handle) -> void
+        {
+            const Common::Point Position { m_Graph->GetPosition(Handle) };
+            const Common::Point Moved { Position.X + Delta.X, Position.Y + Delta.Y };
+            m_Graph->SetPosition(Handle, Moved);
+            UpdateIndex(Handle);
+
+            if (Shared)
+            {
+                m_Remote->Move(m_Graph->GetID(Handle), Moved);
+            }
+        });
+
+    for (const std::weak_ptr<Node>& Item : m_Visible)
     {
-        const std::shared_ptr<Node> Node_ { (*It).lock() };
+        const std::shared_ptr<Node> Node_ { Item.lock() };
 
-        if (Node_ != nullptr)
-        {
-            const OctaneGUI::Vector2 NodePos { Node_->GetPosition() };
-            Node_->SetPosition(NodePos + Delta);
-            ++It;
-        }
-        else
+        if (Node_ != nullptr && m_Selected.Contains(Node_->GetHandle()))
         {
-            It = m_Selected.erase(It);
+            SyncPosition(*Node_);
         }
     }
 
+    m_Moved = true;
     Invalidate();
 
     return *this;
 }
 
-Canvas& Canvas::Remove(const std::shared_ptr<Node>& Item)
+Canvas& Canvas::ApplyDrag()
 {
-    for (std::vector<std::shared_ptr<Node>>::iterator It { m_Nodes.begin() }; It != m_Nodes.end(); ++It)
+    if (m_DragDelta.IsZero())
     {
-        if ((*It) == Item)
-        {
-            m_Nodes.erase(It);
-            break;
-        }
+        return *this;
     }
 
-    Scrollable()->RemoveControl(Item);
-    Document::Close(GetWindow()->App(), Item);
-
-    return RemoveSelected(Item);
+    const OctaneGUI::Vector2 Delta { m_DragDelta };
+    m_DragDelta = {};
+    return MoveSelected(Delta);
 }
 
-Canvas& Canvas::RemoveSelected(const std::shared_ptr<Node>& Item)
+Canvas& Canvas::SyncPosition(Node& Item)
 {
-    for (std::vector<std::weak_ptr<Node>>::iterator It { m_Selected.begin() }; It != m_Selected.end(); ++It)
-    {
-        const std::shared_ptr<Node> Node_ { (*It).lock() };
+    const Common::Point Position { m_Graph->GetPosition(Item.GetHandle()) };
+    const OctaneGUI::Vector2 Target { Position.X, Position.Y };
 
-        if (Node_ == Item)
-        {
-            m_Selected.erase(It);
-            break;
-        }
+    if (Item.GetPosition() != Target)
+    {
+        Item.SetPosition(Target);
     }
 
     return *this;
 }
 
+Canvas& Canvas::Run(const std::shared_ptr<Node>& Item)
+{
+    if (Item == nullptr)
+    {
+        return *this;
+    }
+
+    Document::Flush();
+    LoadSource(Item->GetHandle());
+
+    // Compiling is a no-op when the source is unchanged since the last run, so the
+    // cached bytecode is reused on repeated runs.
+    const Common::NodeID ID { Item->GetID() };
+    std::string Error {};
+    if (!m_Engine.Compile(ID, OctaneGUI::String::ToMultiByte(Item->Name()), Item->Source(), &Error))
+    {
+        return SetOutput(ID, Error, true);
+    }
+
+    const Common::RunResult Result { m_Engine.Run(ID, {}) };
+    return Result.Success ? SetOutput(ID, Result.Log + Result.Output, false) : SetOutput(ID, Result.Error, true);
+}
+
+Canvas& Canvas::RunRemote()
+{
+    Document::Flush();
+
+    std::string Error {};
+    if (!m_Remote->Execute(*m_Graph, Sources(), &Error))
+    {
+        SetStatus("Failed to run the graph on the server: " + Error);
+    }
+
+    return *this;
+}
+
+Canvas& Canvas::SetStatus(const std::string& Message)
+{
+    if (m_OnStatus)
+    {
+        m_OnStatus(Message);
+    }
+
+    return *this;
+}
+
+Canvas& Canvas::SetOutput(Common::NodeID ID, const std::string& Text, bool Error, bool Running)
+{
+    Output& Last { m_Outputs[ID] };
+    Last.Text = Text;
+    Last.Error = Error;
+    Last.Running = Running;
+
+    const std::shared_ptr<Node> Item { Registry::Get().Find(ID) };
+    if (Item != nullptr)
+    {
+        Item->SetOutput(Text, Error);
+    }
+
+    return *this;
+}
+
+Canvas& Canvas::Open(const std::shared_ptr<Node>& Item)
+{
+    if (Item == nullptr)
+    {
+        return *this;
+    }
+
+    LoadSource(Item->GetHandle());
+    Document::Open(GetWindow()->App(), Item);
+    return *this;
+}
+
+Canvas& Canvas::LoadSource(Common::NodeHandle Handle)
+{
+    const std::unordered_map<uint64_t, uint32_t>::const_iterator It { m_Unloaded.find(Handle.Key()) };
+
+    if (It == m_Unloaded.end())
+    {
+        return *this;
+    }
+
+    if (m_Project != nullptr)
+    {
+        // Not an edit, so this goes straight to the model rather than through the journal.
+        m_Graph->SetSource(Handle, std::string { m_Project->GetNode(It->second).Source });
+    }
+
+    m_Unloaded.erase(It);
+    return *this;
+}
+
+Canvas& Canvas::Remove(const std::shared_ptr<Node>& Item)
+{
+    if (Item == nullptr)
+    {
+        return *this;
+    }
+
+    Common::JournalRecord Deleted {};
+    Deleted.Kind = Common::JournalKind::DeleteNode;
+    Deleted.Node = Item->GetID();
+    Record(Deleted);
+
+    return Erase(Item->GetHandle());
+}
+
+Canvas& Canvas::Erase(Common::NodeHandle Handle)
+{
+    const Common::NodeID ID { m_Graph->GetID(Handle) };
+    const std::shared_ptr<Node> Item { Registry::Get().Find(ID) };
+
+    // The document pool finds the node's window through the registry, so the window is
+    // closed before the node is unregistered.
+    if (Item != nullptr)
+    {
+        Document::Close(GetWindow()->App(), Item);
+        Scrollable()->RemoveControl(Item);
+    }
+
+    m_Selected.Remove(Handle);
+
+    RemoveFromIndex(Handle);
+    m_Edges.RemoveNode(*m_Graph, Handle);
+    m_Engine.Forget(ID);
+    m_Graph->RemoveNode(Handle);
+    Registry::Get().Remove(ID);
+    m_Outputs.erase(ID);
+    m_Unloaded.erase(Handle.Key());
+
+    return *this;
+}
+
+Canvas& Canvas::Clear()
+{
+    Registry::Get().ForEach([this](Common::NodeID, const std::shared_ptr<Node>& Item) -> void
+        {
+            Scrollable()->RemoveControl(Item);
+            Document::Close(GetWindow()->App(), Item);
+        });
+
+    for (const std::pair<const uint64_t, NodeIndex::Handle>& Item : m_IndexHandles)
+    {
+        m_Index.Remove(Item.second);
+    }
+
+    Registry::Get().Clear();
+    m_IndexHandles.clear();
+    m_Edges.Clear();
+    m_SelectedEdge = {};
+    m_Selected.Clear();
+    m_Visible.clear();
+    m_Hovered.reset();
+    m_Unloaded.clear();
+    m_Outputs.clear();
+    m_Project = nullptr;
+    m_Graph->Clear();
+    m_VisibleDirty = true;
+
+    if (m_Remote != nullptr)
+    {
+        m_Remote->Invalidate();
+    }
+
+    return *this;
+}
+
+Canvas& Canvas::Connect(Common::PortHandle From, Common::PortHandle To)
+{
+    const Common::Graph::Port* Output { m_Graph->GetPort(From) };
+
+    if (Output == nullptr)
+    {
+        return *this;
+    }
+
+    for (Common::ConnectionHandle Existing : Output->Connections)
+    {
+        if (m_Graph->GetConnection(Existing)->To == To)
+        {
+            return *this;
+        }
+    }
+
+    const Common::ConnectionHandle ID { m_Graph->Connect(From, To) };
+    if (ID.IsValid())
+    {
+        m_Edges.Add(*m_Graph, ID);
+        Record(Common::Journal::Link(Common::JournalKind::Connect, *m_Graph, ID));
+        Invalidate();
+    }
+
+    return *this;
+}
+
+Canvas& Canvas::Disconnect(Common::ConnectionHandle ID)
+{
+    if (!m_Graph->IsValid(ID))
+    {
+        return *this;
+    }
+
+    Record(Common::Journal::Link(Common::JournalKind::Disconnect, *m_Graph, ID));
+    m_Edges.Remove(ID);
+    m_Graph->Disconnect(ID);
+
+    if (m_SelectedEdge == ID)
+    {
+        m_SelectedEdge = {};
+    }
+
+    Invalidate();
+    return *this;
+}
+
+Common::PortHandle Canvas::GetPort(const Node& Item, const OctaneGUI::Vector2& Position, Common::PortKind Kind, bool Nearest) const
+{
+    const OctaneGUI::Vector2 Local { ToContent(Position) };
+    Common::PortHandle Result {};
+    float Closest { Nearest ? std::numeric_limits<float>::max() : PortRadius * PortRadius };
+
+    for (Common::PortHandle Port : m_Graph->GetPorts(Item.GetHandle()))
+    {
+        const Common::Graph::Port* Info { m_Graph->GetPort(Port) };
+
+        if (Info == nullptr || Info->Kind != Kind)
+        {
+            continue;
+        }
+
+        const Common::Point Anchor { Common::EdgeCache::GetAnchor(*m_Graph, Port) };
+        const float X { Anchor.X - Local.X };
+        const float Y { Anchor.Y - Local.Y };
+        const float Distance { X * X + Y * Y };
+
+        if (Distance <= Closest)
+        {
+            Closest = Distance;
+            Result = Port;
+        }
+    }
+
+    return Result;
+}
+
+Canvas& Canvas::Record(const Common::JournalRecord& Record)
+{
+    if (m_Remote != nullptr)
+    {
+        m_Remote->Forward(Record);
+    }
+
+    return Append(Record);
+}
+
+Canvas& Canvas::Append(const Common::JournalRecord& Record)
+{
+    if (!m_Journal.IsOpen())
+    {
+        return *this;
+    }
+
+    m_Journal.Append(Record);
+    m_CompactPending = m_CompactPending || m_Journal.Size() >= CompactSize;
+    return *this;
+}
+
+Canvas& Canvas::ApplyRemote(const Common::JournalRecord& Record)
+{
+    const Common::NodeHandle Handle { m_Graph->Find(Record.Node) };
+
+    switch (Record.Kind)
+    {
+    // The room's graph follows and replaces this one. The journal is started over from a
+    // snapshot once it is in.
+    case Common::JournalKind::Base:
+    {
+        Clear();
+        m_CompactPending = m_Journal.IsOpen();
+        Invalidate();
+    }
+    return *this;
+
+    case Common::JournalKind::CreateNode:
+    {
+        if (Handle.IsValid())
+        {
+            return *this;
+        }
+
+        // The widget is created when the node comes into view.
+        const Common::NodeHandle Created { m_Graph->AddSnippet(Record.Node) };
+        m_Graph
+            ->SetPosition(Created, Record.Position)
+            .SetName(Created, Common::ToUTF32(Record.Text));
+        AddToIndex(Created);
+    }
+    break;
+
+    case Common::JournalKind::DeleteNode:
+    {
+        if (!Handle.IsValid())
+        {
+            return *this;
+        }
+
+        Erase(Handle);
+    }
+    break;
+
+    case Common::JournalKind::MoveNode:
+    {
+        if (!Handle.IsValid())
+        {
+            return *this;
+        }
+
+        m_Graph->SetPosition(Handle, Record.Position);
+        UpdateIndex(Handle);
+
+        const std::shared_ptr<Node> Item { Registry::Get().Find(Record.Node) };
+        if (Item != nullptr)
+        {
+            SyncPosition(*Item);
+        }
+    }
+    break;
+
+    case Common::JournalKind::RenameNode:
+    {
+        if (!Handle.IsValid())
+        {
+            return *this;
+        }
+
+        const std::u32string Name { Common::ToUTF32(Record.Text) };
+        const std::shared_ptr<Node> Item { Registry::Get().Find(Record.Node) };
+        if (Item != nullptr)
+        {
+            Item->SetName(Name.c_str());
+        }
+        else
+        {
+            m_Graph->SetName(Handle, Name);
+        }
+    }
+    break;
+
+    case Common::JournalKind::EditSource:
+    {
+        if (!Handle.IsValid())
+        {
+            return *this;
+        }
+
+        // Edits typed into the node's document were sent ahead of this one, and the room
+        // has transformed it against them, so the model has to have them first.
+        LoadSource(Handle);
+        Document::Flush(Record.Node);
+
+        std::string Source { m_Graph->GetSource(Handle) };
+        if (Record.Offset > Source.size() || Record.Removed > Source.size() - Record.Offset)
+        {
+            return *this;
+        }
+
+        Source.replace(Record.Offset, Record.Removed, Record.Text);
+        m_Graph->SetSource(Handle, Source);
+
+        const std::shared_ptr<Node> Item { Registry::Get().Find(Record.Node) };
+        if (Item != nullptr)
+        {
+            Document::Patch(GetWindow()->App(), Item, { Record.Offset, Record.Removed, Record.Text });
+        }
+    }
+    break;
+
+    case Common::JournalKind::Connect:
+    case Common::JournalKind::Disconnect:
+    {
+        const Common::NodeHandle Target { m_Graph->Find(Record.Target) };
+
+        if (!Handle.IsValid() || !Target.IsValid())
+        {
+            return *this;
+        }
+
+        const std::vector<Common::PortHandle>& Outputs { m_Graph->GetPorts(Handle) };
+        const std::vector<Common::PortHandle>& Inputs { m_Graph->GetPorts(Target) };
+
+        if (Record.Port >= Outputs.size() || Record.TargetPort >= Inputs.size())
+        {
+            return *this;
+        }
+
+        const Common::PortHandle To { Inputs[Record.TargetPort] };
+        Common::ConnectionHandle Existing {};
+
+        for (Common::ConnectionHandle ID : m_Graph->GetPort(Outputs[Record.Port])->Connections)
+        {
+            if (m_Graph->GetConnection(ID)->To == To)
+            {
+                Existing = ID;
+            }
+        }
+
+        if (Record.Kind == Common::JournalKind::Connect && !Existing.IsValid())
+        {
+            const Common::ConnectionHandle ID { m_Graph->Connect(Outputs[Record.Port], To) };
+
+            if (!ID.IsValid())
+            {
+                return *this;
+            }
+
+            m_Edges.Add(*m_Graph, ID);
+        }
+        else if (Record.Kind == Common::JournalKind::Disconnect && Existing.IsValid())
+        {
+            m_Edges.Remove(Existing);
+            m_Graph->Disconnect(Existing);
+
+            if (m_SelectedEdge == Existing)
+            {
+                m_SelectedEdge = {};
+            }
+        }
+        else
+        {
+            return *this;
+        }
+    }
+    break;
+
+    default: return *this;
+    }
+
+    Invalidate();
+    return Append(Record);
+}
+
+Common::ProjectFile::SourceSignature Canvas::Sources() const
+{
+    return [this](Common::NodeHandle Handle) -> std::string_view
+    {
+        return GetSource(Handle);
+    };
+}
+
+bool Canvas::Compact(std::string* Error)
+{
+    Document::Flush();
+    m_CompactPending = false;
+    return Write(m_Snapshot.c_str(), Error) && m_Journal.Rebase(m_Snapshot, Error);
+}
+
+Canvas& Canvas::AddToIndex(Common::NodeHandle Handle)
+{
+    m_IndexHandles[Handle.Key()] = m_Index.Insert(Handle, GetBounds(*m_Graph, Handle));
+    m_VisibleDirty = true;
+    return *this;
+}
+
+Canvas& Canvas::UpdateNode(const Node& Item)
+{
+    const OctaneGUI::Vector2 Position { Item.GetPosition() };
+    const OctaneGUI::Vector2 Size { Item.GetSize() };
+    m_Graph
+        ->SetPosition(Item.GetHandle(), { Position.X, Position.Y })
+        .SetSize(Item.GetHandle(), { Size.X, Size.Y });
+
+    return UpdateIndex(Item.GetHandle());
+}
+
+Canvas& Canvas::UpdateIndex(Common::NodeHandle Handle)
+{
+    const std::unordered_map<uint64_t, NodeIndex::Handle>::const_iterator It { m_IndexHandles.find(Handle.Key()) };
+
+    if (It != m_IndexHandles.end())
+    {
+        m_Index.Update(It->second, GetBounds(*m_Graph, Handle));
+        m_VisibleDirty = true;
+    }
+
+    m_Edges.Invalidate(*m_Graph, Handle);
+    return *this;
+}
+
+Canvas& Canvas::RemoveFromIndex(Common::NodeHandle Handle)
+{
+    const std::unordered_map<uint64_t, NodeIndex::Handle>::const_iterator It { m_IndexHandles.find(Handle.Key()) };
+
+    if (It != m_IndexHandles.end())
+    {
+        m_Index.Remove(It->second);
+        m_IndexHandles.erase(It);
+        m_VisibleDirty = true;
+    }
+
+    return *this;
+}
+
+std::shared_ptr<Node> Canvas::Materialize(Common::NodeHandle Handle)
+{
+    const Common::NodeID ID { m_Graph->GetID(Handle) };
+    const std::shared_ptr<Node> Existing { Registry::Get().Find(ID) };
+
+    if (Existing != nullptr)
+    {
+        return Existing;
+    }
+
+    // The widget is placed before it is bound to the model, so that the resize triggered
+    // by binding writes back the position the model already has.
+    const Common::Point Position { m_Graph->GetPosition(Handle) };
+    const std::shared_ptr<Node> Result = Scrollable()->AddControl<Node>();
+    Result->SetPosition({ Position.X, Position.Y });
+    Result
+        ->SetOnResized([this](Node& Item) -> void
+            {
+                UpdateNode(Item);
+            })
+        .SetOnRenamed([this](Node& Item) -> void
+            {
+                Common::JournalRecord Renamed {};
+                Renamed.Kind = Common::JournalKind::RenameNode;
+                Renamed.Node = Item.GetID();
+                const std::string Name { OctaneGUI::String::ToMultiByte(Item.Name()) };
+                Renamed.Text = Name;
+                Record(Renamed);
+            })
+        .SetOnSourceEdited([this](Node& Item, const Common::TextBuffer::Splice& Edit) -> void
+            {
+                Record(Common::Journal::Edit(Item.GetID(), Edit));
+            })
+        .SetModel(m_Graph, Handle);
+
+    const std::unordered_map<Common::NodeID, Output>::const_iterator Last { m_Outputs.find(ID) };
+    if (Last != m_Outputs.end())
+    {
+        Result->SetOutput(Last->second.Text, Last->second.Error);
+    }
+
+    // New widgets start culled and are picked up by the next visibility pass.
+    Result->SetCulled(true);
+    Registry::Get().Add(ID, Result);
+    return Result;
+}
+
+Canvas& Canvas::Release(const std::shared_ptr<Node>& Item)
+{
+    // The document pool finds a node's window through the registry, and a name being
+    // edited is only in the widget, so those keep their widget while out of view.
+    const Common::NodeID ID { Item->GetID() };
+    if (Registry::Get().FindWindow(ID) != Registry::NoWindow || Item->IsEditingName())
+    {
+        return *this;
+    }
+
+    if (m_Hovered.lock() == Item)
+    {
+        m_Hovered.reset();
+    }
+
+    Scrollable()->RemoveControl(Item);
+    Registry::Get().Remove(ID);
+    return *this;
+}
+
+std::shared_ptr<Node> Canvas::GetNode(const OctaneGUI::Vector2& Position) const
+{
+    const OctaneGUI::Vector2 Local { ToContent(Position) };
+    const NodeIndex::Handle ID { m_Index.Query(Local.X, Local.Y) };
+
+    if (!m_Index.IsValid(ID))
+    {
+        return nullptr;
+    }
+
+    return Registry::Get().Find(m_Graph->GetID(m_Index.Get(ID)));
+}
+
+void Canvas::UpdateVisible()
+{
+    const OctaneGUI::Rect Viewport { GetAbsoluteBounds() };
+    const OctaneGUI::Vector2 Min { ToContent(Viewport.Min) };
+    const OctaneGUI::Vector2 Max { ToContent(Viewport.Max) };
+    const Common::Bounds View { Min.X, Min.Y, Max.X, Max.Y };
+
+    if (!m_VisibleDirty && View == m_VisibleBounds)
+    {
+        return;
+    }
+
+    m_VisibleBounds = View;
+    m_VisibleDirty = false;
+
+    // Cull everything that was visible last pass, then un-cull whatever the index reports
+    // inside the viewport, creating widgets for nodes that are not on screen yet. Widgets
+    // left culled have gone out of view and are released, so only nodes in view have a
+    // widget for layout, update and paint to walk.
+    std::vector<std::shared_ptr<Node>> Previous {};
+    Previous.reserve(m_Visible.size());
+    for (const std::weak_ptr<Node>& Item : m_Visible)
+    {
+        const std::shared_ptr<Node> Node_ { Item.lock() };
+
+        if (Node_ != nullptr)
+        {
+            Node_->SetCulled(true);
+            Previous.push_back(Node_);
+        }
+    }
+
+    std::vector<Common::NodeHandle> Handles {};
+    m_Index.Query(View, [&Handles](NodeIndex::Handle, Common::NodeHandle Handle) -> void
+        {
+            Handles.push_back(Handle);
+        });
+
+    m_Visible.clear();
+    for (Common::NodeHandle Handle : Handles)
+    {
+        m_Visible.push_back(Materialize(Handle));
+    }
+
+    // Node sizes are in content units, so they are scaled by how large the content is
+    // drawn to find how tall they are on screen.
+    const float ViewHeight { View.MaxY - View.MinY };
+    const float Scale { ViewHeight > 0.0f ? Viewport.GetSize().Y / ViewHeight : 1.0f };
+    const bool Simplify { m_Visible.size() > MaxDetailNodes };
+    for (const std::weak_ptr<Node>& Item : m_Visible)
+    {
+        const std::shared_ptr<Node> Node_ { Item.lock() };
+
+        if (Node_ != nullptr)
+        {
+            // Selected nodes dragged in from off screen have not had their widget moved yet.
+            if (m_Action == Action::MoveNodes && m_Selected.Contains(Node_->GetHandle()))
+            {
+                SyncPosition(*Node_);
+            }
+
+            Node_
+                ->SetCulled(false)
+                .SetSimplified(Simplify || Node_->GetSize().Y * Scale < MinDetailHeight);
+        }
+    }
+
+    for (const std::shared_ptr<Node>& Item : Previous)
+    {
+        if (Item->IsCulled())
+        {
+            Release(Item);
+        }
+    }
+}
+
+bool Canvas::IsExtending() const
+{
+    return GetWindow()->IsKeyPressed(OctaneGUI::Keyboard::Key::LeftShift)
+        || GetWindow()->IsKeyPressed(OctaneGUI::Keyboard::Key::RightShift);
+}
+
+Common::Bounds Canvas::GetBox() const
+{
+    const OctaneGUI::Vector2 Start { ToContent(m_BoxStart) };
+    const OctaneGUI::Vector2 End { ToContent(m_BoxEnd) };
+    return { std::min(Start.X, End.X), std::min(Start.Y, End.Y), std::max(Start.X, End.X), std::max(Start.Y, End.Y) };
+}
+
+OctaneGUI::Vector2 Canvas::GetOrigin() const
+{
+    // The anchor is a child of the scrollable container like every node, and is there even
+    // when no node has a widget. The indices store bounds relative to this origin so that
+    // panning the canvas does not require any updates.
+    return m_Anchor->GetAbsolutePosition() - m_Anchor->GetPosition();
+}
+
+OctaneGUI::Vector2 Canvas::ToContent(const OctaneGUI::Vector2& Position) const
+{
+    return Position - GetOrigin();
+}
+
+void Canvas::PaintEdges(OctaneGUI::Paint& Brush) const
+{
+    const OctaneGUI::Vector2 Origin { GetOrigin() };
+    const auto ToScreen = [&Origin](const Common::Point& Point) -> OctaneGUI::Vector2
+    {
+        return { Origin.X + Point.X, Origin.Y + Point.Y };
+    };
+
+    // Only the chunks of edges inside the last visibility pass are drawn. They go into the
+    // paint buffer back to back with nothing in between that would change its state, so all
+    // of them end up in the same draw call. Past the detail limit each chunk is one segment.
+    const bool Simplify { m_Visible.size() > MaxDetailNodes };
+    m_Edges.Query(m_VisibleBounds, [&](Common::ConnectionHandle ID, const Common::Point* Points, uint32_t Count) -> void
+        {
+            const OctaneGUI::Color LineColor { ID == m_SelectedEdge ? OctaneGUI::Color { 255, 255, 0, 255 } : OctaneGUI::Color { 160, 160, 160, 255 } };
+
+            if (Simplify)
+            {
+                Brush.Line(ToScreen(Points[0]), ToScreen(Points[Count - 1]), LineColor, 2.0f);
+                return;
+            }
+
+            for (uint32_t I = 1; I < Count; I++)
+            {
+                Brush.Line(ToScreen(Points[I - 1]), ToScreen(Points[I]), LineColor, 2.0f);
+            }
+        });
+
+    if (m_Action == Action::Connect)
+    {
+        Brush.Line(ToScreen(Common::EdgeCache::GetAnchor(*m_Graph, m_ConnectFrom)), m_BoxEnd, { 255, 255, 0, 255 }, 2.0f);
+    }
+}
+
 void Canvas::PaintSelected(OctaneGUI::Paint& Brush, const std::shared_ptr<Node>& Node_) const
 {
     if (Node_ == nullptr)
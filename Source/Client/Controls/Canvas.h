@@ -26,10 +26,25 @@ SOFTWARE.
 
 #pragma once
 
+#include "../../Common/Execution/Engine.h"
+#include "../../Common/Graph/EdgeCache.h"
+#include "../../Common/Graph/Graph.h"
+#include "../../Common/Graph/HandleSet.h"
+#include "../../Common/SpatialGrid.h"
+#include "../../Common/Storage/Journal.h"
+#include "../../Common/Storage/ProjectFile.h"
 #include "OctaneGUI/Controls/Canvas.h"
 
+#include <functional>
+#include <unordered_map>
+
 namespace Snippet
 {
+namespace Client
+{
+class Remote;
+}
+
 namespace Controls
 {
 
@@ -44,33 +59,141 @@ public:
     {
         None,
         MoveNodes,
+        BoxSelect,
+        Connect,
     };
 
+    using OnStatusSignature = std::function<void(const std::string&)>;
+
     Canvas(OctaneGUI::Window* Window);
 
+    bool Save(const char* Path, std::string* Error = nullptr);
+    bool Load(const char* Path, std::string* Error = nullptr);
+
+    // Journals every edit to Path + ".journal" and periodically compacts it into a
+    // snapshot at Path + ".autosave". An existing journal is replayed first, restoring
+    // the canvas as it was when the last session ended or crashed.
+    bool EnableAutosave(const std::string& Path, std::string* Error = nullptr);
+
+    // Mirrors every edit to Remote and offers to run the graph on the server whenever it
+    // is connected. Results are applied to the nodes as they stream in. Once Remote has
+    // joined a room, edits made by the room's other members are applied as they arrive.
+    Canvas& SetRemote(const std::shared_ptr<Client::Remote>& Remote);
+
+    // Called with a one line message whenever a run on the server finishes or fails, and
+    // when the autosave journal cannot be compacted.
+    Canvas& SetOnStatus(OnStatusSignature&& Fn);
+
     virtual std::weak_ptr<OctaneGUI::Control> GetControl(const OctaneGUI::Vector2& Point) const override;
 
+    virtual void Update() override;
     virtual void OnPaint(OctaneGUI::Paint& Brush) const override;
     virtual void OnMouseMove(const OctaneGUI::Vector2& Position) override;
     virtual bool OnMousePressed(const OctaneGUI::Vector2& Position, OctaneGUI::Mouse::Button Button, OctaneGUI::Mouse::Count Count) override;
     virtual void OnMouseReleased(const OctaneGUI::Vector2& Position, OctaneGUI::Mouse::Button Button) override;
 
 private:
+    using NodeIndex = Common::SpatialGrid<Common::NodeHandle>;
+
     Canvas& SetHovered(const std::shared_ptr<Node>& Hovered);
     Canvas& SetAction(Action Action_);
-    Canvas& AddSelected(const std::shared_ptr<Node>& Node_);
     Canvas& ClearSelected();
+    Canvas& SelectBox();
     Canvas& MoveSelected(const OctaneGUI::Vector2& Delta);
+    Canvas& ApplyDrag();
+    Canvas& SyncPosition(Node& Item);
+    Canvas& Run(const std::shared_ptr<Node>& Item);
+    Canvas& RunRemote();
+    Canvas& SetStatus(const std::string& Message);
+    Canvas& SetOutput(Common::NodeID ID, const std::string& Text, bool Error, bool Running = false);
+    Canvas& Open(const std::shared_ptr<Node>& Item);
+    Canvas& LoadSource(Common::NodeHandle Handle);
     Canvas& Remove(const std::shared_ptr<Node>& Item);
-    Canvas& RemoveSelected(const std::shared_ptr<Node>& Item);
-
+    Canvas& Erase(Common::NodeHandle Handle);
+    Canvas& Clear();
+    Canvas& Connect(Common::PortHandle From, Common::PortHandle To);
+    Canvas& Disconnect(Common::ConnectionHandle ID);
+    // The port of Kind on Item under Position, or with Nearest, the closest one anywhere.
+    Common::PortHandle GetPort(const Node& Item, const OctaneGUI::Vector2& Position, Common::PortKind Kind, bool Nearest = false) const;
+    Canvas& Record(const Common::JournalRecord& Record);
+    Canvas& Append(const Common::JournalRecord& Record);
+    // Applies an edit made by someone else in the room. It is journaled, but not sent back.
+    Canvas& ApplyRemote(const Common::JournalRecord& Record);
+    Common::ProjectFile::SourceSignature Sources() const;
+    bool Write(const char* Path, std::string* Error);
+    std::string_view GetSource(Common::NodeHandle Handle) const;
+    bool Compact(std::string* Error = nullptr);
+    Canvas& AddToIndex(Common::NodeHandle Handle);
+    Canvas& UpdateNode(const Node& Item);
+    Canvas& UpdateIndex(Common::NodeHandle Handle);
+    Canvas& RemoveFromIndex(Common::NodeHandle Handle);
+    std::shared_ptr<Node> Materialize(Common::NodeHandle Handle);
+    // Destroys the widget of a node that has left the view, unless it is still in use.
+    Canvas& Release(const std::shared_ptr<Node>& Item);
+    std::shared_ptr<Node> GetNode(const OctaneGUI::Vector2& Position) const;
+    void UpdateVisible();
+    bool IsExtending() const;
+    Common::Bounds GetBox() const;
+    OctaneGUI::Vector2 GetOrigin() const;
+    OctaneGUI::Vector2 ToContent(const OctaneGUI::Vector2& Position) const;
+
+    void PaintEdges(OctaneGUI::Paint& Brush) const;
     void PaintSelected(OctaneGUI::Paint& Brush, const std::shared_ptr<Node>& Node_) const;
 
-    std::vector<std::shared_ptr<Node>> m_Nodes {};
-    std::vector<std::weak_ptr<Node>> m_Selected {};
+    std::shared_ptr<Common::Graph> m_Graph { nullptr };
+    Common::Engine m_Engine {};
+    // Widgets only exist for nodes in view, and for nodes off screen that are open in a
+    // document or being renamed. They are found through the Registry by node ID. Every
+    // node in the model is in the index.
+    // Selection is by handle, so membership is a constant time check and nodes that have
+    // no widget yet can be selected and moved all the same.
+    Common::HandleSet<Common::NodeTag> m_Selected {};
+    NodeIndex m_Index {};
+    Common::EdgeCache m_Edges {};
+    Common::ConnectionHandle m_SelectedEdge {};
+    Common::PortHandle m_ConnectFrom {};
+    std::unordered_map<uint64_t, NodeIndex::Handle> m_IndexHandles {};
+    std::vector<std::weak_ptr<Node>> m_Visible {};
+    // An empty control at the content origin, which node positions are relative to.
+    std::shared_ptr<OctaneGUI::Container> m_Anchor { nullptr };
+    Common::Bounds m_VisibleBounds {};
+    bool m_VisibleDirty { true };
+
+    // Sources of loaded nodes stay in the mapped project file until a node is opened or
+    // run. Maps a node's handle key to its index in the file.
+    std::shared_ptr<Common::ProjectFile> m_Project { nullptr };
+    std::unordered_map<uint64_t, uint32_t> m_Unloaded {};
+    Common::Journal m_Journal {};
+    std::string m_Snapshot {};
+
+    // The last output of each node, from a local run or from the server, kept for nodes
+    // that have no widget.
+    struct Output
+    {
+        std::string Text {};
+        bool Error { false };
+        bool Running { false };
+    };
+
+    std::shared_ptr<Client::Remote> m_Remote { nullptr };
+    OnStatusSignature m_OnStatus { nullptr };
+    std::unordered_map<Common::NodeID, Output> m_Outputs {};
+    bool m_CompactPending { false };
+    bool m_Moved { false };
+    // Mouse movement accumulated since the selection was last moved.
+    OctaneGUI::Vector2 m_DragDelta {};
+
     std::weak_ptr<Node> m_Hovered {};
     Action m_Action { Action::None };
     OctaneGUI::Vector2 m_LastMousePos {};
+    // Corners of the selection box, in window coordinates. The end also tracks the mouse
+    // while a connection is being drawn.
+    OctaneGUI::Vector2 m_BoxStart {};
+    OctaneGUI::Vector2 m_BoxEnd {};
+
+    // Trace timestamps of the last update and of the oldest mouse movement not yet painted.
+    uint64_t m_LastFrame { 0 };
+    mutable uint64_t m_InputPending { 0 };
 };
 
 }
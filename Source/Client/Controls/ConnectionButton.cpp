@@ -42,15 +42,95 @@ ConnectionButton::ConnectionButton(OctaneGUI::Window* Window)
     m_LinkOff = Window->App().GetTextureCache().LoadSVG("Resources/LinkOff.svg", 20, 20);
     SetTexture(m_LinkOff);
 
-    m_Timer = Window->CreateTimer(1000, false, [this]() -> void
+    SetOnPressed([this](OctaneGUI::Button&) -> void
+        {
+            if (m_Connection != nullptr && m_Connection->IsActive())
+            {
+                Disconnect();
+            }
+            else
+            {
+                Connect();
+            }
+        });
+
+    // The timer only runs while the connection has something to report. It is started by
+    // Connect and stops itself once a disconnect has been fully drained.
+    m_Timer = Window->CreateTimer(1000, true, [this]() -> void
         {
             OnTimer();
         });
+}
+
+ConnectionButton& ConnectionButton::SetConnection(const std::shared_ptr<Client::Connection>& Connection, const std::string& Host, uint16_t Port)
+{
+    m_Connection = Connection;
+    m_Host = Host;
+    m_Port = Port;
+    return *this;
+}
+
+ConnectionButton& ConnectionButton::SetOnStatusChanged(OnStatusSignature&& Fn)
+{
+    m_OnStatusChanged = std::move(Fn);
+    return *this;
+}
+
+ConnectionButton& ConnectionButton::Connect()
+{
+    if (m_Connection == nullptr)
+    {
+        return *this;
+    }
+
+    m_Connection->Connect(m_Host, m_Port);
     m_Timer->Start();
+    return *this;
+}
+
+ConnectionButton& ConnectionButton::Disconnect()
+{
+    if (m_Connection == nullptr)
+    {
+        return *this;
+    }
+
+    m_Connection->Disconnect();
+    m_Timer->Start();
+    return *this;
 }
 
 void ConnectionButton::OnTimer()
 {
+    if (m_Connection == nullptr)
+    {
+        m_Timer->Stop();
+        return;
+    }
+
+    Client::Connection::Status Status {};
+    if (!m_Connection->PollStatus(Status))
+    {
+        if (!m_Connection->IsActive())
+        {
+            m_Timer->Stop();
+        }
+
+        return;
+    }
+
+    if (Status.State != m_ConnectionStatus)
+    {
+        m_ConnectionStatus = Status.State;
+        SetTexture(m_ConnectionStatus == Common::ConnectionStatus::Connected ? m_LinkOn : m_LinkOff);
+        UpdateColors();
+        Invalidate();
+    }
+
+    if (m_OnStatusChanged)
+    {
+        m_OnStatusChanged(Status);
+    }
 }
 
 void ConnectionButton::UpdateColors()
@@ -27,8 +27,11 @@ SOFTWARE.
 #pragma once
 
 #include "../../Common/ConnectionStatus.h"
+#include "../Network/Connection.h"
 #include "OctaneGUI/Controls/ImageButton.h"
 
+#include <functional>
+
 namespace OctaneGUI
 {
 class Texture;
@@ -43,8 +46,15 @@ namespace Controls
 class ConnectionButton : public OctaneGUI::ImageButton
 {
 public:
+    using OnStatusSignature = std::function<void(const Client::Connection::Status&)>;
+
     ConnectionButton(OctaneGUI::Window* Window);
 
+    ConnectionButton& SetConnection(const std::shared_ptr<Client::Connection>& Connection, const std::string& Host, uint16_t Port);
+    ConnectionButton& SetOnStatusChanged(OnStatusSignature&& Fn);
+    ConnectionButton& Connect();
+    ConnectionButton& Disconnect();
+
 private:
     void OnTimer();
     void UpdateColors();
@@ -53,6 +63,10 @@ private:
     std::shared_ptr<OctaneGUI::Texture> m_LinkOff { nullptr };
     std::shared_ptr<OctaneGUI::Timer> m_Timer { nullptr };
     Common::ConnectionStatus m_ConnectionStatus { Common::ConnectionStatus::NotConnected };
+    std::shared_ptr<Client::Connection> m_Connection { nullptr };
+    std::string m_Host {};
+    uint16_t m_Port { 0 };
+    OnStatusSignature m_OnStatusChanged { nullptr };
 };
 
 }
@@ -25,56 +25,331 @@ SOFTWARE.
 */
 
 #include "Document.h"
+#include "../../Common/Execution/Engine.h"
+#include "../../Common/Trace.h"
+#include "../../Common/Unicode.h"
 #include "Node.h"
 #include "OctaneGUI/OctaneGUI.h"
+#include "Registry.h"
+
+#include <algorithm>
+#include <list>
+#include <string_view>
 
 namespace Snippet
 {
 namespace Controls
 {
 
-static std::string GetWindowID(const std::shared_ptr<Node>& Item)
+static OctaneGUI::Color GetColor(Common::TokenKind Kind)
 {
-    std::string Result { "Snippet." };
-
-    if (Item != nullptr)
+    switch (Kind)
     {
-        Result += OctaneGUI::String::ToMultiByte(Item->Name());
+    case Common::TokenKind::Keyword: return { 86, 156, 214, 255 };
+    case Common::TokenKind::Number: return { 181, 206, 168, 255 };
+    case Common::TokenKind::String: return { 206, 145, 120, 255 };
+    case Common::TokenKind::Comment: return { 106, 153, 85, 255 };
+    case Common::TokenKind::Operator: return { 180, 180, 180, 255 };
+    case Common::TokenKind::Error: return { 240, 80, 80, 255 };
+    case Common::TokenKind::Text:
+    default: break;
     }
 
-    return Result;
+    return { 220, 220, 220, 255 };
 }
 
+//
+// Document::Pool
+//
+// Document windows are built once and rebound to whichever node is opened next, so
+// opening a snippet never constructs a widget tree once the pool is warm. A window the
+// user closes keeps its node, and is only reused for another node once it falls off the
+// end of the warm list, so reopening a recently closed snippet just shows it again. The
+// slot a node is bound to is kept in the Registry.
+//
+
+class Document::Pool
+{
+public:
+    static Pool& Get()
+    {
+        static Pool Instance {};
+        return Instance;
+    }
+
+    Pool& SetWarmCapacity(size_t Capacity)
+    {
+        m_WarmCapacity = Capacity;
+        return Trim();
+    }
+
+    Pool& Prewarm(OctaneGUI::Application& App, size_t Count)
+    {
+        while (m_Free.size() < Count)
+        {
+            m_Free.push_back(Create(App));
+        }
+
+        return *this;
+    }
+
+    Pool& Open(OctaneGUI::Application& App, const std::shared_ptr<Node>& Item)
+    {
+        const Common::NodeID ID { Item->GetID() };
+        size_t Index { Registry::Get().FindWindow(ID) };
+
+        if (Index == Registry::NoWindow)
+        {
+            Index = Acquire(App);
+            Slot& Target { m_Slots[Index] };
+            Target.Node = ID;
+            Bind(Target, Item);
+            Registry::Get().SetWindow(ID, Index);
+        }
+
+        Slot& Target { m_Slots[Index] };
+        Unwarm(Index);
+        Target.Visible = true;
+        App.DisplayWindow(Target.ID.c_str());
+        return *this;
+    }
+
+    Pool& Close(OctaneGUI::Application& App, const std::shared_ptr<Node>& Item)
+    {
+        const size_t Index { Registry::Get().FindWindow(Item->GetID()) };
+
+        if (Index == Registry::NoWindow)
+        {
+            return *this;
+        }
+
+        Slot& Target { m_Slots[Index] };
+        Unwarm(Index);
+
+        if (Target.Visible)
+        {
+            Target.Visible = false;
+            App.CloseWindow(Target.ID.c_str());
+        }
+
+        Release(Index);
+        return *this;
+    }
+
+    std::shared_ptr<Document> Find(Common::NodeID ID) const
+    {
+        const size_t Index { Registry::Get().FindWindow(ID) };
+        return Index != Registry::NoWindow ? m_Slots[Index].Editor.lock() : nullptr;
+    }
+
+    Pool& Flush()
+    {
+        for (const Slot& Item : m_Slots)
+        {
+            const std::shared_ptr<Document> Editor { Item.Editor.lock() };
+            if (Editor != nullptr)
+            {
+                Editor->Sync();
+            }
+        }
+
+        return *this;
+    }
+
+    Pool& Flush(Common::NodeID ID)
+    {
+        const std::shared_ptr<Document> Editor { Find(ID) };
+        if (Editor != nullptr)
+        {
+            Editor->Sync();
+        }
+
+        return *this;
+    }
+
+private:
+    struct Slot
+    {
+        std::string ID {};
+        std::weak_ptr<Document> Editor {};
+        Common::NodeID Node { Common::InvalidNodeID };
+        bool Visible { false };
+        bool Warm { false };
+    };
+
+    size_t Create(OctaneGUI::Application& App)
+    {
+        const size_t Index { m_Slots.size() };
+        Slot Item {};
+        Item.ID = "Snippet.Document." + std::to_string(Index);
+
+        const std::shared_ptr<OctaneGUI::Window> Window { App.NewWindow(Item.ID.c_str(), "{}") };
+        Window->SetOnClose([this, Index](OctaneGUI::Window&) -> void
+            {
+                OnClosed(Index);
+            });
+
+        Item.Editor = Window->GetContainer()->AddControl<Document>();
+        m_Slots.push_back(std::move(Item));
+        return Index;
+    }
+
+    size_t Acquire(OctaneGUI::Application& App)
+    {
+        if (!m_Free.empty())
+        {
+            const size_t Result { m_Free.back() };
+            m_Free.pop_back();
+            return Result;
+        }
+
+        if (!m_Warm.empty())
+        {
+            const size_t Result { m_Warm.back() };
+            Unwarm(Result);
+            Unbind(Result);
+            return Result;
+        }
+
+        return Create(App);
+    }
+
+    void Bind(Slot& Target, const std::shared_ptr<Node>& Item)
+    {
+        const std::shared_ptr<Document> Editor { Target.Editor.lock() };
+        if (Editor != nullptr)
+        {
+            const std::string Title { OctaneGUI::String::ToMultiByte(Item->Name()) };
+            Editor->GetWindow()->SetTitle(Title.c_str());
+            Editor->SetNode(Item);
+        }
+    }
+
+    void Unbind(size_t Index)
+    {
+        Slot& Target { m_Slots[Index] };
+        Registry::Get().SetWindow(Target.Node, Registry::NoWindow);
+        Target.Node = Common::InvalidNodeID;
+
+        const std::shared_ptr<Document> Editor { Target.Editor.lock() };
+        if (Editor != nullptr)
+        {
+            Editor->SetNode(nullptr);
+        }
+    }
+
+    void Release(size_t Index)
+    {
+        Unbind(Index);
+        m_Free.push_back(Index);
+    }
+
+    void OnClosed(size_t Index)
+    {
+        Slot& Target { m_Slots[Index] };
+        if (!Target.Visible)
+        {
+            return;
+        }
+
+        Target.Visible = false;
+
+        if (Target.Node != Common::InvalidNodeID)
+        {
+            Target.Warm = true;
+            m_Warm.push_front(Index);
+        }
+
+        Trim();
+    }
+
+    void Unwarm(size_t Index)
+    {
+        Slot& Target { m_Slots[Index] };
+        if (Target.Warm)
+        {
+            m_Warm.remove(Index);
+            Target.Warm = false;
+        }
+    }
+
+    Pool& Trim()
+    {
+        while (m_Warm.size() > m_WarmCapacity)
+        {
+            const size_t Index { m_Warm.back() };
+            Unwarm(Index);
+            Release(Index);
+        }
+
+        return *this;
+    }
+
+    std::vector<Slot> m_Slots {};
+    std::vector<size_t> m_Free {};
+    // Most recently closed first.
+    std::list<size_t> m_Warm {};
+    size_t m_WarmCapacity { 8 };
+};
+
+//
+// Document
+//
+
 void Document::Open(OctaneGUI::Application& App, const std::shared_ptr<Node>& Item)
 {
+    const Common::ScopedTimer Timer { "Document::Open" };
+
     if (Item == nullptr)
     {
         return;
     }
 
-    const std::string Title { OctaneGUI::String::ToMultiByte(Item->Name()) };
-    const std::string WindowID { GetWindowID(Item) };
+    Pool::Get().Open(App, Item);
+}
 
-    if (!App.HasWindow(WindowID.c_str()))
+void Document::Close(OctaneGUI::Application& App, const std::shared_ptr<Node>& Item)
+{
+    if (Item == nullptr)
     {
-        const std::shared_ptr<OctaneGUI::Window> Window { App.NewWindow(WindowID.c_str(), "{}") };
-        Window->SetTitle(Title.c_str());
-
-        const std::shared_ptr<Document> Document_ = Window->GetContainer()->AddControl<Document>();
-        Document_->SetNode(Item);
+        return;
     }
 
-    App.DisplayWindow(WindowID.c_str());
+    Pool::Get().Close(App, Item);
 }
 
-void Document::Close(OctaneGUI::Application& App, const std::shared_ptr<Node>& Item)
+void Document::Patch(OctaneGUI::Application&, const std::shared_ptr<Node>& Item, const Common::TextBuffer::Splice& Edit)
 {
     if (Item == nullptr)
     {
         return;
     }
 
-    App.CloseWindow(GetWindowID(Item).c_str());
+    const std::shared_ptr<Document> Editor { Pool::Get().Find(Item->GetID()) };
+    if (Editor != nullptr)
+    {
+        Editor->Apply(Edit);
+    }
+}
+
+void Document::Flush()
+{
+    Pool::Get().Flush();
+}
+
+void Document::Flush(Common::NodeID ID)
+{
+    Pool::Get().Flush(ID);
+}
+
+void Document::Prewarm(OctaneGUI::Application& App, size_t Count)
+{
+    Pool::Get().Prewarm(App, Count);
+}
+
+void Document::SetWarmCapacity(size_t Capacity)
+{
+    Pool::Get().SetWarmCapacity(Capacity);
 }
 
 Document::Document(OctaneGUI::Window* Window)
@@ -91,11 +366,147 @@ Document::Document(OctaneGUI::Window* Window)
     m_Editor
         ->SetExpand(OctaneGUI::Expand::Both)
         .SetProperty(OctaneGUI::ThemeProperties::FontPath, "Resources/SourceCodePro-Regular.ttf");
+
+    m_Editor->SetOnTextChanged([this](OctaneGUI::TextInput& Input) -> void
+        {
+            const std::shared_ptr<Node> Item { m_Node.lock() };
+            if (Item == nullptr)
+            {
+                return;
+            }
+
+            // The editor only reports that its text changed, so the changed range is found
+            // by trimming what is unchanged at both ends. Only that range is converted.
+            const std::u32string_view Text { Input.GetText() };
+            const size_t Shorter { std::min(Text.size(), m_Text.size()) };
+
+            size_t Prefix { 0 };
+            while (Prefix < Shorter && Text[Prefix] == m_Text[Prefix])
+            {
+                Prefix++;
+            }
+
+            size_t Suffix { 0 };
+            while (Suffix < Shorter - Prefix && Text[Text.size() - 1 - Suffix] == m_Text[m_Text.size() - 1 - Suffix])
+            {
+                Suffix++;
+            }
+
+            const std::u32string_view Removed { std::u32string_view { m_Text }.substr(Prefix, m_Text.size() - Prefix - Suffix) };
+            const std::u32string_view Inserted { Text.substr(Prefix, Text.size() - Prefix - Suffix) };
+            if (Removed.empty() && Inserted.empty())
+            {
+                return;
+            }
+
+            // Only the splice is applied here, and reported through the node so it can be
+            // journaled and sent on as it is. Lexing and compiling happen on the
+            // highlighter's thread against a snapshot, and the node's own copy of the
+            // source is only replaced with the next Sync.
+            const std::string Bytes { Common::ToUTF8(Inserted) };
+            const Common::TextBuffer::Splice Edit { Common::UTF8Length(std::u32string_view { m_Text }.substr(0, Prefix)), Common::UTF8Length(Removed), Bytes };
+            const Common::Highlighter::LineEdit Lines { Common::Highlighter::Measure(m_Buffer, Edit) };
+            m_Buffer.Apply(Edit);
+            m_Highlighter.Submit(m_Buffer, Lines);
+            m_Text.replace(Prefix, Removed.size(), Inserted);
+            m_Modified = true;
+            Item->EditSource(Edit);
+        });
+
+    m_Editor->SetOnModifySpans([this](const std::vector<OctaneGUI::TextSpan>& Spans) -> std::vector<OctaneGUI::TextSpan>
+        {
+            // Spans from a pass that has not caught up with the latest edit may not line up
+            // with the text, so the editor's own are used until the next result arrives.
+            if (m_Spans == nullptr || m_Spans->empty() || Spans.empty() || m_Spans->back().End != Spans.back().End)
+            {
+                return Spans;
+            }
+
+            return *m_Spans;
+        });
+
+    m_Highlighter
+        .SetCheck([](std::string_view Source, std::string& Error) -> bool
+            {
+                return Common::Engine::Check("snippet", Source, &Error);
+            })
+        .SetOnResult([this](const std::shared_ptr<const Common::Highlight>& Result) -> void
+            {
+                const std::shared_ptr<SpanList> Spans { std::make_shared<SpanList>() };
+                Spans->reserve(Result->Spans.size());
+
+                for (const Common::HighlightSpan& Span : Result->Spans)
+                {
+                    Spans->push_back({ Span.Start, Span.End, GetColor(Span.Kind) });
+                }
+
+                std::lock_guard<std::mutex> Lock { m_PendingMutex };
+                m_PendingSpans = Spans;
+            });
 }
 
 Document& Document::SetNode(const std::shared_ptr<Node>& Item)
 {
+    Sync();
+
+    // The buffer holds the editor's text converted back to UTF-8, so that offsets into
+    // one always map onto the other, even if the source was not valid UTF-8.
     m_Node = Item;
+    m_Spans = nullptr;
+    m_Text = Item != nullptr ? Common::ToUTF32(Item->Source()) : std::u32string {};
+    m_Buffer.Assign(Common::ToUTF8(m_Text));
+    m_Highlighter.Reset(m_Buffer);
+    m_Editor->SetText(m_Text.c_str());
+
+    return *this;
+}
+
+Document& Document::Apply(const Common::TextBuffer::Splice& Edit)
+{
+    const std::shared_ptr<Node> Item { m_Node.lock() };
+
+    if (Item == nullptr)
+    {
+        return *this;
+    }
+
+    // The document is flushed before an edit made elsewhere is applied to its node, so the
+    // buffer should be in step with the node. If it is not, the node's source wins.
+    if (m_Modified)
+    {
+        m_Modified = false;
+        m_Buffer.Assign(Item->Source());
+        m_Highlighter.Reset(m_Buffer);
+    }
+    else
+    {
+        const Common::Highlighter::LineEdit Lines { Common::Highlighter::Measure(m_Buffer, Edit) };
+        m_Buffer.Apply(Edit);
+        m_Highlighter.Submit(m_Buffer, Lines);
+    }
+
+    // The editor has no way to splice its text, so it is given all of it. The text it
+    // reports back already matches, so no edit is made.
+    m_Text = Common::ToUTF32(Item->Source());
+    m_Editor->SetText(m_Text.c_str());
+    return *this;
+}
+
+Document& Document::Sync()
+{
+    if (!m_Modified)
+    {
+        return *this;
+    }
+
+    m_Modified = false;
+
+    const std::shared_ptr<Node> Item { m_Node.lock() };
+    if (Item != nullptr)
+    {
+        Item->SetSource(m_Buffer.ToString());
+    }
+
     return *this;
 }
 
@@ -104,5 +515,27 @@ const std::weak_ptr<Node>& Document::GetNode() const
     return m_Node;
 }
 
+Common::TextBuffer Document::Snapshot() const
+{
+    return m_Buffer.Snapshot();
+}
+
+void Document::Update()
+{
+    Container::Update();
+
+    std::shared_ptr<const SpanList> Spans { nullptr };
+    {
+        std::lock_guard<std::mutex> Lock { m_PendingMutex };
+        Spans.swap(m_PendingSpans);
+    }
+
+    if (Spans != nullptr)
+    {
+        m_Spans = Spans;
+        m_Editor->Invalidate();
+    }
+}
+
 }
 }
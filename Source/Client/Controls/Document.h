@@ -26,12 +26,18 @@ SOFTWARE.
 
 #pragma once
 
+#include "../../Common/Graph/NodeID.h"
+#include "../../Common/Text/Highlighter.h"
+#include "../../Common/Text/TextBuffer.h"
 #include "OctaneGUI/Controls/Container.h"
 
+#include <mutex>
+
 namespace OctaneGUI
 {
 class Application;
 class TextEditor;
+struct TextSpan;
 }
 
 namespace Snippet
@@ -48,15 +54,59 @@ class Document : public OctaneGUI::Container
 public:
     static void Open(OctaneGUI::Application& App, const std::shared_ptr<Node>& Item);
     static void Close(OctaneGUI::Application& App, const std::shared_ptr<Node>& Item);
+    // Applies an edit of Item's source made elsewhere to its document, if it has one. The
+    // node's model already has the edited source.
+    static void Patch(OctaneGUI::Application& App, const std::shared_ptr<Node>& Item, const Common::TextBuffer::Splice& Edit);
+    // Typing only updates a document's own buffer, and reports each splice through its
+    // node. The node's source catches up when this is called, which anything reading
+    // sources does first, as runs, saves and compaction do.
+    static void Flush();
+    // Flushes only the document open on the node with ID, if there is one.
+    static void Flush(Common::NodeID ID);
+
+    // Builds Count document windows ahead of the first open.
+    static void Prewarm(OctaneGUI::Application& App, size_t Count);
+    // How many closed documents stay bound to their node. Zero hands a closed window
+    // straight back to the pool.
+    static void SetWarmCapacity(size_t Capacity);
 
     Document(OctaneGUI::Window* Window);
 
     Document& SetNode(const std::shared_ptr<Node>& Item);
     const std::weak_ptr<Node>& GetNode() const;
 
+    // The document's text as of the last edit, safe to hand to another thread.
+    Common::TextBuffer Snapshot() const;
+
+    virtual void Update() override;
+
 private:
+    class Pool;
+
+    Document& Apply(const Common::TextBuffer::Splice& Edit);
+    // Hands the buffer to the node if it was edited since the last call.
+    Document& Sync();
+
+    using SpanList = std::vector<OctaneGUI::TextSpan>;
+
     std::shared_ptr<OctaneGUI::TextEditor> m_Editor { nullptr };
+    // The editor's text as of its last change, which the next change is compared against
+    // to find the splice without converting the whole text.
+    std::u32string m_Text {};
+    // Mirrors the editor's text in UTF-8. Each edit is applied as a splice rather than by
+    // copying the whole source, and provides line lookups and snapshots without touching
+    // the editor.
+    Common::TextBuffer m_Buffer {};
+    bool m_Modified { false };
     std::weak_ptr<Node> m_Node {};
+
+    // Spans converted on the highlighting thread wait here until the next update.
+    std::shared_ptr<const SpanList> m_Spans { nullptr };
+    std::mutex m_PendingMutex {};
+    std::shared_ptr<const SpanList> m_PendingSpans { nullptr };
+
+    // Declared last so its thread stops before anything it reports into is destroyed.
+    Common::Highlighter m_Highlighter {};
 };
 
 }
@@ -25,6 +25,7 @@ SOFTWARE.
 */
 
 #include "Node.h"
+#include "../../Common/Graph/EdgeCache.h"
 #include "OctaneGUI/OctaneGUI.h"
 
 namespace Snippet
@@ -46,15 +47,161 @@ Node::Node(OctaneGUI::Window* Window)
         ->SetMargins({ 4.0f, 4.0f, 4.0f, 4.0f })
         .SetExpand(OctaneGUI::Expand::Both);
 
-    const std::shared_ptr<OctaneGUI::VerticalContainer> Contents = Margins->AddControl<OctaneGUI::VerticalContainer>();
-    Contents->SetExpand(OctaneGUI::Expand::Width);
+    m_Contents = Margins->AddControl<OctaneGUI::VerticalContainer>();
+    m_Contents->SetExpand(OctaneGUI::Expand::Width);
 
-    m_Header = Contents->AddControl<Node::Header>();
+    m_Header = m_Contents->AddControl<Node::Header>();
+    m_Header->SetOnEdited([this](const char32_t* Value) -> void
+        {
+            if (m_Model != nullptr)
+            {
+                m_Model->SetName(m_Handle, Value);
+            }
+
+            if (m_OnRenamed)
+            {
+                m_OnRenamed(*this);
+            }
+        });
+
+    m_Output = std::make_shared<OctaneGUI::Text>(Window);
+}
+
+Node& Node::SetOnResized(OnNodeSignature&& Fn)
+{
+    m_OnResized = std::move(Fn);
+    return *this;
+}
+
+Node& Node::SetOnRenamed(OnNodeSignature&& Fn)
+{
+    m_OnRenamed = std::move(Fn);
+    return *this;
+}
+
+Node& Node::SetOnSourceEdited(OnSourceEditedSignature&& Fn)
+{
+    m_OnSourceEdited = std::move(Fn);
+    return *this;
+}
+
+Node& Node::SetModel(const std::shared_ptr<Common::Graph>& Model, Common::NodeHandle Handle)
+{
+    m_Model = Model;
+    m_Handle = Handle;
+    m_ID = Common::InvalidNodeID;
+
+    if (m_Model == nullptr)
+    {
+        return *this;
+    }
+
+    m_ID = m_Model->GetID(m_Handle);
+
+    // Nodes loaded from a project already have a name. New nodes take the widget's default.
+    const std::u32string& Existing { m_Model->GetName(m_Handle) };
+    if (Existing.empty())
+    {
+        m_Model->SetName(m_Handle, Name());
+    }
+    else
+    {
+        m_Header->Set(Existing.c_str());
+    }
+
+    Resize();
+    return *this;
+}
+
+Common::NodeHandle Node::GetHandle() const
+{
+    return m_Handle;
+}
+
+Common::NodeID Node::GetID() const
+{
+    return m_ID;
+}
+
+Node& Node::EditSource(const Common::TextBuffer::Splice& Edit)
+{
+    if (m_Model != nullptr && m_OnSourceEdited)
+    {
+        m_OnSourceEdited(*this, Edit);
+    }
+
+    return *this;
+}
+
+Node& Node::SetSource(const std::string& Source)
+{
+    if (m_Model != nullptr)
+    {
+        m_Model->SetSource(m_Handle, Source);
+    }
+
+    return *this;
+}
+
+const std::string& Node::Source() const
+{
+    static const std::string Empty {};
+    return m_Model != nullptr ? m_Model->GetSource(m_Handle) : Empty;
+}
+
+Node& Node::SetCulled(bool Culled)
+{
+    m_Culled = Culled;
+    return *this;
+}
+
+bool Node::IsCulled() const
+{
+    return m_Culled;
+}
+
+Node& Node::SetSimplified(bool Simplified)
+{
+    m_Simplified = Simplified;
+    return *this;
+}
+
+bool Node::IsSimplified() const
+{
+    return m_Simplified;
+}
+
+Node& Node::SetOutput(const std::string& Output, bool Error)
+{
+    if (Output.empty())
+    {
+        m_Contents->RemoveControl(m_Output);
+    }
+    else
+    {
+        m_Output
+            ->SetText(Output.c_str())
+            .SetProperty(OctaneGUI::ThemeProperties::Text, Error ? OctaneGUI::Color { 220, 80, 80, 255 } : OctaneGUI::Color { 200, 200, 200, 255 });
+
+        if (!m_Contents->HasControl(m_Output))
+        {
+            m_Contents->InsertControl(m_Output);
+        }
+    }
+
+    Resize();
+    return *this;
 }
 
 Node& Node::SetName(const char32_t* Name)
 {
     m_Header->Set(Name);
+
+    if (m_Model != nullptr)
+    {
+        m_Model->SetName(m_Handle, Name);
+    }
+
     Resize();
     return *this;
 }
@@ -66,15 +213,56 @@ Node& Node::EditName()
     return *this;
 }
 
+bool Node::IsEditingName() const
+{
+    return m_Header->IsEditing();
+}
+
 const char32_t* Node::Name() const
 {
     return m_Header->Value();
 }
 
+void Node::OnPaint(OctaneGUI::Paint& Brush) const
+{
+    if (m_Culled)
+    {
+        return;
+    }
+
+    if (m_Simplified)
+    {
+        Brush.Rectangle(GetAbsoluteBounds(), { 48, 48, 48, 255 });
+        return;
+    }
+
+    Container::OnPaint(Brush);
+
+    if (m_Model == nullptr)
+    {
+        return;
+    }
+
+    // Ports are drawn where the canvas attaches their connections.
+    const Common::Point Position { m_Model->GetPosition(m_Handle) };
+    const OctaneGUI::Vector2 Origin { GetAbsolutePosition() };
+    for (Common::PortHandle Port : m_Model->GetPorts(m_Handle))
+    {
+        const Common::Point Anchor { Common::EdgeCache::GetAnchor(*m_Model, Port) };
+        const OctaneGUI::Vector2 Center { Origin.X + Anchor.X - Position.X, Origin.Y + Anchor.Y - Position.Y };
+        Brush.Rectangle({ Center.X - 4.0f, Center.Y - 4.0f, Center.X + 4.0f, Center.Y + 4.0f }, { 160, 160, 160, 255 });
+    }
+}
+
 void Node::Resize()
 {
     const OctaneGUI::Vector2 Size { ChildrenSize() };
     SetSize({ std::max(Size.X, 200.0f * GetWindow()->RenderScale().X), Size.Y });
+
+    if (m_OnResized)
+    {
+        m_OnResized(*this);
+    }
 }
 
 //
@@ -102,6 +290,12 @@ Node::Header::Header(OctaneGUI::Window* Window)
             });
 }
 
+Node::Header& Node::Header::SetOnEdited(OnEditedSignature&& Fn)
+{
+    m_OnEdited = std::move(Fn);
+    return *this;
+}
+
 Node::Header& Node::Header::Set(const char32_t* Value)
 {
     m_Label->SetText(Value);
@@ -118,6 +312,11 @@ Node::Header& Node::Header::Edit()
     return *this;
 }
 
+bool Node::Header::IsEditing() const
+{
+    return HasControl(m_Input);
+}
+
 const char32_t* Node::Header::Value() const
 {
     return m_Label->GetText();
@@ -136,6 +335,12 @@ Node::Header& Node::Header::FinishEdit()
     RemoveControl(m_Input);
     InsertControl(m_Label);
     m_Label->SetText(m_Input->GetText());
+
+    if (m_OnEdited)
+    {
+        m_OnEdited(m_Label->GetText());
+    }
+
     return *this;
 }
 
@@ -26,12 +26,15 @@ SOFTWARE.
 
 #pragma once
 
+#include "../../Common/Graph/Graph.h"
+#include "../../Common/Text/TextBuffer.h"
 #include "OctaneGUI/Controls/HorizontalContainer.h"
 
 namespace OctaneGUI
 {
 class Text;
 class TextInput;
+class VerticalContainer;
 }
 
 namespace Snippet
@@ -44,20 +47,53 @@ class Node : public OctaneGUI::Container
     CLASS(Snippet.Node)
 
 public:
+    using OnNodeSignature = std::function<void(Node&)>;
+    using OnSourceEditedSignature = std::function<void(Node&, const Common::TextBuffer::Splice&)>;
+
     Node(OctaneGUI::Window* Window);
 
+    Node& SetOnResized(OnNodeSignature&& Fn);
+    Node& SetOnRenamed(OnNodeSignature&& Fn);
+    Node& SetOnSourceEdited(OnSourceEditedSignature&& Fn);
+
+    Node& SetModel(const std::shared_ptr<Common::Graph>& Model, Common::NodeHandle Handle);
+    Common::NodeHandle GetHandle() const;
+    Common::NodeID GetID() const;
+
+    // Reports an edit typed into the node's document. The model's source only catches up
+    // when the document next hands over the whole of it with SetSource, which reports
+    // nothing, since every edit in it has been reported already.
+    Node& EditSource(const Common::TextBuffer::Splice& Edit);
+    Node& SetSource(const std::string& Source);
+    const std::string& Source() const;
+
+    Node& SetCulled(bool Culled);
+    bool IsCulled() const;
+
+    Node& SetSimplified(bool Simplified);
+    bool IsSimplified() const;
+
+    Node& SetOutput(const std::string& Output, bool Error);
+
     Node& SetName(const char32_t* Name);
     Node& EditName();
+    bool IsEditingName() const;
     const char32_t* Name() const;
 
+    virtual void OnPaint(OctaneGUI::Paint& Brush) const override;
+
 private:
     class Header : public OctaneGUI::HorizontalContainer
     {
     public:
+        using OnEditedSignature = std::function<void(const char32_t*)>;
+
         Header(OctaneGUI::Window* Window);
 
+        Header& SetOnEdited(OnEditedSignature&& Fn);
         Header& Set(const char32_t* Value);
         Header& Edit();
+        bool IsEditing() const;
         const char32_t* Value() const;
 
         virtual void Update() override;
@@ -67,11 +103,22 @@ private:
 
         std::shared_ptr<OctaneGUI::Text> m_Label { nullptr };
         std::shared_ptr<OctaneGUI::TextInput> m_Input { nullptr };
+        OnEditedSignature m_OnEdited { nullptr };
     };
 
     void Resize();
 
+    std::shared_ptr<OctaneGUI::VerticalContainer> m_Contents { nullptr };
     std::shared_ptr<Header> m_Header { nullptr };
+    std::shared_ptr<OctaneGUI::Text> m_Output { nullptr };
+    std::shared_ptr<Common::Graph> m_Model { nullptr };
+    Common::NodeHandle m_Handle {};
+    Common::NodeID m_ID { Common::InvalidNodeID };
+    OnNodeSignature m_OnResized { nullptr };
+    OnNodeSignature m_OnRenamed { nullptr };
+    OnSourceEditedSignature m_OnSourceEdited { nullptr };
+    bool m_Culled { false };
+    bool m_Simplified { false };
 };
 
 }
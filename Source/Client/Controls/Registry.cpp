@@ -0,0 +1,94 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Registry.h"
+#include "Node.h"
+
+namespace Snippet
+{
+namespace Controls
+{
+
+Registry& Registry::Get()
+{
+    static Registry Instance {};
+    return Instance;
+}
+
+Registry& Registry::Add(Common::NodeID ID, const std::shared_ptr<Node>& Item)
+{
+    m_Entries[ID].Item = Item;
+    return *this;
+}
+
+Registry& Registry::Remove(Common::NodeID ID)
+{
+    m_Entries.erase(ID);
+    return *this;
+}
+
+Registry& Registry::Clear()
+{
+    m_Entries.clear();
+    return *this;
+}
+
+std::shared_ptr<Node> Registry::Find(Common::NodeID ID) const
+{
+    const std::unordered_map<Common::NodeID, Entry>::const_iterator It { m_Entries.find(ID) };
+    return It != m_Entries.end() ? It->second.Item : nullptr;
+}
+
+Registry& Registry::SetWindow(Common::NodeID ID, size_t Window)
+{
+    const std::unordered_map<Common::NodeID, Entry>::iterator It { m_Entries.find(ID) };
+
+    if (It != m_Entries.end())
+    {
+        It->second.Window = Window;
+    }
+
+    return *this;
+}
+
+size_t Registry::FindWindow(Common::NodeID ID) const
+{
+    const std::unordered_map<Common::NodeID, Entry>::const_iterator It { m_Entries.find(ID) };
+    return It != m_Entries.end() ? It->second.Window : NoWindow;
+}
+
+size_t Registry::Size() const
+{
+    return m_Entries.size();
+}
+
+bool Registry::Empty() const
+{
+    return m_Entries.empty();
+}
+
+}
+}
@@ -0,0 +1,89 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "../../Common/Graph/NodeID.h"
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+
+namespace Snippet
+{
+namespace Controls
+{
+
+class Node;
+
+//
+// Maps node IDs to the widget showing the node and to the document window, if any, it
+// is open in. There is one registry per process, shared by the canvas, the document
+// pool and anything else that receives node IDs, so a node is always found in constant
+// time without going through handles, window names or titles.
+//
+
+class Registry
+{
+public:
+    static constexpr size_t NoWindow { ~static_cast<size_t>(0) };
+
+    static Registry& Get();
+
+    Registry& Add(Common::NodeID ID, const std::shared_ptr<Node>& Item);
+    Registry& Remove(Common::NodeID ID);
+    Registry& Clear();
+
+    std::shared_ptr<Node> Find(Common::NodeID ID) const;
+
+    // Window is an index into the document pool. Ignored for unregistered IDs.
+    Registry& SetWindow(Common::NodeID ID, size_t Window);
+    size_t FindWindow(Common::NodeID ID) const;
+
+    size_t Size() const;
+    bool Empty() const;
+
+    template<typename Fn>
+    void ForEach(Fn&& Callback) const
+    {
+        for (const std::pair<const Common::NodeID, Entry>& Item : m_Entries)
+        {
+            Callback(Item.first, Item.second.Item);
+        }
+    }
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<Node> Item { nullptr };
+        size_t Window { NoWindow };
+    };
+
+    std::unordered_map<Common::NodeID, Entry> m_Entries {};
+};
+
+}
+}
@@ -26,10 +26,16 @@ SOFTWARE.
 
 #include "Controls/Canvas.h"
 #include "Controls/ConnectionButton.h"
+#include "Controls/Document.h"
 #include "Frontend.h"
+#include "../Common/Trace.h"
+#include "Network/Connection.h"
+#include "Network/Remote.h"
 #include "OctaneGUI/OctaneGUI.h"
 
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 int main(int argc, char** argv)
 {
@@ -39,6 +45,8 @@ int main(int argc, char** argv)
         "Main": {"Title": "Snippet", "Width": 1280, "Height": 720,
             "MenuBar": {"Items": [
                 {"Text": "File", "ID": "File", "Items": [
+                    {"Text": "Open", "ID": "Open"},
+                    {"Text": "Save", "ID": "Save"},
                     {"Text": "Quit", "ID": "Quit"}
                 ]}
             ]},
@@ -59,6 +67,62 @@ int main(int argc, char** argv)
     }
 })";
 
+    std::string ServerHost { "127.0.0.1" };
+    uint16_t ServerPort { 7340 };
+    bool AutoConnect { false };
+    std::string ProjectPath { "Project.snippet" };
+    size_t WarmDocuments { 8 };
+    std::string TracePath {};
+    std::string Room {};
+    bool FrameStats { false };
+
+    for (int I = 1; I + 1 < argc; I++)
+    {
+        if (std::strcmp(argv[I], "--server") == 0)
+        {
+            const std::string Address { argv[I + 1] };
+            const size_t Separator { Address.rfind(':') };
+            ServerHost = Address.substr(0, Separator);
+
+            if (Separator != std::string::npos)
+            {
+                ServerPort = static_cast<uint16_t>(std::atoi(Address.c_str() + Separator + 1));
+            }
+
+            AutoConnect = true;
+        }
+        else if (std::strcmp(argv[I], "--project") == 0)
+        {
+            ProjectPath = argv[I + 1];
+        }
+        else if (std::strcmp(argv[I], "--warm-documents") == 0)
+        {
+            WarmDocuments = static_cast<size_t>(std::atoi(argv[I + 1]));
+        }
+        else if (std::strcmp(argv[I], "--trace") == 0)
+        {
+            TracePath = argv[I + 1];
+        }
+        else if (std::strcmp(argv[I], "--room") == 0)
+        {
+            Room = argv[I + 1];
+        }
+    }
+
+    for (int I = 1; I < argc; I++)
+    {
+        if (std::strcmp(argv[I], "--frame-stats") == 0)
+        {
+            FrameStats = true;
+        }
+    }
+
+    // Timers around painting, input and editing only record while tracing is enabled.
+    Snippet::Common::Trace::Get().SetEnabled(!TracePath.empty() || FrameStats);
+
+    Snippet::Common::Socket::Initialize();
+    const std::shared_ptr<Snippet::Client::Connection> Connection { std::make_shared<Snippet::Client::Connection>() };
+
     OctaneGUI::Application Application;
     Frontend::Initialize(Application);
 
@@ -76,6 +140,48 @@ int main(int argc, char** argv)
         .SetCommandLine(argc, argv)
         .Initialize(Json, Controls);
     
+    const std::shared_ptr<Snippet::Controls::Canvas> Canvas = Controls["Main"].To<Snippet::Controls::Canvas>("Canvas");
+
+    // While connected, the graph can be run on the server instead of in the editor.
+    const std::shared_ptr<Snippet::Client::Remote> Remote { std::make_shared<Snippet::Client::Remote>(Connection) };
+    Canvas->SetRemote(Remote);
+
+    // Build a couple of editors up front so the first snippet opened doesn't pay for it.
+    Snippet::Controls::Document::SetWarmCapacity(WarmDocuments);
+    Snippet::Controls::Document::Prewarm(Application, 2);
+
+    // Picks up where the last session left off, even if it crashed.
+    std::string AutosaveError;
+    if (!Canvas->EnableAutosave(ProjectPath, &AutosaveError))
+    {
+        printf("Failed to enable autosave for '%s': %s\n", ProjectPath.c_str(), AutosaveError.c_str());
+    }
+
+    // Shares the canvas with everyone else in the room once connected. The first to join
+    // brings their graph, everyone after starts from the room's.
+    if (!Room.empty())
+    {
+        Remote->Join(Room);
+    }
+
+    Controls["Main"].To<OctaneGUI::MenuItem>("File.Open")->SetOnPressed([&](const OctaneGUI::TextSelectable&) -> void
+        {
+            std::string Error;
+            if (!Canvas->Load(ProjectPath.c_str(), &Error))
+            {
+                printf("Failed to open '%s': %s\n", ProjectPath.c_str(), Error.c_str());
+            }
+        });
+
+    Controls["Main"].To<OctaneGUI::MenuItem>("File.Save")->SetOnPressed([&](const OctaneGUI::TextSelectable&) -> void
+        {
+            std::string Error;
+            if (!Canvas->Save(ProjectPath.c_str(), &Error))
+            {
+                printf("Failed to save '%s': %s\n", ProjectPath.c_str(), Error.c_str());
+            }
+        });
+
     Controls["Main"].To<OctaneGUI::MenuItem>("File.Quit")->SetOnPressed([&](const OctaneGUI::TextSelectable&) -> void
         {
             Application.Quit();
@@ -83,6 +189,70 @@ int main(int argc, char** argv)
 
     const std::shared_ptr<OctaneGUI::Container> StatusBar = Controls["Main"].To<OctaneGUI::Container>("StatusBar");
     const std::shared_ptr<Snippet::Controls::ConnectionButton> ConnectionButton = StatusBar->AddControl<Snippet::Controls::ConnectionButton>();
+    const std::shared_ptr<OctaneGUI::Text> Latency = StatusBar->AddControl<OctaneGUI::Text>();
+
+    ConnectionButton
+        ->SetConnection(Connection, ServerHost, ServerPort)
+        .SetOnStatusChanged([Latency](const Snippet::Client::Connection::Status& Status) -> void
+            {
+                char Buffer[64] {};
+
+                if (Status.State == Snippet::Common::ConnectionStatus::Connected)
+                {
+                    snprintf(Buffer, sizeof(Buffer), "RTT %.2f ms", static_cast<double>(Status.RTT));
+                }
+                else if (Status.State == Snippet::Common::ConnectionStatus::Connecting)
+                {
+                    snprintf(Buffer, sizeof(Buffer), "Connecting...");
+                }
+                else if (Status.Attempts > 0)
+                {
+                    snprintf(Buffer, sizeof(Buffer), "Reconnecting (%u)", Status.Attempts);
+                }
+
+                Latency->SetText(Buffer);
+            });
+
+    const std::shared_ptr<OctaneGUI::Text> Message = StatusBar->AddControl<OctaneGUI::Text>();
+    Canvas->SetOnStatus([Message](const std::string& Text) -> void
+        {
+            Message->SetText(Text.c_str());
+        });
+
+    if (AutoConnect)
+    {
+        ConnectionButton->Connect();
+    }
+
+    std::shared_ptr<OctaneGUI::Timer> FrameStatsTimer { nullptr };
+    if (FrameStats)
+    {
+        const std::shared_ptr<OctaneGUI::Text> Frames = StatusBar->AddControl<OctaneGUI::Text>();
+        FrameStatsTimer = Canvas->GetWindow()->CreateTimer(500, true, [Frames]() -> void
+            {
+                const Snippet::Common::Trace& Tracer { Snippet::Common::Trace::Get() };
+                const Snippet::Common::Trace::Summary Frame { Tracer.Summarize("Frame") };
+                const Snippet::Common::Trace::Summary Input { Tracer.Summarize("Input") };
+
+                char Buffer[128] {};
+                snprintf(Buffer, sizeof(Buffer), "Frame p50 %.1f p95 %.1f p99 %.1f ms | Input p50 %.1f p99 %.1f ms",
+                    Frame.P50, Frame.P95, Frame.P99, Input.P50, Input.P99);
+                Frames->SetText(Buffer);
+            });
+        FrameStatsTimer->Start();
+    }
+
+    const int Result { Application.Run() };
+
+    if (!TracePath.empty())
+    {
+        std::string Error;
+        if (!Snippet::Common::Trace::Get().WriteChromeTrace(TracePath.c_str(), &Error))
+        {
+            printf("Failed to write trace '%s': %s\n", TracePath.c_str(), Error.c_str());
+        }
+    }
 
-    return Application.Run();
+    Snippet::Common::Socket::Shutdown();
+    return Result;
 }
@@ -0,0 +1,596 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Connection.h"
+
+#include <algorithm>
+
+#if !defined(_WIN32)
+    #include <unistd.h>
+#endif
+
+namespace Snippet
+{
+namespace Client
+{
+
+static constexpr std::chrono::milliseconds HeartbeatInterval { 1000 };
+static constexpr std::chrono::milliseconds ConnectTimeout { 5000 };
+static constexpr std::chrono::milliseconds BackoffBase { 250 };
+static constexpr std::chrono::milliseconds BackoffMax { 30000 };
+static constexpr uint32_t MaxMissedHeartbeats { 3 };
+static constexpr size_t ReadSize { 64 * 1024 };
+
+static bool IsLoopback(const std::string& Host)
+{
+    return Host == "localhost" || Host == "::1" || Host.compare(0, 4, "127.") == 0;
+}
+
+Connection::Connection()
+    : m_Random(std::random_device {}())
+{
+    m_Running = true;
+    m_Thread = std::thread([this]() -> void
+        {
+            Run();
+        });
+}
+
+Connection::~Connection()
+{
+    m_Running = false;
+    m_Reactor.Stop();
+
+    if (m_Thread.joinable())
+    {
+        m_Thread.join();
+    }
+}
+
+Connection& Connection::Connect(const std::string& Host, uint16_t Port)
+{
+    m_Active = true;
+    m_Reactor.Post([this, Host, Port]() -> void
+        {
+            Close();
+            m_Host = Host;
+            m_Port = Port;
+            m_Enabled = true;
+            m_Attempts = 0;
+            m_LocalFailed = false;
+            m_Deadline = Clock::now();
+            Publish(Common::ConnectionStatus::NotConnected);
+        });
+
+    return *this;
+}
+
+Connection& Connection::Disconnect()
+{
+    m_Active = false;
+    m_Reactor.Post([this]() -> void
+        {
+            m_Enabled = false;
+            Close();
+            Publish(Common::ConnectionStatus::NotConnected);
+        });
+
+    return *this;
+}
+
+Connection& Connection::Send(std::vector<uint8_t>&& Frames, uint32_t Epoch)
+{
+    m_Reactor.Post([this, Frames = std::move(Frames), Epoch]() -> void
+        {
+            if (m_State == Common::ConnectionStatus::Connected && (Epoch == 0 || Epoch == m_Epoch))
+            {
+                m_Output.Bytes(Frames.data(), Frames.size());
+                if (!Flush())
+                {
+                    OnDisconnected();
+                }
+            }
+        });
+
+    return *this;
+}
+
+bool Connection::Receive(std::vector<uint8_t>& Frames)
+{
+    Frames.clear();
+
+    std::lock_guard<std::mutex> Lock { m_ReceivedMutex };
+    Frames.swap(m_Received.Buffer());
+    m_Received.Clear();
+    return !Frames.empty();
+}
+
+uint32_t Connection::Epoch() const
+{
+    return m_Epoch;
+}
+
+bool Connection::PollStatus(Status& Out)
+{
+    if (!m_Changed.exchange(false))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> Lock { m_StatusMutex };
+    Out = m_Status;
+    return true;
+}
+
+Connection::Status Connection::GetStatus() const
+{
+    std::lock_guard<std::mutex> Lock { m_StatusMutex };
+    return m_Status;
+}
+
+bool Connection::IsActive() const
+{
+    return m_Active || m_Changed;
+}
+
+void Connection::Run()
+{
+    while (m_Running)
+    {
+        m_Reactor.Poll(NextTimeout());
+        Tick();
+    }
+
+    Close();
+}
+
+void Connection::Tick()
+{
+    if (!m_Enabled)
+    {
+        return;
+    }
+
+    const Clock::time_point Now { Clock::now() };
+
+    switch (m_State)
+    {
+    case Common::ConnectionStatus::NotConnected:
+    {
+        if (Now >= m_Deadline)
+        {
+            BeginConnect();
+        }
+    }
+    break;
+
+    case Common::ConnectionStatus::Connecting:
+    {
+        if (Now >= m_Deadline)
+        {
+            OnDisconnected();
+        }
+    }
+    break;
+
+    case Common::ConnectionStatus::Connected:
+    {
+        if (Now >= m_NextHeartbeat)
+        {
+            if (m_MissedHeartbeats >= MaxMissedHeartbeats)
+            {
+                OnDisconnected();
+                break;
+            }
+
+            m_MissedHeartbeats++;
+            m_NextHeartbeat = Now + HeartbeatInterval;
+            SendHeartbeat();
+        }
+    }
+    break;
+
+    default: break;
+    }
+}
+
+int Connection::NextTimeout() const
+{
+    if (!m_Enabled)
+    {
+        return -1;
+    }
+
+    const Clock::time_point Deadline { m_State == Common::ConnectionStatus::Connected ? m_NextHeartbeat : m_Deadline };
+    const std::chrono::milliseconds Remaining { std::chrono::duration_cast<std::chrono::milliseconds>(Deadline - Clock::now()) };
+    return static_cast<int>(std::max<std::chrono::milliseconds::rep>(0, Remaining.count() + 1));
+}
+
+void Connection::BeginConnect()
+{
+    m_Local = false;
+
+    if (!m_LocalFailed && Common::SharedChannel::IsSupported() && IsLoopback(m_Host))
+    {
+        m_Socket = Common::Socket::ConnectUnix(Common::SharedChannel::LocalPath(m_Port).c_str(), false);
+        m_Local = m_Socket.IsValid();
+    }
+
+    if (!m_Socket.IsValid())
+    {
+        m_Socket = Common::Socket::ConnectTCP(m_Host.c_str(), m_Port, false);
+    }
+
+    if (!m_Socket.IsValid())
+    {
+        OnDisconnected();
+        return;
+    }
+
+    m_Reactor.Add(m_Socket.Handle(), Common::Reactor::Writable, [this](uint32_t Events) -> void
+        {
+            OnEvent(Events);
+        });
+
+    m_Deadline = Clock::now() + ConnectTimeout;
+    Publish(Common::ConnectionStatus::Connecting);
+}
+
+void Connection::OnConnected()
+{
+    m_Attempts = 0;
+    m_MissedHeartbeats = 0;
+    m_NextHeartbeat = Clock::now() + HeartbeatInterval;
+    m_Epoch++;
+
+    // The request must be the only thing on the socket until the reply arrives.
+    if (m_Local)
+    {
+        m_Output
+            .Begin(Common::Protocol::MessageType::SharedMemory, ++m_Sequence)
+            .U32(static_cast<uint32_t>(Common::SharedChannel::DefaultCapacity))
+            .End();
+
+        if (!Flush() || !m_Output.Empty())
+        {
+            OnDisconnected();
+            return;
+        }
+
+        m_Upgrading = true;
+    }
+
+    Publish(Common::ConnectionStatus::Connected);
+
+    SendHeartbeat();
+    UpdateInterest();
+}
+
+void Connection::OnDisconnected()
+{
+    if (m_Local && (m_State != Common::ConnectionStatus::Connected || m_Upgrading))
+    {
+        m_LocalFailed = true;
+    }
+
+    Close();
+
+    if (m_Enabled)
+    {
+        // Exponential backoff with jitter so that many clients losing the same server do
+        // not all reconnect in lockstep.
+        const uint32_t Shift { std::min<uint32_t>(m_Attempts, 16) };
+        const std::chrono::milliseconds Delay { std::min(BackoffMax, BackoffBase * (1 << Shift)) };
+        std::uniform_int_distribution<std::chrono::milliseconds::rep> Jitter { 0, Delay.count() / 2 };
+
+        m_Attempts++;
+        m_Deadline = Clock::now() + Delay / 2 + std::chrono::milliseconds { Jitter(m_Random) };
+    }
+
+    Publish(Common::ConnectionStatus::NotConnected);
+}
+
+void Connection::OnEvent(uint32_t Events)
+{
+    if (m_State == Common::ConnectionStatus::Connecting)
+    {
+        if ((Events & Common::Reactor::Hangup) == 0 && m_Socket.FinishConnect())
+        {
+            OnConnected();
+        }
+        else
+        {
+            OnDisconnected();
+        }
+
+        return;
+    }
+
+    if ((Events & Common::Reactor::Readable) != 0 && !Read())
+    {
+        OnDisconnected();
+        return;
+    }
+
+    if ((Events & Common::Reactor::Writable) != 0 && !Flush())
+    {
+        OnDisconnected();
+        return;
+    }
+
+    if ((Events & Common::Reactor::Hangup) != 0 && (Events & Common::Reactor::Readable) == 0)
+    {
+        OnDisconnected();
+    }
+}
+
+void Connection::OnDoorbell()
+{
+    m_Channel.ClearDoorbell();
+
+    // The doorbell rings both for new messages and for room to send more.
+    bool Valid { true };
+    Valid = m_Channel.Receive([this, &Valid](const Common::Protocol::MessageView& Message) -> void
+        {
+            Valid = Dispatch(Message) && Valid;
+        }) && Valid;
+
+    if (!Valid || !Flush())
+    {
+        OnDisconnected();
+    }
+}
+
+bool Connection::Read()
+{
+    bool Closed { false };
+
+    while (true)
+    {
+        const size_t Offset { m_Input.size() };
+        m_Input.resize(Offset + ReadSize);
+
+        const Common::IOResult Result { m_Local ? m_Socket.Receive(m_Input.data() + Offset, ReadSize, m_Handles) : m_Socket.Receive(m_Input.data() + Offset, ReadSize) };
+        m_Input.resize(Offset + Result.Bytes);
+
+        if (Result.Status == Common::IOStatus::WouldBlock)
+        {
+            break;
+        }
+
+        if (Result.Status != Common::IOStatus::Ok)
+        {
+            Closed = true;
+            break;
+        }
+    }
+
+    Common::Protocol::MessageReader Reader { m_Input.data(), m_Input.size() };
+    Common::Protocol::MessageView Message {};
+    Common::Protocol::ParseStatus Status { Common::Protocol::ParseStatus::Ok };
+
+    while ((Status = Reader.Next(Message)) == Common::Protocol::ParseStatus::Ok)
+    {
+        if (!Dispatch(Message))
+        {
+            Closed = true;
+            break;
+        }
+    }
+
+    m_Input.erase(m_Input.begin(), m_Input.begin() + Reader.Consumed());
+    return !Closed && Status != Common::Protocol::ParseStatus::Invalid;
+}
+
+bool Connection::Dispatch(const Common::Protocol::MessageView& Message)
+{
+    if (Message.Type == Common::Protocol::MessageType::HeartbeatAck)
+    {
+        Common::Protocol::PayloadReader Payload { Message };
+        uint64_t Sent { 0 };
+
+        if (Payload.U64(Sent))
+        {
+            const uint64_t Now { static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count()) };
+            m_RTT = static_cast<float>(Now - Sent) / 1000000.0f;
+            m_MissedHeartbeats = 0;
+            Publish(m_State);
+        }
+    }
+    else if (Message.Type == Common::Protocol::MessageType::ExecutionResult
+        || Message.Type == Common::Protocol::MessageType::ExecutionSummary
+        || Message.Type == Common::Protocol::MessageType::Error
+        || Message.Type == Common::Protocol::MessageType::GraphEdit
+        || Message.Type == Common::Protocol::MessageType::Joined
+        || Message.Type == Common::Protocol::MessageType::TextEdit
+        || Message.Type == Common::Protocol::MessageType::MoveBatch)
+    {
+        std::lock_guard<std::mutex> Lock { m_ReceivedMutex };
+        m_Received
+            .Begin(Message.Type, Message.Sequence)
+            .Bytes(Message.Payload, Message.Size)
+            .End();
+    }
+    else if (Message.Type == Common::Protocol::MessageType::SharedMemory)
+    {
+        return Upgrade(Message);
+    }
+
+    return true;
+}
+
+bool Connection::Upgrade(const Common::Protocol::MessageView& Message)
+{
+    if (!m_Upgrading)
+    {
+        return true;
+    }
+
+    Common::Protocol::PayloadReader Payload { Message };
+    uint32_t Capacity { 0 };
+    m_Upgrading = false;
+
+    // A declined upgrade leaves the connection on the local socket, which works as well
+    // as TCP does.
+    if (Payload.U32(Capacity) && Capacity != 0)
+    {
+        m_Channel = Common::SharedChannel::Open(m_Handles.data(), m_Handles.size());
+        m_Handles.clear();
+
+        if (!m_Channel.IsValid())
+        {
+            m_LocalFailed = true;
+            return false;
+        }
+
+        m_Reactor.Add(m_Channel.Doorbell(), Common::Reactor::Readable, [this](uint32_t) -> void
+            {
+                OnDoorbell();
+            });
+    }
+
+    return Flush();
+}
+
+bool Connection::Flush()
+{
+    // Held back until the server has answered the upgrade request.
+    if (m_Upgrading)
+    {
+        return true;
+    }
+
+    const std::vector<uint8_t>& Buffer { m_Output.Buffer() };
+
+    if (m_Channel.IsValid())
+    {
+        m_OutputOffset += m_Channel.Send(Buffer.data() + m_OutputOffset, Buffer.size() - m_OutputOffset);
+    }
+
+    while (!m_Channel.IsValid() && m_OutputOffset < Buffer.size())
+    {
+        const Common::IOResult Result { m_Socket.Send(Buffer.data() + m_OutputOffset, Buffer.size() - m_OutputOffset) };
+
+        if (Result.Status == Common::IOStatus::WouldBlock)
+        {
+            break;
+        }
+
+        if (Result.Status != Common::IOStatus::Ok)
+        {
+            return false;
+        }
+
+        m_OutputOffset += Result.Bytes;
+    }
+
+    if (m_OutputOffset == Buffer.size())
+    {
+        m_Output.Clear();
+        m_OutputOffset = 0;
+    }
+
+    UpdateInterest();
+    return true;
+}
+
+void Connection::UpdateInterest()
+{
+    if (!m_Socket.IsValid())
+    {
+        return;
+    }
+
+    uint32_t Events { Common::Reactor::Readable };
+
+    if (!m_Output.Empty() && !m_Upgrading && !m_Channel.IsValid())
+    {
+        Events |= Common::Reactor::Writable;
+    }
+
+    m_Reactor.Modify(m_Socket.Handle(), Events);
+}
+
+void Connection::SendHeartbeat()
+{
+    const uint64_t Now { static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count()) };
+
+    m_Output
+        .Begin(Common::Protocol::MessageType::Heartbeat, ++m_Sequence)
+        .U64(Now)
+        .End();
+
+    if (!Flush())
+    {
+        OnDisconnected();
+    }
+}
+
+void Connection::Close()
+{
+    if (m_Channel.IsValid())
+    {
+        m_Reactor.Remove(m_Channel.Doorbell());
+        m_Channel.Close();
+    }
+
+#if !defined(_WIN32)
+    for (int Handle : m_Handles)
+    {
+        close(Handle);
+    }
+#endif
+
+    if (m_Socket.IsValid())
+    {
+        m_Reactor.Remove(m_Socket.Handle());
+        m_Socket.Close();
+    }
+
+    m_Handles.clear();
+    m_Upgrading = false;
+
+    m_Input.clear();
+    m_Output.Clear();
+    m_OutputOffset = 0;
+}
+
+void Connection::Publish(Common::ConnectionStatus State)
+{
+    m_State = State;
+
+    {
+        std::lock_guard<std::mutex> Lock { m_StatusMutex };
+        m_Status.State = m_State;
+        m_Status.RTT = m_RTT;
+        m_Status.Attempts = m_Attempts;
+    }
+
+    m_Changed = true;
+}
+
+}
+}
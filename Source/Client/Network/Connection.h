@@ -0,0 +1,150 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "../../Common/ConnectionStatus.h"
+#include "../../Common/Network/Protocol.h"
+#include "../../Common/Network/Reactor.h"
+#include "../../Common/Network/SharedChannel.h"
+#include "../../Common/Network/Socket.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Snippet
+{
+namespace Client
+{
+
+//
+// Owns the client's connection to SnippetServer. All socket work happens on a dedicated
+// network thread. The GUI thread only calls Connect/Disconnect/Send, which are queued onto
+// that thread, and polls for status changes with PollStatus and for everything else the
+// server sends with Receive, neither of which waits on the network.
+//
+// When the server is on this host, the connection is made over the server's local socket
+// instead of TCP and upgraded to a SharedChannel as soon as it is established. Anything
+// sent while the upgrade is pending is held back and goes through the channel.
+//
+
+class Connection
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Status
+    {
+        Common::ConnectionStatus State { Common::ConnectionStatus::NotConnected };
+        float RTT { 0.0f };
+        uint32_t Attempts { 0 };
+    };
+
+    Connection();
+    ~Connection();
+
+    Connection& Connect(const std::string& Host, uint16_t Port);
+    Connection& Disconnect();
+    // With a non-zero Epoch, Frames are dropped unless they can be sent on that same
+    // connection, so nothing meant for a session that has since been lost reaches a new one.
+    Connection& Send(std::vector<uint8_t>&& Frames, uint32_t Epoch = 0);
+
+    // Moves the execution results, errors and room messages received since the last
+    // call into Frames, still framed for a MessageReader.
+    bool Receive(std::vector<uint8_t>& Frames);
+
+    // Incremented every time a connection is established. The server keeps no state
+    // across connections, so a new epoch means everything sent before it is gone.
+    uint32_t Epoch() const;
+
+    bool PollStatus(Status& Out);
+    Status GetStatus() const;
+    bool IsActive() const;
+
+private:
+    void Run();
+    void Tick();
+    int NextTimeout() const;
+
+    void BeginConnect();
+    void OnConnected();
+    void OnDisconnected();
+    void OnEvent(uint32_t Events);
+    void OnDoorbell();
+    bool Read();
+    bool Dispatch(const Common::Protocol::MessageView& Message);
+    bool Upgrade(const Common::Protocol::MessageView& Message);
+    bool Flush();
+    void UpdateInterest();
+    void SendHeartbeat();
+    void Close();
+
+    void Publish(Common::ConnectionStatus State);
+
+    Common::Reactor m_Reactor {};
+    std::thread m_Thread {};
+    std::atomic<bool> m_Running { false };
+    std::atomic<bool> m_Active { false };
+
+    // Only touched on the network thread.
+    Common::Socket m_Socket {};
+    Common::ConnectionStatus m_State { Common::ConnectionStatus::NotConnected };
+    std::string m_Host {};
+    uint16_t m_Port { 0 };
+    bool m_Enabled { false };
+    uint32_t m_Attempts { 0 };
+    uint32_t m_Sequence { 0 };
+    uint32_t m_MissedHeartbeats { 0 };
+    float m_RTT { 0.0f };
+    Clock::time_point m_Deadline {};
+    Clock::time_point m_NextHeartbeat {};
+    std::mt19937 m_Random {};
+    std::vector<uint8_t> m_Input {};
+    Common::Protocol::MessageWriter m_Output {};
+    size_t m_OutputOffset { 0 };
+    Common::SharedChannel m_Channel {};
+    std::vector<int> m_Handles {};
+    bool m_Local { false };
+    bool m_Upgrading { false };
+    // Set once a local connection fails, so reconnects go straight to TCP.
+    bool m_LocalFailed { false };
+
+    // Shared with the GUI thread.
+    mutable std::mutex m_StatusMutex {};
+    Status m_Status {};
+    std::atomic<bool> m_Changed { false };
+    std::atomic<uint32_t> m_Epoch { 0 };
+    std::mutex m_ReceivedMutex {};
+    Common::Protocol::MessageWriter m_Received {};
+};
+
+}
+}
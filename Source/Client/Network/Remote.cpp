@@ -0,0 +1,776 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Remote.h"
+#include "../../Common/Hash.h"
+#include "../../Common/Unicode.h"
+#include "Connection.h"
+
+namespace Snippet
+{
+namespace Client
+{
+
+Remote::Remote(const std::shared_ptr<Connection>& Connection_)
+    : m_Connection(Connection_)
+{
+}
+
+Remote& Remote::SetOnResult(OnResultSignature&& Fn)
+{
+    m_OnResult = std::move(Fn);
+    return *this;
+}
+
+Remote& Remote::SetOnFinished(OnFinishedSignature&& Fn)
+{
+    m_OnFinished = std::move(Fn);
+    return *this;
+}
+
+Remote& Remote::SetOnEdit(OnEditSignature&& Fn)
+{
+    m_OnEdit = std::move(Fn);
+    return *this;
+}
+
+Remote& Remote::SetOnJoined(OnJoinedSignature&& Fn)
+{
+    m_OnJoined = std::move(Fn);
+    return *this;
+}
+
+Remote& Remote::SetOnStatus(OnStatusSignature&& Fn)
+{
+    m_OnStatus = std::move(Fn);
+    return *this;
+}
+
+bool Remote::IsAvailable() const
+{
+    return m_Connection != nullptr && m_Connection->GetStatus().State == Common::ConnectionStatus::Connected;
+}
+
+bool Remote::IsRunning() const
+{
+    return m_Run != 0;
+}
+
+Remote& Remote::Forward(const Common::JournalRecord& Record)
+{
+    if (!m_Room.empty())
+    {
+        // Nothing goes to a room before it has been joined. A room that was empty is then
+        // filled with the graph as it is by that time, and any other replaces it.
+        if (!IsJoined())
+        {
+            return *this;
+        }
+
+        if (Record.Kind == Common::JournalKind::MoveNode)
+        {
+            return Move(Record.Node, Record.Position);
+        }
+
+        if (Record.Kind == Common::JournalKind::EditSource)
+        {
+            if (Record.Removed == 0 && Record.Text.empty())
+            {
+                return *this;
+            }
+
+            Text& State { m_Texts[Record.Node] };
+            State.Pending.push_back({ Record.Offset, Record.Removed, std::string { Record.Text } });
+            return State.InFlight == 0 ? SendText(Record.Node) : *this;
+        }
+    }
+    // Until the server has a copy, the next run sends the graph as it is by then.
+    else if (!IsSynced())
+    {
+        return *this;
+    }
+
+    Common::Protocol::GraphEdit Edit {};
+    Edit.Node = Record.Node;
+    Edit.Target = Record.Target;
+    Edit.X = Record.Position.X;
+    Edit.Y = Record.Position.Y;
+    Edit.Text = Record.Text;
+
+    switch (Record.Kind)
+    {
+    case Common::JournalKind::CreateNode: Edit.Kind = Common::Protocol::EditKind::CreateNode; m_Nodes[Record.Node] = 0; break;
+    case Common::JournalKind::DeleteNode: Edit.Kind = Common::Protocol::EditKind::DeleteNode; m_Nodes.erase(Record.Node); break;
+    case Common::JournalKind::MoveNode: Edit.Kind = Common::Protocol::EditKind::MoveNode; break;
+    case Common::JournalKind::RenameNode: Edit.Kind = Common::Protocol::EditKind::RenameNode; break;
+    // Every snippet has one input and one output, which is what the server connects.
+    case Common::JournalKind::Connect: Edit.Kind = Common::Protocol::EditKind::Connect; break;
+    case Common::JournalKind::Disconnect: Edit.Kind = Common::Protocol::EditKind::Disconnect; break;
+    // Sources are compared by hash when the next run starts.
+    case Common::JournalKind::EditSource:
+    case Common::JournalKind::Base:
+    default: return *this;
+    }
+
+    m_Output.Write(Edit, ++m_Sequence);
+
+    if (Record.Kind == Common::JournalKind::RenameNode && IsJoined())
+    {
+        m_PendingNames[Record.Node] = m_Sequence;
+    }
+    else if (Record.Kind == Common::JournalKind::DeleteNode)
+    {
+        m_Texts.erase(Record.Node);
+        m_Positions.erase(Record.Node);
+        m_Moves.erase(Record.Node);
+        m_PendingMoves.erase(Record.Node);
+        m_PendingNames.erase(Record.Node);
+    }
+
+    return *this;
+}
+
+Remote& Remote::Invalidate()
+{
+    m_Synced = false;
+    return *this;
+}
+
+Remote& Remote::Join(const std::string& Room)
+{
+    if (Room == m_Room)
+    {
+        return *this;
+    }
+
+    // Another room is joined by the next Update. The server leaves the current one first.
+    const bool Leave { Room.empty() && m_Join != 0 && IsAvailable() && m_Connection->Epoch() == m_Epoch };
+    m_Room = Room;
+    m_Join = 0;
+
+    if (Leave)
+    {
+        ResetRoom();
+        m_Join = ++m_Sequence;
+        m_Output
+            .Begin(Common::Protocol::MessageType::Join, m_Join)
+            .String({})
+            .End();
+        Flush();
+    }
+
+    return *this;
+}
+
+bool Remote::IsJoined() const
+{
+    return m_Member != 0 && m_Connection != nullptr && m_Connection->Epoch() == m_Epoch;
+}
+
+Remote& Remote::Publish(const Common::Graph& Model, const SourceSignature& Source)
+{
+    if (!IsJoined())
+    {
+        return *this;
+    }
+
+    WriteGraph(Model);
+
+    // Sources go in as edits like any other, so the room has their revisions.
+    Model.ForEachNode([&](Common::NodeHandle Handle, const Common::Graph::Node& Node) -> void
+        {
+            const std::string_view Contents { Node.Source.empty() && Source ? Source(Handle) : std::string_view { Node.Source } };
+            Text& State { m_Texts[Node.ID] };
+
+            if (!Contents.empty())
+            {
+                State.Pending.push_back({ 0, 0, std::string { Contents } });
+
+                if (State.InFlight == 0)
+                {
+                    SendText(Node.ID);
+                }
+            }
+        });
+
+    return Flush();
+}
+
+Remote& Remote::Move(Common::NodeID Node, const Common::Point& Position)
+{
+    if (IsJoined())
+    {
+        m_Moves[Node] = Position;
+    }
+
+    return *this;
+}
+
+bool Remote::Execute(const Common::Graph& Model, const SourceSignature& Source, std::string* Error)
+{
+    const char* Reason { nullptr };
+
+    if (!IsAvailable())
+    {
+        Reason = "not connected to a server";
+    }
+    else if (IsRunning())
+    {
+        Reason = "a run is already in progress";
+    }
+    else if (!m_Room.empty() && !IsJoined())
+    {
+        Reason = "still joining the room";
+    }
+
+    if (Reason != nullptr)
+    {
+        if (Error != nullptr)
+        {
+            *Error = Reason;
+        }
+
+        return false;
+    }
+
+    // A room's copy is kept up to date as edits are made.
+    if (IsJoined())
+    {
+        SendMoves();
+        m_Run = ++m_Sequence;
+        m_Output.Write(Common::Protocol::MessageType::Execute, m_Run);
+        Flush();
+        return true;
+    }
+
+    if (!IsSynced())
+    {
+        Sync(Model);
+    }
+
+    Model.ForEachNode([&](Common::NodeHandle Handle, const Common::Graph::Node& Node) -> void
+        {
+            // A node loaded from a project keeps its source in the file until it is opened.
+            const bool Stored { Node.Source.empty() && Source };
+            const std::string_view Text { Stored ? Source(Handle) : std::string_view { Node.Source } };
+            const uint64_t Hash { Stored ? Common::Hash(Text) : Node.SourceHash };
+            uint64_t& Sent { m_Nodes[Node.ID] };
+
+            if (Sent != Hash)
+            {
+                Common::Protocol::SnippetSource Message {};
+                Message.Node = Node.ID;
+                Message.Hash = Hash;
+                Message.Source = Text;
+                m_Output.Write(Message, ++m_Sequence);
+                Sent = Hash;
+            }
+        });
+
+    m_Run = ++m_Sequence;
+    m_Output.Write(Common::Protocol::MessageType::Execute, m_Run);
+    Flush();
+    return true;
+}
+
+void Remote::Update()
+{
+    // Joined again on every new connection, since the server forgets who was in a room.
+    if (!m_Room.empty() && IsAvailable() && (m_Join == 0 || m_Connection->Epoch() != m_Epoch))
+    {
+        SendJoin();
+    }
+
+    SendMoves();
+    Flush();
+
+    if (IsRunning() && (m_Connection->Epoch() != m_Epoch || !IsAvailable()))
+    {
+        Finish(nullptr, "lost the connection to the server");
+    }
+
+    if (m_Connection == nullptr || !m_Connection->Receive(m_Frames))
+    {
+        return;
+    }
+
+    Common::Protocol::MessageReader Reader { m_Frames.data(), m_Frames.size() };
+    Common::Protocol::MessageView Message {};
+
+    while (Reader.Next(Message) == Common::Protocol::ParseStatus::Ok)
+    {
+        switch (Message.Type)
+        {
+        case Common::Protocol::MessageType::ExecutionResult:
+        {
+            Common::Protocol::ExecutionResult Decoded {};
+
+            if (Message.Sequence == m_Run && Common::Protocol::Decode(Message, Decoded) && m_OnResult)
+            {
+                m_OnResult({ Decoded.Node, Decoded.Status, Decoded.Seconds, std::string { Decoded.Output }, std::string { Decoded.Log } });
+            }
+        }
+        break;
+
+        case Common::Protocol::MessageType::ExecutionSummary:
+        {
+            Common::Protocol::ExecutionSummary Summary {};
+
+            if (Message.Sequence == m_Run && Common::Protocol::Decode(Message, Summary))
+            {
+                Finish(&Summary, {});
+            }
+        }
+        break;
+
+        case Common::Protocol::MessageType::Error:
+        {
+            Common::Protocol::PayloadReader Payload { Message };
+            std::string_view Text {};
+            Payload.String(Text);
+
+            if (Message.Sequence == m_Run)
+            {
+                Finish(nullptr, std::string { Text });
+            }
+            else if (!m_Room.empty())
+            {
+                // Joining again replaces the canvas with the room's graph as it is now.
+                m_Join = 0;
+
+                if (m_OnStatus)
+                {
+                    m_OnStatus("Room rejected an update: " + std::string { Text } + ". Rejoining to catch up.");
+                }
+            }
+            else if (Message.Sequence >= m_Baseline)
+            {
+                // The server's copy no longer matches the canvas. Rather than guess how,
+                // the next run replaces it.
+                Invalidate();
+
+                if (m_OnStatus)
+                {
+                    m_OnStatus("Server rejected an update: " + std::string { Text } + ". The next run sends the whole graph.");
+                }
+            }
+        }
+        break;
+
+        case Common::Protocol::MessageType::Joined: OnJoined(Message); break;
+        case Common::Protocol::MessageType::GraphEdit: OnGraphEdit(Message); break;
+        case Common::Protocol::MessageType::TextEdit: OnTextEdit(Message); break;
+        case Common::Protocol::MessageType::MoveBatch: OnMoveBatch(Message); break;
+
+        default: break;
+        }
+    }
+}
+
+bool Remote::IsSynced() const
+{
+    return m_Synced && m_Connection != nullptr && m_Connection->Epoch() == m_Epoch;
+}
+
+Remote& Remote::Flush()
+{
+    if (m_Output.Empty())
+    {
+        return *this;
+    }
+
+    // Queued for the epoch the messages were written for, so none of them can reach a
+    // newer session that never saw the ones before.
+    if (m_Connection != nullptr)
+    {
+        m_Connection->Send(std::move(m_Output.Buffer()), m_Epoch);
+    }
+
+    m_Output.Clear();
+    return *this;
+}
+
+Remote& Remote::Sync(const Common::Graph& Model)
+{
+    // Edits forwarded for the previous copy go out first, on the epoch they were meant for.
+    Flush();
+
+    const uint32_t Epoch { m_Connection->Epoch() };
+
+    // A copy on the same session is emptied first. A new session starts out empty.
+    if (Epoch == m_Epoch)
+    {
+        for (const std::pair<const Common::NodeID, uint64_t>& Item : m_Nodes)
+        {
+            Common::Protocol::GraphEdit Edit {};
+            Edit.Kind = Common::Protocol::EditKind::DeleteNode;
+            Edit.Node = Item.first;
+            m_Output.Write(Edit, ++m_Sequence);
+        }
+    }
+
+    m_Nodes.clear();
+    m_Epoch = Epoch;
+    m_Synced = true;
+    m_Baseline = m_Sequence + 1;
+
+    Model.ForEachNode([this](Common::NodeHandle, const Common::Graph::Node& Node) -> void
+        {
+            m_Nodes[Node.ID] = 0;
+        });
+
+    return WriteGraph(Model);
+}
+
+Remote& Remote::WriteGraph(const Common::Graph& Model)
+{
+    Model.ForEachNode([this](Common::NodeHandle, const Common::Graph::Node& Node) -> void
+        {
+            const std::string Name { Common::ToUTF8(Node.Name) };
+            Common::Protocol::GraphEdit Edit {};
+            Edit.Kind = Common::Protocol::EditKind::CreateNode;
+            Edit.Node = Node.ID;
+            Edit.X = Node.Position.X;
+            Edit.Y = Node.Position.Y;
+            Edit.Text = Name;
+            m_Output.Write(Edit, ++m_Sequence);
+        });
+
+    Model.ForEachConnection([&](Common::ConnectionHandle, const Common::Graph::Connection& Item) -> void
+        {
+            const Common::Graph::Port* From { Model.GetPort(Item.From) };
+            const Common::Graph::Port* To { Model.GetPort(Item.To) };
+
+            if (From == nullptr || To == nullptr)
+            {
+                return;
+            }
+
+            Common::Protocol::GraphEdit Edit {};
+            Edit.Kind = Common::Protocol::EditKind::Connect;
+            Edit.Node = Model.GetID(From->Owner);
+            Edit.Target = Model.GetID(To->Owner);
+            m_Output.Write(Edit, ++m_Sequence);
+        });
+
+    return *this;
+}
+
+void Remote::Finish(const Common::Protocol::ExecutionSummary* Summary, const std::string& Error)
+{
+    m_Run = 0;
+
+    if (m_OnFinished)
+    {
+        m_OnFinished(Summary, Error);
+    }
+}
+
+Remote& Remote::SendJoin()
+{
+    // Edits meant for the previous connection go out on it, if it is still there.
+    Flush();
+    ResetRoom();
+
+    // The session's own copy of the graph is not kept up to date while in a room.
+    m_Epoch = m_Connection->Epoch();
+    m_Synced = false;
+    m_Join = ++m_Sequence;
+    m_Output
+        .Begin(Common::Protocol::MessageType::Join, m_Join)
+        .String(m_Room)
+        .End();
+
+    return Flush();
+}
+
+Remote& Remote::SendMoves()
+{
+    if (!IsJoined())
+    {
+        m_Moves.clear();
+        return *this;
+    }
+
+    for (const std::pair<const Common::NodeID, Common::Point>& Item : m_Moves)
+    {
+        Common::Protocol::GraphEdit Edit {};
+        Edit.Kind = Common::Protocol::EditKind::MoveNode;
+        Edit.Node = Item.first;
+        Edit.X = Item.second.X;
+        Edit.Y = Item.second.Y;
+        m_Output.Write(Edit, ++m_Sequence);
+        m_PendingMoves[Item.first] = m_Sequence;
+    }
+
+    m_Moves.clear();
+    return *this;
+}
+
+Remote& Remote::SendText(Common::NodeID Node)
+{
+    Text& State { m_Texts[Node] };
+
+    if (State.Pending.empty())
+    {
+        State.InFlight = 0;
+        return *this;
+    }
+
+    const Common::TextOp& Op { State.Pending.front() };
+    Common::Protocol::TextEdit Edit {};
+    Edit.Node = Node;
+    Edit.Revision = State.Revision;
+    Edit.Offset = static_cast<uint32_t>(Op.Offset);
+    Edit.Removed = static_cast<uint32_t>(Op.Removed);
+    Edit.Inserted = Op.Inserted;
+
+    State.InFlight = ++m_Sequence;
+    m_Output.Write(Edit, State.InFlight);
+    return *this;
+}
+
+Remote& Remote::ResetRoom()
+{
+    m_Member = 0;
+    m_Texts.clear();
+    m_Positions.clear();
+    m_Moves.clear();
+    m_PendingMoves.clear();
+    m_PendingNames.clear();
+    return *this;
+}
+
+void Remote::OnJoined(const Common::Protocol::MessageView& Message)
+{
+    Common::Protocol::Joined Reply {};
+
+    if (Message.Sequence != m_Join || !Common::Protocol::Decode(Message, Reply))
+    {
+        return;
+    }
+
+    ResetRoom();
+    m_Member = Reply.Member;
+
+    if (m_Member == 0)
+    {
+        Invalidate();
+    }
+    else if (!Reply.Fresh && m_OnEdit)
+    {
+        m_OnEdit(Common::JournalRecord {});
+    }
+
+    if (m_OnJoined)
+    {
+        m_OnJoined(Reply);
+    }
+}
+
+void Remote::OnGraphEdit(const Common::Protocol::MessageView& Message)
+{
+    Common::Protocol::GraphEdit Edit {};
+
+    if (m_Member == 0 || !Common::Protocol::Decode(Message, Edit))
+    {
+        return;
+    }
+
+    // Edits this side made come back with the sequence they were sent with.
+    const bool Own { Message.Sequence != 0 };
+    Common::JournalRecord Record {};
+    Record.Node = Edit.Node;
+    Record.Target = Edit.Target;
+    Record.Position = { Edit.X, Edit.Y };
+    Record.Text = Edit.Text;
+
+    switch (Edit.Kind)
+    {
+    case Common::Protocol::EditKind::CreateNode:
+    {
+        Record.Kind = Common::JournalKind::CreateNode;
+        m_Positions[Edit.Node] = { Common::Protocol::Quantize(Edit.X), Common::Protocol::Quantize(Edit.Y) };
+    }
+    break;
+
+    case Common::Protocol::EditKind::DeleteNode:
+    {
+        Record.Kind = Common::JournalKind::DeleteNode;
+        m_Texts.erase(Edit.Node);
+        m_Positions.erase(Edit.Node);
+        m_Moves.erase(Edit.Node);
+        m_PendingMoves.erase(Edit.Node);
+        m_PendingNames.erase(Edit.Node);
+    }
+    break;
+
+    case Common::Protocol::EditKind::RenameNode:
+    {
+        Record.Kind = Common::JournalKind::RenameNode;
+        const std::unordered_map<Common::NodeID, uint32_t>::const_iterator It { m_PendingNames.find(Edit.Node) };
+
+        if (It != m_PendingNames.end())
+        {
+            if (Own && It->second <= Message.Sequence)
+            {
+                m_PendingNames.erase(It);
+            }
+
+            return;
+        }
+    }
+    break;
+
+    // Every snippet's ports are its input and then its output.
+    case Common::Protocol::EditKind::Connect:
+    case Common::Protocol::EditKind::Disconnect:
+    {
+        Record.Kind = Edit.Kind == Common::Protocol::EditKind::Connect ? Common::JournalKind::Connect : Common::JournalKind::Disconnect;
+        Record.Port = 1;
+        Record.TargetPort = 0;
+    }
+    break;
+
+    case Common::Protocol::EditKind::MoveNode:
+    default: return;
+    }
+
+    if (!Own && m_OnEdit)
+    {
+        m_OnEdit(Record);
+    }
+}
+
+void Remote::OnTextEdit(const Common::Protocol::MessageView& Message)
+{
+    Common::Protocol::TextEdit Edit {};
+
+    if (m_Member == 0 || !Common::Protocol::Decode(Message, Edit))
+    {
+        return;
+    }
+
+    const std::unordered_map<Common::NodeID, Text>::iterator It { m_Texts.find(Edit.Node) };
+
+    // The server has taken the edit in flight. The next one is made against the revision
+    // it produced.
+    if (Message.Sequence != 0)
+    {
+        if (It != m_Texts.end() && It->second.InFlight == Message.Sequence)
+        {
+            It->second.Revision = Edit.Revision;
+            It->second.Pending.pop_front();
+            SendText(Edit.Node);
+        }
+
+        return;
+    }
+
+    if (m_Positions.find(Edit.Node) == m_Positions.end())
+    {
+        return;
+    }
+
+    // The server ordered this before every edit still pending here, which it has not seen
+    // yet. Each is moved past it, and it past each of them, before it is applied.
+    Text& State { m_Texts[Edit.Node] };
+    Common::TextOp Op { Edit.Offset, Edit.Removed, std::string { Edit.Inserted } };
+
+    for (Common::TextOp& Pending : State.Pending)
+    {
+        Common::TextOp::Transform(Op, Pending);
+    }
+
+    State.Revision = Edit.Revision;
+
+    if (!Op.IsEmpty() && m_OnEdit)
+    {
+        Common::JournalRecord Record {};
+        Record.Kind = Common::JournalKind::EditSource;
+        Record.Node = Edit.Node;
+        Record.Offset = static_cast<uint32_t>(Op.Offset);
+        Record.Removed = static_cast<uint32_t>(Op.Removed);
+        Record.Text = Op.Inserted;
+        m_OnEdit(Record);
+    }
+}
+
+void Remote::OnMoveBatch(const Common::Protocol::MessageView& Message)
+{
+    Common::Protocol::MoveBatch Batch {};
+
+    if (m_Member == 0 || !Common::Protocol::Decode(Message, Batch))
+    {
+        return;
+    }
+
+    // Moves this side made up to the group's sequence have all been ordered by now, so
+    // anyone else's moves in the batch came after them.
+    for (const Common::Protocol::MoveBatch::Group& Group : Batch.Groups)
+    {
+        if (Group.Member != m_Member)
+        {
+            continue;
+        }
+
+        for (std::unordered_map<Common::NodeID, uint32_t>::iterator It = m_PendingMoves.begin(); It != m_PendingMoves.end();)
+        {
+            It = It->second <= Group.Sequence ? m_PendingMoves.erase(It) : std::next(It);
+        }
+    }
+
+    for (const Common::Protocol::MoveBatch::Group& Group : Batch.Groups)
+    {
+        for (const Common::Protocol::MoveBatch::Move& Move_ : Group.Moves)
+        {
+            const std::unordered_map<Common::NodeID, Position>::iterator It { m_Positions.find(Move_.Node) };
+
+            if (It == m_Positions.end())
+            {
+                continue;
+            }
+
+            It->second.X = static_cast<int32_t>(It->second.X + Move_.X);
+            It->second.Y = static_cast<int32_t>(It->second.Y + Move_.Y);
+
+            const bool Local { Group.Member == m_Member || m_PendingMoves.count(Move_.Node) > 0 || m_Moves.count(Move_.Node) > 0 };
+            if (Local || !m_OnEdit)
+            {
+                continue;
+            }
+
+            Common::JournalRecord Record {};
+            Record.Kind = Common::JournalKind::MoveNode;
+            Record.Node = Move_.Node;
+            Record.Position = { Common::Protocol::Dequantize(It->second.X), Common::Protocol::Dequantize(It->second.Y) };
+            m_OnEdit(Record);
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,195 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "../../Common/Graph/Graph.h"
+#include "../../Common/Network/Protocol.h"
+#include "../../Common/Storage/Journal.h"
+#include "../../Common/Storage/ProjectFile.h"
+#include "../../Common/Text/TextOp.h"
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Snippet
+{
+namespace Client
+{
+
+class Connection;
+
+//
+// Runs the canvas's graph on SnippetServer. The server's copy of the graph is kept in
+// step incrementally: structural edits are forwarded as they are journaled, and sources
+// are only sent for nodes whose hash differs from the one the server last received. The
+// first run on a new connection, or after Invalidate, sends the whole graph. Nothing
+// here waits on the network: messages are queued onto the connection's thread, and
+// results it has received are handed out from Update on the GUI thread.
+//
+// After Join, the graph is shared with everyone else in the same room on the server
+// instead. Every edit is sent as it is made, and edits made by others are handed to
+// OnEdit as journal records. Anything this side changed and has not yet seen come back
+// from the server keeps its local value, since the server ordered the other edits
+// before it. Source edits still in flight are transformed against the ones that arrive
+// meanwhile, and only one edit per node is in flight at a time. Positions of dragged
+// nodes are sent at most once per Update.
+//
+
+class Remote
+{
+public:
+    struct Result
+    {
+        Common::NodeID Node { Common::InvalidNodeID };
+        Common::Protocol::ResultStatus Status { Common::Protocol::ResultStatus::Success };
+        double Seconds { 0.0 };
+        std::string Output {};
+        std::string Log {};
+    };
+
+    using SourceSignature = Common::ProjectFile::SourceSignature;
+    using OnResultSignature = std::function<void(const Result&)>;
+    // Summary is null when the run could not be started or was lost with the connection,
+    // and Error says why.
+    using OnFinishedSignature = std::function<void(const Common::Protocol::ExecutionSummary* Summary, const std::string& Error)>;
+    // A Base record means the canvas is to be emptied, before the room's graph arrives.
+    using OnEditSignature = std::function<void(const Common::JournalRecord&)>;
+    // Member is zero after leaving a room.
+    using OnJoinedSignature = std::function<void(const Common::Protocol::Joined&)>;
+    // Reports what the server said about an edit it turned down, and what is done about it.
+    using OnStatusSignature = std::function<void(const std::string&)>;
+
+    Remote(const std::shared_ptr<Connection>& Connection_);
+
+    Remote& SetOnResult(OnResultSignature&& Fn);
+    Remote& SetOnFinished(OnFinishedSignature&& Fn);
+    Remote& SetOnEdit(OnEditSignature&& Fn);
+    Remote& SetOnJoined(OnJoinedSignature&& Fn);
+    Remote& SetOnStatus(OnStatusSignature&& Fn);
+
+    bool IsAvailable() const;
+    bool IsRunning() const;
+
+    // Mirrors an edit already applied to the canvas's graph onto the server's copy.
+    Remote& Forward(const Common::JournalRecord& Record);
+
+    // For when the canvas's graph is replaced wholesale. The next run replaces the
+    // server's copy instead of updating it.
+    Remote& Invalidate();
+
+    // Shares the graph with the room named Room, on this connection and on every one
+    // made after it. An empty name leaves the room.
+    Remote& Join(const std::string& Room);
+    bool IsJoined() const;
+
+    // Fills a room that was empty when it was joined with Model.
+    Remote& Publish(const Common::Graph& Model, const SourceSignature& Source = nullptr);
+
+    // The position of a node being dragged. Only the last one given before the next
+    // Update is sent.
+    Remote& Move(Common::NodeID Node, const Common::Point& Position);
+
+    // Brings the server's copy up to date with Model and starts a run. Sources are read
+    // from Source when given, for nodes whose source is not in the model yet.
+    bool Execute(const Common::Graph& Model, const SourceSignature& Source = nullptr, std::string* Error = nullptr);
+
+    // Sends forwarded edits and hands out the results received since the last call.
+    // Called once per frame.
+    void Update();
+
+private:
+    bool IsSynced() const;
+    Remote& Flush();
+    Remote& Sync(const Common::Graph& Model);
+    Remote& WriteGraph(const Common::Graph& Model);
+    void Finish(const Common::Protocol::ExecutionSummary* Summary, const std::string& Error);
+
+    Remote& SendJoin();
+    Remote& SendMoves();
+    Remote& SendText(Common::NodeID Node);
+    Remote& ResetRoom();
+    void OnJoined(const Common::Protocol::MessageView& Message);
+    void OnGraphEdit(const Common::Protocol::MessageView& Message);
+    void OnTextEdit(const Common::Protocol::MessageView& Message);
+    void OnMoveBatch(const Common::Protocol::MessageView& Message);
+
+    std::shared_ptr<Connection> m_Connection { nullptr };
+    OnResultSignature m_OnResult { nullptr };
+    OnFinishedSignature m_OnFinished { nullptr };
+    OnEditSignature m_OnEdit { nullptr };
+    OnJoinedSignature m_OnJoined { nullptr };
+    OnStatusSignature m_OnStatus { nullptr };
+
+    // The connection epoch the server's copy was built on, and every node in it with the
+    // hash of the source last sent for it. Errors for messages sent before Baseline
+    // belong to an earlier copy and are ignored.
+    uint32_t m_Epoch { 0 };
+    bool m_Synced { false };
+    std::unordered_map<Common::NodeID, uint64_t> m_Nodes {};
+    uint32_t m_Sequence { 0 };
+    uint32_t m_Baseline { 0 };
+    // Sequence of the Execute message of the run in flight, or zero.
+    uint32_t m_Run { 0 };
+
+    // Edits to a node's source that the server has not acknowledged, oldest first. Only
+    // the first is in flight, made against Revision.
+    struct Text
+    {
+        uint32_t Revision { 0 };
+        std::deque<Common::TextOp> Pending {};
+        uint32_t InFlight { 0 };
+    };
+
+    struct Position
+    {
+        int32_t X { 0 };
+        int32_t Y { 0 };
+    };
+
+    // The room to be in, and the member this side is once the server has said so. Member
+    // is zero until then, and while it is, nothing is sent to the room.
+    std::string m_Room {};
+    uint32_t m_Member { 0 };
+    uint32_t m_Join { 0 };
+    std::unordered_map<Common::NodeID, Text> m_Texts {};
+    // Where the room last put each node, which MoveBatch offsets are relative to.
+    std::unordered_map<Common::NodeID, Position> m_Positions {};
+    std::unordered_map<Common::NodeID, Common::Point> m_Moves {};
+    // The sequence of the last move or rename sent for a node and not yet seen back.
+    std::unordered_map<Common::NodeID, uint32_t> m_PendingMoves {};
+    std::unordered_map<Common::NodeID, uint32_t> m_PendingNames {};
+
+    Common::Protocol::MessageWriter m_Output {};
+    std::vector<uint8_t> m_Frames {};
+};
+
+}
+}
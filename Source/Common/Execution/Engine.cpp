@@ -0,0 +1,568 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Engine.h"
+#include "../Hash.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+
+extern "C"
+{
+#include "lauxlib.h"
+#include "lua.h"
+#include "lualib.h"
+}
+
+namespace Snippet
+{
+namespace Common
+{
+
+static constexpr int HookInterval { 1000 };
+static const char* SandboxKey { "Snippet.Sandbox" };
+static const char* LibrariesKey { "Snippet.Libraries" };
+static const char* EnvironmentKey { "Snippet.Environment" };
+static const char* InstructionLimit { "instruction limit exceeded" };
+static const char* MemoryLimit { "memory limit exceeded" };
+
+struct Engine::VM
+{
+    lua_State* State { nullptr };
+    size_t Used { 0 };
+    size_t Limit { 0 };
+    int64_t Budget { 0 };
+    const char* Violation { nullptr };
+    std::string* Log { nullptr };
+
+    ~VM()
+    {
+        if (State != nullptr)
+        {
+            lua_close(State);
+        }
+    }
+};
+
+static Engine::VM*& GetVM(lua_State* State);
+
+static void* Allocate(void* UserData, void* Pointer, size_t OldSize, size_t NewSize)
+{
+    Engine::VM* Target { static_cast<Engine::VM*>(UserData) };
+    const size_t Previous { Pointer != nullptr ? OldSize : 0 };
+
+    if (NewSize == 0)
+    {
+        Target->Used -= Previous;
+        std::free(Pointer);
+        return nullptr;
+    }
+
+    if (Target->Limit != 0 && NewSize > Previous && Target->Used + (NewSize - Previous) > Target->Limit)
+    {
+        if (Target->Violation == nullptr)
+        {
+            Target->Violation = MemoryLimit;
+        }
+
+        return nullptr;
+    }
+
+    void* Result { std::realloc(Pointer, NewSize) };
+    if (Result != nullptr)
+    {
+        Target->Used = Target->Used - Previous + NewSize;
+    }
+
+    return Result;
+}
+
+static void OnHook(lua_State* State, lua_Debug*)
+{
+    Engine::VM* Target { GetVM(State) };
+
+    if (Target->Violation == nullptr)
+    {
+        Target->Budget -= HookInterval;
+
+        if (Target->Budget < 0)
+        {
+            Target->Violation = InstructionLimit;
+        }
+    }
+
+    // The error raised here can be caught by pcall, so once a limit is hit the hook fires
+    // on every instruction and raises it again until the run has unwound completely.
+    if (Target->Violation != nullptr)
+    {
+        lua_sethook(State, OnHook, LUA_MASKCOUNT, 1);
+        lua_pushstring(State, Target->Violation);
+        lua_error(State);
+    }
+}
+
+static int Print(lua_State* State)
+{
+    Engine::VM* Target { GetVM(State) };
+    const int Count { lua_gettop(State) };
+
+    for (int I = 1; I <= Count; I++)
+    {
+        size_t Length { 0 };
+        const char* Value { luaL_tolstring(State, I, &Length) };
+
+        if (Target->Log != nullptr)
+        {
+            if (I > 1)
+            {
+                Target->Log->push_back('\t');
+            }
+
+            Target->Log->append(Value, Length);
+        }
+
+        lua_pop(State, 1);
+    }
+
+    if (Target->Log != nullptr)
+    {
+        Target->Log->push_back('\n');
+    }
+
+    return 0;
+}
+
+// Wraps the standard load so that chunks are only ever compiled from text and, unless an
+// environment is given, see the current run's globals instead of the shared ones.
+static int Load(lua_State* State)
+{
+    const bool HasEnvironment { !lua_isnone(State, 4) };
+    lua_settop(State, 4);
+
+    lua_pushliteral(State, "t");
+    lua_replace(State, 3);
+
+    if (!HasEnvironment)
+    {
+        lua_getfield(State, LUA_REGISTRYINDEX, EnvironmentKey);
+        lua_replace(State, 4);
+    }
+
+    lua_pushvalue(State, lua_upvalueindex(1));
+    lua_insert(State, 1);
+    lua_call(State, 4, LUA_MULTRET);
+    return lua_gettop(State);
+}
+
+static int Write(lua_State*, const void* Data, size_t Size, void* UserData)
+{
+    static_cast<std::string*>(UserData)->append(static_cast<const char*>(Data), Size);
+    return 0;
+}
+
+static Engine::VM*& GetVM(lua_State* State)
+{
+    return *static_cast<Engine::VM**>(lua_getextraspace(State));
+}
+
+static void ToString(lua_State* State, int Index, std::string& Out)
+{
+    size_t Length { 0 };
+    const char* Value { nullptr };
+
+    switch (lua_type(State, Index))
+    {
+    case LUA_TNIL: break;
+    case LUA_TBOOLEAN: Out = lua_toboolean(State, Index) ? "true" : "false"; break;
+    case LUA_TNUMBER:
+    case LUA_TSTRING:
+    {
+        Value = lua_tolstring(State, Index, &Length);
+        Out.assign(Value, Length);
+    }
+    break;
+    default: Out = lua_typename(State, lua_type(State, Index)); break;
+    }
+}
+
+bool Engine::Check(std::string_view Name, std::string_view Source, std::string* Error)
+{
+    lua_State* State { luaL_newstate() };
+    if (State == nullptr)
+    {
+        if (Error != nullptr)
+        {
+            *Error = "failed to create lua state";
+        }
+
+        return false;
+    }
+
+    const std::string ChunkName { "=" + std::string { Name } };
+    const bool Success { luaL_loadbufferx(State, Source.data(), Source.size(), ChunkName.c_str(), "t") == LUA_OK };
+
+    if (!Success && Error != nullptr)
+    {
+        const char* Message { lua_tostring(State, -1) };
+        *Error = Message != nullptr ? Message : "failed to compile";
+    }
+
+    lua_close(State);
+    return Success;
+}
+
+Engine::Engine(const Limits& Limits_)
+    : m_Limits(Limits_)
+{
+}
+
+Engine::~Engine()
+{
+}
+
+bool Engine::Compile(uint64_t Key, std::string_view Name, std::string_view Source, std::string* Error)
+{
+    const uint64_t SourceHash { Hash(Source) };
+
+    if (const std::shared_ptr<const Chunk> Existing = Find(Key))
+    {
+        if (Existing->SourceHash == SourceHash && Existing->Name == Name)
+        {
+            m_CacheHits++;
+
+            if (Error != nullptr)
+            {
+                *Error = Existing->Error;
+            }
+
+            return Existing->Error.empty();
+        }
+    }
+
+    std::shared_ptr<Chunk> Result { std::make_shared<Chunk>() };
+    Result->Name = Name;
+    Result->SourceHash = SourceHash;
+
+    // Nothing is cached when no state could be created, since the next attempt may succeed.
+    std::unique_ptr<VM> Target { Acquire() };
+    if (Target == nullptr)
+    {
+        if (Error != nullptr)
+        {
+            *Error = "failed to create lua state";
+        }
+
+        return false;
+    }
+
+    lua_State* State { Target->State };
+    const std::string ChunkName { "=" + Result->Name };
+
+    if (luaL_loadbufferx(State, Source.data(), Source.size(), ChunkName.c_str(), "t") == LUA_OK)
+    {
+        lua_dump(State, Write, &Result->Bytecode, 0);
+        Result->BytecodeHash = Hash(Result->Bytecode);
+    }
+    else
+    {
+        const char* Message { lua_tostring(State, -1) };
+        Result->Error = Message != nullptr ? Message : "failed to compile";
+    }
+
+    lua_settop(State, 0);
+    Release(std::move(Target), true);
+    m_Compiles++;
+
+    if (Error != nullptr)
+    {
+        *Error = Result->Error;
+    }
+
+    const bool Success { Result->Error.empty() };
+
+    {
+        std::unique_lock<std::shared_mutex> Lock { m_ChunksMutex };
+        m_Chunks[Key] = std::move(Result);
+    }
+
+    return Success;
+}
+
+RunResult Engine::Run(uint64_t Key, const std::vector<std::string>& Inputs) const
+{
+    const std::chrono::steady_clock::time_point Start { std::chrono::steady_clock::now() };
+    RunResult Result {};
+
+    const std::shared_ptr<const Chunk> Item { Find(Key) };
+    if (Item == nullptr || !Item->Error.empty())
+    {
+        Result.Error = Item != nullptr ? Item->Error : "snippet has not been compiled";
+        return Result;
+    }
+
+    std::unique_ptr<VM> Target { Acquire() };
+    if (Target == nullptr)
+    {
+        Result.Error = "failed to create lua state";
+        return Result;
+    }
+
+    lua_State* State { Target->State };
+    Target->Log = &Result.Log;
+
+    int Status { luaL_loadbufferx(State, Item->Bytecode.data(), Item->Bytecode.size(), Item->Name.c_str(), "b") };
+
+    if (Status == LUA_OK)
+    {
+        // Give this run its own globals and its own view of each library table. Reads fall
+        // through to the shared tables while writes, rawset included, land in tables that
+        // are dropped with the run, so nothing leaks into the next run on this VM.
+        lua_newtable(State);
+        lua_getfield(State, LUA_REGISTRYINDEX, SandboxKey);
+        lua_setmetatable(State, -2);
+
+        lua_getfield(State, LUA_REGISTRYINDEX, LibrariesKey);
+        lua_pushnil(State);
+        while (lua_next(State, -2) != 0)
+        {
+            lua_newtable(State);
+            lua_insert(State, -2);
+            lua_setmetatable(State, -2);
+            lua_pushvalue(State, -2);
+            lua_insert(State, -2);
+            lua_rawset(State, -5);
+        }
+        lua_pop(State, 1);
+
+        lua_pushvalue(State, -1);
+        lua_setfield(State, -2, LUA_GNAME);
+        lua_pushvalue(State, -1);
+        lua_setfield(State, LUA_REGISTRYINDEX, EnvironmentKey);
+        lua_setupvalue(State, -2, 1);
+
+        for (const std::string& Input : Inputs)
+        {
+            lua_pushlstring(State, Input.data(), Input.size());
+        }
+
+        Target->Limit = m_Limits.Memory > 0 ? Target->Used + m_Limits.Memory : 0;
+        Target->Budget = m_Limits.Instructions > 0 ? static_cast<int64_t>(m_Limits.Instructions) : INT64_MAX;
+        Target->Violation = nullptr;
+
+        if (m_Limits.Instructions > 0 || m_Limits.Memory > 0)
+        {
+            lua_sethook(State, OnHook, LUA_MASKCOUNT, HookInterval);
+        }
+
+        Status = lua_pcall(State, static_cast<int>(Inputs.size()), 1, 0);
+    }
+
+    if (Target->Violation != nullptr)
+    {
+        // Reported even when the snippet caught the error and returned normally.
+        Result.Error = Target->Violation;
+    }
+    else if (Status == LUA_OK)
+    {
+        ToString(State, -1, Result.Output);
+        Result.Success = true;
+    }
+    else
+    {
+        const char* Message { lua_tostring(State, -1) };
+        Result.Error = Message != nullptr ? Message : "failed to run";
+    }
+
+    // The limits stay in place while the run's garbage is collected, since finalizers
+    // it registered can run here.
+    lua_settop(State, 0);
+    lua_pushnil(State);
+    lua_setfield(State, LUA_REGISTRYINDEX, EnvironmentKey);
+    lua_gc(State, LUA_GCSTEP, 0);
+    lua_sethook(State, nullptr, 0, 0);
+
+    // collectgarbage is available to snippets, so undo anything a run changed about the
+    // collector.
+    lua_gc(State, LUA_GCRESTART);
+    lua_gc(State, LUA_GCINC, 0, 0, 0);
+    Target->Limit = 0;
+    Target->Log = nullptr;
+
+    // A state that ran out of memory may be left in a poor condition, so it is dropped
+    // rather than returned to the pool.
+    const bool Healthy { Status != LUA_ERRMEM && Target->Violation != MemoryLimit };
+    Release(std::move(Target), Healthy);
+    m_Runs++;
+
+    Result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+    return Result;
+}
+
+uint64_t Engine::BytecodeHash(uint64_t Key) const
+{
+    const std::shared_ptr<const Chunk> Item { Find(Key) };
+    return Item != nullptr ? Item->BytecodeHash : 0;
+}
+
+Engine& Engine::Forget(uint64_t Key)
+{
+    std::unique_lock<std::shared_mutex> Lock { m_ChunksMutex };
+    m_Chunks.erase(Key);
+    return *this;
+}
+
+Engine::Stats Engine::GetStats() const
+{
+    Stats Result {};
+    Result.Compiles = m_Compiles;
+    Result.CacheHits = m_CacheHits;
+    Result.Runs = m_Runs;
+    Result.VMsCreated = m_VMsCreated;
+    return Result;
+}
+
+std::shared_ptr<const Engine::Chunk> Engine::Find(uint64_t Key) const
+{
+    std::shared_lock<std::shared_mutex> Lock { m_ChunksMutex };
+    const std::unordered_map<uint64_t, std::shared_ptr<const Chunk>>::const_iterator It { m_Chunks.find(Key) };
+    return It != m_Chunks.end() ? It->second : nullptr;
+}
+
+std::unique_ptr<Engine::VM> Engine::Acquire() const
+{
+    {
+        std::lock_guard<std::mutex> Lock { m_PoolMutex };
+
+        if (!m_Pool.empty())
+        {
+            std::unique_ptr<VM> Result { std::move(m_Pool.back()) };
+            m_Pool.pop_back();
+            return Result;
+        }
+    }
+
+    std::unique_ptr<VM> Result { std::make_unique<VM>() };
+    Result->State = lua_newstate(Allocate, Result.get());
+    lua_State* State { Result->State };
+    if (State == nullptr)
+    {
+        return nullptr;
+    }
+
+    GetVM(State) = Result.get();
+
+    const std::pair<const char*, lua_CFunction> Libraries[] {
+        { LUA_GNAME, luaopen_base },
+        { LUA_COLIBNAME, luaopen_coroutine },
+        { LUA_TABLIBNAME, luaopen_table },
+        { LUA_STRLIBNAME, luaopen_string },
+        { LUA_MATHLIBNAME, luaopen_math },
+        { LUA_UTF8LIBNAME, luaopen_utf8 },
+    };
+
+    for (const std::pair<const char*, lua_CFunction>& Library : Libraries)
+    {
+        luaL_requiref(State, Library.first, Library.second, 1);
+        lua_pop(State, 1);
+    }
+
+    lua_pushcfunction(State, Print);
+    lua_setglobal(State, "print");
+
+    lua_getglobal(State, "load");
+    lua_pushcclosure(State, Load, 1);
+    lua_setglobal(State, "load");
+
+    for (const char* Name : { "dofile", "loadfile" })
+    {
+        lua_pushnil(State);
+        lua_setglobal(State, Name);
+    }
+
+    // Bytecode is never loaded from snippets, so there is no reason to produce it.
+    lua_getglobal(State, LUA_STRLIBNAME);
+    lua_pushnil(State);
+    lua_setfield(State, -2, "dump");
+    lua_pop(State, 1);
+
+    // The string metatable is shared by every run and reachable through getmetatable(""),
+    // so it is hidden from snippets.
+    lua_pushliteral(State, "");
+    lua_getmetatable(State, -1);
+    lua_pushboolean(State, 0);
+    lua_setfield(State, -2, "__metatable");
+    lua_pop(State, 2);
+
+    lua_newtable(State);
+    lua_rawgeti(State, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+    lua_setfield(State, -2, "__index");
+    lua_pushboolean(State, 0);
+    lua_setfield(State, -2, "__metatable");
+    lua_setfield(State, LUA_REGISTRYINDEX, SandboxKey);
+
+    // One protected metatable per library, used by every run to build its own view.
+    lua_newtable(State);
+    for (const std::pair<const char*, lua_CFunction>& Library : Libraries)
+    {
+        if (std::string_view { Library.first } == LUA_GNAME)
+        {
+            continue;
+        }
+
+        lua_newtable(State);
+        lua_getglobal(State, Library.first);
+        lua_setfield(State, -2, "__index");
+        lua_pushboolean(State, 0);
+        lua_setfield(State, -2, "__metatable");
+        lua_setfield(State, -2, Library.first);
+    }
+    lua_setfield(State, LUA_REGISTRYINDEX, LibrariesKey);
+
+    m_VMsCreated++;
+    return Result;
+}
+
+void Engine::Release(std::unique_ptr<VM>&& Item, bool Healthy) const
+{
+    if (!Healthy)
+    {
+        return;
+    }
+
+    const size_t MaxIdle { std::max<size_t>(4, std::thread::hardware_concurrency() * 2) };
+    std::lock_guard<std::mutex> Lock { m_PoolMutex };
+
+    if (m_Pool.size() < MaxIdle)
+    {
+        m_Pool.push_back(std::move(Item));
+    }
+}
+
+}
+}
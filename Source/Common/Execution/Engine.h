@@ -0,0 +1,126 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Snippet
+{
+namespace Common
+{
+
+struct Limits
+{
+    size_t Memory { 64 * 1024 * 1024 };
+    uint64_t Instructions { 100000000 };
+};
+
+struct RunResult
+{
+    bool Success { false };
+    std::string Output {};
+    std::string Log {};
+    std::string Error {};
+    double Seconds { 0.0 };
+};
+
+//
+// Compiles snippet sources into Lua bytecode once and runs them on a pool of reusable
+// lua_State instances. Chunks are keyed by the caller (usually a node ID) and are only
+// recompiled when the hash of their source changes. Every run gets fresh globals and
+// library tables that fall back to the shared standard library, plus memory and
+// instruction limits that the snippet cannot catch.
+// Compile and Run are safe to call from multiple threads.
+//
+
+class Engine
+{
+public:
+    struct Stats
+    {
+        uint64_t Compiles { 0 };
+        uint64_t CacheHits { 0 };
+        uint64_t Runs { 0 };
+        uint64_t VMsCreated { 0 };
+    };
+
+    // Pooled interpreter state. Opaque outside of Engine.cpp.
+    struct VM;
+
+    // Parses Source without keeping or running it, on a throwaway state, so that it can
+    // be called from any thread without an Engine. Error receives the parser's message.
+    static bool Check(std::string_view Name, std::string_view Source, std::string* Error = nullptr);
+
+    Engine(const Limits& Limits_ = {});
+    ~Engine();
+
+    bool Compile(uint64_t Key, std::string_view Name, std::string_view Source, std::string* Error = nullptr);
+    RunResult Run(uint64_t Key, const std::vector<std::string>& Inputs) const;
+    uint64_t BytecodeHash(uint64_t Key) const;
+    Engine& Forget(uint64_t Key);
+
+    Stats GetStats() const;
+
+private:
+    struct Chunk
+    {
+        std::string Name {};
+        uint64_t SourceHash { 0 };
+        uint64_t BytecodeHash { 0 };
+        std::string Bytecode {};
+        std::string Error {};
+    };
+
+    std::shared_ptr<const Chunk> Find(uint64_t Key) const;
+    // Returns null when a new state is needed and cannot be created.
+    std::unique_ptr<VM> Acquire() const;
+    void Release(std::unique_ptr<VM>&& Item, bool Healthy) const;
+
+    Limits m_Limits {};
+
+    mutable std::shared_mutex m_ChunksMutex {};
+    std::unordered_map<uint64_t, std::shared_ptr<const Chunk>> m_Chunks {};
+
+    mutable std::mutex m_PoolMutex {};
+    mutable std::vector<std::unique_ptr<VM>> m_Pool {};
+
+    std::atomic<uint64_t> m_Compiles { 0 };
+    mutable std::atomic<uint64_t> m_CacheHits { 0 };
+    mutable std::atomic<uint64_t> m_Runs { 0 };
+    mutable std::atomic<uint64_t> m_VMsCreated { 0 };
+};
+
+}
+}
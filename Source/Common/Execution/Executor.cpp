@@ -0,0 +1,476 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Executor.h"
+#include "../Hash.h"
+#include "../Unicode.h"
+#include "Engine.h"
+#include "Memo.h"
+#include "ResultCache.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+
+namespace Snippet
+{
+namespace Common
+{
+
+static constexpr uint32_t InvalidIndex { ~0u };
+
+struct Executor::Plan
+{
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t Scope { 0 };
+    std::vector<NodeHandle> Handles {};
+    std::vector<std::string> Names {};
+    std::vector<std::string> Sources {};
+    std::vector<uint64_t> SourceHashes {};
+    std::vector<Memo::Entry> Previous {};
+
+    // Upstream node of every input, grouped per node, and the reverse edges. Both are
+    // stored as offset/value arrays so a plan is a handful of allocations regardless of
+    // the graph's size.
+    std::vector<uint32_t> InputOffsets {};
+    std::vector<uint32_t> Inputs {};
+    std::vector<uint32_t> DependentOffsets {};
+    std::vector<uint32_t> Dependents {};
+
+    std::unique_ptr<std::atomic<uint32_t>[]> Remaining { nullptr };
+    std::atomic<uint32_t> Unfinished { 0 };
+
+    // Each slot is written only by the task running that node and read by its dependents
+    // after the dependency counter hand-off.
+    std::vector<NodeReport> Reports {};
+    std::vector<double> PathSeconds {};
+    std::vector<uint32_t> PathParent {};
+
+    Clock::time_point Start {};
+    OnCompleteSignature OnComplete { nullptr };
+    OnProgressSignature OnProgress { nullptr };
+};
+
+Executor::Executor(Engine& Engine_, ThreadPool& Pool, ResultCache* Cache)
+    : m_Engine(Engine_)
+    , m_Pool(Pool)
+    , m_Cache(Cache)
+{
+}
+
+bool Executor::Run(const Graph& Model, const Memo* Previous, uint64_t Scope, OnCompleteSignature&& OnComplete, std::string* Error)
+{
+    return Run(Model, Previous, Scope, std::move(OnComplete), nullptr, Error);
+}
+
+bool Executor::Run(const Graph& Model, const Memo* Previous, uint64_t Scope, OnCompleteSignature&& OnComplete, OnProgressSignature&& OnProgress, std::string* Error)
+{
+    std::shared_ptr<Plan> Item { std::make_shared<Plan>() };
+    std::string Reason {};
+
+    if (!Build(Model, Previous, *Item, Reason))
+    {
+        if (Error != nullptr)
+        {
+            *Error = std::move(Reason);
+        }
+
+        return false;
+    }
+
+    Item->Scope = Scope;
+    Item->OnComplete = std::move(OnComplete);
+    Item->OnProgress = std::move(OnProgress);
+    Item->Start = Plan::Clock::now();
+
+    const uint32_t Count { static_cast<uint32_t>(Item->Handles.size()) };
+    if (Count == 0)
+    {
+        m_Pool.Submit([this, Item]() -> void
+            {
+                Finish(*Item);
+            });
+        return true;
+    }
+
+    // Collect the roots before scheduling any of them. Once the first task is running it
+    // may already be decrementing counters that this loop would otherwise be reading.
+    std::vector<uint32_t> Roots {};
+    for (uint32_t I = 0; I < Count; I++)
+    {
+        if (Item->Remaining[I] == 0)
+        {
+            Roots.push_back(I);
+        }
+    }
+
+    for (uint32_t Root : Roots)
+    {
+        Schedule(Item, Root);
+    }
+
+    return true;
+}
+
+ExecutionReport Executor::Run(const Graph& Model, const Memo* Previous, uint64_t Scope)
+{
+    std::promise<ExecutionReport> Promise {};
+    std::future<ExecutionReport> Future { Promise.get_future() };
+    std::string Error {};
+
+    const bool Started { Run(Model, Previous, Scope, [&Promise](ExecutionReport&& Report) -> void
+        {
+            Promise.set_value(std::move(Report));
+        }, &Error) };
+
+    if (!Started)
+    {
+        ExecutionReport Result {};
+        Result.Error = std::move(Error);
+        return Result;
+    }
+
+    return Future.get();
+}
+
+Executor& Executor::Forget(uint64_t Scope, NodeHandle Node)
+{
+    m_Engine.Forget(ChunkKey(Scope, Node));
+    return *this;
+}
+
+uint64_t Executor::ChunkKey(uint64_t Scope, NodeHandle Node)
+{
+    const uint64_t Key { Node.Key() };
+    return Hash(&Key, sizeof(Key), Scope);
+}
+
+void Executor::Schedule(const std::shared_ptr<Plan>& Item, uint32_t Index)
+{
+    m_Pool.Submit([this, Item, Index]() -> void
+        {
+            Execute(Item, Index);
+        });
+}
+
+void Executor::Execute(const std::shared_ptr<Plan>& Item, uint32_t Index)
+{
+    Plan& Target { *Item };
+    NodeReport& Report { Target.Reports[Index] };
+
+    const Plan::Clock::time_point Start { Plan::Clock::now() };
+    Report.Start = std::chrono::duration<double>(Start - Target.Start).count();
+
+    double Longest { 0.0 };
+    uint32_t Parent { InvalidIndex };
+    bool Ready { true };
+    uint64_t Fingerprint { Target.SourceHashes[Index] };
+    uint64_t InputsHash { Target.InputOffsets[Index + 1] - Target.InputOffsets[Index] };
+
+    for (uint32_t I = Target.InputOffsets[Index]; I < Target.InputOffsets[Index + 1]; I++)
+    {
+        const uint32_t Upstream { Target.Inputs[I] };
+        const NodeReport& Input { Target.Reports[Upstream] };
+
+        if (Input.Status != NodeStatus::Succeeded)
+        {
+            Ready = false;
+        }
+
+        if (Parent == InvalidIndex || Target.PathSeconds[Upstream] > Longest)
+        {
+            Longest = Target.PathSeconds[Upstream];
+            Parent = Upstream;
+        }
+
+        Fingerprint = Combine(Fingerprint, Input.OutputHash);
+        InputsHash = Combine(InputsHash, Input.OutputHash);
+    }
+
+    const Memo::Entry& Cached { Target.Previous[Index] };
+    const uint64_t Chunk { ChunkKey(Target.Scope, Report.Node) };
+    Report.Fingerprint = Fingerprint;
+
+    if (!Ready)
+    {
+        Report.Status = NodeStatus::Skipped;
+        Report.Error = "an input failed";
+    }
+    else if (Cached != nullptr && Cached->Fingerprint == Fingerprint)
+    {
+        Report.Status = NodeStatus::Succeeded;
+        Report.Output = Cached->Output;
+        Report.Log = Cached->Log;
+        Report.OutputHash = Cached->OutputHash;
+        Report.Reused = true;
+    }
+    else if (!m_Engine.Compile(Chunk, Target.Names[Index], Target.Sources[Index], &Report.Error))
+    {
+        Report.Status = NodeStatus::Failed;
+    }
+    else
+    {
+        const ResultCache::Key Key { m_Engine.BytecodeHash(Chunk), InputsHash };
+        const ResultCache::Entry Hit { m_Cache != nullptr ? m_Cache->Find(Key) : nullptr };
+
+        if (Hit != nullptr)
+        {
+            Report.Status = NodeStatus::Succeeded;
+            Report.Output = Hit->Output;
+            Report.Log = Hit->Log;
+            Report.OutputHash = Hit->OutputHash;
+        }
+        else
+        {
+            if (Target.OnProgress)
+            {
+                Target.OnProgress(Report);
+            }
+
+            // Inputs are only copied out of the upstream reports once the node has to run.
+            std::vector<std::string> Inputs {};
+            Inputs.reserve(Target.InputOffsets[Index + 1] - Target.InputOffsets[Index]);
+            for (uint32_t I = Target.InputOffsets[Index]; I < Target.InputOffsets[Index + 1]; I++)
+            {
+                Inputs.push_back(Target.Reports[Target.Inputs[I]].Output);
+            }
+
+            RunResult Result { m_Engine.Run(Chunk, Inputs) };
+            Report.Status = Result.Success ? NodeStatus::Succeeded : NodeStatus::Failed;
+            Report.Output = std::move(Result.Output);
+            Report.Log = std::move(Result.Log);
+            Report.Error = std::move(Result.Error);
+            Report.OutputHash = Hash(Report.Output);
+
+            if (Result.Success && m_Cache != nullptr)
+            {
+                m_Cache->Insert(Key, std::make_shared<const ResultCache::Value>(ResultCache::Value { Report.Output, Report.Log, Report.OutputHash }));
+            }
+        }
+    }
+
+    // Sources and previous results are not needed once the node has run and can be large.
+    std::string().swap(Target.Sources[Index]);
+    Target.Previous[Index] = nullptr;
+
+    Report.Seconds = std::chrono::duration<double>(Plan::Clock::now() - Start).count();
+    Target.PathSeconds[Index] = Longest + Report.Seconds;
+    Target.PathParent[Index] = Parent;
+
+    if (Target.OnProgress)
+    {
+        Target.OnProgress(Report);
+    }
+
+    for (uint32_t I = Target.DependentOffsets[Index]; I < Target.DependentOffsets[Index + 1]; I++)
+    {
+        const uint32_t Dependent { Target.Dependents[I] };
+
+        if (Target.Remaining[Dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            Schedule(Item, Dependent);
+        }
+    }
+
+    if (Target.Unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        Finish(Target);
+    }
+}
+
+void Executor::Finish(Plan& Item)
+{
+    ExecutionReport Result {};
+    Result.Valid = true;
+    Result.Seconds = std::chrono::duration<double>(Plan::Clock::now() - Item.Start).count();
+
+    uint32_t Tail { InvalidIndex };
+    for (uint32_t I = 0; I < Item.PathSeconds.size(); I++)
+    {
+        if (Tail == InvalidIndex || Item.PathSeconds[I] > Item.PathSeconds[Tail])
+        {
+            Tail = I;
+        }
+    }
+
+    if (Tail != InvalidIndex)
+    {
+        Result.CriticalPathSeconds = Item.PathSeconds[Tail];
+
+        for (uint32_t I = Tail; I != InvalidIndex; I = Item.PathParent[I])
+        {
+            Result.CriticalPath.push_back(Item.Handles[I]);
+        }
+
+        std::reverse(Result.CriticalPath.begin(), Result.CriticalPath.end());
+    }
+
+    for (const NodeReport& Node : Item.Reports)
+    {
+        Result.Reused += Node.Reused ? 1 : 0;
+    }
+
+    Result.Nodes = std::move(Item.Reports);
+
+    if (Item.OnComplete)
+    {
+        Item.OnComplete(std::move(Result));
+    }
+}
+
+bool Executor::Build(const Graph& Model, const Memo* Previous, Plan& Item, std::string& Error)
+{
+    std::vector<uint32_t> IndexOf(Model.NodeCapacity(), InvalidIndex);
+
+    Item.Handles.reserve(Model.NodeCount());
+    Item.Names.reserve(Model.NodeCount());
+    Item.Sources.reserve(Model.NodeCount());
+    Item.SourceHashes.reserve(Model.NodeCount());
+    Item.Previous.reserve(Model.NodeCount());
+
+    Model.ForEachNode([&](NodeHandle ID, const Graph::Node& Node) -> void
+        {
+            IndexOf[ID.Index] = static_cast<uint32_t>(Item.Handles.size());
+            Item.Handles.push_back(ID);
+            Item.Names.push_back(ToUTF8(Node.Name));
+            Item.Sources.push_back(Node.Source);
+            Item.SourceHashes.push_back(Node.SourceHash);
+            Item.Previous.push_back(Previous != nullptr ? Previous->Find(ID) : nullptr);
+        });
+
+    const uint32_t Count { static_cast<uint32_t>(Item.Handles.size()) };
+    std::vector<uint32_t> DependentCounts(Count, 0);
+
+    Item.InputOffsets.reserve(Count + 1);
+    Item.InputOffsets.push_back(0);
+
+    for (uint32_t I = 0; I < Count; I++)
+    {
+        for (PortHandle PortID : Model.GetPorts(Item.Handles[I]))
+        {
+            const Graph::Port* Port { Model.GetPort(PortID) };
+
+            if (Port == nullptr || Port->Kind != PortKind::Input)
+            {
+                continue;
+            }
+
+            for (ConnectionHandle ConnectionID : Port->Connections)
+            {
+                const Graph::Connection* Connection { Model.GetConnection(ConnectionID) };
+                const Graph::Port* Other { Connection != nullptr ? Model.GetPort(Connection->From == PortID ? Connection->To : Connection->From) : nullptr };
+
+                if (Other == nullptr || Other->Kind != PortKind::Output || !Model.IsValid(Other->Owner))
+                {
+                    continue;
+                }
+
+                const uint32_t Upstream { IndexOf[Other->Owner.Index] };
+                Item.Inputs.push_back(Upstream);
+                DependentCounts[Upstream]++;
+            }
+        }
+
+        Item.InputOffsets.push_back(static_cast<uint32_t>(Item.Inputs.size()));
+    }
+
+    Item.DependentOffsets.resize(Count + 1, 0);
+    for (uint32_t I = 0; I < Count; I++)
+    {
+        Item.DependentOffsets[I + 1] = Item.DependentOffsets[I] + DependentCounts[I];
+    }
+
+    Item.Dependents.resize(Item.Inputs.size());
+    std::vector<uint32_t> Cursor(Item.DependentOffsets.begin(), Item.DependentOffsets.end() - 1);
+    for (uint32_t I = 0; I < Count; I++)
+    {
+        for (uint32_t J = Item.InputOffsets[I]; J < Item.InputOffsets[I + 1]; J++)
+        {
+            Item.Dependents[Cursor[Item.Inputs[J]]++] = I;
+        }
+    }
+
+    // Topological sort only to reject cycles up front. A cycle would otherwise leave its
+    // nodes waiting forever and the run would never complete.
+    std::vector<uint32_t> InDegree(Count, 0);
+    std::vector<uint32_t> Ready {};
+    for (uint32_t I = 0; I < Count; I++)
+    {
+        InDegree[I] = Item.InputOffsets[I + 1] - Item.InputOffsets[I];
+
+        if (InDegree[I] == 0)
+        {
+            Ready.push_back(I);
+        }
+    }
+
+    uint32_t Ordered { 0 };
+    while (!Ready.empty())
+    {
+        const uint32_t Index { Ready.back() };
+        Ready.pop_back();
+        Ordered++;
+
+        for (uint32_t J = Item.DependentOffsets[Index]; J < Item.DependentOffsets[Index + 1]; J++)
+        {
+            if (--InDegree[Item.Dependents[J]] == 0)
+            {
+                Ready.push_back(Item.Dependents[J]);
+            }
+        }
+    }
+
+    if (Ordered != Count)
+    {
+        Error = "graph contains a cycle";
+        return false;
+    }
+
+    Item.Remaining = std::make_unique<std::atomic<uint32_t>[]>(Count);
+    for (uint32_t I = 0; I < Count; I++)
+    {
+        Item.Remaining[I].store(Item.InputOffsets[I + 1] - Item.InputOffsets[I], std::memory_order_relaxed);
+    }
+
+    Item.Unfinished = Count;
+    Item.Reports.resize(Count);
+    Item.PathSeconds.resize(Count, 0.0);
+    Item.PathParent.resize(Count, InvalidIndex);
+
+    for (uint32_t I = 0; I < Count; I++)
+    {
+        Item.Reports[I].Node = Item.Handles[I];
+    }
+
+    return true;
+}
+
+}
+}
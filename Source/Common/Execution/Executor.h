@@ -0,0 +1,142 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "../Graph/Graph.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Snippet
+{
+namespace Common
+{
+
+class Engine;
+class Memo;
+class ResultCache;
+class ThreadPool;
+
+enum class NodeStatus : uint8_t
+{
+    Pending,
+    Succeeded,
+    Failed,
+    Skipped,
+};
+
+struct NodeReport
+{
+    NodeHandle Node {};
+    NodeStatus Status { NodeStatus::Pending };
+    std::string Output {};
+    std::string Log {};
+    std::string Error {};
+    // Offset from the start of the run and wall time spent in the node, in seconds.
+    double Start { 0.0 };
+    double Seconds { 0.0 };
+    // Hash of the node's source and inputs, and of the output they produced.
+    uint64_t Fingerprint { 0 };
+    uint64_t OutputHash { 0 };
+    // Set when the output was taken from the previous run instead of running the node.
+    bool Reused { false };
+};
+
+struct ExecutionReport
+{
+    bool Valid { false };
+    std::string Error {};
+    std::vector<NodeReport> Nodes {};
+    uint32_t Reused { 0 };
+    double Seconds { 0.0 };
+    // Longest chain of dependent nodes weighted by their wall time. No amount of extra
+    // cores can finish the run faster than this.
+    double CriticalPathSeconds { 0.0 };
+    std::vector<NodeHandle> CriticalPath {};
+};
+
+//
+// Evaluates a snippet graph as a dataflow DAG. The graph is snapshotted into a compact
+// plan, checked for cycles, and every node whose inputs are ready is handed to the
+// thread pool. Each node carries an atomic count of unfinished dependencies; whichever
+// task brings a dependent's count to zero schedules it, so no lock is held across the
+// run. A node's inputs are the outputs of the nodes connected to its input ports, in
+// port order. Dependents of a failed node are skipped.
+//
+// When given the Memo of a previous run, a node whose fingerprint is unchanged reuses
+// its previous output without being compiled or run. Nodes that do need to run are
+// looked up in the ResultCache, if one is given, by their bytecode and inputs, and only
+// run on a miss.
+//
+// Graphs that share an engine are run with different scopes. A node's chunk is kept in
+// the engine under its scope and handle, so one graph never replaces another's snippet,
+// and stays there until the owner of the graph forgets it.
+//
+
+class Executor
+{
+public:
+    using OnCompleteSignature = std::function<void(ExecutionReport&&)>;
+    // Called on the pool's threads with a node's report, still Pending, just before it is
+    // run, and again once it has finished, reused or been skipped. Dependents are only
+    // scheduled after it returns, so it should do little more than queue the report.
+    using OnProgressSignature = std::function<void(const NodeReport&)>;
+
+    Executor(Engine& Engine_, ThreadPool& Pool, ResultCache* Cache = nullptr);
+
+    // Starts evaluating a snapshot of Model and returns immediately. Previous may be null
+    // and is only read before this returns. OnComplete is called on one of the pool's
+    // threads once every node has finished. Returns false, without calling OnComplete,
+    // if the graph cannot be scheduled.
+    bool Run(const Graph& Model, const Memo* Previous, uint64_t Scope, OnCompleteSignature&& OnComplete, std::string* Error = nullptr);
+    bool Run(const Graph& Model, const Memo* Previous, uint64_t Scope, OnCompleteSignature&& OnComplete, OnProgressSignature&& OnProgress, std::string* Error = nullptr);
+
+    // Blocking variant. Must not be called from one of the pool's threads.
+    ExecutionReport Run(const Graph& Model, const Memo* Previous = nullptr, uint64_t Scope = 0);
+
+    // Drops the chunk compiled for Node by runs with Scope, once the node is gone.
+    Executor& Forget(uint64_t Scope, NodeHandle Node);
+
+private:
+    struct Plan;
+
+    static uint64_t ChunkKey(uint64_t Scope, NodeHandle Node);
+    static bool Build(const Graph& Model, const Memo* Previous, Plan& Item, std::string& Error);
+
+    void Schedule(const std::shared_ptr<Plan>& Item, uint32_t Index);
+    void Execute(const std::shared_ptr<Plan>& Item, uint32_t Index);
+    void Finish(Plan& Item);
+
+    Engine& m_Engine;
+    ThreadPool& m_Pool;
+    ResultCache* m_Cache { nullptr };
+};
+
+}
+}
@@ -0,0 +1,92 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Memo.h"
+
+namespace Snippet
+{
+namespace Common
+{
+
+Memo::Entry Memo::Find(NodeHandle Node) const
+{
+    const std::unordered_map<uint64_t, Entry>::const_iterator It { m_Entries.find(Node.Key()) };
+    return It != m_Entries.end() ? It->second : nullptr;
+}
+
+Memo& Memo::Update(const ExecutionReport& Report)
+{
+    if (!Report.Valid)
+    {
+        return *this;
+    }
+
+    std::unordered_map<uint64_t, Entry> Entries {};
+    Entries.reserve(Report.Nodes.size());
+
+    for (const NodeReport& Node : Report.Nodes)
+    {
+        if (Node.Status != NodeStatus::Succeeded)
+        {
+            continue;
+        }
+
+        // Reused results are already held by the previous memo; share them rather than
+        // copying their output again.
+        const std::unordered_map<uint64_t, Entry>::const_iterator It { m_Entries.find(Node.Node.Key()) };
+        if (Node.Reused && It != m_Entries.end() && It->second->Fingerprint == Node.Fingerprint)
+        {
+            Entries.emplace(Node.Node.Key(), It->second);
+        }
+        else
+        {
+            Entries.emplace(Node.Node.Key(), std::make_shared<const NodeReport>(Node));
+        }
+    }
+
+    m_Entries = std::move(Entries);
+    return *this;
+}
+
+Memo& Memo::Invalidate(NodeHandle Node)
+{
+    m_Entries.erase(Node.Key());
+    return *this;
+}
+
+Memo& Memo::Clear()
+{
+    m_Entries.clear();
+    return *this;
+}
+
+size_t Memo::Size() const
+{
+    return m_Entries.size();
+}
+
+}
+}
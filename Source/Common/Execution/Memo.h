@@ -0,0 +1,70 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "Executor.h"
+
+#include <memory>
+#include <unordered_map>
+
+namespace Snippet
+{
+namespace Common
+{
+
+//
+// Successful node results from the previous run of a graph, keyed by node. Each result
+// carries the fingerprint it was produced from: the hash of the node's source combined
+// with the hashes of its inputs. The executor reuses a result whenever the fingerprint
+// it computes for the new run matches, so an edit only re-runs the edited node and
+// whichever dependents actually see a different input.
+//
+// Snippets are assumed to be pure functions of their source and inputs. The memo is not
+// thread-safe; it is read when a run is planned and updated once the run completes.
+//
+
+class Memo
+{
+public:
+    using Entry = std::shared_ptr<const NodeReport>;
+
+    Entry Find(NodeHandle Node) const;
+
+    // Replaces the memo's contents with the successful results of Report. Nodes that no
+    // longer exist in the graph are dropped along the way.
+    Memo& Update(const ExecutionReport& Report);
+    Memo& Invalidate(NodeHandle Node);
+    Memo& Clear();
+
+    size_t Size() const;
+
+private:
+    std::unordered_map<uint64_t, Entry> m_Entries {};
+};
+
+}
+}
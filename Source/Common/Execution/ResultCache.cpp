@@ -0,0 +1,403 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "ResultCache.h"
+#include "../Hash.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace Snippet
+{
+namespace Common
+{
+
+// Spilled results are stored in native byte order. The directory is a cache for this
+// machine, not a file format to share.
+static constexpr uint32_t SpillMagic { 0x31435253 };
+static constexpr size_t SpillHeaderSize { 48 };
+
+ResultCache::ResultCache(const Options& Options_)
+    : m_Options(Options_)
+    , m_ShardBytes(Options_.MemoryBytes / ShardCount)
+{
+    if (!m_Options.Directory.empty())
+    {
+        Scan();
+    }
+}
+
+ResultCache::Entry ResultCache::Find(const Key& Item)
+{
+    Shard& Target { GetShard(Item) };
+
+    {
+        std::lock_guard<std::mutex> Lock { Target.Mutex };
+        const auto It { Target.Index.find(Item) };
+
+        if (It != Target.Index.end())
+        {
+            Target.Slots.splice(Target.Slots.begin(), Target.Slots, It->second);
+            m_Hits++;
+            return It->second->Result;
+        }
+    }
+
+    if (!m_Options.Directory.empty())
+    {
+        const Entry Result { Load(Item) };
+
+        if (Result != nullptr)
+        {
+            m_Hits++;
+            m_DiskHits++;
+            Insert(Item, Result);
+            return Result;
+        }
+    }
+
+    m_Misses++;
+    return nullptr;
+}
+
+ResultCache& ResultCache::Insert(const Key& Item, const Entry& Result)
+{
+    if (Result == nullptr)
+    {
+        return *this;
+    }
+
+    const size_t Size { SizeOf(*Result) };
+    if (Size > m_ShardBytes)
+    {
+        Spill({ Item, Result, Size });
+        return *this;
+    }
+
+    // Evicted entries are written out after the shard is unlocked so that disk I/O never
+    // holds up lookups.
+    std::list<Slot> Evicted {};
+    Shard& Target { GetShard(Item) };
+
+    {
+        std::lock_guard<std::mutex> Lock { Target.Mutex };
+        Store(Target, Item, Result, Size, Evicted);
+    }
+
+    for (const Slot& Evict : Evicted)
+    {
+        Spill(Evict);
+    }
+
+    return *this;
+}
+
+ResultCache::Stats ResultCache::GetStats() const
+{
+    Stats Result {};
+    Result.Hits = m_Hits;
+    Result.Misses = m_Misses;
+    Result.Evictions = m_Evictions;
+    Result.Spills = m_Spills;
+    Result.DiskHits = m_DiskHits;
+    Result.Entries = m_Entries;
+    Result.Bytes = m_Bytes;
+
+    {
+        std::lock_guard<std::mutex> Lock { m_DiskMutex };
+        Result.DiskBytes = m_DiskBytes;
+    }
+
+    return Result;
+}
+
+size_t ResultCache::SizeOf(const Value& Result)
+{
+    // Output and log plus a rough allowance for the slot, list and index nodes.
+    return Result.Output.size() + Result.Log.size() + sizeof(Value) + sizeof(Slot) + 64;
+}
+
+ResultCache::Shard& ResultCache::GetShard(const Key& Item)
+{
+    return m_Shards[KeyHash {}(Item) % ShardCount];
+}
+
+void ResultCache::Store(Shard& Target, const Key& Item, const Entry& Result, size_t Size, std::list<Slot>& Evicted)
+{
+    const auto It { Target.Index.find(Item) };
+
+    if (It != Target.Index.end())
+    {
+        Target.Bytes -= It->second->Size;
+        m_Bytes -= It->second->Size;
+        It->second->Result = Result;
+        It->second->Size = Size;
+        Target.Slots.splice(Target.Slots.begin(), Target.Slots, It->second);
+    }
+    else
+    {
+        Target.Slots.push_front({ Item, Result, Size });
+        Target.Index.emplace(Item, Target.Slots.begin());
+        m_Entries++;
+    }
+
+    Target.Bytes += Size;
+    m_Bytes += Size;
+
+    // The new entry fits the shard's budget on its own, so it is never the one evicted.
+    while (Target.Bytes > m_ShardBytes && Target.Slots.size() > 1)
+    {
+        const std::list<Slot>::iterator Last { std::prev(Target.Slots.end()) };
+        Target.Index.erase(Last->ID);
+        Target.Bytes -= Last->Size;
+        m_Bytes -= Last->Size;
+        m_Entries--;
+        m_Evictions++;
+        Evicted.splice(Evicted.end(), Target.Slots, Last);
+    }
+}
+
+void ResultCache::Spill(const Slot& Item)
+{
+    if (m_Options.Directory.empty())
+    {
+        return;
+    }
+
+    const Value& Result { *Item.Result };
+    const uint64_t Size { SpillHeaderSize + Result.Output.size() + Result.Log.size() };
+    if (Size > m_Options.DiskBytes)
+    {
+        return;
+    }
+
+    {
+        // Content-addressed, so a file that is already there holds the same result.
+        std::lock_guard<std::mutex> Lock { m_DiskMutex };
+        if (m_FileIndex.find(Item.ID) != m_FileIndex.end())
+        {
+            return;
+        }
+    }
+
+    const std::string Path { PathOf(Item.ID) };
+    const std::string Temp { Path + "." + std::to_string(m_TempCounter++) + ".tmp" };
+
+    uint8_t Header[SpillHeaderSize] {};
+    const uint32_t Version { 1 };
+    const uint64_t OutputSize { Result.Output.size() };
+    const uint64_t LogSize { Result.Log.size() };
+    std::memcpy(Header, &SpillMagic, 4);
+    std::memcpy(Header + 4, &Version, 4);
+    std::memcpy(Header + 8, &Item.ID.Code, 8);
+    std::memcpy(Header + 16, &Item.ID.Inputs, 8);
+    std::memcpy(Header + 24, &Result.OutputHash, 8);
+    std::memcpy(Header + 32, &OutputSize, 8);
+    std::memcpy(Header + 40, &LogSize, 8);
+
+    std::FILE* File { std::fopen(Temp.c_str(), "wb") };
+    if (File == nullptr)
+    {
+        return;
+    }
+
+    bool Valid { std::fwrite(Header, 1, sizeof(Header), File) == sizeof(Header) };
+    Valid = Valid && std::fwrite(Result.Output.data(), 1, Result.Output.size(), File) == Result.Output.size();
+    Valid = Valid && std::fwrite(Result.Log.data(), 1, Result.Log.size(), File) == Result.Log.size();
+    Valid = std::fclose(File) == 0 && Valid;
+
+    if (!Valid || std::rename(Temp.c_str(), Path.c_str()) != 0)
+    {
+        std::remove(Temp.c_str());
+        return;
+    }
+
+    m_Spills++;
+
+    // Files are removed under the lock so that a result spilled again in the meantime
+    // cannot have its new file deleted by a stale eviction.
+    std::lock_guard<std::mutex> Lock { m_DiskMutex };
+    if (m_FileIndex.find(Item.ID) != m_FileIndex.end())
+    {
+        return;
+    }
+
+    m_Files.push_back({ Item.ID, Size });
+    m_FileIndex.emplace(Item.ID, std::prev(m_Files.end()));
+    m_DiskBytes += Size;
+
+    Trim();
+}
+
+ResultCache::Entry ResultCache::Load(const Key& Item)
+{
+    {
+        std::lock_guard<std::mutex> Lock { m_DiskMutex };
+        if (m_FileIndex.find(Item) == m_FileIndex.end())
+        {
+            return nullptr;
+        }
+    }
+
+    std::shared_ptr<Value> Result { std::make_shared<Value>() };
+    std::FILE* File { std::fopen(PathOf(Item).c_str(), "rb") };
+    bool Valid { File != nullptr };
+
+    uint8_t Header[SpillHeaderSize] {};
+    uint32_t Magic { 0 };
+    Key Stored {};
+    uint64_t OutputSize { 0 };
+    uint64_t LogSize { 0 };
+
+    Valid = Valid && std::fread(Header, 1, sizeof(Header), File) == sizeof(Header);
+    if (Valid)
+    {
+        std::memcpy(&Magic, Header, 4);
+        std::memcpy(&Stored.Code, Header + 8, 8);
+        std::memcpy(&Stored.Inputs, Header + 16, 8);
+        std::memcpy(&Result->OutputHash, Header + 24, 8);
+        std::memcpy(&OutputSize, Header + 32, 8);
+        std::memcpy(&LogSize, Header + 40, 8);
+        Valid = Magic == SpillMagic && Stored == Item && OutputSize + LogSize <= m_Options.DiskBytes;
+    }
+
+    if (Valid)
+    {
+        Result->Output.resize(OutputSize);
+        Result->Log.resize(LogSize);
+        Valid = std::fread(Result->Output.data(), 1, OutputSize, File) == OutputSize
+            && std::fread(Result->Log.data(), 1, LogSize, File) == LogSize
+            && Hash(Result->Output) == Result->OutputHash;
+    }
+
+    if (File != nullptr)
+    {
+        std::fclose(File);
+    }
+
+    if (Valid)
+    {
+        return Result;
+    }
+
+    // Missing or damaged. Forget the file so it is not read again.
+    std::lock_guard<std::mutex> Lock { m_DiskMutex };
+    const auto It { m_FileIndex.find(Item) };
+    if (It != m_FileIndex.end())
+    {
+        std::remove(PathOf(Item).c_str());
+        m_DiskBytes -= It->second->Size;
+        m_Files.erase(It->second);
+        m_FileIndex.erase(It);
+    }
+
+    return nullptr;
+}
+
+void ResultCache::Scan()
+{
+    namespace fs = std::filesystem;
+
+    std::error_code Error {};
+    fs::create_directories(m_Options.Directory, Error);
+
+    struct Found
+    {
+        fs::file_time_type Time {};
+        SpillFile File {};
+    };
+
+    std::vector<Found> Files {};
+    for (fs::directory_iterator It { m_Options.Directory, Error }, End {}; !Error && It != End; It.increment(Error))
+    {
+        const fs::path& Path { It->path() };
+        const std::string Stem { Path.stem().string() };
+
+        if (Path.extension() == ".tmp")
+        {
+            fs::remove(Path, Error);
+            continue;
+        }
+
+        if (Path.extension() != ".result" || Stem.size() != 32 || Stem.find_first_not_of("0123456789abcdef") != std::string::npos)
+        {
+            continue;
+        }
+
+        Found Item {};
+        Item.Time = It->last_write_time(Error);
+        Item.File.Size = It->file_size(Error);
+        Item.File.ID.Code = std::strtoull(Stem.substr(0, 16).c_str(), nullptr, 16);
+        Item.File.ID.Inputs = std::strtoull(Stem.substr(16).c_str(), nullptr, 16);
+
+        if (!Error)
+        {
+            Files.push_back(Item);
+        }
+
+        Error.clear();
+    }
+
+    std::sort(Files.begin(), Files.end(), [](const Found& A, const Found& B) -> bool
+        {
+            return A.Time < B.Time;
+        });
+
+    std::lock_guard<std::mutex> Lock { m_DiskMutex };
+    for (const Found& Item : Files)
+    {
+        m_Files.push_back(Item.File);
+        m_FileIndex.emplace(Item.File.ID, std::prev(m_Files.end()));
+        m_DiskBytes += Item.File.Size;
+    }
+
+    Trim();
+}
+
+void ResultCache::Trim()
+{
+    while (m_DiskBytes > m_Options.DiskBytes && !m_Files.empty())
+    {
+        const SpillFile& Oldest { m_Files.front() };
+        std::remove(PathOf(Oldest.ID).c_str());
+        m_DiskBytes -= Oldest.Size;
+        m_FileIndex.erase(Oldest.ID);
+        m_Files.pop_front();
+    }
+}
+
+std::string ResultCache::PathOf(const Key& Item) const
+{
+    char Name[40] {};
+    std::snprintf(Name, sizeof(Name), "%016llx%016llx.result", static_cast<unsigned long long>(Item.Code), static_cast<unsigned long long>(Item.Inputs));
+    return (std::filesystem::path { m_Options.Directory } / Name).string();
+}
+
+}
+}
@@ -0,0 +1,168 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Snippet
+{
+namespace Common
+{
+
+//
+// Content-addressed store of successful snippet results, shared by every run on a
+// server. A result is keyed by the hash of the bytecode that produced it and the hashes
+// of its inputs, so the same snippet fed the same inputs is found again whichever
+// workspace, node or session ran it first. Like the memo, this assumes snippets are pure;
+// one that calls math.random will keep returning the first value it produced.
+//
+// Entries are spread over a fixed number of shards by key, each with its own lock, LRU
+// list and an equal share of the memory budget. Entries evicted from memory are written
+// to the spill directory when one is set, one file per key, and read back on a later
+// miss. The directory has a budget of its own and drops its oldest files first. Files
+// left by a previous process are picked up when the cache is created.
+//
+
+class ResultCache
+{
+public:
+    static constexpr uint32_t ShardCount { 16 };
+
+    struct Key
+    {
+        uint64_t Code { 0 };
+        uint64_t Inputs { 0 };
+
+        bool operator==(const Key& Other) const { return Code == Other.Code && Inputs == Other.Inputs; }
+    };
+
+    struct Value
+    {
+        std::string Output {};
+        std::string Log {};
+        uint64_t OutputHash { 0 };
+    };
+
+    using Entry = std::shared_ptr<const Value>;
+
+    struct Options
+    {
+        size_t MemoryBytes { 256 * 1024 * 1024 };
+        // Empty to keep results in memory only.
+        std::string Directory {};
+        uint64_t DiskBytes { 1024ull * 1024 * 1024 };
+    };
+
+    struct Stats
+    {
+        uint64_t Hits { 0 };
+        uint64_t Misses { 0 };
+        uint64_t Evictions { 0 };
+        uint64_t Spills { 0 };
+        uint64_t DiskHits { 0 };
+        uint64_t Entries { 0 };
+        uint64_t Bytes { 0 };
+        uint64_t DiskBytes { 0 };
+    };
+
+    ResultCache(const Options& Options_);
+
+    // Returns null on a miss. A result found on disk is moved back into memory.
+    Entry Find(const Key& Item);
+    // Results larger than a shard's budget are only ever written to disk.
+    ResultCache& Insert(const Key& Item, const Entry& Result);
+    ResultCache& Clear();
+
+    Stats GetStats() const;
+
+private:
+    struct KeyHash
+    {
+        size_t operator()(const Key& Item) const { return static_cast<size_t>(Item.Code ^ (Item.Inputs * 0x9e3779b97f4a7c15ull)); }
+    };
+
+    struct Slot
+    {
+        Key ID {};
+        Entry Result { nullptr };
+        size_t Size { 0 };
+    };
+
+    struct Shard
+    {
+        std::mutex Mutex {};
+        // Most recently used first.
+        std::list<Slot> Slots {};
+        std::unordered_map<Key, std::list<Slot>::iterator, KeyHash> Index {};
+        size_t Bytes { 0 };
+    };
+
+    struct SpillFile
+    {
+        Key ID {};
+        uint64_t Size { 0 };
+    };
+
+    static size_t SizeOf(const Value& Result);
+
+    Shard& GetShard(const Key& Item);
+    void Store(Shard& Target, const Key& Item, const Entry& Result, size_t Size, std::list<Slot>& Evicted);
+    void Spill(const Slot& Item);
+    Entry Load(const Key& Item);
+    void Scan();
+    // Drops the oldest files until the directory is within budget. Needs the disk lock.
+    void Trim();
+    std::string PathOf(const Key& Item) const;
+
+    Options m_Options {};
+    size_t m_ShardBytes { 0 };
+    Shard m_Shards[ShardCount] {};
+
+    // Spilled files in the order they were written, which is the order they are dropped.
+    mutable std::mutex m_DiskMutex {};
+    std::list<SpillFile> m_Files {};
+    std::unordered_map<Key, std::list<SpillFile>::iterator, KeyHash> m_FileIndex {};
+    uint64_t m_DiskBytes { 0 };
+    std::atomic<uint64_t> m_TempCounter { 0 };
+
+    std::atomic<uint64_t> m_Hits { 0 };
+    std::atomic<uint64_t> m_Misses { 0 };
+    std::atomic<uint64_t> m_Evictions { 0 };
+    std::atomic<uint64_t> m_Spills { 0 };
+    std::atomic<uint64_t> m_DiskHits { 0 };
+    std::atomic<uint64_t> m_Entries { 0 };
+    std::atomic<uint64_t> m_Bytes { 0 };
+};
+
+}
+}
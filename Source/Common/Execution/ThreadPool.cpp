@@ -0,0 +1,200 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace Snippet
+{
+namespace Common
+{
+
+// The pool and deque index of the calling thread, or nullptr when the caller is not one
+// of a pool's workers.
+static thread_local const ThreadPool* CurrentPool { nullptr };
+static thread_local size_t CurrentIndex { 0 };
+
+ThreadPool::ThreadPool(unsigned int Threads)
+{
+    if (Threads == 0)
+    {
+        Threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned int I = 0; I < Threads; I++)
+    {
+        m_Queues.push_back(std::make_unique<Queue>());
+    }
+
+    for (unsigned int I = 0; I < Threads; I++)
+    {
+        m_Threads.emplace_back([this, I]() -> void
+            {
+                Work(I);
+            });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> Lock { m_SleepMutex };
+        m_Stopping = true;
+    }
+
+    m_SleepCondition.notify_all();
+
+    for (std::thread& Thread : m_Threads)
+    {
+        if (Thread.joinable())
+        {
+            Thread.join();
+        }
+    }
+}
+
+ThreadPool& ThreadPool::Submit(TaskSignature&& Task)
+{
+    const size_t Index { IsWorkerThread() ? CurrentIndex : m_Next.fetch_add(1, std::memory_order_relaxed) % m_Queues.size() };
+
+    {
+        Queue& Target { *m_Queues[Index] };
+        std::lock_guard<std::mutex> Lock { Target.Mutex };
+        Target.Tasks.push_back(std::move(Task));
+    }
+
+    // Sleepers re-check m_Queued under the sleep lock after announcing themselves, so
+    // either they see this task or this sees them and wakes one up.
+    m_Queued++;
+    if (m_Sleeping > 0)
+    {
+        std::lock_guard<std::mutex> Lock { m_SleepMutex };
+        m_SleepCondition.notify_one();
+    }
+
+    return *this;
+}
+
+unsigned int ThreadPool::Size() const
+{
+    return static_cast<unsigned int>(m_Threads.size());
+}
+
+bool ThreadPool::IsWorkerThread() const
+{
+    return CurrentPool == this;
+}
+
+ThreadPool::Stats ThreadPool::GetStats() const
+{
+    Stats Result {};
+    Result.Executed = m_Executed;
+    Result.Stolen = m_Stolen;
+    return Result;
+}
+
+bool ThreadPool::Pop(size_t Index, TaskSignature& Task)
+{
+    Queue& Target { *m_Queues[Index] };
+    std::lock_guard<std::mutex> Lock { Target.Mutex };
+
+    if (Target.Tasks.empty())
+    {
+        return false;
+    }
+
+    Task = std::move(Target.Tasks.back());
+    Target.Tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::Steal(size_t Index, TaskSignature& Task)
+{
+    const size_t Count { m_Queues.size() };
+
+    for (size_t I = 1; I < Count; I++)
+    {
+        Queue& Victim { *m_Queues[(Index + I) % Count] };
+        std::unique_lock<std::mutex> Lock { Victim.Mutex, std::try_to_lock };
+
+        if (!Lock.owns_lock() || Victim.Tasks.empty())
+        {
+            continue;
+        }
+
+        Task = std::move(Victim.Tasks.front());
+        Victim.Tasks.pop_front();
+        m_Stolen.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::Work(size_t Index)
+{
+    CurrentPool = this;
+    CurrentIndex = Index;
+
+    TaskSignature Task { nullptr };
+
+    while (true)
+    {
+        if (Pop(Index, Task) || Steal(Index, Task))
+        {
+            m_Queued--;
+            Task();
+            Task = nullptr;
+            m_Executed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        // A failed try_lock in Steal can miss a task, so only sleep once the queued count
+        // says there really is nothing left.
+        if (m_Queued > 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> Lock { m_SleepMutex };
+        m_Sleeping++;
+        m_SleepCondition.wait(Lock, [this]() -> bool
+            {
+                return m_Queued > 0 || m_Stopping;
+            });
+        m_Sleeping--;
+
+        if (m_Stopping && m_Queued == 0)
+        {
+            break;
+        }
+    }
+}
+
+}
+}
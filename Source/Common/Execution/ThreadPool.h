@@ -0,0 +1,95 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Snippet
+{
+namespace Common
+{
+
+//
+// Fixed set of worker threads, each with its own task deque. A worker pushes and pops
+// its own tasks from the back and, once empty, steals from the front of the others, so
+// there is no shared queue for workers to contend on. Tasks submitted from outside the
+// pool are spread across the deques round-robin. Workers only touch the shared sleep
+// lock when there is nothing left to run anywhere.
+//
+
+class ThreadPool
+{
+public:
+    using TaskSignature = std::function<void()>;
+
+    struct Stats
+    {
+        uint64_t Executed { 0 };
+        uint64_t Stolen { 0 };
+    };
+
+    ThreadPool(unsigned int Threads = 0);
+    ~ThreadPool();
+
+    ThreadPool& Submit(TaskSignature&& Task);
+
+    unsigned int Size() const;
+    bool IsWorkerThread() const;
+    Stats GetStats() const;
+
+private:
+    struct Queue
+    {
+        std::mutex Mutex {};
+        std::deque<TaskSignature> Tasks {};
+    };
+
+    bool Pop(size_t Index, TaskSignature& Task);
+    bool Steal(size_t Index, TaskSignature& Task);
+    void Work(size_t Index);
+
+    std::vector<std::unique_ptr<Queue>> m_Queues {};
+    std::vector<std::thread> m_Threads {};
+    std::atomic<size_t> m_Next { 0 };
+    std::atomic<size_t> m_Queued { 0 };
+    std::atomic<size_t> m_Sleeping { 0 };
+    std::atomic<bool> m_Stopping { false };
+    std::mutex m_SleepMutex {};
+    std::condition_variable m_SleepCondition {};
+    std::atomic<uint64_t> m_Executed { 0 };
+    std::atomic<uint64_t> m_Stolen { 0 };
+};
+
+}
+}
@@ -0,0 +1,69 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+namespace Snippet
+{
+namespace Common
+{
+
+struct Point
+{
+    float X { 0.0f };
+    float Y { 0.0f };
+};
+
+struct Bounds
+{
+    float MinX { 0.0f };
+    float MinY { 0.0f };
+    float MaxX { 0.0f };
+    float MaxY { 0.0f };
+
+    bool Contains(float X, float Y) const
+    {
+        return MinX <= X && X <= MaxX && MinY <= Y && Y <= MaxY;
+    }
+
+    bool Intersects(const Bounds& Other) const
+    {
+        return MinX <= Other.MaxX && Other.MinX <= MaxX && MinY <= Other.MaxY && Other.MinY <= MaxY;
+    }
+
+    bool operator==(const Bounds& Other) const
+    {
+        return MinX == Other.MinX && MinY == Other.MinY && MaxX == Other.MaxX && MaxY == Other.MaxY;
+    }
+
+    bool operator!=(const Bounds& Other) const
+    {
+        return !(*this == Other);
+    }
+};
+
+}
+}
@@ -0,0 +1,328 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "EdgeCache.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Snippet
+{
+namespace Common
+{
+
+// Extra room around each chunk's bounds so thick lines and hit tests near the ends of a
+// chunk still find it.
+static constexpr float ChunkPadding { 4.0f };
+
+static float DistanceSquared(const Point& P, const Point& A, const Point& B)
+{
+    const float DX { B.X - A.X };
+    const float DY { B.Y - A.Y };
+    const float Length { DX * DX + DY * DY };
+    float T { Length > 0.0f ? ((P.X - A.X) * DX + (P.Y - A.Y) * DY) / Length : 0.0f };
+    T = std::clamp(T, 0.0f, 1.0f);
+
+    const float X { A.X + DX * T - P.X };
+    const float Y { A.Y + DY * T - P.Y };
+    return X * X + Y * Y;
+}
+
+Point EdgeCache::GetAnchor(const Graph& Model, PortHandle Port)
+{
+    const Graph::Port* Item { Model.GetPort(Port) };
+
+    if (Item == nullptr)
+    {
+        return {};
+    }
+
+    uint32_t Index { 0 };
+    uint32_t Count { 0 };
+    for (PortHandle Other : Model.GetPorts(Item->Owner))
+    {
+        const Graph::Port* Sibling { Model.GetPort(Other) };
+
+        if (Sibling != nullptr && Sibling->Kind == Item->Kind)
+        {
+            if (Other == Port)
+            {
+                Index = Count;
+            }
+
+            Count++;
+        }
+    }
+
+    const Point Position { Model.GetPosition(Item->Owner) };
+    const Point Size { Model.GetSize(Item->Owner) };
+    const float X { Item->Kind == PortKind::Input ? Position.X : Position.X + Size.X };
+    return { X, Position.Y + Size.Y * static_cast<float>(Index + 1) / static_cast<float>(Count + 1) };
+}
+
+EdgeCache::EdgeCache()
+{
+}
+
+EdgeCache& EdgeCache::Rebuild(const Graph& Model)
+{
+    Clear();
+    Model.ForEachConnection([this, &Model](ConnectionHandle ID, const Graph::Connection&) -> void
+        {
+            Add(Model, ID);
+        });
+    return *this;
+}
+
+EdgeCache& EdgeCache::Add(const Graph& Model, ConnectionHandle ID)
+{
+    if (!Model.IsValid(ID) || Contains(ID))
+    {
+        return *this;
+    }
+
+    if (ID.Index >= m_Edges.size())
+    {
+        m_Edges.resize(static_cast<size_t>(ID.Index) + 1);
+        m_Points.resize(m_Edges.size() * PointsPerEdge);
+    }
+
+    // A live edge in the same slot belongs to a connection that has since been removed.
+    Edge& Item { m_Edges[ID.Index] };
+    if (Item.Alive)
+    {
+        Remove(Item.Connection);
+    }
+
+    Item.Connection = ID;
+    Item.Alive = true;
+    Item.Dirty = false;
+    std::fill(std::begin(Item.Chunks), std::end(Item.Chunks), ChunkIndex::InvalidHandle);
+    m_Count++;
+
+    Tessellate(Model, ID.Index);
+    return *this;
+}
+
+EdgeCache& EdgeCache::Remove(ConnectionHandle ID)
+{
+    if (!Contains(ID))
+    {
+        return *this;
+    }
+
+    Edge& Item { m_Edges[ID.Index] };
+    for (ChunkIndex::Handle Chunk : Item.Chunks)
+    {
+        m_Index.Remove(Chunk);
+    }
+
+    Item.Alive = false;
+    Item.Dirty = false;
+    m_Count--;
+    return *this;
+}
+
+EdgeCache& EdgeCache::RemoveNode(const Graph& Model, NodeHandle Node)
+{
+    for (PortHandle Port : Model.GetPorts(Node))
+    {
+        if (const Graph::Port* Item = Model.GetPort(Port))
+        {
+            for (ConnectionHandle ID : Item->Connections)
+            {
+                Remove(ID);
+            }
+        }
+    }
+
+    return *this;
+}
+
+EdgeCache& EdgeCache::Clear()
+{
+    m_Edges.clear();
+    m_Points.clear();
+    m_Dirty.clear();
+    m_Index.Clear();
+    m_Count = 0;
+    return *this;
+}
+
+EdgeCache& EdgeCache::Invalidate(const Graph& Model, NodeHandle Node)
+{
+    for (PortHandle Port : Model.GetPorts(Node))
+    {
+        if (const Graph::Port* Item = Model.GetPort(Port))
+        {
+            for (ConnectionHandle ID : Item->Connections)
+            {
+                if (Contains(ID))
+                {
+                    MarkDirty(ID.Index);
+                }
+            }
+        }
+    }
+
+    return *this;
+}
+
+size_t EdgeCache::Update(const Graph& Model)
+{
+    size_t Result { 0 };
+
+    for (uint32_t Slot : m_Dirty)
+    {
+        Edge& Item { m_Edges[Slot] };
+
+        if (!Item.Alive || !Item.Dirty)
+        {
+            continue;
+        }
+
+        Item.Dirty = false;
+
+        if (!Model.IsValid(Item.Connection))
+        {
+            Remove(Item.Connection);
+            continue;
+        }
+
+        Tessellate(Model, Slot);
+        Result++;
+    }
+
+    m_Dirty.clear();
+    return Result;
+}
+
+bool EdgeCache::Contains(ConnectionHandle ID) const
+{
+    return ID.Index < m_Edges.size() && m_Edges[ID.Index].Alive && m_Edges[ID.Index].Connection == ID;
+}
+
+const Point* EdgeCache::GetPoints(ConnectionHandle ID) const
+{
+    return Contains(ID) ? m_Points.data() + static_cast<size_t>(ID.Index) * PointsPerEdge : nullptr;
+}
+
+ConnectionHandle EdgeCache::HitTest(float X, float Y, float Tolerance) const
+{
+    const Point Target { X, Y };
+    ConnectionHandle Result {};
+    float Closest { Tolerance * Tolerance };
+
+    Query({ X - Tolerance, Y - Tolerance, X + Tolerance, Y + Tolerance }, [&](ConnectionHandle ID, const Point* Points, uint32_t Count) -> void
+        {
+            for (uint32_t I = 1; I < Count; I++)
+            {
+                const float Distance { DistanceSquared(Target, Points[I - 1], Points[I]) };
+
+                if (Distance <= Closest)
+                {
+                    Closest = Distance;
+                    Result = ID;
+                }
+            }
+        });
+
+    return Result;
+}
+
+size_t EdgeCache::Size() const
+{
+    return m_Count;
+}
+
+void EdgeCache::Tessellate(const Graph& Model, uint32_t Slot)
+{
+    Edge& Item { m_Edges[Slot] };
+    const Graph::Connection* Connection { Model.GetConnection(Item.Connection) };
+
+    if (Connection == nullptr)
+    {
+        return;
+    }
+
+    // Both ends leave their port horizontally, bending further the further apart they are.
+    const Point From { GetAnchor(Model, Connection->From) };
+    const Point To { GetAnchor(Model, Connection->To) };
+    const float Bend { std::max(std::fabs(To.X - From.X) * 0.5f, 50.0f) };
+    const Point C1 { From.X + Bend, From.Y };
+    const Point C2 { To.X - Bend, To.Y };
+
+    Point* Points { m_Points.data() + static_cast<size_t>(Slot) * PointsPerEdge };
+    for (uint32_t I = 0; I < PointsPerEdge; I++)
+    {
+        const float T { static_cast<float>(I) / static_cast<float>(Segments) };
+        const float U { 1.0f - T };
+        const float A { U * U * U };
+        const float B { 3.0f * U * U * T };
+        const float C { 3.0f * U * T * T };
+        const float D { T * T * T };
+        Points[I] = { A * From.X + B * C1.X + C * C2.X + D * To.X, A * From.Y + B * C1.Y + C * C2.Y + D * To.Y };
+    }
+
+    for (uint32_t Chunk = 0; Chunk < Chunks; Chunk++)
+    {
+        const Point* First { Points + Chunk * SegmentsPerChunk };
+        Bounds Box { First->X, First->Y, First->X, First->Y };
+
+        for (uint32_t I = 1; I <= SegmentsPerChunk; I++)
+        {
+            Box.MinX = std::min(Box.MinX, First[I].X);
+            Box.MinY = std::min(Box.MinY, First[I].Y);
+            Box.MaxX = std::max(Box.MaxX, First[I].X);
+            Box.MaxY = std::max(Box.MaxY, First[I].Y);
+        }
+
+        Box = { Box.MinX - ChunkPadding, Box.MinY - ChunkPadding, Box.MaxX + ChunkPadding, Box.MaxY + ChunkPadding };
+
+        if (m_Index.IsValid(Item.Chunks[Chunk]))
+        {
+            m_Index.Update(Item.Chunks[Chunk], Box);
+        }
+        else
+        {
+            Item.Chunks[Chunk] = m_Index.Insert(Slot * Chunks + Chunk, Box);
+        }
+    }
+}
+
+void EdgeCache::MarkDirty(uint32_t Slot)
+{
+    Edge& Item { m_Edges[Slot] };
+
+    if (!Item.Dirty)
+    {
+        Item.Dirty = true;
+        m_Dirty.push_back(Slot);
+    }
+}
+
+}
+}
@@ -0,0 +1,121 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "../SpatialGrid.h"
+#include "Graph.h"
+
+#include <vector>
+
+namespace Snippet
+{
+namespace Common
+{
+
+//
+// Tessellated curves for the connections of a graph. Every edge is a cubic curve from its
+// output port to its input port, flattened into a fixed number of points stored at a
+// fixed offset in one shared buffer, so the whole set can be walked and submitted as a
+// single stream of line segments. An edge is only tessellated again after one of its
+// nodes has been invalidated. Each edge is split into a few chunks that are indexed
+// separately, which keeps long edges from covering every cell of their bounding box and
+// lets a paint or hit test visit only the parts of an edge near the query.
+//
+
+class EdgeCache
+{
+public:
+    static constexpr uint32_t Segments { 24 };
+    static constexpr uint32_t Chunks { 4 };
+    static constexpr uint32_t PointsPerEdge { Segments + 1 };
+    static constexpr uint32_t SegmentsPerChunk { Segments / Chunks };
+
+    // Where a port's connections attach to its node. Inputs are spread down the left edge
+    // and outputs down the right edge, in the order they were added.
+    static Point GetAnchor(const Graph& Model, PortHandle Port);
+
+    EdgeCache();
+
+    // Drops everything cached and adds every connection in Model.
+    EdgeCache& Rebuild(const Graph& Model);
+    EdgeCache& Add(const Graph& Model, ConnectionHandle ID);
+    EdgeCache& Remove(ConnectionHandle ID);
+    // Removes the edges of every port on Node. Called before the node is removed.
+    EdgeCache& RemoveNode(const Graph& Model, NodeHandle Node);
+    EdgeCache& Clear();
+
+    // Marks the edges attached to Node for tessellation on the next Update.
+    EdgeCache& Invalidate(const Graph& Model, NodeHandle Node);
+    // Tessellates every invalidated edge. Returns how many were.
+    size_t Update(const Graph& Model);
+
+    bool Contains(ConnectionHandle ID) const;
+    // The PointsPerEdge points of an edge, or null if it is not cached.
+    const Point* GetPoints(ConnectionHandle ID) const;
+
+    // Calls Fn(Connection, Points, Count) for every chunk of an edge that intersects Box.
+    // Consecutive points are the segments to draw.
+    template<typename Fn>
+    void Query(const Bounds& Box, Fn&& Callback) const
+    {
+        m_Index.Query(Box, [&](ChunkIndex::Handle, uint32_t Chunk) -> void
+            {
+                const uint32_t Slot { Chunk / Chunks };
+                const Point* Points { m_Points.data() + static_cast<size_t>(Slot) * PointsPerEdge + (Chunk % Chunks) * SegmentsPerChunk };
+                Callback(m_Edges[Slot].Connection, Points, SegmentsPerChunk + 1);
+            });
+    }
+
+    // The edge passing closest to the point, if any passes within Tolerance.
+    ConnectionHandle HitTest(float X, float Y, float Tolerance) const;
+
+    size_t Size() const;
+
+private:
+    using ChunkIndex = SpatialGrid<uint32_t>;
+
+    struct Edge
+    {
+        ConnectionHandle Connection {};
+        ChunkIndex::Handle Chunks[EdgeCache::Chunks] {};
+        bool Alive { false };
+        bool Dirty { false };
+    };
+
+    void Tessellate(const Graph& Model, uint32_t Slot);
+    void MarkDirty(uint32_t Slot);
+
+    // Indexed by the connection handle's slot, the same way the graph stores connections.
+    std::vector<Edge> m_Edges {};
+    std::vector<Point> m_Points {};
+    std::vector<uint32_t> m_Dirty {};
+    ChunkIndex m_Index { 512.0f };
+    size_t m_Count { 0 };
+};
+
+}
+}
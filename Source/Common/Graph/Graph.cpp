@@ -0,0 +1,350 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Graph.h"
+#include "../Hash.h"
+
+#include <algorithm>
+
+namespace Snippet
+{
+namespace Common
+{
+
+static const std::u32string EmptyName {};
+static const std::string EmptySource {};
+static const std::vector<PortHandle> EmptyPorts {};
+
+template<typename T>
+static void Erase(std::vector<T>& List, const T& Item)
+{
+    const typename std::vector<T>::iterator It { std::find(List.begin(), List.end(), Item) };
+
+    if (It != List.end())
+    {
+        *It = List.back();
+        List.pop_back();
+    }
+}
+
+Graph::Graph()
+{
+}
+
+NodeHandle Graph::AddNode(NodeID ID)
+{
+    if (ID == InvalidNodeID || m_IDs.count(ID) > 0)
+    {
+        ID = m_Generator.Next();
+    }
+    else
+    {
+        m_Generator.Observe(ID);
+    }
+
+    Node Item {};
+    Item.ID = ID;
+
+    const NodeHandle Result { m_Nodes.Insert(std::move(Item)) };
+    m_IDs[ID] = Result;
+    return Result;
+}
+
+NodeHandle Graph::AddSnippet(NodeID ID)
+{
+    const NodeHandle Result { AddNode(ID) };
+    AddPort(Result, PortKind::Input, "In");
+    AddPort(Result, PortKind::Output, "Out");
+    return Result;
+}
+
+bool Graph::RemoveNode(NodeHandle ID)
+{
+    const Node* Item { m_Nodes.Get(ID) };
+
+    if (Item == nullptr)
+    {
+        return false;
+    }
+
+    const std::vector<PortHandle> Ports { Item->Ports };
+    for (PortHandle Port_ : Ports)
+    {
+        RemovePort(Port_);
+    }
+
+    m_IDs.erase(Item->ID);
+    return m_Nodes.Remove(ID);
+}
+
+bool Graph::IsValid(NodeHandle ID) const
+{
+    return m_Nodes.Contains(ID);
+}
+
+NodeHandle Graph::Find(NodeID ID) const
+{
+    const std::unordered_map<NodeID, NodeHandle>::const_iterator It { m_IDs.find(ID) };
+    return It != m_IDs.end() ? It->second : NodeHandle {};
+}
+
+NodeID Graph::GetID(NodeHandle ID) const
+{
+    const Node* Item { m_Nodes.Get(ID) };
+    return Item != nullptr ? Item->ID : InvalidNodeID;
+}
+
+Graph& Graph::SetSite(uint16_t Site)
+{
+    if (Site == m_Generator.Site())
+    {
+        return *this;
+    }
+
+    m_Generator = NodeIDGenerator { Site };
+    for (const std::pair<const NodeID, NodeHandle>& Item : m_IDs)
+    {
+        m_Generator.Observe(Item.first);
+    }
+
+    return *this;
+}
+
+Graph& Graph::SetPosition(NodeHandle ID, const Point& Position)
+{
+    if (Node* Item = m_Nodes.Get(ID))
+    {
+        Item->Position = Position;
+    }
+
+    return *this;
+}
+
+Point Graph::GetPosition(NodeHandle ID) const
+{
+    const Node* Item { m_Nodes.Get(ID) };
+    return Item != nullptr ? Item->Position : Point {};
+}
+
+Graph& Graph::SetSize(NodeHandle ID, const Point& Size)
+{
+    if (Node* Item = m_Nodes.Get(ID))
+    {
+        Item->Size = Size;
+    }
+
+    return *this;
+}
+
+Point Graph::GetSize(NodeHandle ID) const
+{
+    const Node* Item { m_Nodes.Get(ID) };
+    return Item != nullptr ? Item->Size : Point {};
+}
+
+Graph& Graph::SetName(NodeHandle ID, const std::u32string& Name)
+{
+    if (Node* Item = m_Nodes.Get(ID))
+    {
+        Item->Name = Name;
+    }
+
+    return *this;
+}
+
+const std::u32string& Graph::GetName(NodeHandle ID) const
+{
+    const Node* Item { m_Nodes.Get(ID) };
+    return Item != nullptr ? Item->Name : EmptyName;
+}
+
+Graph& Graph::SetSource(NodeHandle ID, const std::string& Source)
+{
+    if (Node* Item = m_Nodes.Get(ID))
+    {
+        Item->Source = Source;
+        Item->SourceHash = Hash(Source);
+    }
+
+    return *this;
+}
+
+const std::string& Graph::GetSource(NodeHandle ID) const
+{
+    const Node* Item { m_Nodes.Get(ID) };
+    return Item != nullptr ? Item->Source : EmptySource;
+}
+
+uint64_t Graph::GetSourceHash(NodeHandle ID) const
+{
+    const Node* Item { m_Nodes.Get(ID) };
+    return Item != nullptr ? Item->SourceHash : 0;
+}
+
+PortHandle Graph::AddPort(NodeHandle ID, PortKind Kind, const std::string& Name)
+{
+    Node* Item { m_Nodes.Get(ID) };
+
+    if (Item == nullptr)
+    {
+        return {};
+    }
+
+    const PortHandle Result { m_Ports.Insert({ ID, Kind, Name, {} }) };
+    Item->Ports.push_back(Result);
+    return Result;
+}
+
+bool Graph::RemovePort(PortHandle ID)
+{
+    const Port* Item { m_Ports.Get(ID) };
+
+    if (Item == nullptr)
+    {
+        return false;
+    }
+
+    const std::vector<ConnectionHandle> Connections { Item->Connections };
+    for (ConnectionHandle Connection_ : Connections)
+    {
+        Disconnect(Connection_);
+    }
+
+    if (Node* Owner = m_Nodes.Get(Item->Owner))
+    {
+        Erase(Owner->Ports, ID);
+    }
+
+    return m_Ports.Remove(ID);
+}
+
+bool Graph::IsValid(PortHandle ID) const
+{
+    return m_Ports.Contains(ID);
+}
+
+const Graph::Port* Graph::GetPort(PortHandle ID) const
+{
+    return m_Ports.Get(ID);
+}
+
+const std::vector<PortHandle>& Graph::GetPorts(NodeHandle ID) const
+{
+    const Node* Item { m_Nodes.Get(ID) };
+    return Item != nullptr ? Item->Ports : EmptyPorts;
+}
+
+ConnectionHandle Graph::Connect(PortHandle From, PortHandle To)
+{
+    Port* Output { m_Ports.Get(From) };
+    Port* Input { m_Ports.Get(To) };
+
+    if (Output == nullptr || Input == nullptr)
+    {
+        return {};
+    }
+
+    if (Output->Kind != PortKind::Output || Input->Kind != PortKind::Input || Output->Owner == Input->Owner)
+    {
+        return {};
+    }
+
+    const ConnectionHandle Result { m_Connections.Insert({ From, To }) };
+    Output->Connections.push_back(Result);
+    Input->Connections.push_back(Result);
+    return Result;
+}
+
+bool Graph::Disconnect(ConnectionHandle ID)
+{
+    const Connection* Item { m_Connections.Get(ID) };
+
+    if (Item == nullptr)
+    {
+        return false;
+    }
+
+    if (Port* From = m_Ports.Get(Item->From))
+    {
+        Erase(From->Connections, ID);
+    }
+
+    if (Port* To = m_Ports.Get(Item->To))
+    {
+        Erase(To->Connections, ID);
+    }
+
+    return m_Connections.Remove(ID);
+}
+
+bool Graph::IsValid(ConnectionHandle ID) const
+{
+    return m_Connections.Contains(ID);
+}
+
+const Graph::Connection* Graph::GetConnection(ConnectionHandle ID) const
+{
+    return m_Connections.Get(ID);
+}
+
+const Graph::Node* Graph::GetNode(NodeHandle ID) const
+{
+    return m_Nodes.Get(ID);
+}
+
+size_t Graph::NodeCount() const
+{
+    return m_Nodes.Size();
+}
+
+size_t Graph::ConnectionCount() const
+{
+    return m_Connections.Size();
+}
+
+uint32_t Graph::NodeCapacity() const
+{
+    return m_Nodes.Capacity();
+}
+
+Graph& Graph::Reserve(size_t Nodes)
+{
+    m_Nodes.Reserve(Nodes);
+    m_IDs.reserve(Nodes);
+    return *this;
+}
+
+Graph& Graph::Clear()
+{
+    m_Nodes.Clear();
+    m_Ports.Clear();
+    m_Connections.Clear();
+    m_IDs.clear();
+    return *this;
+}
+
+}
+}
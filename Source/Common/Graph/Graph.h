@@ -0,0 +1,160 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "../Geometry.h"
+#include "NodeID.h"
+#include "SlotMap.h"
+
+#include <string>
+#include <unordered_map>
+
+namespace Snippet
+{
+namespace Common
+{
+
+struct NodeTag {};
+struct PortTag {};
+struct ConnectionTag {};
+
+using NodeHandle = Handle<NodeTag>;
+using PortHandle = Handle<PortTag>;
+using ConnectionHandle = Handle<ConnectionTag>;
+
+enum class PortKind : unsigned char
+{
+    Input,
+    Output,
+};
+
+//
+// GUI-free representation of a snippet graph. Nodes, ports and connections live in
+// contiguous slot maps and are referenced by generational handles, so the same model can
+// be loaded, evaluated and inspected by the server without creating any widgets. Every
+// node also carries a NodeID, indexed so a node can be found from its ID in constant time.
+//
+
+class Graph
+{
+public:
+    struct Node
+    {
+        NodeID ID { InvalidNodeID };
+        Point Position {};
+        Point Size {};
+        std::u32string Name {};
+        std::string Source {};
+        uint64_t SourceHash { 0 };
+        std::vector<PortHandle> Ports {};
+    };
+
+    struct Port
+    {
+        NodeHandle Owner {};
+        PortKind Kind { PortKind::Input };
+        std::string Name {};
+        std::vector<ConnectionHandle> Connections {};
+    };
+
+    struct Connection
+    {
+        PortHandle From {};
+        PortHandle To {};
+    };
+
+    Graph();
+
+    // Adds a node with the given ID, or a newly generated one if ID is invalid or already
+    // in use.
+    NodeHandle AddNode(NodeID ID = InvalidNodeID);
+    // Adds a node with the "In" input and "Out" output every new snippet starts with.
+    NodeHandle AddSnippet(NodeID ID = InvalidNodeID);
+    bool RemoveNode(NodeHandle ID);
+    bool IsValid(NodeHandle ID) const;
+
+    NodeHandle Find(NodeID ID) const;
+    NodeID GetID(NodeHandle ID) const;
+
+    // Generates new IDs under Site from now on, after every ID already in the graph.
+    Graph& SetSite(uint16_t Site);
+
+    Graph& SetPosition(NodeHandle ID, const Point& Position);
+    Point GetPosition(NodeHandle ID) const;
+
+    Graph& SetSize(NodeHandle ID, const Point& Size);
+    Point GetSize(NodeHandle ID) const;
+
+    Graph& SetName(NodeHandle ID, const std::u32string& Name);
+    const std::u32string& GetName(NodeHandle ID) const;
+
+    Graph& SetSource(NodeHandle ID, const std::string& Source);
+    const std::string& GetSource(NodeHandle ID) const;
+    uint64_t GetSourceHash(NodeHandle ID) const;
+
+    PortHandle AddPort(NodeHandle ID, PortKind Kind, const std::string& Name);
+    bool RemovePort(PortHandle ID);
+    bool IsValid(PortHandle ID) const;
+    const Port* GetPort(PortHandle ID) const;
+    const std::vector<PortHandle>& GetPorts(NodeHandle ID) const;
+
+    ConnectionHandle Connect(PortHandle From, PortHandle To);
+    bool Disconnect(ConnectionHandle ID);
+    bool IsValid(ConnectionHandle ID) const;
+    const Connection* GetConnection(ConnectionHandle ID) const;
+
+    const Node* GetNode(NodeHandle ID) const;
+
+    template<typename Fn>
+    void ForEachNode(Fn&& Callback) const
+    {
+        m_Nodes.ForEach(std::forward<Fn>(Callback));
+    }
+
+    template<typename Fn>
+    void ForEachConnection(Fn&& Callback) const
+    {
+        m_Connections.ForEach(std::forward<Fn>(Callback));
+    }
+
+    size_t NodeCount() const;
+    size_t ConnectionCount() const;
+    uint32_t NodeCapacity() const;
+
+    Graph& Reserve(size_t Nodes);
+    Graph& Clear();
+
+private:
+    SlotMap<Node, NodeTag> m_Nodes {};
+    SlotMap<Port, PortTag> m_Ports {};
+    SlotMap<Connection, ConnectionTag> m_Connections {};
+    std::unordered_map<NodeID, NodeHandle> m_IDs {};
+    NodeIDGenerator m_Generator {};
+};
+
+}
+}
@@ -0,0 +1,138 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "SlotMap.h"
+
+namespace Snippet
+{
+namespace Common
+{
+
+//
+// Set of slot map handles with constant time insertion, removal and membership tests.
+// Members are kept densely packed for iteration, and a sparse array indexed by slot
+// records where each one is, so no hashing or searching is involved. A slot holds one
+// member at a time: inserting a handle replaces a stale one from the same slot, and stale
+// handles are never reported as members.
+//
+
+template<typename Tag>
+class HandleSet
+{
+public:
+    using HandleType = Handle<Tag>;
+
+    bool Insert(HandleType ID)
+    {
+        if (!ID.IsValid() || Contains(ID))
+        {
+            return false;
+        }
+
+        if (ID.Index >= m_Sparse.size())
+        {
+            m_Sparse.resize(static_cast<size_t>(ID.Index) + 1, InvalidPosition);
+        }
+
+        const uint32_t Position { m_Sparse[ID.Index] };
+        if (Position < m_Dense.size() && m_Dense[Position].Index == ID.Index)
+        {
+            m_Dense[Position] = ID;
+            return true;
+        }
+
+        m_Sparse[ID.Index] = static_cast<uint32_t>(m_Dense.size());
+        m_Dense.push_back(ID);
+        return true;
+    }
+
+    bool Remove(HandleType ID)
+    {
+        if (!Contains(ID))
+        {
+            return false;
+        }
+
+        const uint32_t Position { m_Sparse[ID.Index] };
+        const HandleType Last { m_Dense.back() };
+        m_Dense[Position] = Last;
+        m_Sparse[Last.Index] = Position;
+        m_Dense.pop_back();
+        m_Sparse[ID.Index] = InvalidPosition;
+        return true;
+    }
+
+    bool Contains(HandleType ID) const
+    {
+        if (ID.Index >= m_Sparse.size())
+        {
+            return false;
+        }
+
+        const uint32_t Position { m_Sparse[ID.Index] };
+        return Position < m_Dense.size() && m_Dense[Position] == ID;
+    }
+
+    void Clear()
+    {
+        for (HandleType ID : m_Dense)
+        {
+            m_Sparse[ID.Index] = InvalidPosition;
+        }
+
+        m_Dense.clear();
+    }
+
+    size_t Size() const
+    {
+        return m_Dense.size();
+    }
+
+    bool Empty() const
+    {
+        return m_Dense.empty();
+    }
+
+    template<typename Fn>
+    void ForEach(Fn&& Callback) const
+    {
+        for (HandleType ID : m_Dense)
+        {
+            Callback(ID);
+        }
+    }
+
+private:
+    static constexpr uint32_t InvalidPosition { ~0u };
+
+    std::vector<HandleType> m_Dense {};
+    std::vector<uint32_t> m_Sparse {};
+};
+
+}
+}
@@ -0,0 +1,93 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+namespace Snippet
+{
+namespace Common
+{
+
+// Stable identity of a node. Unlike a handle, an ID survives saving, loading, journal
+// replay and being sent to the server, so it is what every layer uses to refer to a node.
+using NodeID = uint64_t;
+
+static constexpr NodeID InvalidNodeID { 0 };
+
+//
+// Hands out node IDs made of a 16-bit site prefix and a 48-bit counter. IDs from different
+// processes editing the same project only collide if their sites do, and IDs read back
+// from a file are observed so the counter never repeats one of this site's. The site is
+// random unless one is assigned, as a room does for each of its members.
+//
+
+class NodeIDGenerator
+{
+public:
+    static constexpr uint32_t SiteShift { 48 };
+    static constexpr NodeID CounterMask { (NodeID { 1 } << SiteShift) - 1 };
+
+    NodeIDGenerator()
+        : NodeIDGenerator(static_cast<uint16_t>(std::random_device {}()))
+    {
+    }
+
+    NodeIDGenerator(uint16_t Site)
+        : m_Site(Site)
+    {
+    }
+
+    NodeID Next()
+    {
+        m_Counter = m_Counter < CounterMask ? m_Counter + 1 : 1;
+        return (static_cast<NodeID>(m_Site) << SiteShift) | m_Counter;
+    }
+
+    NodeIDGenerator& Observe(NodeID ID)
+    {
+        if ((ID >> SiteShift) == m_Site && (ID & CounterMask) > m_Counter)
+        {
+            m_Counter = ID & CounterMask;
+        }
+
+        return *this;
+    }
+
+    uint16_t Site() const
+    {
+        return m_Site;
+    }
+
+private:
+    uint16_t m_Site { 0 };
+    NodeID m_Counter { 0 };
+};
+
+}
+}
@@ -0,0 +1,201 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Snippet
+{
+namespace Common
+{
+
+template<typename Tag>
+struct Handle
+{
+    static constexpr uint32_t InvalidIndex { ~0u };
+
+    uint32_t Index { InvalidIndex };
+    uint32_t Generation { 0 };
+
+    bool IsValid() const
+    {
+        return Index != InvalidIndex;
+    }
+
+    uint64_t Key() const
+    {
+        return (static_cast<uint64_t>(Generation) << 32) | Index;
+    }
+
+    bool operator==(const Handle& Other) const
+    {
+        return Index == Other.Index && Generation == Other.Generation;
+    }
+
+    bool operator!=(const Handle& Other) const
+    {
+        return !(*this == Other);
+    }
+};
+
+//
+// Contiguous storage addressed by generational handles. Removed slots are recycled and
+// their generation bumped so stale handles are rejected instead of aliasing a new value.
+//
+
+template<typename T, typename Tag>
+class SlotMap
+{
+public:
+    using HandleType = Handle<Tag>;
+
+    HandleType Insert(T&& Value)
+    {
+        uint32_t Index { HandleType::InvalidIndex };
+
+        if (!m_Free.empty())
+        {
+            Index = m_Free.back();
+            m_Free.pop_back();
+            m_Values[Index] = std::move(Value);
+        }
+        else
+        {
+            Index = static_cast<uint32_t>(m_Values.size());
+            m_Values.push_back(std::move(Value));
+            m_Generations.push_back(0);
+            m_Alive.push_back(0);
+        }
+
+        m_Alive[Index] = 1;
+        m_Count++;
+        return { Index, m_Generations[Index] };
+    }
+
+    bool Remove(HandleType ID)
+    {
+        if (!Contains(ID))
+        {
+            return false;
+        }
+
+        m_Values[ID.Index] = T {};
+        m_Alive[ID.Index] = 0;
+        m_Generations[ID.Index]++;
+        m_Free.push_back(ID.Index);
+        m_Count--;
+        return true;
+    }
+
+    bool Contains(HandleType ID) const
+    {
+        return ID.Index < m_Values.size() && m_Alive[ID.Index] != 0 && m_Generations[ID.Index] == ID.Generation;
+    }
+
+    T* Get(HandleType ID)
+    {
+        return Contains(ID) ? &m_Values[ID.Index] : nullptr;
+    }
+
+    const T* Get(HandleType ID) const
+    {
+        return Contains(ID) ? &m_Values[ID.Index] : nullptr;
+    }
+
+    HandleType At(uint32_t Index) const
+    {
+        if (Index >= m_Values.size() || m_Alive[Index] == 0)
+        {
+            return {};
+        }
+
+        return { Index, m_Generations[Index] };
+    }
+
+    template<typename Fn>
+    void ForEach(Fn&& Callback)
+    {
+        for (uint32_t Index = 0; Index < m_Values.size(); Index++)
+        {
+            if (m_Alive[Index] != 0)
+            {
+                Callback(HandleType { Index, m_Generations[Index] }, m_Values[Index]);
+            }
+        }
+    }
+
+    template<typename Fn>
+    void ForEach(Fn&& Callback) const
+    {
+        for (uint32_t Index = 0; Index < m_Values.size(); Index++)
+        {
+            if (m_Alive[Index] != 0)
+            {
+                Callback(HandleType { Index, m_Generations[Index] }, m_Values[Index]);
+            }
+        }
+    }
+
+    void Reserve(size_t Count)
+    {
+        m_Values.reserve(Count);
+        m_Generations.reserve(Count);
+        m_Alive.reserve(Count);
+    }
+
+    void Clear()
+    {
+        m_Values.clear();
+        m_Generations.clear();
+        m_Alive.clear();
+        m_Free.clear();
+        m_Count = 0;
+    }
+
+    size_t Size() const
+    {
+        return m_Count;
+    }
+
+    uint32_t Capacity() const
+    {
+        return static_cast<uint32_t>(m_Values.size());
+    }
+
+private:
+    std::vector<T> m_Values {};
+    std::vector<uint32_t> m_Generations {};
+    std::vector<uint8_t> m_Alive {};
+    std::vector<uint32_t> m_Free {};
+    size_t m_Count { 0 };
+};
+
+}
+}
@@ -0,0 +1,99 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace Snippet
+{
+namespace Common
+{
+
+//
+// 64-bit non-cryptographic content hash (MurmurHash64A). Used to detect changes to
+// snippet sources, inputs and outputs; it is not suitable for anything adversarial.
+//
+
+inline uint64_t Hash(const void* Data, size_t Size, uint64_t Seed = 0)
+{
+    constexpr uint64_t M { 0xc6a4a7935bd1e995ull };
+    constexpr int R { 47 };
+
+    const uint8_t* Bytes { static_cast<const uint8_t*>(Data) };
+    uint64_t Result { Seed ^ (Size * M) };
+
+    const size_t Blocks { Size / 8 };
+    for (size_t I = 0; I < Blocks; I++)
+    {
+        uint64_t K { 0 };
+        std::memcpy(&K, Bytes + I * 8, sizeof(K));
+
+        K *= M;
+        K ^= K >> R;
+        K *= M;
+
+        Result ^= K;
+        Result *= M;
+    }
+
+    const uint8_t* Tail { Bytes + Blocks * 8 };
+    switch (Size & 7)
+    {
+    case 7: Result ^= static_cast<uint64_t>(Tail[6]) << 48; [[fallthrough]];
+    case 6: Result ^= static_cast<uint64_t>(Tail[5]) << 40; [[fallthrough]];
+    case 5: Result ^= static_cast<uint64_t>(Tail[4]) << 32; [[fallthrough]];
+    case 4: Result ^= static_cast<uint64_t>(Tail[3]) << 24; [[fallthrough]];
+    case 3: Result ^= static_cast<uint64_t>(Tail[2]) << 16; [[fallthrough]];
+    case 2: Result ^= static_cast<uint64_t>(Tail[1]) << 8; [[fallthrough]];
+    case 1:
+        Result ^= static_cast<uint64_t>(Tail[0]);
+        Result *= M;
+        break;
+    default: break;
+    }
+
+    Result ^= Result >> R;
+    Result *= M;
+    Result ^= Result >> R;
+    return Result;
+}
+
+inline uint64_t Hash(std::string_view Value, uint64_t Seed = 0)
+{
+    return Hash(Value.data(), Value.size(), Seed);
+}
+
+inline uint64_t Combine(uint64_t Seed, uint64_t Value)
+{
+    return Seed ^ (Value + 0x9e3779b97f4a7c15ull + (Seed << 6) + (Seed >> 2));
+}
+
+}
+}
@@ -0,0 +1,787 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Protocol.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace Snippet
+{
+namespace Common
+{
+namespace Protocol
+{
+
+static uint16_t Load16(const uint8_t* Data)
+{
+    return static_cast<uint16_t>(Data[0] | (Data[1] << 8));
+}
+
+static uint32_t Load32(const uint8_t* Data)
+{
+    return static_cast<uint32_t>(Data[0])
+        | (static_cast<uint32_t>(Data[1]) << 8)
+        | (static_cast<uint32_t>(Data[2]) << 16)
+        | (static_cast<uint32_t>(Data[3]) << 24);
+}
+
+static uint64_t Load64(const uint8_t* Data)
+{
+    return static_cast<uint64_t>(Load32(Data)) | (static_cast<uint64_t>(Load32(Data + 4)) << 32);
+}
+
+static void Store32(uint8_t* Data, uint32_t Value)
+{
+    Data[0] = static_cast<uint8_t>(Value);
+    Data[1] = static_cast<uint8_t>(Value >> 8);
+    Data[2] = static_cast<uint8_t>(Value >> 16);
+    Data[3] = static_cast<uint8_t>(Value >> 24);
+}
+
+static constexpr size_t TruncatedMarkerSize { 40 };
+
+static std::string Truncate(std::string_view Value, size_t Limit)
+{
+    if (Value.size() <= Limit)
+    {
+        return std::string { Value };
+    }
+
+    std::string Result { Value.substr(0, Limit) };
+    Result += "\n[truncated " + std::to_string(Value.size() - Limit) + " bytes]";
+    return Result;
+}
+
+static uint64_t ZigZag(int64_t Value)
+{
+    return (static_cast<uint64_t>(Value) << 1) ^ static_cast<uint64_t>(Value >> 63);
+}
+
+static int64_t UnZigZag(uint64_t Value)
+{
+    return static_cast<int64_t>(Value >> 1) ^ -static_cast<int64_t>(Value & 1);
+}
+
+bool IsValidPosition(float Position)
+{
+    return std::isfinite(Position) && std::fabs(Position) <= MaxPosition;
+}
+
+int32_t Quantize(float Position)
+{
+    return static_cast<int32_t>(std::lround(Position * PositionScale));
+}
+
+float Dequantize(int32_t Position)
+{
+    return static_cast<float>(Position) / PositionScale;
+}
+
+//
+// PayloadReader
+//
+
+PayloadReader::PayloadReader(const MessageView& Message)
+    : m_Data(Message.Payload)
+    , m_Size(Message.Size)
+{
+}
+
+PayloadReader::PayloadReader(const uint8_t* Data, size_t Size)
+    : m_Data(Data)
+    , m_Size(Size)
+{
+}
+
+bool PayloadReader::U8(uint8_t& Value)
+{
+    const uint8_t* Data { nullptr };
+    if (!Bytes(Data, 1))
+    {
+        return false;
+    }
+
+    Value = Data[0];
+    return true;
+}
+
+bool PayloadReader::U16(uint16_t& Value)
+{
+    const uint8_t* Data { nullptr };
+    if (!Bytes(Data, 2))
+    {
+        return false;
+    }
+
+    Value = Load16(Data);
+    return true;
+}
+
+bool PayloadReader::U32(uint32_t& Value)
+{
+    const uint8_t* Data { nullptr };
+    if (!Bytes(Data, 4))
+    {
+        return false;
+    }
+
+    Value = Load32(Data);
+    return true;
+}
+
+bool PayloadReader::U64(uint64_t& Value)
+{
+    const uint8_t* Data { nullptr };
+    if (!Bytes(Data, 8))
+    {
+        return false;
+    }
+
+    Value = Load64(Data);
+    return true;
+}
+
+bool PayloadReader::F32(float& Value)
+{
+    uint32_t Bits { 0 };
+    if (!U32(Bits))
+    {
+        return false;
+    }
+
+    std::memcpy(&Value, &Bits, sizeof(Value));
+    return true;
+}
+
+bool PayloadReader::F64(double& Value)
+{
+    uint64_t Bits { 0 };
+    if (!U64(Bits))
+    {
+        return false;
+    }
+
+    std::memcpy(&Value, &Bits, sizeof(Value));
+    return true;
+}
+
+bool PayloadReader::VarU64(uint64_t& Value)
+{
+    Value = 0;
+
+    for (unsigned int Shift = 0; Shift < 64; Shift += 7)
+    {
+        uint8_t Byte { 0 };
+        if (!U8(Byte))
+        {
+            return false;
+        }
+
+        Value |= static_cast<uint64_t>(Byte & 0x7F) << Shift;
+
+        if ((Byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+
+    m_Valid = false;
+    return false;
+}
+
+bool PayloadReader::String(std::string_view& Value)
+{
+    uint32_t Length { 0 };
+    const uint8_t* Data { nullptr };
+
+    if (!U32(Length) || !Bytes(Data, Length))
+    {
+        return false;
+    }
+
+    Value = std::string_view { reinterpret_cast<const char*>(Data), Length };
+    return true;
+}
+
+bool PayloadReader::Bytes(const uint8_t*& Data, size_t Size)
+{
+    if (!m_Valid || Size > m_Size - m_Offset)
+    {
+        m_Valid = false;
+        return false;
+    }
+
+    Data = m_Data + m_Offset;
+    m_Offset += Size;
+    return true;
+}
+
+size_t PayloadReader::Remaining() const
+{
+    return m_Size - m_Offset;
+}
+
+bool PayloadReader::IsValid() const
+{
+    return m_Valid;
+}
+
+//
+// MessageReader
+//
+
+MessageReader::MessageReader(const uint8_t* Data, size_t Size)
+    : m_Data(Data)
+    , m_Size(Size)
+{
+}
+
+ParseStatus MessageReader::Next(MessageView& Message)
+{
+    const size_t Available { m_Size - m_Offset };
+
+    if (Available < HeaderSize)
+    {
+        return ParseStatus::NeedMore;
+    }
+
+    const uint8_t* Header { m_Data + m_Offset };
+    const uint32_t Length { Load32(Header + 4) };
+
+    if (Load16(Header) != Magic || Header[2] != Version || Length > MaxPayload)
+    {
+        return ParseStatus::Invalid;
+    }
+
+    if (Available - HeaderSize < Length)
+    {
+        return ParseStatus::NeedMore;
+    }
+
+    Message.Type = static_cast<MessageType>(Header[3]);
+    Message.Sequence = Load32(Header + 8);
+    Message.Payload = Header + HeaderSize;
+    Message.Size = Length;
+
+    m_Offset += HeaderSize + Length;
+    return ParseStatus::Ok;
+}
+
+size_t MessageReader::Consumed() const
+{
+    return m_Offset;
+}
+
+//
+// MessageWriter
+//
+
+MessageWriter& MessageWriter::Begin(MessageType Type, uint32_t Sequence)
+{
+    if (m_Open)
+    {
+        End();
+    }
+
+    m_Start = m_Buffer.size();
+    m_Open = true;
+
+    uint8_t* Header { Grow(HeaderSize) };
+    Header[0] = static_cast<uint8_t>(Magic);
+    Header[1] = static_cast<uint8_t>(Magic >> 8);
+    Header[2] = Version;
+    Header[3] = static_cast<uint8_t>(Type);
+    Store32(Header + 4, 0);
+    Store32(Header + 8, Sequence);
+    return *this;
+}
+
+MessageWriter& MessageWriter::End()
+{
+    if (m_Open)
+    {
+        const size_t Length { m_Buffer.size() - m_Start - HeaderSize };
+        m_Open = false;
+
+        if (Length > MaxPayload)
+        {
+            // The peer drops any connection that frames more than MaxPayload, so the message
+            // is replaced with an error carrying the same sequence.
+            const uint32_t Sequence { Load32(m_Buffer.data() + m_Start + 8) };
+            m_Buffer.resize(m_Start);
+            return Begin(MessageType::Error, Sequence)
+                .String("Message of " + std::to_string(Length) + " bytes exceeds the maximum payload.")
+                .End();
+        }
+
+        Store32(m_Buffer.data() + m_Start + 4, static_cast<uint32_t>(Length));
+    }
+
+    return *this;
+}
+
+MessageWriter& MessageWriter::U8(uint8_t Value)
+{
+    m_Buffer.push_back(Value);
+    return *this;
+}
+
+MessageWriter& MessageWriter::U16(uint16_t Value)
+{
+    uint8_t* Data { Grow(2) };
+    Data[0] = static_cast<uint8_t>(Value);
+    Data[1] = static_cast<uint8_t>(Value >> 8);
+    return *this;
+}
+
+MessageWriter& MessageWriter::U32(uint32_t Value)
+{
+    Store32(Grow(4), Value);
+    return *this;
+}
+
+MessageWriter& MessageWriter::U64(uint64_t Value)
+{
+    uint8_t* Data { Grow(8) };
+    Store32(Data, static_cast<uint32_t>(Value));
+    Store32(Data + 4, static_cast<uint32_t>(Value >> 32));
+    return *this;
+}
+
+MessageWriter& MessageWriter::F32(float Value)
+{
+    uint32_t Bits { 0 };
+    std::memcpy(&Bits, &Value, sizeof(Value));
+    return U32(Bits);
+}
+
+MessageWriter& MessageWriter::F64(double Value)
+{
+    uint64_t Bits { 0 };
+    std::memcpy(&Bits, &Value, sizeof(Value));
+    return U64(Bits);
+}
+
+MessageWriter& MessageWriter::VarU64(uint64_t Value)
+{
+    while (Value >= 0x80)
+    {
+        U8(static_cast<uint8_t>(Value) | 0x80);
+        Value >>= 7;
+    }
+
+    return U8(static_cast<uint8_t>(Value));
+}
+
+MessageWriter& MessageWriter::String(std::string_view Value)
+{
+    U32(static_cast<uint32_t>(Value.size()));
+    return Bytes(Value.data(), Value.size());
+}
+
+MessageWriter& MessageWriter::Bytes(const void* Data, size_t Size)
+{
+    if (Size > 0)
+    {
+        std::memcpy(Grow(Size), Data, Size);
+    }
+
+    return *this;
+}
+
+MessageWriter& MessageWriter::Append(const uint8_t* Frames, size_t Size)
+{
+    if (Size > 0)
+    {
+        std::memcpy(Grow(Size), Frames, Size);
+    }
+
+    return *this;
+}
+
+MessageWriter& MessageWriter::Write(MessageType Type, uint32_t Sequence)
+{
+    return Begin(Type, Sequence).End();
+}
+
+MessageWriter& MessageWriter::Write(const GraphEdit& Edit, uint32_t Sequence)
+{
+    return Begin(MessageType::GraphEdit, Sequence)
+        .U8(static_cast<uint8_t>(Edit.Kind))
+        .U64(Edit.Node)
+        .U64(Edit.Target)
+        .F32(Edit.X)
+        .F32(Edit.Y)
+        .String(Edit.Text)
+        .End();
+}
+
+MessageWriter& MessageWriter::Write(const SnippetSource& Source, uint32_t Sequence)
+{
+    return Begin(MessageType::SnippetSource, Sequence)
+        .U64(Source.Node)
+        .U64(Source.Hash)
+        .String(Source.Source)
+        .End();
+}
+
+MessageWriter& MessageWriter::Write(const ExecutionResult& Result, uint32_t Sequence)
+{
+    // Output and Log are cut down to what fits in one message, with a marker noting how much
+    // was dropped, rather than losing the whole result to the payload limit. Output keeps at
+    // least half of the space.
+    const size_t Available { MaxPayload - (8 + 1 + 8 + 4 + 4) - TruncatedMarkerSize * 2 };
+    if (Result.Output.size() + Result.Log.size() > Available)
+    {
+        const size_t OutputLimit { std::min(Result.Output.size(), std::max(Available / 2, Available - std::min(Result.Log.size(), Available))) };
+        return Begin(MessageType::ExecutionResult, Sequence)
+            .U64(Result.Node)
+            .U8(static_cast<uint8_t>(Result.Status))
+            .F64(Result.Seconds)
+            .String(Truncate(Result.Output, OutputLimit))
+            .String(Truncate(Result.Log, Available - OutputLimit))
+            .End();
+    }
+
+    return Begin(MessageType::ExecutionResult, Sequence)
+        .U64(Result.Node)
+        .U8(static_cast<uint8_t>(Result.Status))
+        .F64(Result.Seconds)
+        .String(Result.Output)
+        .String(Result.Log)
+        .End();
+}
+
+MessageWriter& MessageWriter::Write(const ExecutionSummary& Summary, uint32_t Sequence)
+{
+    Begin(MessageType::ExecutionSummary, Sequence)
+        .U32(Summary.Nodes)
+        .U32(Summary.Failed)
+        .U32(Summary.Skipped)
+        .U32(Summary.Reused)
+        .F64(Summary.Seconds)
+        .F64(Summary.CriticalPathSeconds)
+        .U32(static_cast<uint32_t>(Summary.CriticalPath.size()));
+
+    for (NodeID Node : Summary.CriticalPath)
+    {
+        U64(Node);
+    }
+
+    return End();
+}
+
+MessageWriter& MessageWriter::Write(const Joined& Reply, uint32_t Sequence)
+{
+    return Begin(MessageType::Joined, Sequence)
+        .U32(Reply.Member)
+        .U32(Reply.Members)
+        .U16(Reply.Site)
+        .U8(Reply.Fresh ? 1 : 0)
+        .End();
+}
+
+MessageWriter& MessageWriter::Write(const TextEdit& Edit, uint32_t Sequence)
+{
+    return Begin(MessageType::TextEdit, Sequence)
+        .U64(Edit.Node)
+        .U32(Edit.Revision)
+        .U32(Edit.Offset)
+        .U32(Edit.Removed)
+        .String(Edit.Inserted)
+        .End();
+}
+
+MessageWriter& MessageWriter::Write(const MoveBatch& Batch, uint32_t Sequence)
+{
+    Begin(MessageType::MoveBatch, Sequence)
+        .VarU64(Batch.Groups.size());
+
+    for (const MoveBatch::Group& Item : Batch.Groups)
+    {
+        VarU64(Item.Member)
+            .VarU64(Item.Sequence)
+            .VarU64(Item.Moves.size());
+
+        // Each move is the node's ID delta and then its offset, or a zero tag when the
+        // offset is the same as the previous move's, as it is for every node of a group
+        // being dragged together.
+        NodeID Previous { 0 };
+        int64_t X { 0 };
+        int64_t Y { 0 };
+
+        for (const MoveBatch::Move& Move : Item.Moves)
+        {
+            VarU64(Move.Node - Previous);
+            Previous = Move.Node;
+
+            if (Move.X == X && Move.Y == Y)
+            {
+                U8(0);
+                continue;
+            }
+
+            VarU64(ZigZag(Move.X) + 1).VarU64(ZigZag(Move.Y));
+            X = Move.X;
+            Y = Move.Y;
+        }
+    }
+
+    return End();
+}
+
+uint8_t* MessageWriter::Grow(size_t Size)
+{
+    const size_t Offset { m_Buffer.size() };
+    m_Buffer.resize(Offset + Size);
+    return m_Buffer.data() + Offset;
+}
+
+const std::vector<uint8_t>& MessageWriter::Buffer() const
+{
+    return m_Buffer;
+}
+
+std::vector<uint8_t>& MessageWriter::Buffer()
+{
+    return m_Buffer;
+}
+
+size_t MessageWriter::Size() const
+{
+    return m_Buffer.size();
+}
+
+bool MessageWriter::Empty() const
+{
+    return m_Buffer.empty();
+}
+
+MessageWriter& MessageWriter::Clear()
+{
+    m_Buffer.clear();
+    m_Start = 0;
+    m_Open = false;
+    return *this;
+}
+
+//
+// Decoding
+//
+
+bool Decode(const MessageView& Message, GraphEdit& Edit)
+{
+    if (Message.Type != MessageType::GraphEdit)
+    {
+        return false;
+    }
+
+    PayloadReader Reader { Message };
+    uint8_t Kind { 0 };
+
+    Reader.U8(Kind);
+    Reader.U64(Edit.Node);
+    Reader.U64(Edit.Target);
+    Reader.F32(Edit.X);
+    Reader.F32(Edit.Y);
+    Reader.String(Edit.Text);
+
+    Edit.Kind = static_cast<EditKind>(Kind);
+    return Reader.IsValid() && Kind <= static_cast<uint8_t>(EditKind::Disconnect);
+}
+
+bool Decode(const MessageView& Message, SnippetSource& Source)
+{
+    if (Message.Type != MessageType::SnippetSource)
+    {
+        return false;
+    }
+
+    PayloadReader Reader { Message };
+    Reader.U64(Source.Node);
+    Reader.U64(Source.Hash);
+    Reader.String(Source.Source);
+    return Reader.IsValid();
+}
+
+bool Decode(const MessageView& Message, ExecutionResult& Result)
+{
+    if (Message.Type != MessageType::ExecutionResult)
+    {
+        return false;
+    }
+
+    PayloadReader Reader { Message };
+    uint8_t Status { 0 };
+
+    Reader.U64(Result.Node);
+    Reader.U8(Status);
+    Reader.F64(Result.Seconds);
+    Reader.String(Result.Output);
+    Reader.String(Result.Log);
+
+    Result.Status = static_cast<ResultStatus>(Status);
+    return Reader.IsValid() && Status <= static_cast<uint8_t>(ResultStatus::Running);
+}
+
+bool Decode(const MessageView& Message, ExecutionSummary& Summary)
+{
+    if (Message.Type != MessageType::ExecutionSummary)
+    {
+        return false;
+    }
+
+    PayloadReader Reader { Message };
+    uint32_t Count { 0 };
+
+    Reader.U32(Summary.Nodes);
+    Reader.U32(Summary.Failed);
+    Reader.U32(Summary.Skipped);
+    Reader.U32(Summary.Reused);
+    Reader.F64(Summary.Seconds);
+    Reader.F64(Summary.CriticalPathSeconds);
+    Reader.U32(Count);
+
+    if (!Reader.IsValid() || Count > Reader.Remaining() / sizeof(uint64_t))
+    {
+        return false;
+    }
+
+    Summary.CriticalPath.resize(Count);
+    for (NodeID& Node : Summary.CriticalPath)
+    {
+        Reader.U64(Node);
+    }
+
+    return Reader.IsValid();
+}
+
+bool Decode(const MessageView& Message, Joined& Reply)
+{
+    if (Message.Type != MessageType::Joined)
+    {
+        return false;
+    }
+
+    PayloadReader Reader { Message };
+    uint8_t Fresh { 0 };
+
+    Reader.U32(Reply.Member);
+    Reader.U32(Reply.Members);
+    Reader.U16(Reply.Site);
+    Reader.U8(Fresh);
+
+    Reply.Fresh = Fresh != 0;
+    return Reader.IsValid();
+}
+
+bool Decode(const MessageView& Message, TextEdit& Edit)
+{
+    if (Message.Type != MessageType::TextEdit)
+    {
+        return false;
+    }
+
+    PayloadReader Reader { Message };
+    Reader.U64(Edit.Node);
+    Reader.U32(Edit.Revision);
+    Reader.U32(Edit.Offset);
+    Reader.U32(Edit.Removed);
+    Reader.String(Edit.Inserted);
+    return Reader.IsValid();
+}
+
+bool Decode(const MessageView& Message, MoveBatch& Batch)
+{
+    if (Message.Type != MessageType::MoveBatch)
+    {
+        return false;
+    }
+
+    PayloadReader Reader { Message };
+    uint64_t Groups { 0 };
+
+    // Every group takes at least three bytes and every move two, which bounds the counts
+    // before anything is allocated for them.
+    if (!Reader.VarU64(Groups) || Groups > Reader.Remaining() / 3)
+    {
+        return false;
+    }
+
+    Batch.Groups.resize(Groups);
+    for (MoveBatch::Group& Item : Batch.Groups)
+    {
+        uint64_t Member { 0 };
+        uint64_t Sequence { 0 };
+        uint64_t Count { 0 };
+
+        if (!Reader.VarU64(Member) || !Reader.VarU64(Sequence) || !Reader.VarU64(Count) || Count > Reader.Remaining() / 2)
+        {
+            return false;
+        }
+
+        Item.Member = static_cast<uint32_t>(Member);
+        Item.Sequence = static_cast<uint32_t>(Sequence);
+        Item.Moves.resize(Count);
+
+        NodeID Previous { 0 };
+        int64_t X { 0 };
+        int64_t Y { 0 };
+
+        for (MoveBatch::Move& Move : Item.Moves)
+        {
+            uint64_t Delta { 0 };
+            uint64_t Tag { 0 };
+
+            if (!Reader.VarU64(Delta) || !Reader.VarU64(Tag))
+            {
+                return false;
+            }
+
+            if (Tag != 0)
+            {
+                uint64_t Value { 0 };
+                Reader.VarU64(Value);
+                X = UnZigZag(Tag - 1);
+                Y = UnZigZag(Value);
+            }
+
+            Previous += Delta;
+            Move.Node = Previous;
+            Move.X = X;
+            Move.Y = Y;
+        }
+    }
+
+    return Reader.IsValid();
+}
+
+}
+}
+}
@@ -0,0 +1,331 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "../Graph/NodeID.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Snippet
+{
+namespace Common
+{
+
+//
+// Every message on the wire is a fixed 12 byte little-endian header followed by Length
+// bytes of payload:
+//
+//     uint16 Magic | uint8 Version | uint8 Type | uint32 Length | uint32 Sequence
+//
+// Readers never copy payloads. A MessageView and every string read from it point
+// directly into the caller's receive buffer and are only valid until that buffer changes.
+//
+
+namespace Protocol
+{
+
+static constexpr uint16_t Magic { 0x4E53 };
+static constexpr uint8_t Version { 5 };
+static constexpr size_t HeaderSize { 12 };
+static constexpr uint32_t MaxPayload { 64u * 1024u * 1024u };
+
+enum class MessageType : uint8_t
+{
+    Invalid,
+    Heartbeat,
+    HeartbeatAck,
+    GraphEdit,
+    SnippetSource,
+    ExecutionResult,
+    Error,
+    Execute,
+    ExecutionSummary,
+    // Asks to move the connection onto a SharedChannel. Both the request and the reply
+    // carry a uint32 ring capacity; a reply of zero declines. An accepting reply is sent
+    // with the channel's handles attached and is the last message on the socket.
+    SharedMemory,
+    // Carries the name of a room to share the session's graph with, or an empty name to
+    // leave one. Answered with Joined.
+    Join,
+    Joined,
+    TextEdit,
+    MoveBatch,
+};
+
+enum class ParseStatus : uint8_t
+{
+    Ok,
+    NeedMore,
+    Invalid,
+};
+
+struct MessageView
+{
+    MessageType Type { MessageType::Invalid };
+    uint32_t Sequence { 0 };
+    const uint8_t* Payload { nullptr };
+    uint32_t Size { 0 };
+};
+
+//
+// Payloads
+//
+
+enum class EditKind : uint8_t
+{
+    CreateNode,
+    DeleteNode,
+    MoveNode,
+    RenameNode,
+    Connect,
+    Disconnect,
+};
+
+struct GraphEdit
+{
+    EditKind Kind { EditKind::CreateNode };
+    NodeID Node { InvalidNodeID };
+    NodeID Target { InvalidNodeID };
+    float X { 0.0f };
+    float Y { 0.0f };
+    std::string_view Text {};
+};
+
+struct SnippetSource
+{
+    NodeID Node { InvalidNodeID };
+    uint64_t Hash { 0 };
+    std::string_view Source {};
+};
+
+enum class ResultStatus : uint8_t
+{
+    Success,
+    Failed,
+    Cancelled,
+    // The node has started running. Its final result follows in a later message.
+    Running,
+};
+
+// Streamed while a run is in progress, as each node starts and finishes. Nodes whose
+// previous output was reused are not reported again. Output holds the error message
+// when Status is Failed or Cancelled.
+struct ExecutionResult
+{
+    NodeID Node { InvalidNodeID };
+    ResultStatus Status { ResultStatus::Success };
+    double Seconds { 0.0 };
+    std::string_view Output {};
+    std::string_view Log {};
+};
+
+// Sent once every ExecutionResult of a run has been written. Unlike the other payloads
+// the critical path is decoded into its own storage.
+struct ExecutionSummary
+{
+    uint32_t Nodes { 0 };
+    uint32_t Failed { 0 };
+    uint32_t Skipped { 0 };
+    uint32_t Reused { 0 };
+    double Seconds { 0.0 };
+    double CriticalPathSeconds { 0.0 };
+    std::vector<NodeID> CriticalPath {};
+};
+
+// Sent in reply to Join. A room that was Fresh had no nodes, and the member is expected to
+// fill it with its own graph. Otherwise the room's graph follows as GraphEdit and
+// TextEdit messages, which replace whatever the member had.
+// Site is the prefix the member is to generate node IDs under. No two members of a room
+// are given the same one.
+struct Joined
+{
+    uint32_t Member { 0 };
+    uint32_t Members { 0 };
+    uint16_t Site { 0 };
+    bool Fresh { false };
+};
+
+// A splice of a node's source, made against Revision. The server transforms it against
+// the edits it has ordered since, applies it and relays it to the room with Revision set
+// to the revision it produced. The member that made it only gets an empty edit back, with
+// the sequence of its request and the new revision.
+struct TextEdit
+{
+    NodeID Node { InvalidNodeID };
+    uint32_t Revision { 0 };
+    uint32_t Offset { 0 };
+    uint32_t Removed { 0 };
+    std::string_view Inserted {};
+};
+
+// Node positions are sent in fixed point, in sixteenths of a unit. Only positions for
+// which IsValidPosition holds can be quantized, and edits carrying any other are rejected.
+static constexpr float PositionScale { 16.0f };
+static constexpr float MaxPosition { 1.0e8f };
+
+bool IsValidPosition(float Position);
+int32_t Quantize(float Position);
+float Dequantize(int32_t Position);
+
+// Node moves made in a room over a short interval, as quantized offsets from each node's
+// previous position in the room. Moves are grouped by the member that made them, and each
+// group carries the sequence of the member's last move in the interval, even if a later
+// move by someone else replaced all of its own. On the wire every field is a varint and
+// node IDs are deltas from the previous move's, so a group drag of nearby nodes costs a
+// couple of bytes per node. Offsets are wider than positions, since one can span the
+// whole range from one end to the other. Decoded into its own storage.
+struct MoveBatch
+{
+    struct Move
+    {
+        NodeID Node { InvalidNodeID };
+        int64_t X { 0 };
+        int64_t Y { 0 };
+    };
+
+    struct Group
+    {
+        uint32_t Member { 0 };
+        uint32_t Sequence { 0 };
+        std::vector<Move> Moves {};
+    };
+
+    std::vector<Group> Groups {};
+};
+
+//
+// PayloadReader
+//
+
+class PayloadReader
+{
+public:
+    PayloadReader(const MessageView& Message);
+    PayloadReader(const uint8_t* Data, size_t Size);
+
+    bool U8(uint8_t& Value);
+    bool U16(uint16_t& Value);
+    bool U32(uint32_t& Value);
+    bool U64(uint64_t& Value);
+    bool F32(float& Value);
+    bool F64(double& Value);
+    bool VarU64(uint64_t& Value);
+    bool String(std::string_view& Value);
+    bool Bytes(const uint8_t*& Data, size_t Size);
+
+    size_t Remaining() const;
+    bool IsValid() const;
+
+private:
+    const uint8_t* m_Data { nullptr };
+    size_t m_Size { 0 };
+    size_t m_Offset { 0 };
+    bool m_Valid { true };
+};
+
+//
+// MessageReader
+//
+
+class MessageReader
+{
+public:
+    MessageReader(const uint8_t* Data, size_t Size);
+
+    ParseStatus Next(MessageView& Message);
+    size_t Consumed() const;
+
+private:
+    const uint8_t* m_Data { nullptr };
+    size_t m_Size { 0 };
+    size_t m_Offset { 0 };
+};
+
+//
+// MessageWriter
+//
+// Appends any number of framed messages to one buffer so that a batch of small messages
+// can be handed to the socket with a single write.
+//
+
+class MessageWriter
+{
+public:
+    MessageWriter& Begin(MessageType Type, uint32_t Sequence);
+    MessageWriter& End();
+
+    MessageWriter& U8(uint8_t Value);
+    MessageWriter& U16(uint16_t Value);
+    MessageWriter& U32(uint32_t Value);
+    MessageWriter& U64(uint64_t Value);
+    MessageWriter& F32(float Value);
+    MessageWriter& F64(double Value);
+    MessageWriter& VarU64(uint64_t Value);
+    MessageWriter& String(std::string_view Value);
+    MessageWriter& Bytes(const void* Data, size_t Size);
+
+    // Copies messages already framed by another writer.
+    MessageWriter& Append(const uint8_t* Frames, size_t Size);
+
+    MessageWriter& Write(MessageType Type, uint32_t Sequence);
+    MessageWriter& Write(const GraphEdit& Edit, uint32_t Sequence = 0);
+    MessageWriter& Write(const SnippetSource& Source, uint32_t Sequence = 0);
+    MessageWriter& Write(const ExecutionResult& Result, uint32_t Sequence = 0);
+    MessageWriter& Write(const ExecutionSummary& Summary, uint32_t Sequence = 0);
+    MessageWriter& Write(const Joined& Reply, uint32_t Sequence = 0);
+    MessageWriter& Write(const TextEdit& Edit, uint32_t Sequence = 0);
+    MessageWriter& Write(const MoveBatch& Batch, uint32_t Sequence = 0);
+
+    const std::vector<uint8_t>& Buffer() const;
+    std::vector<uint8_t>& Buffer();
+    size_t Size() const;
+    bool Empty() const;
+    MessageWriter& Clear();
+
+private:
+    uint8_t* Grow(size_t Size);
+
+    std::vector<uint8_t> m_Buffer {};
+    size_t m_Start { 0 };
+    bool m_Open { false };
+};
+
+bool Decode(const MessageView& Message, GraphEdit& Edit);
+bool Decode(const MessageView& Message, SnippetSource& Source);
+bool Decode(const MessageView& Message, ExecutionResult& Result);
+bool Decode(const MessageView& Message, ExecutionSummary& Summary);
+bool Decode(const MessageView& Message, Joined& Reply);
+bool Decode(const MessageView& Message, TextEdit& Edit);
+bool Decode(const MessageView& Message, MoveBatch& Batch);
+
+}
+}
+}
@@ -0,0 +1,405 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Reactor.h"
+
+#if defined(__linux__)
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <unistd.h>
+#elif defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <winsock2.h>
+#else
+    #include <poll.h>
+#endif
+
+namespace Snippet
+{
+namespace Common
+{
+
+#if defined(__linux__)
+static constexpr uint64_t WakeKey { ~0ull };
+static constexpr int MaxEvents { 256 };
+
+static uint32_t ToNative(uint32_t Events)
+{
+    uint32_t Result { 0 };
+
+    if ((Events & Reactor::Readable) != 0)
+    {
+        Result |= EPOLLIN;
+    }
+
+    if ((Events & Reactor::Writable) != 0)
+    {
+        Result |= EPOLLOUT;
+    }
+
+    return Result | EPOLLRDHUP;
+}
+
+static uint32_t FromNative(uint32_t Events)
+{
+    uint32_t Result { 0 };
+
+    if ((Events & EPOLLIN) != 0)
+    {
+        Result |= Reactor::Readable;
+    }
+
+    if ((Events & EPOLLOUT) != 0)
+    {
+        Result |= Reactor::Writable;
+    }
+
+    if ((Events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) != 0)
+    {
+        Result |= Reactor::Hangup;
+    }
+
+    return Result;
+}
+
+static uint64_t ToKey(NativeSocket Handle, uint32_t Generation)
+{
+    return (static_cast<uint64_t>(Generation) << 32) | static_cast<uint32_t>(Handle);
+}
+#else
+    #if defined(_WIN32)
+        #define poll WSAPoll
+    #endif
+
+static short ToNative(uint32_t Events)
+{
+    short Result { 0 };
+
+    if ((Events & Reactor::Readable) != 0)
+    {
+        Result |= POLLIN;
+    }
+
+    if ((Events & Reactor::Writable) != 0)
+    {
+        Result |= POLLOUT;
+    }
+
+    return Result;
+}
+
+static uint32_t FromNative(short Events)
+{
+    uint32_t Result { 0 };
+
+    if ((Events & POLLIN) != 0)
+    {
+        Result |= Reactor::Readable;
+    }
+
+    if ((Events & POLLOUT) != 0)
+    {
+        Result |= Reactor::Writable;
+    }
+
+    if ((Events & (POLLHUP | POLLERR | POLLNVAL)) != 0)
+    {
+        Result |= Reactor::Hangup;
+    }
+
+    return Result;
+}
+#endif
+
+Reactor::Reactor()
+{
+#if defined(__linux__)
+    m_Poll = epoll_create1(EPOLL_CLOEXEC);
+    m_WakeEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (m_Poll >= 0 && m_WakeEvent >= 0)
+    {
+        epoll_event Event {};
+        Event.events = EPOLLIN;
+        Event.data.u64 = WakeKey;
+        epoll_ctl(m_Poll, EPOLL_CTL_ADD, m_WakeEvent, &Event);
+    }
+#else
+    if (Socket::Pair(m_WakeRead, m_WakeWrite))
+    {
+        m_WakeRead.SetNonBlocking(true);
+        m_WakeWrite.SetNonBlocking(true);
+    }
+#endif
+}
+
+Reactor::~Reactor()
+{
+#if defined(__linux__)
+    if (m_WakeEvent >= 0)
+    {
+        close(m_WakeEvent);
+    }
+
+    if (m_Poll >= 0)
+    {
+        close(m_Poll);
+    }
+#endif
+}
+
+bool Reactor::IsValid() const
+{
+#if defined(__linux__)
+    return m_Poll >= 0 && m_WakeEvent >= 0;
+#else
+    return m_WakeRead.IsValid() && m_WakeWrite.IsValid();
+#endif
+}
+
+bool Reactor::Add(NativeSocket Handle, uint32_t Events, OnEventSignature&& Fn)
+{
+    if (m_Entries.find(Handle) != m_Entries.end())
+    {
+        return false;
+    }
+
+    Entry Item {};
+    Item.Generation = ++m_Generation;
+    Item.Events = Events;
+    Item.Callback = std::make_shared<OnEventSignature>(std::move(Fn));
+
+#if defined(__linux__)
+    epoll_event Event {};
+    Event.events = ToNative(Events);
+    Event.data.u64 = ToKey(Handle, Item.Generation);
+
+    if (epoll_ctl(m_Poll, EPOLL_CTL_ADD, Handle, &Event) != 0)
+    {
+        return false;
+    }
+#endif
+
+    m_Entries.emplace(Handle, std::move(Item));
+    return true;
+}
+
+bool Reactor::Modify(NativeSocket Handle, uint32_t Events)
+{
+    const std::unordered_map<NativeSocket, Entry>::iterator It { m_Entries.find(Handle) };
+
+    if (It == m_Entries.end())
+    {
+        return false;
+    }
+
+    if (It->second.Events == Events)
+    {
+        return true;
+    }
+
+    It->second.Events = Events;
+
+#if defined(__linux__)
+    epoll_event Event {};
+    Event.events = ToNative(Events);
+    Event.data.u64 = ToKey(Handle, It->second.Generation);
+    return epoll_ctl(m_Poll, EPOLL_CTL_MOD, Handle, &Event) == 0;
+#else
+    return true;
+#endif
+}
+
+bool Reactor::Remove(NativeSocket Handle)
+{
+    const std::unordered_map<NativeSocket, Entry>::iterator It { m_Entries.find(Handle) };
+
+    if (It == m_Entries.end())
+    {
+        return false;
+    }
+
+    m_Entries.erase(It);
+
+#if defined(__linux__)
+    epoll_ctl(m_Poll, EPOLL_CTL_DEL, Handle, nullptr);
+#endif
+
+    return true;
+}
+
+int Reactor::Poll(int TimeoutMS)
+{
+    int Dispatched { 0 };
+
+#if defined(__linux__)
+    epoll_event Events[MaxEvents];
+    const int Count { epoll_wait(m_Poll, Events, MaxEvents, TimeoutMS) };
+
+    for (int I = 0; I < Count; I++)
+    {
+        if (Events[I].data.u64 == WakeKey)
+        {
+            DrainWake();
+            continue;
+        }
+
+        const NativeSocket Handle { static_cast<NativeSocket>(Events[I].data.u64 & 0xFFFFFFFF) };
+        const uint32_t Generation { static_cast<uint32_t>(Events[I].data.u64 >> 32) };
+        const std::unordered_map<NativeSocket, Entry>::const_iterator It { m_Entries.find(Handle) };
+
+        // The handle may have been removed, or closed and reused, by an earlier callback
+        // in this same batch.
+        if (It == m_Entries.end() || It->second.Generation != Generation)
+        {
+            continue;
+        }
+
+        const std::shared_ptr<OnEventSignature> Callback { It->second.Callback };
+        (*Callback)(FromNative(Events[I].events));
+        Dispatched++;
+    }
+#else
+    std::vector<pollfd> Handles;
+    std::vector<uint32_t> Generations;
+    Handles.reserve(m_Entries.size() + 1);
+    Generations.reserve(m_Entries.size() + 1);
+
+    Handles.push_back({ m_WakeRead.Handle(), POLLIN, 0 });
+    Generations.push_back(0);
+
+    for (const std::pair<const NativeSocket, Entry>& Item : m_Entries)
+    {
+        Handles.push_back({ Item.first, ToNative(Item.second.Events), 0 });
+        Generations.push_back(Item.second.Generation);
+    }
+
+    const int Count { poll(Handles.data(), static_cast<unsigned long>(Handles.size()), TimeoutMS) };
+
+    for (size_t I = 0; Count > 0 && I < Handles.size(); I++)
+    {
+        if (Handles[I].revents == 0)
+        {
+            continue;
+        }
+
+        if (I == 0)
+        {
+            DrainWake();
+            continue;
+        }
+
+        const std::unordered_map<NativeSocket, Entry>::const_iterator It { m_Entries.find(Handles[I].fd) };
+
+        if (It == m_Entries.end() || It->second.Generation != Generations[I])
+        {
+            continue;
+        }
+
+        const std::shared_ptr<OnEventSignature> Callback { It->second.Callback };
+        (*Callback)(FromNative(Handles[I].revents));
+        Dispatched++;
+    }
+#endif
+
+    RunTasks();
+    return Dispatched;
+}
+
+void Reactor::Run()
+{
+    m_Running = true;
+
+    while (m_Running)
+    {
+        Poll(-1);
+    }
+}
+
+void Reactor::Stop()
+{
+    m_Running = false;
+    Wake();
+}
+
+bool Reactor::IsRunning() const
+{
+    return m_Running;
+}
+
+void Reactor::Post(TaskSignature&& Task)
+{
+    {
+        std::lock_guard<std::mutex> Lock { m_TasksMutex };
+        m_Tasks.push_back(std::move(Task));
+    }
+
+    Wake();
+}
+
+void Reactor::Wake()
+{
+#if defined(__linux__)
+    const uint64_t Value { 1 };
+    const ssize_t Written { write(m_WakeEvent, &Value, sizeof(Value)) };
+    (void)Written;
+#else
+    const char Value { 1 };
+    m_WakeWrite.Send(&Value, sizeof(Value));
+#endif
+}
+
+void Reactor::RunTasks()
+{
+    std::vector<TaskSignature> Tasks;
+
+    {
+        std::lock_guard<std::mutex> Lock { m_TasksMutex };
+        Tasks.swap(m_Tasks);
+    }
+
+    for (const TaskSignature& Task : Tasks)
+    {
+        Task();
+    }
+}
+
+void Reactor::DrainWake()
+{
+#if defined(__linux__)
+    uint64_t Value { 0 };
+    const ssize_t Read { read(m_WakeEvent, &Value, sizeof(Value)) };
+    (void)Read;
+#else
+    char Buffer[64];
+    while (m_WakeRead.Receive(Buffer, sizeof(Buffer)).Status == IOStatus::Ok)
+    {
+    }
+#endif
+}
+
+}
+}
@@ -0,0 +1,107 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "Socket.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Snippet
+{
+namespace Common
+{
+
+//
+// Single-threaded event loop. Sockets are registered with a callback that is invoked on
+// the reactor's thread whenever the requested events are ready. Uses epoll on Linux and
+// poll everywhere else. Stop and Post may be called from any thread.
+//
+
+class Reactor
+{
+public:
+    enum Event : uint32_t
+    {
+        Readable = 1 << 0,
+        Writable = 1 << 1,
+        Hangup = 1 << 2,
+    };
+
+    using OnEventSignature = std::function<void(uint32_t Events)>;
+    using TaskSignature = std::function<void()>;
+
+    Reactor();
+    ~Reactor();
+
+    bool IsValid() const;
+
+    bool Add(NativeSocket Handle, uint32_t Events, OnEventSignature&& Fn);
+    bool Modify(NativeSocket Handle, uint32_t Events);
+    bool Remove(NativeSocket Handle);
+
+    int Poll(int TimeoutMS);
+    void Run();
+    void Stop();
+    bool IsRunning() const;
+
+    void Post(TaskSignature&& Task);
+    void Wake();
+
+private:
+    struct Entry
+    {
+        uint32_t Generation { 0 };
+        uint32_t Events { 0 };
+        std::shared_ptr<OnEventSignature> Callback { nullptr };
+    };
+
+    void RunTasks();
+    void DrainWake();
+
+    std::unordered_map<NativeSocket, Entry> m_Entries {};
+    uint32_t m_Generation { 0 };
+    std::atomic<bool> m_Running { false };
+
+    std::mutex m_TasksMutex {};
+    std::vector<TaskSignature> m_Tasks {};
+
+#if defined(__linux__)
+    int m_Poll { -1 };
+    int m_WakeEvent { -1 };
+#else
+    Socket m_WakeRead {};
+    Socket m_WakeWrite {};
+#endif
+};
+
+}
+}
@@ -0,0 +1,534 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "SharedChannel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+
+#if defined(__linux__)
+    #include <sys/eventfd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace Snippet
+{
+namespace Common
+{
+
+static constexpr uint32_t ChannelMagic { 0x4E484353 };
+static constexpr size_t ControlSize { 4096 };
+
+// Handles are sent in this order. Side 0 is the creator, which writes to ring 0 and is
+// woken through doorbell 0.
+static constexpr int MemoryHandle { 0 };
+static constexpr int DoorbellHandle { 1 };
+
+// Both processes map the same counters, which is only sound if they never fall back to
+// a lock.
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared counters must be lock-free");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared flags must be lock-free");
+
+struct SharedChannel::Ring
+{
+    // Running byte counts. Head is only written by the producer and Tail only by the
+    // consumer; they are kept on their own cache lines so the two ends do not contend.
+    // A new reader counts as waiting, so the first write always rings its doorbell.
+    alignas(64) std::atomic<uint64_t> Head { 0 };
+    alignas(64) std::atomic<uint64_t> Tail { 0 };
+    alignas(64) std::atomic<uint32_t> ReaderWaiting { 1 };
+    std::atomic<uint32_t> WriterWaiting { 0 };
+};
+
+struct SharedChannel::Control
+{
+    uint32_t Magic { ChannelMagic };
+    uint32_t Version { 1 };
+    uint64_t Capacity { 0 };
+    Ring Rings[2] {};
+};
+
+bool SharedChannel::IsSupported()
+{
+#if defined(__linux__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::string SharedChannel::LocalPath(uint16_t Port)
+{
+    return "@SnippetServer." + std::to_string(Port);
+}
+
+#if defined(__linux__)
+
+SharedChannel SharedChannel::Create(size_t Capacity)
+{
+    const size_t Page { static_cast<size_t>(sysconf(_SC_PAGESIZE)) };
+    size_t Size { Page };
+    while (Size < Capacity)
+    {
+        Size <<= 1;
+    }
+
+    static_assert(sizeof(Control) <= ControlSize, "control block must fit in its page");
+
+    SharedChannel Result {};
+    Result.m_Handles[MemoryHandle] = memfd_create("SnippetChannel", MFD_CLOEXEC);
+    Result.m_Handles[DoorbellHandle] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    Result.m_Handles[DoorbellHandle + 1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    Result.m_Capacity = Size;
+
+    if (Result.m_Handles[MemoryHandle] < 0 || Result.m_Handles[DoorbellHandle] < 0 || Result.m_Handles[DoorbellHandle + 1] < 0)
+    {
+        return {};
+    }
+
+    if (ftruncate(Result.m_Handles[MemoryHandle], static_cast<off_t>(ControlSize + Size * 2)) != 0 || !Result.Map(0))
+    {
+        return {};
+    }
+
+    new (Result.m_Control) Control {};
+    Result.m_Control->Capacity = Size;
+    return Result;
+}
+
+SharedChannel SharedChannel::Open(const int* Handles, size_t Count)
+{
+    SharedChannel Result {};
+    for (size_t I = 0; I < Count; I++)
+    {
+        if (I < HandleCount)
+        {
+            Result.m_Handles[I] = Handles[I];
+        }
+        else
+        {
+            close(Handles[I]);
+        }
+    }
+
+    if (Count != HandleCount)
+    {
+        return {};
+    }
+
+    // The capacity is taken from the creator's control block, and only trusted once it
+    // agrees with the size of the segment.
+    struct stat Info {};
+    if (fstat(Result.m_Handles[MemoryHandle], &Info) != 0 || static_cast<size_t>(Info.st_size) <= ControlSize)
+    {
+        return {};
+    }
+
+    const size_t Size { (static_cast<size_t>(Info.st_size) - ControlSize) / 2 };
+    const size_t Page { static_cast<size_t>(sysconf(_SC_PAGESIZE)) };
+    if (Size < Page || (Size & (Size - 1)) != 0 || ControlSize + Size * 2 != static_cast<size_t>(Info.st_size))
+    {
+        return {};
+    }
+
+    Result.m_Capacity = Size;
+    if (!Result.Map(1) || Result.m_Control->Magic != ChannelMagic || Result.m_Control->Capacity != Size)
+    {
+        return {};
+    }
+
+    return Result;
+}
+
+SharedChannel::SharedChannel()
+{
+}
+
+SharedChannel::SharedChannel(SharedChannel&& Other)
+{
+    *this = std::move(Other);
+}
+
+SharedChannel& SharedChannel::operator=(SharedChannel&& Other)
+{
+    if (this != &Other)
+    {
+        Close();
+
+        for (size_t I = 0; I < HandleCount; I++)
+        {
+            m_Handles[I] = Other.m_Handles[I];
+            Other.m_Handles[I] = -1;
+        }
+
+        m_Capacity = Other.m_Capacity;
+        m_Side = Other.m_Side;
+        m_Control = Other.m_Control;
+        m_Tx = Other.m_Tx;
+        m_Rx = Other.m_Rx;
+        m_Overflow = std::move(Other.m_Overflow);
+
+        Other.m_Capacity = 0;
+        Other.m_Control = nullptr;
+        Other.m_Tx = nullptr;
+        Other.m_Rx = nullptr;
+    }
+
+    return *this;
+}
+
+SharedChannel::~SharedChannel()
+{
+    Close();
+}
+
+bool SharedChannel::IsValid() const
+{
+    return m_Control != nullptr;
+}
+
+size_t SharedChannel::Capacity() const
+{
+    return m_Capacity;
+}
+
+const int* SharedChannel::Handles() const
+{
+    return m_Handles;
+}
+
+NativeSocket SharedChannel::Doorbell() const
+{
+    return m_Handles[DoorbellHandle + m_Side];
+}
+
+void SharedChannel::ClearDoorbell() const
+{
+    uint64_t Value { 0 };
+    const ssize_t Read { read(Doorbell(), &Value, sizeof(Value)) };
+    (void)Read;
+}
+
+size_t SharedChannel::Send(const void* Data, size_t Size)
+{
+    const uint8_t* Bytes { static_cast<const uint8_t*>(Data) };
+    Ring& Target { m_Control->Rings[m_Side] };
+    size_t Sent { 0 };
+
+    while (Sent < Size)
+    {
+        const size_t Written { Write(Bytes + Sent, Size - Sent) };
+        Sent += Written;
+
+        if (Written == 0)
+        {
+            // Ask to be woken, then look again in case the reader made room before it
+            // could have seen the request.
+            Target.WriterWaiting.store(1);
+            if (Target.Head.load() - Target.Tail.load() >= m_Capacity)
+            {
+                break;
+            }
+        }
+    }
+
+    return Sent;
+}
+
+bool SharedChannel::Receive(const OnMessageSignature& Fn)
+{
+    Ring& Source { m_Control->Rings[1 - m_Side] };
+    // Bytes already looked at that do not yet make up a whole message.
+    uint64_t Seen { 0 };
+
+    while (true)
+    {
+        const uint64_t Tail { Source.Tail.load(std::memory_order_relaxed) };
+        const uint64_t Available { Source.Head.load() - Tail };
+
+        if (Available > m_Capacity)
+        {
+            return false;
+        }
+
+        if (Available == Seen)
+        {
+            Source.ReaderWaiting.store(1);
+            if (Source.Head.load() - Tail == Seen)
+            {
+                return true;
+            }
+
+            continue;
+        }
+
+        const uint8_t* Data { m_Rx + (Tail & (m_Capacity - 1)) };
+        size_t Used { 0 };
+
+        if (m_Overflow.empty())
+        {
+            if (!Parse(Data, Available, Fn, Used))
+            {
+                return false;
+            }
+
+            // A message longer than the ring never completes in place. Gather it, and
+            // whatever follows it, in the overflow buffer instead.
+            if (Used == 0 && Available == m_Capacity)
+            {
+                m_Overflow.assign(Data, Data + Available);
+                Used = Available;
+            }
+        }
+        else
+        {
+            m_Overflow.insert(m_Overflow.end(), Data, Data + Available);
+            Used = Available;
+
+            size_t Parsed { 0 };
+            if (!Parse(m_Overflow.data(), m_Overflow.size(), Fn, Parsed))
+            {
+                return false;
+            }
+
+            m_Overflow.erase(m_Overflow.begin(), m_Overflow.begin() + Parsed);
+        }
+
+        Consume(Used);
+        Seen = Available - Used;
+    }
+}
+
+void SharedChannel::Close()
+{
+    if (m_Control != nullptr)
+    {
+        munmap(m_Control, ControlSize);
+    }
+
+    if (m_Tx != nullptr)
+    {
+        munmap(m_Tx, m_Capacity * 2);
+    }
+
+    if (m_Rx != nullptr)
+    {
+        munmap(m_Rx, m_Capacity * 2);
+    }
+
+    for (int& Handle : m_Handles)
+    {
+        if (Handle >= 0)
+        {
+            close(Handle);
+            Handle = -1;
+        }
+    }
+
+    m_Capacity = 0;
+    m_Control = nullptr;
+    m_Tx = nullptr;
+    m_Rx = nullptr;
+    m_Overflow.clear();
+}
+
+bool SharedChannel::Map(int Side)
+{
+    const int Memory { m_Handles[MemoryHandle] };
+    m_Side = Side;
+
+    void* Control_ { mmap(nullptr, ControlSize, PROT_READ | PROT_WRITE, MAP_SHARED, Memory, 0) };
+    if (Control_ == MAP_FAILED)
+    {
+        return false;
+    }
+
+    m_Control = static_cast<Control*>(Control_);
+
+    // Reserve twice the ring's size and map the ring's pages into both halves.
+    uint8_t* Rings[2] { nullptr, nullptr };
+    for (int I = 0; I < 2; I++)
+    {
+        void* Reserved { mmap(nullptr, m_Capacity * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) };
+        if (Reserved == MAP_FAILED)
+        {
+            return false;
+        }
+
+        Rings[I] = static_cast<uint8_t*>(Reserved);
+        (I == Side ? m_Tx : m_Rx) = Rings[I];
+
+        const off_t Offset { static_cast<off_t>(ControlSize + m_Capacity * I) };
+        for (int Half = 0; Half < 2; Half++)
+        {
+            if (mmap(Rings[I] + m_Capacity * Half, m_Capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, Memory, Offset) == MAP_FAILED)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+size_t SharedChannel::Write(const void* Data, size_t Size)
+{
+    Ring& Target { m_Control->Rings[m_Side] };
+    const uint64_t Head { Target.Head.load(std::memory_order_relaxed) };
+    const uint64_t Used { Head - Target.Tail.load(std::memory_order_acquire) };
+
+    if (Used >= m_Capacity)
+    {
+        return 0;
+    }
+
+    const size_t Count { std::min<size_t>(Size, m_Capacity - Used) };
+    std::memcpy(m_Tx + (Head & (m_Capacity - 1)), Data, Count);
+
+    // Sequentially consistent so that either the reader sees the new head before it goes
+    // to sleep or this sees that it is asleep.
+    Target.Head.store(Head + Count);
+    if (Target.ReaderWaiting.load() != 0 && Target.ReaderWaiting.exchange(0) != 0)
+    {
+        Signal(1 - m_Side);
+    }
+
+    return Count;
+}
+
+void SharedChannel::Consume(size_t Size)
+{
+    if (Size == 0)
+    {
+        return;
+    }
+
+    Ring& Source { m_Control->Rings[1 - m_Side] };
+    Source.Tail.store(Source.Tail.load(std::memory_order_relaxed) + Size);
+
+    if (Source.WriterWaiting.load() != 0 && Source.WriterWaiting.exchange(0) != 0)
+    {
+        Signal(1 - m_Side);
+    }
+}
+
+void SharedChannel::Signal(int Bell) const
+{
+    const uint64_t Value { 1 };
+    const ssize_t Written { write(m_Handles[DoorbellHandle + Bell], &Value, sizeof(Value)) };
+    (void)Written;
+}
+
+#else
+
+SharedChannel SharedChannel::Create(size_t)
+{
+    return {};
+}
+
+SharedChannel SharedChannel::Open(const int*, size_t)
+{
+    return {};
+}
+
+SharedChannel::SharedChannel()
+{
+}
+
+SharedChannel::SharedChannel(SharedChannel&&)
+{
+}
+
+SharedChannel& SharedChannel::operator=(SharedChannel&&)
+{
+    return *this;
+}
+
+SharedChannel::~SharedChannel()
+{
+}
+
+bool SharedChannel::IsValid() const
+{
+    return false;
+}
+
+size_t SharedChannel::Capacity() const
+{
+    return 0;
+}
+
+const int* SharedChannel::Handles() const
+{
+    return m_Handles;
+}
+
+NativeSocket SharedChannel::Doorbell() const
+{
+    return Socket::Invalid;
+}
+
+void SharedChannel::ClearDoorbell() const
+{
+}
+
+size_t SharedChannel::Send(const void*, size_t)
+{
+    return 0;
+}
+
+bool SharedChannel::Receive(const OnMessageSignature&)
+{
+    return false;
+}
+
+void SharedChannel::Close()
+{
+}
+
+#endif
+
+bool SharedChannel::Parse(const uint8_t* Data, size_t Size, const OnMessageSignature& Fn, size_t& Used) const
+{
+    Protocol::MessageReader Reader { Data, Size };
+    Protocol::MessageView Message {};
+    Protocol::ParseStatus Status { Protocol::ParseStatus::Ok };
+
+    while ((Status = Reader.Next(Message)) == Protocol::ParseStatus::Ok)
+    {
+        Fn(Message);
+    }
+
+    Used = Reader.Consumed();
+    return Status != Protocol::ParseStatus::Invalid;
+}
+
+}
+}
@@ -0,0 +1,125 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "Protocol.h"
+#include "Socket.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Snippet
+{
+namespace Common
+{
+
+//
+// Message transport between two processes on the same host, used in place of the socket
+// once a local connection has been upgraded. A memfd segment holds one single-producer,
+// single-consumer byte ring per direction. Each ring is mapped twice back to back, so a
+// message that wraps around the end is still contiguous and is handed to the reader in
+// place, without being copied out of the segment. Messages larger than a ring are the
+// exception and are gathered in a private buffer.
+//
+// Each end has an eventfd doorbell to register with its reactor. A writer only rings the
+// peer's doorbell when the peer has said it is waiting for data, and a reader only when
+// the writer has said it is waiting for space, so a busy channel makes no system calls.
+//
+// Only available on Linux. Elsewhere IsSupported is false and Create fails, and callers
+// keep using the socket.
+//
+
+class SharedChannel
+{
+public:
+    using OnMessageSignature = std::function<void(const Protocol::MessageView&)>;
+
+    static constexpr size_t DefaultCapacity { 8 * 1024 * 1024 };
+    static constexpr size_t HandleCount { 3 };
+
+    static bool IsSupported();
+
+    // Abstract Unix socket a server listening on Port also accepts local connections on.
+    static std::string LocalPath(uint16_t Port);
+
+    // Creates the segment and both doorbells. Capacity is rounded up to a power of two.
+    // Returns an invalid channel on failure.
+    static SharedChannel Create(size_t Capacity = DefaultCapacity);
+    // Maps the other end of a channel from the handles sent by its creator. Takes
+    // ownership of the handles, and closes them on failure.
+    static SharedChannel Open(const int* Handles, size_t Count);
+
+    SharedChannel();
+    SharedChannel(SharedChannel&& Other);
+    SharedChannel& operator=(SharedChannel&& Other);
+    SharedChannel(const SharedChannel&) = delete;
+    SharedChannel& operator=(const SharedChannel&) = delete;
+    ~SharedChannel();
+
+    bool IsValid() const;
+    size_t Capacity() const;
+
+    // The memfd and both doorbells, to be sent to the peer. Still owned by this channel.
+    const int* Handles() const;
+    NativeSocket Doorbell() const;
+    void ClearDoorbell() const;
+
+    // Copies as much of Data as there is room for and returns the number of bytes sent.
+    // When that is short, the peer rings the doorbell once it has made room.
+    size_t Send(const void* Data, size_t Size);
+
+    // Hands every complete message waiting in the ring to Fn. The views point into the
+    // segment and are only valid during the call. Returns false if the peer sent
+    // something that is not a valid message, or corrupted the ring.
+    bool Receive(const OnMessageSignature& Fn);
+
+    void Close();
+
+private:
+    struct Ring;
+    struct Control;
+
+    bool Map(int Side);
+    size_t Write(const void* Data, size_t Size);
+    void Consume(size_t Size);
+    bool Parse(const uint8_t* Data, size_t Size, const OnMessageSignature& Fn, size_t& Used) const;
+    void Signal(int Bell) const;
+
+    int m_Handles[HandleCount] { -1, -1, -1 };
+    size_t m_Capacity { 0 };
+    int m_Side { 0 };
+    Control* m_Control { nullptr };
+    uint8_t* m_Tx { nullptr };
+    uint8_t* m_Rx { nullptr };
+    std::vector<uint8_t> m_Overflow {};
+};
+
+}
+}
@@ -0,0 +1,581 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Socket.h"
+
+#include <cstring>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #include <afunix.h>
+#else
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <netdb.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+namespace Snippet
+{
+namespace Common
+{
+
+#if defined(_WIN32)
+const NativeSocket Socket::Invalid { INVALID_SOCKET };
+
+static bool IsWouldBlock()
+{
+    const int Error { WSAGetLastError() };
+    return Error == WSAEWOULDBLOCK || Error == WSAEINPROGRESS;
+}
+
+static void CloseNative(NativeSocket Handle)
+{
+    closesocket(Handle);
+}
+#else
+const NativeSocket Socket::Invalid { -1 };
+
+static bool IsWouldBlock()
+{
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS;
+}
+
+static void CloseNative(NativeSocket Handle)
+{
+    close(Handle);
+}
+#endif
+
+static bool Resolve(const char* Host, uint16_t Port, sockaddr_in& Address)
+{
+    std::memset(&Address, 0, sizeof(Address));
+    Address.sin_family = AF_INET;
+    Address.sin_port = htons(Port);
+
+    if (Host == nullptr || *Host == '\0')
+    {
+        Address.sin_addr.s_addr = htonl(INADDR_ANY);
+        return true;
+    }
+
+    if (inet_pton(AF_INET, Host, &Address.sin_addr) == 1)
+    {
+        return true;
+    }
+
+    addrinfo Hints {};
+    Hints.ai_family = AF_INET;
+    Hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* Info { nullptr };
+    if (getaddrinfo(Host, nullptr, &Hints, &Info) != 0 || Info == nullptr)
+    {
+        return false;
+    }
+
+    Address.sin_addr = reinterpret_cast<sockaddr_in*>(Info->ai_addr)->sin_addr;
+    freeaddrinfo(Info);
+    return true;
+}
+
+static bool IsAbstract(const char* Path)
+{
+#if defined(__linux__)
+    return Path[0] == '@';
+#else
+    (void)Path;
+    return false;
+#endif
+}
+
+static bool ToUnixAddress(const char* Path, sockaddr_un& Address)
+{
+    std::memset(&Address, 0, sizeof(Address));
+    Address.sun_family = AF_UNIX;
+
+    const size_t Length { std::strlen(Path) };
+    if (Length == 0 || Length >= sizeof(Address.sun_path))
+    {
+        return false;
+    }
+
+    std::memcpy(Address.sun_path, Path, Length);
+
+#if defined(__linux__)
+    if (IsAbstract(Path))
+    {
+        Address.sun_path[0] = '\0';
+    }
+#endif
+
+    return true;
+}
+
+bool Socket::Initialize()
+{
+#if defined(_WIN32)
+    WSADATA Data {};
+    return WSAStartup(MAKEWORD(2, 2), &Data) == 0;
+#else
+    return true;
+#endif
+}
+
+void Socket::Shutdown()
+{
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+Socket Socket::ListenTCP(const char* Host, uint16_t Port, bool ReusePort)
+{
+    sockaddr_in Address {};
+    if (!Resolve(Host, Port, Address))
+    {
+        return {};
+    }
+
+    Socket Result { socket(AF_INET, SOCK_STREAM, 0) };
+    if (!Result.IsValid())
+    {
+        return {};
+    }
+
+    int Enable { 1 };
+    setsockopt(Result.m_Handle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&Enable), sizeof(Enable));
+
+#if defined(SO_REUSEPORT)
+    if (ReusePort)
+    {
+        setsockopt(Result.m_Handle, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<const char*>(&Enable), sizeof(Enable));
+    }
+#else
+    (void)ReusePort;
+#endif
+
+    if (bind(Result.m_Handle, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) != 0)
+    {
+        return {};
+    }
+
+    if (listen(Result.m_Handle, SOMAXCONN) != 0)
+    {
+        return {};
+    }
+
+    return Result;
+}
+
+Socket Socket::ListenUnix(const char* Path)
+{
+    sockaddr_un Address {};
+    if (!ToUnixAddress(Path, Address))
+    {
+        return {};
+    }
+
+    Socket Result { socket(AF_UNIX, SOCK_STREAM, 0) };
+    if (!Result.IsValid())
+    {
+        return {};
+    }
+
+#if defined(_WIN32)
+    DeleteFileA(Path);
+#else
+    if (!IsAbstract(Path))
+    {
+        unlink(Path);
+    }
+#endif
+
+    if (bind(Result.m_Handle, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) != 0)
+    {
+        return {};
+    }
+
+    if (listen(Result.m_Handle, SOMAXCONN) != 0)
+    {
+        return {};
+    }
+
+    return Result;
+}
+
+Socket Socket::ConnectTCP(const char* Host, uint16_t Port, bool Blocking)
+{
+    sockaddr_in Address {};
+    if (!Resolve(Host, Port, Address))
+    {
+        return {};
+    }
+
+    Socket Result { socket(AF_INET, SOCK_STREAM, 0) };
+    if (!Result.IsValid())
+    {
+        return {};
+    }
+
+    Result.SetNoDelay(true);
+
+    if (!Blocking && !Result.SetNonBlocking(true))
+    {
+        return {};
+    }
+
+    if (connect(Result.m_Handle, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) != 0 && (Blocking || !IsWouldBlock()))
+    {
+        return {};
+    }
+
+    return Result;
+}
+
+Socket Socket::ConnectUnix(const char* Path, bool Blocking)
+{
+    sockaddr_un Address {};
+    if (!ToUnixAddress(Path, Address))
+    {
+        return {};
+    }
+
+    Socket Result { socket(AF_UNIX, SOCK_STREAM, 0) };
+    if (!Result.IsValid())
+    {
+        return {};
+    }
+
+    if (!Blocking && !Result.SetNonBlocking(true))
+    {
+        return {};
+    }
+
+    if (connect(Result.m_Handle, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) != 0 && (Blocking || !IsWouldBlock()))
+    {
+        return {};
+    }
+
+    return Result;
+}
+
+bool Socket::Pair(Socket& A, Socket& B)
+{
+#if defined(_WIN32)
+    Socket Listener { ListenTCP("127.0.0.1", 0) };
+    if (!Listener.IsValid())
+    {
+        return false;
+    }
+
+    A = ConnectTCP("127.0.0.1", Listener.LocalPort());
+    B = Listener.Accept();
+    return A.IsValid() && B.IsValid();
+#else
+    int Handles[2] { -1, -1 };
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, Handles) != 0)
+    {
+        return false;
+    }
+
+    A = Socket { Handles[0] };
+    B = Socket { Handles[1] };
+    return true;
+#endif
+}
+
+Socket::Socket()
+    : m_Handle(Invalid)
+{
+}
+
+Socket::Socket(NativeSocket Handle)
+    : m_Handle(Handle)
+{
+}
+
+Socket::Socket(Socket&& Other)
+    : m_Handle(Other.Release())
+{
+}
+
+Socket& Socket::operator=(Socket&& Other)
+{
+    if (this != &Other)
+    {
+        Close();
+        m_Handle = Other.Release();
+    }
+
+    return *this;
+}
+
+Socket::~Socket()
+{
+    Close();
+}
+
+Socket Socket::Accept() const
+{
+    const NativeSocket Handle { accept(m_Handle, nullptr, nullptr) };
+    return Socket { Handle };
+}
+
+IOResult Socket::Send(const void* Data, size_t Size) const
+{
+#if defined(_WIN32)
+    const int Sent { send(m_Handle, static_cast<const char*>(Data), static_cast<int>(Size), 0) };
+#elif defined(MSG_NOSIGNAL)
+    const ssize_t Sent { send(m_Handle, Data, Size, MSG_NOSIGNAL) };
+#else
+    const ssize_t Sent { send(m_Handle, Data, Size, 0) };
+#endif
+
+    if (Sent < 0)
+    {
+        return { IsWouldBlock() ? IOStatus::WouldBlock : IOStatus::Error, 0 };
+    }
+
+    return { IOStatus::Ok, static_cast<size_t>(Sent) };
+}
+
+IOResult Socket::Receive(void* Data, size_t Size) const
+{
+#if defined(_WIN32)
+    const int Received { recv(m_Handle, static_cast<char*>(Data), static_cast<int>(Size), 0) };
+#else
+    const ssize_t Received { recv(m_Handle, Data, Size, 0) };
+#endif
+
+    if (Received < 0)
+    {
+        return { IsWouldBlock() ? IOStatus::WouldBlock : IOStatus::Error, 0 };
+    }
+
+    if (Received == 0)
+    {
+        return { IOStatus::Closed, 0 };
+    }
+
+    return { IOStatus::Ok, static_cast<size_t>(Received) };
+}
+
+IOResult Socket::SendHandles(const void* Data, size_t Size, const int* Handles, size_t Count) const
+{
+#if defined(_WIN32)
+    (void)Data;
+    (void)Size;
+    (void)Handles;
+    (void)Count;
+    return { IOStatus::Error, 0 };
+#else
+    std::vector<uint8_t> Control(CMSG_SPACE(sizeof(int) * Count));
+    iovec Vector { const_cast<void*>(Data), Size };
+
+    msghdr Header {};
+    Header.msg_iov = &Vector;
+    Header.msg_iovlen = 1;
+    Header.msg_control = Control.data();
+    Header.msg_controllen = Control.size();
+
+    cmsghdr* Message { CMSG_FIRSTHDR(&Header) };
+    Message->cmsg_level = SOL_SOCKET;
+    Message->cmsg_type = SCM_RIGHTS;
+    Message->cmsg_len = CMSG_LEN(sizeof(int) * Count);
+    std::memcpy(CMSG_DATA(Message), Handles, sizeof(int) * Count);
+
+    #if defined(MSG_NOSIGNAL)
+    const ssize_t Sent { sendmsg(m_Handle, &Header, MSG_NOSIGNAL) };
+    #else
+    const ssize_t Sent { sendmsg(m_Handle, &Header, 0) };
+    #endif
+
+    if (Sent < 0)
+    {
+        return { IsWouldBlock() ? IOStatus::WouldBlock : IOStatus::Error, 0 };
+    }
+
+    return { IOStatus::Ok, static_cast<size_t>(Sent) };
+#endif
+}
+
+IOResult Socket::Receive(void* Data, size_t Size, std::vector<int>& Handles) const
+{
+#if defined(_WIN32)
+    (void)Handles;
+    return Receive(Data, Size);
+#else
+    alignas(cmsghdr) uint8_t Control[CMSG_SPACE(sizeof(int) * 8)] {};
+    iovec Vector { Data, Size };
+
+    msghdr Header {};
+    Header.msg_iov = &Vector;
+    Header.msg_iovlen = 1;
+    Header.msg_control = Control;
+    Header.msg_controllen = sizeof(Control);
+
+    #if defined(MSG_CMSG_CLOEXEC)
+    const ssize_t Received { recvmsg(m_Handle, &Header, MSG_CMSG_CLOEXEC) };
+    #else
+    const ssize_t Received { recvmsg(m_Handle, &Header, 0) };
+    #endif
+
+    if (Received < 0)
+    {
+        return { IsWouldBlock() ? IOStatus::WouldBlock : IOStatus::Error, 0 };
+    }
+
+    for (cmsghdr* Message = CMSG_FIRSTHDR(&Header); Message != nullptr; Message = CMSG_NXTHDR(&Header, Message))
+    {
+        if (Message->cmsg_level != SOL_SOCKET || Message->cmsg_type != SCM_RIGHTS)
+        {
+            continue;
+        }
+
+        const size_t Count { (Message->cmsg_len - CMSG_LEN(0)) / sizeof(int) };
+        for (size_t I = 0; I < Count; I++)
+        {
+            int Handle { -1 };
+            std::memcpy(&Handle, CMSG_DATA(Message) + I * sizeof(int), sizeof(int));
+            Handles.push_back(Handle);
+        }
+    }
+
+    if (Received == 0)
+    {
+        return { IOStatus::Closed, 0 };
+    }
+
+    return { IOStatus::Ok, static_cast<size_t>(Received) };
+#endif
+}
+
+bool Socket::SetNonBlocking(bool NonBlocking) const
+{
+#if defined(_WIN32)
+    u_long Mode { NonBlocking ? 1ul : 0ul };
+    return ioctlsocket(m_Handle, FIONBIO, &Mode) == 0;
+#else
+    const int Flags { fcntl(m_Handle, F_GETFL, 0) };
+    if (Flags < 0)
+    {
+        return false;
+    }
+
+    return fcntl(m_Handle, F_SETFL, NonBlocking ? (Flags | O_NONBLOCK) : (Flags & ~O_NONBLOCK)) == 0;
+#endif
+}
+
+bool Socket::SetNoDelay(bool NoDelay) const
+{
+    const int Value { NoDelay ? 1 : 0 };
+    return setsockopt(m_Handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&Value), sizeof(Value)) == 0;
+}
+
+bool Socket::FinishConnect() const
+{
+    int Error { 0 };
+    socklen_t Length { sizeof(Error) };
+
+    if (getsockopt(m_Handle, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&Error), &Length) != 0)
+    {
+        return false;
+    }
+
+    return Error == 0;
+}
+
+bool Socket::Disconnect() const
+{
+#if defined(_WIN32)
+    return shutdown(m_Handle, SD_BOTH) == 0;
+#else
+    return shutdown(m_Handle, SHUT_RDWR) == 0;
+#endif
+}
+
+uint16_t Socket::LocalPort() const
+{
+    sockaddr_in Address {};
+    socklen_t Length { sizeof(Address) };
+
+    if (getsockname(m_Handle, reinterpret_cast<sockaddr*>(&Address), &Length) != 0 || Address.sin_family != AF_INET)
+    {
+        return 0;
+    }
+
+    return ntohs(Address.sin_port);
+}
+
+bool Socket::IsUnix() const
+{
+    sockaddr_storage Address {};
+    socklen_t Length { sizeof(Address) };
+
+    if (getsockname(m_Handle, reinterpret_cast<sockaddr*>(&Address), &Length) != 0)
+    {
+        return false;
+    }
+
+    return Address.ss_family == AF_UNIX;
+}
+
+bool Socket::IsValid() const
+{
+    return m_Handle != Invalid;
+}
+
+NativeSocket Socket::Handle() const
+{
+    return m_Handle;
+}
+
+NativeSocket Socket::Release()
+{
+    const NativeSocket Result { m_Handle };
+    m_Handle = Invalid;
+    return Result;
+}
+
+void Socket::Close()
+{
+    if (IsValid())
+    {
+        CloseNative(m_Handle);
+        m_Handle = Invalid;
+    }
+}
+
+}
+}
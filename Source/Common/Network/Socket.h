@@ -0,0 +1,115 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Snippet
+{
+namespace Common
+{
+
+#if defined(_WIN32)
+using NativeSocket = uintptr_t;
+#else
+using NativeSocket = int;
+#endif
+
+enum class IOStatus : unsigned char
+{
+    Ok,
+    WouldBlock,
+    Closed,
+    Error,
+};
+
+struct IOResult
+{
+    IOStatus Status { IOStatus::Ok };
+    size_t Bytes { 0 };
+};
+
+//
+// Thin owning wrapper over a platform socket handle. All factory functions return an
+// invalid socket on failure; callers check IsValid() rather than catching exceptions.
+// On Linux, a Unix socket path starting with '@' is in the abstract namespace.
+//
+
+class Socket
+{
+public:
+    static const NativeSocket Invalid;
+
+    static bool Initialize();
+    static void Shutdown();
+
+    static Socket ListenTCP(const char* Host, uint16_t Port, bool ReusePort = false);
+    static Socket ListenUnix(const char* Path);
+    static Socket ConnectTCP(const char* Host, uint16_t Port, bool Blocking = true);
+    static Socket ConnectUnix(const char* Path, bool Blocking = true);
+    static bool Pair(Socket& A, Socket& B);
+
+    Socket();
+    explicit Socket(NativeSocket Handle);
+    Socket(Socket&& Other);
+    Socket& operator=(Socket&& Other);
+    Socket(const Socket&) = delete;
+    Socket& operator=(const Socket&) = delete;
+    ~Socket();
+
+    Socket Accept() const;
+    IOResult Send(const void* Data, size_t Size) const;
+    IOResult Receive(void* Data, size_t Size) const;
+    // Unix domain sockets only. The handles are passed to the peer along with the first
+    // byte of Data.
+    IOResult SendHandles(const void* Data, size_t Size, const int* Handles, size_t Count) const;
+    // Like Receive, and appends any handles that arrived with the data to Handles.
+    IOResult Receive(void* Data, size_t Size, std::vector<int>& Handles) const;
+
+    bool SetNonBlocking(bool NonBlocking) const;
+    bool SetNoDelay(bool NoDelay) const;
+    bool FinishConnect() const;
+    // Shuts down both directions without closing the handle, so the owner sees a hangup.
+    bool Disconnect() const;
+
+    uint16_t LocalPort() const;
+    bool IsUnix() const;
+
+    bool IsValid() const;
+    NativeSocket Handle() const;
+    NativeSocket Release();
+    void Close();
+
+private:
+    NativeSocket m_Handle;
+};
+
+}
+}
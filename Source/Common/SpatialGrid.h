@@ -0,0 +1,403 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "Geometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Snippet
+{
+namespace Common
+{
+
+//
+// Uniform grid of buckets used to answer point and rectangle queries without visiting
+// every item. Items are addressed by the handle returned from Insert. When several items
+// overlap a point, the one inserted last wins, which matches the paint order of children.
+//
+// An item spanning more than MaxItemCells cells is kept in a list of its own, which every
+// query checks, rather than in each of its cells, so that a huge or infinite box does not
+// cost a bucket per cell it covers.
+//
+
+template<typename T>
+class SpatialGrid
+{
+public:
+    using Handle = uint32_t;
+    static constexpr Handle InvalidHandle { ~0u };
+    static constexpr uint64_t MaxItemCells { 256 };
+
+    SpatialGrid(float CellSize = 256.0f)
+        : m_CellSize(CellSize)
+    {
+    }
+
+    Handle Insert(const T& Value, const Bounds& Box)
+    {
+        Handle ID { InvalidHandle };
+
+        if (!m_Free.empty())
+        {
+            ID = m_Free.back();
+            m_Free.pop_back();
+        }
+        else
+        {
+            ID = static_cast<Handle>(m_Items.size());
+            m_Items.emplace_back();
+            m_Stamps.push_back(0);
+        }
+
+        Item& Entry { m_Items[ID] };
+        Entry.Value = Value;
+        Entry.Box = Box;
+        Entry.Order = m_NextOrder++;
+        Entry.Alive = true;
+        Entry.Cells = ToCells(Box);
+        AddToCells(ID, Entry.Cells);
+        m_Count++;
+
+        return ID;
+    }
+
+    SpatialGrid& Update(Handle ID, const Bounds& Box)
+    {
+        if (!IsValid(ID))
+        {
+            return *this;
+        }
+
+        Item& Entry { m_Items[ID] };
+        const CellRange Cells { ToCells(Box) };
+
+        if (!(Cells == Entry.Cells))
+        {
+            RemoveFromCells(ID, Entry.Cells);
+            AddToCells(ID, Cells);
+            Entry.Cells = Cells;
+        }
+
+        Entry.Box = Box;
+        return *this;
+    }
+
+    SpatialGrid& Remove(Handle ID)
+    {
+        if (!IsValid(ID))
+        {
+            return *this;
+        }
+
+        Item& Entry { m_Items[ID] };
+        RemoveFromCells(ID, Entry.Cells);
+        Entry.Value = T {};
+        Entry.Alive = false;
+        m_Free.push_back(ID);
+        m_Count--;
+
+        return *this;
+    }
+
+    SpatialGrid& Clear()
+    {
+        m_Items.clear();
+        m_Stamps.clear();
+        m_Free.clear();
+        m_Cells.clear();
+        m_Oversized.clear();
+        m_Count = 0;
+        return *this;
+    }
+
+    bool IsValid(Handle ID) const
+    {
+        return ID < m_Items.size() && m_Items[ID].Alive;
+    }
+
+    const T& Get(Handle ID) const
+    {
+        return m_Items[ID].Value;
+    }
+
+    const Bounds& GetBounds(Handle ID) const
+    {
+        return m_Items[ID].Box;
+    }
+
+    size_t Size() const
+    {
+        return m_Count;
+    }
+
+    Handle Query(float X, float Y) const
+    {
+        Handle Result { InvalidHandle };
+        uint64_t Order { 0 };
+
+        const auto Visit { [&](const std::vector<Handle>& Bucket) -> void
+            {
+                for (Handle ID : Bucket)
+                {
+                    const Item& Entry { m_Items[ID] };
+
+                    if (Entry.Box.Contains(X, Y) && (Result == InvalidHandle || Entry.Order > Order))
+                    {
+                        Result = ID;
+                        Order = Entry.Order;
+                    }
+                }
+            } };
+
+        const typename std::unordered_map<uint64_t, std::vector<Handle>>::const_iterator It { m_Cells.find(Key(ToCell(X), ToCell(Y))) };
+
+        if (It != m_Cells.end())
+        {
+            Visit(It->second);
+        }
+
+        Visit(m_Oversized);
+        return Result;
+    }
+
+    // A rectangle covering more cells than are occupied only visits the occupied ones, so
+    // a zoomed out view costs what is in it rather than its area. Nothing is found for a
+    // rectangle with a NaN coordinate.
+    template<typename Fn>
+    void Query(const Bounds& Box, Fn&& Callback) const
+    {
+        if (std::isnan(Box.MinX) || std::isnan(Box.MinY) || std::isnan(Box.MaxX) || std::isnan(Box.MaxY))
+        {
+            return;
+        }
+
+        const CellRange Cells { ToCells(Box) };
+        const uint32_t Stamp { NextStamp() };
+
+        const auto Visit { [&](const std::vector<Handle>& Bucket) -> void
+            {
+                for (Handle ID : Bucket)
+                {
+                    if (m_Stamps[ID] == Stamp)
+                    {
+                        continue;
+                    }
+
+                    m_Stamps[ID] = Stamp;
+
+                    if (m_Items[ID].Box.Intersects(Box))
+                    {
+                        Callback(ID, m_Items[ID].Value);
+                    }
+                }
+            } };
+
+        Visit(m_Oversized);
+
+        if (Cells.Area() > m_Cells.size())
+        {
+            for (const std::pair<const uint64_t, std::vector<Handle>>& Cell : m_Cells)
+            {
+                const int32_t X { static_cast<int32_t>(static_cast<uint32_t>(Cell.first >> 32)) };
+                const int32_t Y { static_cast<int32_t>(static_cast<uint32_t>(Cell.first)) };
+
+                if (X >= Cells.MinX && X <= Cells.MaxX && Y >= Cells.MinY && Y <= Cells.MaxY)
+                {
+                    Visit(Cell.second);
+                }
+            }
+
+            return;
+        }
+
+        for (int32_t Y = Cells.MinY; Y <= Cells.MaxY; Y++)
+        {
+            for (int32_t X = Cells.MinX; X <= Cells.MaxX; X++)
+            {
+                const typename std::unordered_map<uint64_t, std::vector<Handle>>::const_iterator It { m_Cells.find(Key(X, Y)) };
+
+                if (It != m_Cells.end())
+                {
+                    Visit(It->second);
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr int32_t MinCell { -(1 << 30) };
+    static constexpr int32_t MaxCell { 1 << 30 };
+
+    struct CellRange
+    {
+        int32_t MinX { 0 };
+        int32_t MinY { 0 };
+        int32_t MaxX { -1 };
+        int32_t MaxY { -1 };
+
+        bool operator==(const CellRange& Other) const
+        {
+            return MinX == Other.MinX && MinY == Other.MinY && MaxX == Other.MaxX && MaxY == Other.MaxY;
+        }
+
+        uint64_t Area() const
+        {
+            if (MaxX < MinX || MaxY < MinY)
+            {
+                return 0;
+            }
+
+            return static_cast<uint64_t>(static_cast<int64_t>(MaxX) - MinX + 1) * static_cast<uint64_t>(static_cast<int64_t>(MaxY) - MinY + 1);
+        }
+    };
+
+    struct Item
+    {
+        T Value {};
+        Bounds Box {};
+        CellRange Cells {};
+        uint64_t Order { 0 };
+        bool Alive { false };
+    };
+
+    static uint64_t Key(int32_t X, int32_t Y)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(X)) << 32) | static_cast<uint32_t>(Y);
+    }
+
+    // Cells are clamped to a range any coordinate converts to safely, infinities included.
+    // A NaN coordinate is put in cell 0.
+    int32_t ToCell(float Value) const
+    {
+        const double Cell { std::floor(static_cast<double>(Value) / m_CellSize) };
+
+        if (std::isnan(Cell))
+        {
+            return 0;
+        }
+
+        return static_cast<int32_t>(std::clamp(Cell, static_cast<double>(MinCell), static_cast<double>(MaxCell)));
+    }
+
+    CellRange ToCells(const Bounds& Box) const
+    {
+        return { ToCell(Box.MinX), ToCell(Box.MinY), ToCell(Box.MaxX), ToCell(Box.MaxY) };
+    }
+
+    void AddToCells(Handle ID, const CellRange& Cells)
+    {
+        if (Cells.Area() > MaxItemCells)
+        {
+            m_Oversized.push_back(ID);
+            return;
+        }
+
+        for (int32_t Y = Cells.MinY; Y <= Cells.MaxY; Y++)
+        {
+            for (int32_t X = Cells.MinX; X <= Cells.MaxX; X++)
+            {
+                m_Cells[Key(X, Y)].push_back(ID);
+            }
+        }
+    }
+
+    void RemoveFromCells(Handle ID, const CellRange& Cells)
+    {
+        if (Cells.Area() > MaxItemCells)
+        {
+            for (size_t I = 0; I < m_Oversized.size(); I++)
+            {
+                if (m_Oversized[I] == ID)
+                {
+                    m_Oversized[I] = m_Oversized.back();
+                    m_Oversized.pop_back();
+                    break;
+                }
+            }
+
+            return;
+        }
+
+        for (int32_t Y = Cells.MinY; Y <= Cells.MaxY; Y++)
+        {
+            for (int32_t X = Cells.MinX; X <= Cells.MaxX; X++)
+            {
+                const typename std::unordered_map<uint64_t, std::vector<Handle>>::iterator It { m_Cells.find(Key(X, Y)) };
+
+                if (It == m_Cells.end())
+                {
+                    continue;
+                }
+
+                std::vector<Handle>& Bucket { It->second };
+                for (size_t I = 0; I < Bucket.size(); I++)
+                {
+                    if (Bucket[I] == ID)
+                    {
+                        Bucket[I] = Bucket.back();
+                        Bucket.pop_back();
+                        break;
+                    }
+                }
+
+                if (Bucket.empty())
+                {
+                    m_Cells.erase(It);
+                }
+            }
+        }
+    }
+
+    uint32_t NextStamp() const
+    {
+        if (++m_Stamp == 0)
+        {
+            std::fill(m_Stamps.begin(), m_Stamps.end(), 0);
+            m_Stamp = 1;
+        }
+
+        return m_Stamp;
+    }
+
+    float m_CellSize { 256.0f };
+    std::vector<Item> m_Items {};
+    std::vector<Handle> m_Free {};
+    std::unordered_map<uint64_t, std::vector<Handle>> m_Cells {};
+    std::vector<Handle> m_Oversized {};
+    mutable std::vector<uint32_t> m_Stamps {};
+    mutable uint32_t m_Stamp { 0 };
+    uint64_t m_NextOrder { 0 };
+    size_t m_Count { 0 };
+};
+
+}
+}
@@ -0,0 +1,638 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Journal.h"
+#include "../Hash.h"
+#include "../Network/Protocol.h"
+#include "../Text/TextBuffer.h"
+#include "../Unicode.h"
+#include "MappedFile.h"
+#include "ProjectFile.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#if defined(_WIN32)
+    #include <fcntl.h>
+    #include <io.h>
+    #include <sys/stat.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace Snippet
+{
+namespace Common
+{
+
+static constexpr size_t FrameSize { 8 };
+
+static bool SetError(std::string* Error, const char* Message)
+{
+    if (Error != nullptr)
+    {
+        *Error = Message;
+    }
+
+    return false;
+}
+
+static uint32_t Checksum(const uint8_t* Data, size_t Size)
+{
+    return static_cast<uint32_t>(Hash(Data, Size));
+}
+
+// Appends the framed record to Out. Payload is scratch space for the unframed record.
+static void Encode(const JournalRecord& Record, Protocol::MessageWriter& Payload, Protocol::MessageWriter& Out)
+{
+    Payload
+        .Clear()
+        .U8(static_cast<uint8_t>(Record.Kind))
+        .U64(Record.Node);
+
+    switch (Record.Kind)
+    {
+    case JournalKind::Base:
+    {
+        Payload.String(Record.Text);
+    }
+    break;
+
+    case JournalKind::CreateNode:
+    {
+        Payload
+            .F32(Record.Position.X)
+            .F32(Record.Position.Y)
+            .String(Record.Text);
+    }
+    break;
+
+    case JournalKind::MoveNode:
+    {
+        Payload
+            .F32(Record.Position.X)
+            .F32(Record.Position.Y);
+    }
+    break;
+
+    case JournalKind::RenameNode:
+    {
+        Payload.String(Record.Text);
+    }
+    break;
+
+    case JournalKind::EditSource:
+    {
+        Payload
+            .U32(Record.Offset)
+            .U32(Record.Removed)
+            .String(Record.Text);
+    }
+    break;
+
+    case JournalKind::Connect:
+    case JournalKind::Disconnect:
+    {
+        Payload
+            .U32(Record.Port)
+            .U64(Record.Target)
+            .U32(Record.TargetPort);
+    }
+    break;
+
+    case JournalKind::DeleteNode:
+    default: break;
+    }
+
+    const std::vector<uint8_t>& Data { Payload.Buffer() };
+    Out
+        .U32(static_cast<uint32_t>(Data.size()))
+        .U32(Checksum(Data.data(), Data.size()))
+        .Bytes(Data.data(), Data.size());
+}
+
+static bool Decode(const uint8_t* Data, size_t Size, JournalRecord& Record)
+{
+    Protocol::PayloadReader Reader { Data, Size };
+
+    uint8_t Kind { 0 };
+    if (!Reader.U8(Kind) || Kind > static_cast<uint8_t>(JournalKind::Disconnect) || !Reader.U64(Record.Node))
+    {
+        return false;
+    }
+
+    Record.Kind = static_cast<JournalKind>(Kind);
+
+    switch (Record.Kind)
+    {
+    case JournalKind::Base: Reader.String(Record.Text); break;
+
+    case JournalKind::CreateNode: Reader.F32(Record.Position.X) && Reader.F32(Record.Position.Y) && Reader.String(Record.Text); break;
+    case JournalKind::MoveNode: Reader.F32(Record.Position.X) && Reader.F32(Record.Position.Y); break;
+    case JournalKind::RenameNode: Reader.String(Record.Text); break;
+    case JournalKind::EditSource: Reader.U32(Record.Offset) && Reader.U32(Record.Removed) && Reader.String(Record.Text); break;
+    case JournalKind::Connect:
+    case JournalKind::Disconnect: Reader.U32(Record.Port) && Reader.U64(Record.Target) && Reader.U32(Record.TargetPort); break;
+    case JournalKind::DeleteNode:
+    default: break;
+    }
+
+    return Reader.IsValid() && Reader.Remaining() == 0;
+}
+
+JournalRecord Journal::Edit(NodeID Node, std::string_view Before, std::string_view After)
+{
+    return Edit(Node, TextBuffer::Diff(Before, After));
+}
+
+JournalRecord Journal::Edit(NodeID Node, const TextBuffer::Splice& Splice)
+{
+    JournalRecord Result {};
+    Result.Kind = JournalKind::EditSource;
+    Result.Node = Node;
+    Result.Offset = static_cast<uint32_t>(Splice.Offset);
+    Result.Removed = static_cast<uint32_t>(Splice.Removed);
+    Result.Text = Splice.Inserted;
+    return Result;
+}
+
+JournalRecord Journal::Link(JournalKind Kind, const Graph& Model, ConnectionHandle ID)
+{
+    JournalRecord Result {};
+    Result.Kind = Kind;
+
+    const Graph::Connection* Connection { Model.GetConnection(ID) };
+    const Graph::Port* From { Connection != nullptr ? Model.GetPort(Connection->From) : nullptr };
+    const Graph::Port* To { Connection != nullptr ? Model.GetPort(Connection->To) : nullptr };
+
+    if (From == nullptr || To == nullptr)
+    {
+        return Result;
+    }
+
+    const std::vector<PortHandle>& Outputs { Model.GetPorts(From->Owner) };
+    const std::vector<PortHandle>& Inputs { Model.GetPorts(To->Owner) };
+    Result.Node = Model.GetID(From->Owner);
+    Result.Port = static_cast<uint32_t>(std::find(Outputs.begin(), Outputs.end(), Connection->From) - Outputs.begin());
+    Result.Target = Model.GetID(To->Owner);
+    Result.TargetPort = static_cast<uint32_t>(std::find(Inputs.begin(), Inputs.end(), Connection->To) - Inputs.begin());
+    return Result;
+}
+
+bool Journal::Read(const char* Path, const RecordSignature& Fn, size_t* Valid)
+{
+    if (Valid != nullptr)
+    {
+        *Valid = 0;
+    }
+
+    MappedFile File {};
+    if (!File.Open(Path))
+    {
+        return true;
+    }
+
+    const uint8_t* Data { File.Data() };
+    const size_t Size { File.Size() };
+    size_t Offset { 0 };
+    JournalRecord Record {};
+
+    while (Size - Offset >= FrameSize)
+    {
+        Protocol::PayloadReader Frame { Data + Offset, FrameSize };
+        uint32_t Length { 0 };
+        uint32_t Check { 0 };
+        Frame.U32(Length);
+        Frame.U32(Check);
+
+        const uint8_t* Payload { Data + Offset + FrameSize };
+        if (Size - Offset - FrameSize < Length
+            || Checksum(Payload, Length) != Check
+            || !Decode(Payload, Length, Record))
+        {
+            break;
+        }
+
+        if (Fn)
+        {
+            Fn(Record);
+        }
+
+        Offset += FrameSize + Length;
+    }
+
+    if (Valid != nullptr)
+    {
+        *Valid = Offset;
+    }
+
+    return Offset == Size;
+}
+
+bool Journal::Recover(const char* Path, Graph& Model, std::string* Error)
+{
+    // Edits are applied to a copy of each source, which is handed to the model once at
+    // the end, instead of rewriting and rehashing the model's source on every keystroke.
+    std::unordered_map<NodeID, std::string> Sources {};
+    bool Failed { false };
+
+    Read(Path, [&](const JournalRecord& Record) -> void
+        {
+            if (Failed)
+            {
+                return;
+            }
+
+            if (Record.Kind == JournalKind::Base)
+            {
+                Model.Clear();
+                Sources.clear();
+
+                if (Record.Text.empty())
+                {
+                    return;
+                }
+
+                ProjectFile Project {};
+                if (!Project.Open(std::string { Record.Text }.c_str(), Error))
+                {
+                    Failed = true;
+                    return;
+                }
+
+                Project.Load(Model, nullptr, true);
+                return;
+            }
+
+            if (Record.Kind == JournalKind::CreateNode)
+            {
+                const NodeHandle Handle { Model.AddSnippet(Record.Node) };
+                Model
+                    .SetPosition(Handle, Record.Position)
+                    .SetName(Handle, ToUTF32(Record.Text));
+                return;
+            }
+
+            const NodeHandle Handle { Model.Find(Record.Node) };
+            if (!Handle.IsValid())
+            {
+                return;
+            }
+
+            switch (Record.Kind)
+            {
+            case JournalKind::DeleteNode:
+            {
+                Model.RemoveNode(Handle);
+                Sources.erase(Record.Node);
+            }
+            break;
+
+            case JournalKind::MoveNode: Model.SetPosition(Handle, Record.Position); break;
+
+            case JournalKind::Connect:
+            case JournalKind::Disconnect:
+            {
+                const std::vector<PortHandle>& Outputs { Model.GetPorts(Handle) };
+                const std::vector<PortHandle>& Inputs { Model.GetPorts(Model.Find(Record.Target)) };
+                if (Record.Port >= Outputs.size() || Record.TargetPort >= Inputs.size())
+                {
+                    break;
+                }
+
+                const PortHandle From { Outputs[Record.Port] };
+                const PortHandle To { Inputs[Record.TargetPort] };
+                if (Record.Kind == JournalKind::Connect)
+                {
+                    Model.Connect(From, To);
+                    break;
+                }
+
+                for (ConnectionHandle ID : Model.GetPort(From)->Connections)
+                {
+                    if (Model.GetConnection(ID)->To == To)
+                    {
+                        Model.Disconnect(ID);
+                        break;
+                    }
+                }
+            }
+            break;
+            case JournalKind::RenameNode: Model.SetName(Handle, ToUTF32(Record.Text)); break;
+
+            case JournalKind::EditSource:
+            {
+                std::unordered_map<NodeID, std::string>::iterator Source { Sources.find(Record.Node) };
+                if (Source == Sources.end())
+                {
+                    Source = Sources.emplace(Record.Node, Model.GetSource(Handle)).first;
+                }
+
+                if (static_cast<size_t>(Record.Offset) + Record.Removed <= Source->second.size())
+                {
+                    Source->second.replace(Record.Offset, Record.Removed, Record.Text);
+                }
+            }
+            break;
+
+            default: break;
+            }
+        });
+
+    if (Failed)
+    {
+        Model.Clear();
+        return false;
+    }
+
+    for (const std::pair<const NodeID, std::string>& Source : Sources)
+    {
+        Model.SetSource(Model.Find(Source.first), Source.second);
+    }
+
+    return true;
+}
+
+Journal::Journal()
+{
+}
+
+Journal::~Journal()
+{
+    Close();
+}
+
+bool Journal::Open(const char* Path, std::string* Error)
+{
+    Close();
+
+    size_t Valid { 0 };
+    Read(Path, nullptr, &Valid);
+
+#if defined(_WIN32)
+    m_File = _open(Path, _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+    const bool Truncated { m_File >= 0 && _chsize_s(m_File, static_cast<__int64>(Valid)) == 0 };
+#else
+    m_File = ::open(Path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    const bool Truncated { m_File >= 0 && ::ftruncate(m_File, static_cast<off_t>(Valid)) == 0 };
+#endif
+
+    if (!Truncated)
+    {
+        Close();
+        return SetError(Error, "failed to open journal");
+    }
+
+    m_Size = Valid;
+    m_Stopping = false;
+    m_Thread = std::thread([this]() -> void
+        {
+            Run();
+        });
+
+    return true;
+}
+
+void Journal::Close()
+{
+    if (m_Thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> Lock { m_Mutex };
+            m_Stopping = true;
+        }
+
+        m_Condition.notify_all();
+        m_Thread.join();
+    }
+
+    if (m_File >= 0)
+    {
+#if defined(_WIN32)
+        _close(m_File);
+#else
+        ::close(m_File);
+#endif
+        m_File = -1;
+    }
+
+    m_Pending.Clear();
+    m_Size = 0;
+}
+
+bool Journal::IsOpen() const
+{
+    return m_File >= 0;
+}
+
+Journal& Journal::Append(const JournalRecord& Record)
+{
+    if (!IsOpen())
+    {
+        return *this;
+    }
+
+    bool Notify { false };
+    {
+        std::lock_guard<std::mutex> Lock { m_Mutex };
+        const size_t Start { m_Pending.Size() };
+        Encode(Record, m_Record, m_Pending);
+
+        Notify = Start == 0;
+        m_Size += m_Pending.Size() - Start;
+        m_Appended++;
+        m_Stats.Records++;
+        m_Stats.Bytes += m_Pending.Size() - Start;
+    }
+
+    if (Notify)
+    {
+        m_Condition.notify_one();
+    }
+
+    return *this;
+}
+
+Journal& Journal::Flush()
+{
+    if (!IsOpen())
+    {
+        return *this;
+    }
+
+    std::unique_lock<std::mutex> Lock { m_Mutex };
+    const uint64_t Target { m_Appended };
+
+    if (m_Durable < Target)
+    {
+        m_Flushing = true;
+        m_Condition.notify_one();
+        m_Synced.wait(Lock, [this, Target]() -> bool
+            {
+                return m_Durable >= Target;
+            });
+    }
+
+    return *this;
+}
+
+bool Journal::Rebase(std::string_view Snapshot, std::string* Error)
+{
+    if (!IsOpen())
+    {
+        return SetError(Error, "journal is not open");
+    }
+
+    Flush();
+
+    // The sync thread is idle once everything is durable, so the file can be rewritten
+    // here. Holding the lock keeps it that way until the base record is on disk.
+    std::unique_lock<std::mutex> Lock { m_Mutex };
+    m_Synced.wait(Lock, [this]() -> bool
+        {
+            return !m_Busy;
+        });
+
+    JournalRecord Base {};
+    Base.Kind = JournalKind::Base;
+    Base.Text = Snapshot;
+
+    Protocol::MessageWriter Buffer {};
+    Encode(Base, m_Record, Buffer);
+
+#if defined(_WIN32)
+    const bool Truncated { _chsize_s(m_File, 0) == 0 };
+#else
+    const bool Truncated { ::ftruncate(m_File, 0) == 0 };
+#endif
+
+    if (!Truncated || !Write(Buffer.Buffer().data(), Buffer.Size()) || !Sync())
+    {
+        m_Stats.Errors++;
+        return SetError(Error, "failed to rewrite journal");
+    }
+
+    // Records appended since the flush above still follow the new base.
+    m_Size = Buffer.Size() + m_Pending.Size();
+    m_Stats.Syncs++;
+    return true;
+}
+
+uint64_t Journal::Size() const
+{
+    std::lock_guard<std::mutex> Lock { m_Mutex };
+    return m_Size;
+}
+
+Journal::Stats Journal::GetStats() const
+{
+    std::lock_guard<std::mutex> Lock { m_Mutex };
+    return m_Stats;
+}
+
+bool Journal::Write(const uint8_t* Data, size_t Size)
+{
+    while (Size > 0)
+    {
+#if defined(_WIN32)
+        const int Written { _write(m_File, Data, static_cast<unsigned int>(std::min<size_t>(Size, 1u << 30))) };
+#else
+        const ssize_t Written { ::write(m_File, Data, Size) };
+#endif
+
+        if (Written <= 0)
+        {
+            return false;
+        }
+
+        Data += Written;
+        Size -= static_cast<size_t>(Written);
+    }
+
+    return true;
+}
+
+bool Journal::Sync()
+{
+#if defined(_WIN32)
+    return _commit(m_File) == 0;
+#elif defined(__APPLE__)
+    return ::fsync(m_File) == 0;
+#else
+    return ::fdatasync(m_File) == 0;
+#endif
+}
+
+void Journal::Run()
+{
+    std::unique_lock<std::mutex> Lock { m_Mutex };
+
+    while (true)
+    {
+        m_Condition.wait(Lock, [this]() -> bool
+            {
+                return m_Stopping || !m_Pending.Empty();
+            });
+
+        if (m_Pending.Empty())
+        {
+            break;
+        }
+
+        // Give the rest of a burst of edits a chance to arrive so that they share a sync.
+        m_Condition.wait_for(Lock, SyncInterval, [this]() -> bool
+            {
+                return m_Stopping || m_Flushing;
+            });
+
+        std::swap(m_Pending.Buffer(), m_Writing);
+        m_Pending.Clear();
+        const uint64_t Target { m_Appended };
+        m_Busy = true;
+        Lock.unlock();
+
+        const bool Written { Write(m_Writing.data(), m_Writing.size()) && Sync() };
+        m_Writing.clear();
+
+        Lock.lock();
+        m_Busy = false;
+        m_Durable = Target;
+        m_Flushing = m_Flushing && m_Durable < m_Appended;
+        m_Stats.Syncs++;
+
+        if (!Written)
+        {
+            m_Stats.Errors++;
+        }
+
+        m_Synced.notify_all();
+    }
+}
+
+}
+}
@@ -0,0 +1,167 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "../Graph/Graph.h"
+#include "../Network/Protocol.h"
+#include "../Text/TextBuffer.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace Snippet
+{
+namespace Common
+{
+
+enum class JournalKind : uint8_t
+{
+    Base,
+    CreateNode,
+    DeleteNode,
+    MoveNode,
+    RenameNode,
+    EditSource,
+    Connect,
+    Disconnect,
+};
+
+// Nodes are referred to by their ID, which the snapshot named by the Base record stores
+// and CreateNode records carry, so replay finds them again without any mapping of its own.
+// Connections name the output port of Node and the input port of Target by their index in
+// each node's port list.
+struct JournalRecord
+{
+    JournalKind Kind { JournalKind::Base };
+    NodeID Node { InvalidNodeID };
+    NodeID Target { InvalidNodeID };
+    uint32_t Port { 0 };
+    uint32_t TargetPort { 0 };
+    Point Position {};
+    uint32_t Offset { 0 };
+    uint32_t Removed { 0 };
+    std::string_view Text {};
+};
+
+//
+// Append-only edit journal. Every record is framed with its size and a checksum:
+//
+//     Size      u32 payload length
+//     Check     u32 low bits of the payload hash
+//     Payload   u8 kind, u64 node, then fields depending on the kind
+//
+// Append only serializes the record into memory. A background thread writes whatever has
+// accumulated and syncs it to disk in one go, waiting a short interval after the first
+// pending record so that bursts of edits share a single sync. A crash loses at most the
+// records of the current interval, and replay stops at the first torn or corrupt record.
+//
+
+class Journal
+{
+public:
+    using RecordSignature = std::function<void(const JournalRecord&)>;
+
+    struct Stats
+    {
+        uint64_t Records { 0 };
+        uint64_t Bytes { 0 };
+        uint64_t Syncs { 0 };
+        uint64_t Errors { 0 };
+    };
+
+    static constexpr std::chrono::milliseconds SyncInterval { 50 };
+
+    // Builds the smallest EditSource record that turns Before into After.
+    static JournalRecord Edit(NodeID Node, std::string_view Before, std::string_view After);
+    // Builds the EditSource record of a splice that is already known, pointing at the same
+    // inserted text.
+    static JournalRecord Edit(NodeID Node, const TextBuffer::Splice& Splice);
+
+    // Builds a Connect or Disconnect record for a connection in Model.
+    static JournalRecord Link(JournalKind Kind, const Graph& Model, ConnectionHandle ID);
+
+    // Calls Fn for every intact record in the journal at Path. Valid, if given, receives
+    // the length of the intact prefix. A missing journal has no records. Returns false if
+    // the journal ends in a torn or corrupt record.
+    static bool Read(const char* Path, const RecordSignature& Fn, size_t* Valid = nullptr);
+
+    // Loads the snapshot named by the journal's Base record into Model, with sources, and
+    // replays the records that follow on top of it.
+    static bool Recover(const char* Path, Graph& Model, std::string* Error = nullptr);
+
+    Journal();
+    ~Journal();
+
+    // Opens or creates the journal at Path for appending. A torn tail left by a crash is
+    // cut off so that new records follow the last intact one.
+    bool Open(const char* Path, std::string* Error = nullptr);
+    void Close();
+    bool IsOpen() const;
+
+    Journal& Append(const JournalRecord& Record);
+
+    // Blocks until every record appended so far is on disk.
+    Journal& Flush();
+
+    // Empties the journal and starts it over from the snapshot at Snapshot. Called after
+    // the snapshot has been saved.
+    bool Rebase(std::string_view Snapshot, std::string* Error = nullptr);
+
+    // Bytes in the journal since the last rebase, including those not yet synced.
+    uint64_t Size() const;
+    Stats GetStats() const;
+
+private:
+    bool Write(const uint8_t* Data, size_t Size);
+    bool Sync();
+    void Run();
+
+    int m_File { -1 };
+    std::thread m_Thread {};
+    mutable std::mutex m_Mutex {};
+    std::condition_variable m_Condition {};
+    std::condition_variable m_Synced {};
+    Protocol::MessageWriter m_Record {};
+    Protocol::MessageWriter m_Pending {};
+    std::vector<uint8_t> m_Writing {};
+    uint64_t m_Appended { 0 };
+    uint64_t m_Durable { 0 };
+    uint64_t m_Size { 0 };
+    bool m_Busy { false };
+    bool m_Flushing { false };
+    bool m_Stopping { false };
+    Stats m_Stats {};
+};
+
+}
+}
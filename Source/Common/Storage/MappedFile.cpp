@@ -0,0 +1,181 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "MappedFile.h"
+
+#include <utility>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace Snippet
+{
+namespace Common
+{
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::MappedFile(MappedFile&& Other)
+{
+    *this = std::move(Other);
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& Other)
+{
+    if (this != &Other)
+    {
+        Close();
+        std::swap(m_Data, Other.m_Data);
+        std::swap(m_Size, Other.m_Size);
+#if defined(_WIN32)
+        std::swap(m_File, Other.m_File);
+        std::swap(m_Mapping, Other.m_Mapping);
+#endif
+    }
+
+    return *this;
+}
+
+bool MappedFile::Open(const char* Path)
+{
+    Close();
+
+#if defined(_WIN32)
+    HANDLE File { CreateFileA(Path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+    if (File == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER Size {};
+    if (!GetFileSizeEx(File, &Size) || Size.QuadPart == 0)
+    {
+        CloseHandle(File);
+        return false;
+    }
+
+    HANDLE Mapping { CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr) };
+    if (Mapping == nullptr)
+    {
+        CloseHandle(File);
+        return false;
+    }
+
+    const void* Data { MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0) };
+    if (Data == nullptr)
+    {
+        CloseHandle(Mapping);
+        CloseHandle(File);
+        return false;
+    }
+
+    m_File = File;
+    m_Mapping = Mapping;
+    m_Data = static_cast<const uint8_t*>(Data);
+    m_Size = static_cast<size_t>(Size.QuadPart);
+#else
+    const int File { ::open(Path, O_RDONLY) };
+    if (File < 0)
+    {
+        return false;
+    }
+
+    struct stat Info {};
+    if (::fstat(File, &Info) != 0 || Info.st_size <= 0)
+    {
+        ::close(File);
+        return false;
+    }
+
+    void* Data { ::mmap(nullptr, static_cast<size_t>(Info.st_size), PROT_READ, MAP_PRIVATE, File, 0) };
+
+    // The mapping keeps its own reference to the file.
+    ::close(File);
+
+    if (Data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    m_Data = static_cast<const uint8_t*>(Data);
+    m_Size = static_cast<size_t>(Info.st_size);
+#endif
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_Data == nullptr)
+    {
+        return;
+    }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(m_Data);
+    CloseHandle(m_Mapping);
+    CloseHandle(m_File);
+    m_Mapping = nullptr;
+    m_File = nullptr;
+#else
+    ::munmap(const_cast<uint8_t*>(m_Data), m_Size);
+#endif
+
+    m_Data = nullptr;
+    m_Size = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+    return m_Data != nullptr;
+}
+
+const uint8_t* MappedFile::Data() const
+{
+    return m_Data;
+}
+
+size_t MappedFile::Size() const
+{
+    return m_Size;
+}
+
+}
+}
@@ -0,0 +1,71 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Snippet
+{
+namespace Common
+{
+
+//
+// Read-only memory mapping of a whole file. Pages are only read from disk when they are
+// first touched, so opening a large file costs the same as opening a small one.
+//
+
+class MappedFile
+{
+public:
+    MappedFile();
+    MappedFile(MappedFile&& Other);
+    MappedFile(const MappedFile&) = delete;
+    ~MappedFile();
+
+    MappedFile& operator=(MappedFile&& Other);
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const char* Path);
+    void Close();
+
+    bool IsOpen() const;
+    const uint8_t* Data() const;
+    size_t Size() const;
+
+private:
+    const uint8_t* m_Data { nullptr };
+    size_t m_Size { 0 };
+
+#if defined(_WIN32)
+    void* m_File { nullptr };
+    void* m_Mapping { nullptr };
+#endif
+};
+
+}
+}
@@ -0,0 +1,551 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "ProjectFile.h"
+#include "../Unicode.h"
+
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+namespace Snippet
+{
+namespace Common
+{
+
+static constexpr size_t HeaderSize { 64 };
+static constexpr size_t NodeSize { 56 };
+static constexpr size_t NodeSizeV1 { 48 };
+static constexpr size_t PortSize { 16 };
+static constexpr size_t ConnectionSize { 8 };
+static constexpr uint32_t InvalidIndex { ~0u };
+
+static uint32_t Load32(const uint8_t* Data)
+{
+    return static_cast<uint32_t>(Data[0])
+        | (static_cast<uint32_t>(Data[1]) << 8)
+        | (static_cast<uint32_t>(Data[2]) << 16)
+        | (static_cast<uint32_t>(Data[3]) << 24);
+}
+
+static uint64_t Load64(const uint8_t* Data)
+{
+    return static_cast<uint64_t>(Load32(Data)) | (static_cast<uint64_t>(Load32(Data + 4)) << 32);
+}
+
+static float LoadF32(const uint8_t* Data)
+{
+    const uint32_t Bits { Load32(Data) };
+    float Result { 0.0f };
+    std::memcpy(&Result, &Bits, sizeof(Result));
+    return Result;
+}
+
+static void Store32(uint8_t* Data, uint32_t Value)
+{
+    Data[0] = static_cast<uint8_t>(Value);
+    Data[1] = static_cast<uint8_t>(Value >> 8);
+    Data[2] = static_cast<uint8_t>(Value >> 16);
+    Data[3] = static_cast<uint8_t>(Value >> 24);
+}
+
+static void Store64(uint8_t* Data, uint64_t Value)
+{
+    Store32(Data, static_cast<uint32_t>(Value));
+    Store32(Data + 4, static_cast<uint32_t>(Value >> 32));
+}
+
+static void StoreF32(uint8_t* Data, float Value)
+{
+    uint32_t Bits { 0 };
+    std::memcpy(&Bits, &Value, sizeof(Bits));
+    Store32(Data, Bits);
+}
+
+static bool SetError(std::string* Error, const char* Message)
+{
+    if (Error != nullptr)
+    {
+        *Error = Message;
+    }
+
+    return false;
+}
+
+//
+// Writer
+//
+
+class Writer
+{
+public:
+    Writer(const char* Path)
+        : m_File(std::fopen(Path, "wb"))
+    {
+        if (m_File != nullptr)
+        {
+            std::setvbuf(m_File, nullptr, _IOFBF, 1 << 20);
+        }
+    }
+
+    ~Writer()
+    {
+        Close();
+    }
+
+    bool IsOpen() const
+    {
+        return m_File != nullptr;
+    }
+
+    bool IsValid() const
+    {
+        return m_File != nullptr && m_Valid;
+    }
+
+    Writer& Write(const void* Data, size_t Size)
+    {
+        if (m_Valid && Size > 0 && std::fwrite(Data, 1, Size, m_File) != Size)
+        {
+            m_Valid = false;
+        }
+
+        return *this;
+    }
+
+    // Overwrites the start of the file, leaving the write position at the end.
+    Writer& WriteHeader(const void* Data, size_t Size)
+    {
+        if (m_Valid && (std::fseek(m_File, 0, SEEK_SET) != 0 || std::fwrite(Data, 1, Size, m_File) != Size || std::fseek(m_File, 0, SEEK_END) != 0))
+        {
+            m_Valid = false;
+        }
+
+        return *this;
+    }
+
+    bool Close()
+    {
+        if (m_File != nullptr)
+        {
+            m_Valid = std::fclose(m_File) == 0 && m_Valid;
+            m_File = nullptr;
+        }
+
+        return m_Valid;
+    }
+
+private:
+    std::FILE* m_File { nullptr };
+    bool m_Valid { true };
+};
+
+//
+// ProjectFile
+//
+
+bool ProjectFile::Save(const Graph& Model, const char* Path, const SourceSignature& Source, std::string* Error)
+{
+    const auto GetSource = [&](NodeHandle ID, const Graph::Node& Node) -> std::string_view
+    {
+        return Source ? Source(ID) : std::string_view { Node.Source };
+    };
+
+    // First pass assigns every port a global index so connections can refer to them.
+    std::unordered_map<uint64_t, uint32_t> PortIndices {};
+    uint32_t PortCount { 0 };
+    Model.ForEachNode([&](NodeHandle, const Graph::Node& Node) -> void
+        {
+            for (PortHandle Port : Node.Ports)
+            {
+                PortIndices[Port.Key()] = PortCount++;
+            }
+        });
+
+    std::vector<std::pair<uint32_t, uint32_t>> Connections {};
+    Connections.reserve(Model.ConnectionCount());
+    Model.ForEachConnection([&](ConnectionHandle, const Graph::Connection& Connection) -> void
+        {
+            const std::unordered_map<uint64_t, uint32_t>::const_iterator From { PortIndices.find(Connection.From.Key()) };
+            const std::unordered_map<uint64_t, uint32_t>::const_iterator To { PortIndices.find(Connection.To.Key()) };
+
+            if (From != PortIndices.end() && To != PortIndices.end())
+            {
+                Connections.emplace_back(From->second, To->second);
+            }
+        });
+
+    const uint32_t NodeCount { static_cast<uint32_t>(Model.NodeCount()) };
+    const uint64_t NodeTable { HeaderSize };
+    const uint64_t PortTable { NodeTable + static_cast<uint64_t>(NodeCount) * NodeSize };
+    const uint64_t ConnectionTable { PortTable + static_cast<uint64_t>(PortCount) * PortSize };
+    const uint64_t StringTable { ConnectionTable + Connections.size() * ConnectionSize };
+
+    const std::string Temp { std::string { Path } + ".tmp" };
+    Writer File { Temp.c_str() };
+
+    if (!File.IsOpen())
+    {
+        return SetError(Error, "failed to create project file");
+    }
+
+    // Strings are written after every table, in the same order their offsets are handed
+    // out here, so the tables can be streamed without buffering the whole file.
+    uint64_t StringsSize { 0 };
+    const auto AddString = [&](size_t Length) -> uint64_t
+    {
+        const uint64_t Offset { StringsSize };
+        StringsSize += Length;
+        return Offset;
+    };
+
+    std::vector<std::string> Names {};
+    Names.reserve(NodeCount);
+
+    uint8_t Header[HeaderSize] {};
+    File.Write(Header, sizeof(Header));
+
+    uint32_t FirstPort { 0 };
+    Model.ForEachNode([&](NodeHandle ID, const Graph::Node& Node) -> void
+        {
+            Names.push_back(ToUTF8(Node.Name));
+            const std::string_view Code { GetSource(ID, Node) };
+
+            uint8_t Record[NodeSize] {};
+            StoreF32(Record + 0, Node.Position.X);
+            StoreF32(Record + 4, Node.Position.Y);
+            StoreF32(Record + 8, Node.Size.X);
+            StoreF32(Record + 12, Node.Size.Y);
+            Store64(Record + 16, AddString(Names.back().size()));
+            Store64(Record + 24, AddString(Code.size()));
+            Store32(Record + 32, static_cast<uint32_t>(Names.back().size()));
+            Store32(Record + 36, static_cast<uint32_t>(Code.size()));
+            Store32(Record + 40, FirstPort);
+            Store32(Record + 44, static_cast<uint32_t>(Node.Ports.size()));
+            Store64(Record + 48, Node.ID);
+            File.Write(Record, sizeof(Record));
+
+            FirstPort += static_cast<uint32_t>(Node.Ports.size());
+        });
+
+    Model.ForEachNode([&](NodeHandle, const Graph::Node& Node) -> void
+        {
+            for (PortHandle ID : Node.Ports)
+            {
+                const Graph::Port* Port { Model.GetPort(ID) };
+                const std::string_view Name { Port != nullptr ? std::string_view { Port->Name } : std::string_view {} };
+
+                uint8_t Record[PortSize] {};
+                Store64(Record + 0, AddString(Name.size()));
+                Store32(Record + 8, static_cast<uint32_t>(Name.size()));
+                Record[12] = static_cast<uint8_t>(Port != nullptr ? Port->Kind : PortKind::Input);
+                File.Write(Record, sizeof(Record));
+            }
+        });
+
+    for (const std::pair<uint32_t, uint32_t>& Connection : Connections)
+    {
+        uint8_t Record[ConnectionSize] {};
+        Store32(Record + 0, Connection.first);
+        Store32(Record + 4, Connection.second);
+        File.Write(Record, sizeof(Record));
+    }
+
+    uint32_t NodeIndex { 0 };
+    Model.ForEachNode([&](NodeHandle ID, const Graph::Node& Node) -> void
+        {
+            const std::string_view Code { GetSource(ID, Node) };
+            File
+                .Write(Names[NodeIndex].data(), Names[NodeIndex].size())
+                .Write(Code.data(), Code.size());
+            NodeIndex++;
+        });
+
+    Model.ForEachNode([&](NodeHandle, const Graph::Node& Node) -> void
+        {
+            for (PortHandle ID : Node.Ports)
+            {
+                if (const Graph::Port* Port = Model.GetPort(ID))
+                {
+                    File.Write(Port->Name.data(), Port->Name.size());
+                }
+            }
+        });
+
+    // The header goes in last so a file that was only partially written is never
+    // mistaken for a valid project.
+    Store32(Header + 0, Magic);
+    Store32(Header + 4, Version);
+    Store32(Header + 8, NodeCount);
+    Store32(Header + 12, PortCount);
+    Store32(Header + 16, static_cast<uint32_t>(Connections.size()));
+    Store64(Header + 24, NodeTable);
+    Store64(Header + 32, PortTable);
+    Store64(Header + 40, ConnectionTable);
+    Store64(Header + 48, StringTable);
+    Store64(Header + 56, StringsSize);
+
+    if (!File.WriteHeader(Header, sizeof(Header)).Close())
+    {
+        std::remove(Temp.c_str());
+        return SetError(Error, "failed to write project file");
+    }
+
+#if defined(_WIN32)
+    std::remove(Path);
+#endif
+
+    if (std::rename(Temp.c_str(), Path) != 0)
+    {
+        std::remove(Temp.c_str());
+        return SetError(Error, "failed to replace project file");
+    }
+
+    return true;
+}
+
+bool ProjectFile::Open(const char* Path, std::string* Error)
+{
+    Close();
+
+    if (!m_File.Open(Path))
+    {
+        return SetError(Error, "failed to open project file");
+    }
+
+    const uint8_t* Data { m_File.Data() };
+    const uint64_t Size { m_File.Size() };
+
+    if (Size < HeaderSize || Load32(Data) != Magic)
+    {
+        Close();
+        return SetError(Error, "not a project file");
+    }
+
+    const uint32_t FileVersion { Load32(Data + 4) };
+    if (FileVersion != Version && FileVersion != 1)
+    {
+        Close();
+        return SetError(Error, "unsupported project file version");
+    }
+
+    const size_t FileNodeSize { FileVersion == 1 ? NodeSizeV1 : NodeSize };
+
+    const uint32_t NodeCount { Load32(Data + 8) };
+    const uint32_t PortCount { Load32(Data + 12) };
+    const uint32_t ConnectionCount { Load32(Data + 16) };
+    const uint64_t NodeTable { Load64(Data + 24) };
+    const uint64_t PortTable { Load64(Data + 32) };
+    const uint64_t ConnectionTable { Load64(Data + 40) };
+    const uint64_t StringTable { Load64(Data + 48) };
+    const uint64_t StringsSize { Load64(Data + 56) };
+
+    const auto Fits = [Size](uint64_t Offset, uint64_t Count, uint64_t Stride) -> bool
+    {
+        return Offset <= Size && Count <= (Size - Offset) / Stride;
+    };
+
+    if (!Fits(NodeTable, NodeCount, FileNodeSize)
+        || !Fits(PortTable, PortCount, PortSize)
+        || !Fits(ConnectionTable, ConnectionCount, ConnectionSize)
+        || !Fits(StringTable, StringsSize, 1))
+    {
+        Close();
+        return SetError(Error, "project file is truncated");
+    }
+
+    m_NodeCount = NodeCount;
+    m_PortCount = PortCount;
+    m_ConnectionCount = ConnectionCount;
+    m_Nodes = Data + NodeTable;
+    m_NodeSize = FileNodeSize;
+    m_Ports = Data + PortTable;
+    m_Connections = Data + ConnectionTable;
+    m_Strings = Data + StringTable;
+    m_StringsSize = StringsSize;
+    return true;
+}
+
+void ProjectFile::Close()
+{
+    m_File.Close();
+    m_NodeCount = 0;
+    m_PortCount = 0;
+    m_ConnectionCount = 0;
+    m_Nodes = nullptr;
+    m_NodeSize = 0;
+    m_Ports = nullptr;
+    m_Connections = nullptr;
+    m_Strings = nullptr;
+    m_StringsSize = 0;
+}
+
+bool ProjectFile::IsOpen() const
+{
+    return m_File.IsOpen();
+}
+
+uint32_t ProjectFile::NodeCount() const
+{
+    return m_NodeCount;
+}
+
+uint32_t ProjectFile::PortCount() const
+{
+    return m_PortCount;
+}
+
+uint32_t ProjectFile::ConnectionCount() const
+{
+    return m_ConnectionCount;
+}
+
+ProjectFile::NodeView ProjectFile::GetNode(uint32_t Index) const
+{
+    NodeView Result {};
+
+    if (Index >= m_NodeCount)
+    {
+        return Result;
+    }
+
+    const uint8_t* Record { m_Nodes + static_cast<size_t>(Index) * m_NodeSize };
+    Result.Position = { LoadF32(Record + 0), LoadF32(Record + 4) };
+    Result.Size = { LoadF32(Record + 8), LoadF32(Record + 12) };
+    Result.Name = GetString(Load64(Record + 16), Load32(Record + 32));
+    Result.Source = GetString(Load64(Record + 24), Load32(Record + 36));
+    Result.FirstPort = Load32(Record + 40);
+    Result.PortCount = Load32(Record + 44);
+    Result.ID = m_NodeSize >= NodeSize ? Load64(Record + 48) : InvalidNodeID;
+
+    if (Result.FirstPort > m_PortCount || Result.PortCount > m_PortCount - Result.FirstPort)
+    {
+        Result.FirstPort = 0;
+        Result.PortCount = 0;
+    }
+
+    return Result;
+}
+
+ProjectFile::PortView ProjectFile::GetPort(uint32_t Index) const
+{
+    PortView Result {};
+
+    if (Index >= m_PortCount)
+    {
+        return Result;
+    }
+
+    const uint8_t* Record { m_Ports + static_cast<size_t>(Index) * PortSize };
+    Result.Name = GetString(Load64(Record + 0), Load32(Record + 8));
+    Result.Kind = Record[12] == static_cast<uint8_t>(PortKind::Output) ? PortKind::Output : PortKind::Input;
+    return Result;
+}
+
+ProjectFile::ConnectionView ProjectFile::GetConnection(uint32_t Index) const
+{
+    ConnectionView Result { InvalidIndex, InvalidIndex };
+
+    if (Index >= m_ConnectionCount)
+    {
+        return Result;
+    }
+
+    const uint8_t* Record { m_Connections + static_cast<size_t>(Index) * ConnectionSize };
+    Result.From = Load32(Record + 0);
+    Result.To = Load32(Record + 4);
+    return Result;
+}
+
+bool ProjectFile::Load(Graph& Model, std::vector<NodeHandle>* Handles, bool Sources) const
+{
+    if (!IsOpen())
+    {
+        return false;
+    }
+
+    std::vector<PortHandle> Ports(m_PortCount);
+    Model.Reserve(Model.NodeCount() + m_NodeCount);
+
+    if (Handles != nullptr)
+    {
+        Handles->resize(m_NodeCount);
+    }
+
+    for (uint32_t I = 0; I < m_NodeCount; I++)
+    {
+        const NodeView Node { GetNode(I) };
+        const NodeHandle ID { Model.AddNode(Node.ID) };
+
+        Model
+            .SetPosition(ID, Node.Position)
+            .SetSize(ID, Node.Size)
+            .SetName(ID, ToUTF32(Node.Name));
+
+        if (Sources && !Node.Source.empty())
+        {
+            Model.SetSource(ID, std::string { Node.Source });
+        }
+
+        for (uint32_t Port = Node.FirstPort; Port < Node.FirstPort + Node.PortCount; Port++)
+        {
+            const PortView View { GetPort(Port) };
+            Ports[Port] = Model.AddPort(ID, View.Kind, std::string { View.Name });
+        }
+
+        if (Handles != nullptr)
+        {
+            (*Handles)[I] = ID;
+        }
+    }
+
+    // Connections that refer to ports outside of the file are dropped. Graph::Connect
+    // rejects the rest of what a corrupt file could contain.
+    for (uint32_t I = 0; I < m_ConnectionCount; I++)
+    {
+        const ConnectionView Connection { GetConnection(I) };
+
+        if (Connection.From < m_PortCount && Connection.To < m_PortCount)
+        {
+            Model.Connect(Ports[Connection.From], Ports[Connection.To]);
+        }
+    }
+
+    return true;
+}
+
+std::string_view ProjectFile::GetString(uint64_t Offset, uint32_t Length) const
+{
+    if (Offset > m_StringsSize || Length > m_StringsSize - Offset)
+    {
+        return {};
+    }
+
+    return { reinterpret_cast<const char*>(m_Strings + Offset), Length };
+}
+
+}
+}
@@ -0,0 +1,127 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "../Graph/Graph.h"
+#include "MappedFile.h"
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Snippet
+{
+namespace Common
+{
+
+//
+// Binary project file. Everything is little-endian and laid out as fixed-size tables
+// followed by one string table, so any node can be read in constant time straight out of
+// a memory mapping without parsing the rest of the file:
+//
+//     Header      64 bytes: magic, version, table counts and offsets
+//     Nodes       56 bytes each: position, size, name and source, first port and count, ID
+//     Ports       16 bytes each: name and kind
+//     Connections  8 bytes each: global indices of the output and input ports
+//     Strings     UTF-8 names and sources referenced by offset and length
+//
+// Opening a project only validates the header and table bounds. String bounds are
+// checked when a record is read. Version 1 files, whose 48-byte node records have no ID,
+// are still read and their nodes get new IDs when loaded.
+//
+
+class ProjectFile
+{
+public:
+    static constexpr uint32_t Magic { 0x46504E53 };
+    static constexpr uint32_t Version { 2 };
+
+    struct NodeView
+    {
+        NodeID ID { InvalidNodeID };
+        Point Position {};
+        Point Size {};
+        std::string_view Name {};
+        std::string_view Source {};
+        uint32_t FirstPort { 0 };
+        uint32_t PortCount { 0 };
+    };
+
+    struct PortView
+    {
+        PortKind Kind { PortKind::Input };
+        std::string_view Name {};
+    };
+
+    struct ConnectionView
+    {
+        uint32_t From { 0 };
+        uint32_t To { 0 };
+    };
+
+    using SourceSignature = std::function<std::string_view(NodeHandle)>;
+
+    // Writes Model to a temporary file next to Path and renames it into place. Sources
+    // are read from Source when given, which lets a caller save nodes whose sources are
+    // still only in a previously opened project.
+    static bool Save(const Graph& Model, const char* Path, const SourceSignature& Source = nullptr, std::string* Error = nullptr);
+
+    bool Open(const char* Path, std::string* Error = nullptr);
+    void Close();
+    bool IsOpen() const;
+
+    uint32_t NodeCount() const;
+    uint32_t PortCount() const;
+    uint32_t ConnectionCount() const;
+
+    NodeView GetNode(uint32_t Index) const;
+    PortView GetPort(uint32_t Index) const;
+    ConnectionView GetConnection(uint32_t Index) const;
+
+    // Adds every node, port and connection to Model. Handles, if given, receives the
+    // handle created for each node index. With Sources false, node sources are left empty
+    // for the caller to fetch with GetNode when they are needed.
+    bool Load(Graph& Model, std::vector<NodeHandle>* Handles = nullptr, bool Sources = true) const;
+
+private:
+    std::string_view GetString(uint64_t Offset, uint32_t Length) const;
+
+    MappedFile m_File {};
+    uint32_t m_NodeCount { 0 };
+    uint32_t m_PortCount { 0 };
+    uint32_t m_ConnectionCount { 0 };
+    const uint8_t* m_Nodes { nullptr };
+    size_t m_NodeSize { 0 };
+    const uint8_t* m_Ports { nullptr };
+    const uint8_t* m_Connections { nullptr };
+    const uint8_t* m_Strings { nullptr };
+    uint64_t m_StringsSize { 0 };
+};
+
+}
+}
@@ -0,0 +1,352 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Highlighter.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace Snippet
+{
+namespace Common
+{
+
+// Lua reports errors as "<chunk>:<line>: <message>" with one-based lines.
+static Diagnostic Parse(const std::string& Message)
+{
+    Diagnostic Result {};
+    Result.Valid = true;
+    Result.Message = Message;
+
+    for (size_t Colon = Message.find(':'); Colon != std::string::npos; Colon = Message.find(':', Colon + 1))
+    {
+        char* End { nullptr };
+        const unsigned long Line { std::strtoul(Message.c_str() + Colon + 1, &End, 10) };
+
+        if (End != Message.c_str() + Colon + 1 && *End == ':' && Line > 0)
+        {
+            Result.Line = static_cast<size_t>(Line - 1);
+            Result.Message = Message.substr(static_cast<size_t>(End - Message.c_str()) + 1);
+            break;
+        }
+    }
+
+    return Result;
+}
+
+// Rewrites byte offsets within Content as code point offsets and returns its length in
+// code points.
+static uint32_t ToCharacters(std::string_view Content, std::vector<Token>& Tokens)
+{
+    const bool Ascii { std::none_of(Content.begin(), Content.end(), [](char Value) -> bool
+        {
+            return static_cast<unsigned char>(Value) >= 0x80;
+        }) };
+
+    if (Ascii)
+    {
+        return static_cast<uint32_t>(Content.size());
+    }
+
+    std::vector<uint32_t> Characters(Content.size() + 1, 0);
+    for (size_t I = 0; I < Content.size(); I++)
+    {
+        const bool Continuation { (static_cast<unsigned char>(Content[I]) & 0xC0) == 0x80 };
+        Characters[I + 1] = Characters[I] + (Continuation ? 0 : 1);
+    }
+
+    for (Token& Item : Tokens)
+    {
+        const uint32_t Start { Characters[Item.Start] };
+        Item.Length = Characters[Item.Start + Item.Length] - Start;
+        Item.Start = Start;
+    }
+
+    return Characters.back();
+}
+
+Highlighter::LineEdit Highlighter::Measure(const TextBuffer& Before, const TextBuffer::Splice& Edit)
+{
+    LineEdit Result {};
+    Result.First = Before.LineOf(Edit.Offset);
+    Result.Removed = Before.LineOf(Edit.Offset + Edit.Removed) - Result.First;
+    Result.Inserted = static_cast<size_t>(std::count(Edit.Inserted.begin(), Edit.Inserted.end(), '\n'));
+    return Result;
+}
+
+Highlighter::Highlighter()
+{
+    m_Thread = std::thread([this]() -> void
+        {
+            Run();
+        });
+}
+
+Highlighter::~Highlighter()
+{
+    {
+        std::lock_guard<std::mutex> Lock { m_Mutex };
+        m_Stopping = true;
+    }
+
+    m_Condition.notify_all();
+    m_Thread.join();
+}
+
+Highlighter& Highlighter::SetCheck(CheckSignature&& Fn)
+{
+    std::lock_guard<std::mutex> Lock { m_Mutex };
+    m_Check = std::move(Fn);
+    return *this;
+}
+
+Highlighter& Highlighter::SetOnResult(OnResultSignature&& Fn)
+{
+    std::lock_guard<std::mutex> Lock { m_Mutex };
+    m_OnResult = std::move(Fn);
+    return *this;
+}
+
+Highlighter& Highlighter::Reset(const TextBuffer& Text)
+{
+    {
+        std::lock_guard<std::mutex> Lock { m_Mutex };
+        m_Text = Text;
+        m_Edits.clear();
+        m_Reset = true;
+        m_Submitted++;
+    }
+
+    m_Condition.notify_one();
+    return *this;
+}
+
+Highlighter& Highlighter::Submit(const TextBuffer& Text, const LineEdit& Edit)
+{
+    {
+        std::lock_guard<std::mutex> Lock { m_Mutex };
+        m_Text = Text;
+        m_Submitted++;
+
+        // Everything is re-lexed after a reset anyway.
+        if (!m_Reset)
+        {
+            m_Edits.push_back(Edit);
+        }
+    }
+
+    m_Condition.notify_one();
+    return *this;
+}
+
+std::shared_ptr<const Highlight> Highlighter::Latest() const
+{
+    std::lock_guard<std::mutex> Lock { m_Mutex };
+    return m_Latest;
+}
+
+Highlighter& Highlighter::Wait()
+{
+    std::unique_lock<std::mutex> Lock { m_Mutex };
+    const uint64_t Target { m_Submitted };
+    m_Done.wait(Lock, [this, Target]() -> bool
+        {
+            return m_Finished >= Target;
+        });
+    return *this;
+}
+
+void Highlighter::Run()
+{
+    std::unique_lock<std::mutex> Lock { m_Mutex };
+
+    while (true)
+    {
+        m_Condition.wait(Lock, [this]() -> bool
+            {
+                return m_Stopping || m_Submitted > m_Finished;
+            });
+
+        if (m_Stopping)
+        {
+            break;
+        }
+
+        const TextBuffer Text { m_Text };
+        std::vector<LineEdit> Edits {};
+        Edits.swap(m_Edits);
+        const bool Reset { m_Reset };
+        const uint64_t Version { m_Submitted };
+        const CheckSignature Check { m_Check };
+        const OnResultSignature OnResult { m_OnResult };
+        Diagnostic Error { m_Latest != nullptr ? m_Latest->Error : Diagnostic {} };
+        m_Reset = false;
+        Lock.unlock();
+
+        // Replace the cached lines each edit covered with dirty ones. Anything that does not
+        // add up to the snapshot's line count is highlighted from scratch.
+        if (Reset)
+        {
+            m_Lines.assign(Text.LineCount(), Line {});
+        }
+        else
+        {
+            for (const LineEdit& Edit : Edits)
+            {
+                const size_t First { std::min(Edit.First, m_Lines.size()) };
+                const size_t Last { std::min(Edit.First + Edit.Removed + 1, m_Lines.size()) };
+                m_Lines.erase(m_Lines.begin() + static_cast<std::ptrdiff_t>(First), m_Lines.begin() + static_cast<std::ptrdiff_t>(Last));
+                m_Lines.insert(m_Lines.begin() + static_cast<std::ptrdiff_t>(First), Edit.Inserted + 1, Line {});
+            }
+        }
+
+        if (m_Lines.size() != Text.LineCount())
+        {
+            m_Lines.assign(Text.LineCount(), Line {});
+        }
+
+        const size_t Relexed { Relex(Text) };
+
+        // Compiling needs the whole text, so it waits until typing pauses. Until then the
+        // last known error is kept.
+        Lock.lock();
+        const bool Newer { m_Submitted > Version };
+        Lock.unlock();
+
+        if (!Newer && Check)
+        {
+            std::string Message {};
+            Error = Check(Text.ToString(), Message) ? Diagnostic {} : Parse(Message);
+        }
+
+        const std::shared_ptr<Highlight> Result { Build(Version, Error) };
+        Result->Relexed = Relexed;
+
+        if (OnResult)
+        {
+            OnResult(Result);
+        }
+
+        Lock.lock();
+        m_Latest = Result;
+        m_Finished = Version;
+        m_Done.notify_all();
+    }
+}
+
+size_t Highlighter::Relex(const TextBuffer& Text)
+{
+    size_t Result { 0 };
+    uint32_t State { LuaLexer::Normal };
+
+    for (size_t I = 0; I < m_Lines.size(); I++)
+    {
+        Line& Item { m_Lines[I] };
+
+        // A clean line only needs lexing again when the line before it now ends in a
+        // different state, such as when a long comment was opened above it.
+        if (Item.Dirty || Item.Start != State)
+        {
+            const std::string Content { Text.Line(I) };
+            Item.Tokens.clear();
+            Item.Start = State;
+            Item.End = LuaLexer::Lex(Content, State, Item.Tokens);
+            Item.Characters = ToCharacters(Content, Item.Tokens) + (I + 1 < m_Lines.size() ? 1 : 0);
+            Item.Dirty = false;
+            Result++;
+        }
+
+        State = Item.End;
+    }
+
+    return Result;
+}
+
+std::shared_ptr<Highlight> Highlighter::Build(uint64_t Version, const Diagnostic& Error) const
+{
+    const std::shared_ptr<Highlight> Result { std::make_shared<Highlight>() };
+    Result->Version = Version;
+    Result->Lines = m_Lines.size();
+    Result->Error = Error;
+
+    std::vector<HighlightSpan>& Spans { Result->Spans };
+    size_t Cursor { 0 };
+
+    const auto Add = [&Spans, &Cursor](size_t Start, size_t End, TokenKind Kind) -> void
+    {
+        if (End <= Start)
+        {
+            return;
+        }
+
+        if (Start > Cursor)
+        {
+            Spans.push_back({ Cursor, Start, TokenKind::Text });
+        }
+
+        if (!Spans.empty() && Spans.back().Kind == Kind && Spans.back().End == Start)
+        {
+            Spans.back().End = End;
+        }
+        else
+        {
+            Spans.push_back({ Start, End, Kind });
+        }
+
+        Cursor = End;
+    };
+
+    size_t Offset { 0 };
+    for (size_t I = 0; I < m_Lines.size(); I++)
+    {
+        const Line& Item { m_Lines[I] };
+
+        if (Error.Valid && Error.Line == I)
+        {
+            const size_t Newline { I + 1 < m_Lines.size() ? 1u : 0u };
+            Add(Offset, Offset + Item.Characters - Newline, TokenKind::Error);
+        }
+        else
+        {
+            for (const Token& Piece : Item.Tokens)
+            {
+                Add(Offset + Piece.Start, Offset + Piece.Start + Piece.Length, Piece.Kind);
+            }
+        }
+
+        Offset += Item.Characters;
+    }
+
+    if (Offset > Cursor)
+    {
+        Spans.push_back({ Cursor, Offset, TokenKind::Text });
+    }
+
+    return Result;
+}
+
+}
+}
@@ -0,0 +1,144 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "LuaLexer.h"
+#include "TextBuffer.h"
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Snippet
+{
+namespace Common
+{
+
+struct HighlightSpan
+{
+    size_t Start { 0 };
+    size_t End { 0 };
+    TokenKind Kind { TokenKind::Text };
+};
+
+struct Diagnostic
+{
+    bool Valid { false };
+    size_t Line { 0 };
+    std::string Message {};
+};
+
+// Spans are in code points, covering the whole text without gaps, so they can be handed
+// to an editor that indexes characters rather than bytes.
+struct Highlight
+{
+    uint64_t Version { 0 };
+    size_t Lines { 0 };
+    size_t Relexed { 0 };
+    std::vector<HighlightSpan> Spans {};
+    Diagnostic Error {};
+};
+
+//
+// Highlights a document on its own thread. The owner submits an immutable snapshot of
+// the text after every edit, along with which lines the edit replaced, and never waits.
+// The thread keeps the tokens and end state of every line from the previous pass, so it
+// only re-lexes edited lines and the lines after them whose start state changed. Edits
+// submitted while a pass is running are folded into the next one. Once there is nothing
+// newer to do, the whole text is also compiled to find the first syntax error.
+//
+
+class Highlighter
+{
+public:
+    // Returns false and sets Error to the compiler's message when Source does not compile.
+    using CheckSignature = std::function<bool(std::string_view Source, std::string& Error)>;
+    // Called on the highlighting thread.
+    using OnResultSignature = std::function<void(const std::shared_ptr<const Highlight>&)>;
+
+    struct LineEdit
+    {
+        size_t First { 0 };
+        size_t Removed { 0 };
+        size_t Inserted { 0 };
+    };
+
+    // Lines of Before replaced by applying Edit to it.
+    static LineEdit Measure(const TextBuffer& Before, const TextBuffer::Splice& Edit);
+
+    Highlighter();
+    ~Highlighter();
+
+    Highlighter& SetCheck(CheckSignature&& Fn);
+    Highlighter& SetOnResult(OnResultSignature&& Fn);
+
+    // Highlights Text from scratch.
+    Highlighter& Reset(const TextBuffer& Text);
+    // Text is the snapshot after the edit.
+    Highlighter& Submit(const TextBuffer& Text, const LineEdit& Edit);
+
+    std::shared_ptr<const Highlight> Latest() const;
+    // Blocks until everything submitted so far has been highlighted.
+    Highlighter& Wait();
+
+private:
+    struct Line
+    {
+        uint32_t Start { LuaLexer::Normal };
+        uint32_t End { LuaLexer::Normal };
+        uint32_t Characters { 0 };
+        bool Dirty { true };
+        std::vector<Token> Tokens {};
+    };
+
+    void Run();
+    size_t Relex(const TextBuffer& Text);
+    std::shared_ptr<Highlight> Build(uint64_t Version, const Diagnostic& Error) const;
+
+    std::vector<Line> m_Lines {};
+
+    CheckSignature m_Check { nullptr };
+    OnResultSignature m_OnResult { nullptr };
+    std::thread m_Thread {};
+    mutable std::mutex m_Mutex {};
+    std::condition_variable m_Condition {};
+    std::condition_variable m_Done {};
+    TextBuffer m_Text {};
+    std::vector<LineEdit> m_Edits {};
+    bool m_Reset { false };
+    bool m_Stopping { false };
+    uint64_t m_Submitted { 0 };
+    uint64_t m_Finished { 0 };
+    std::shared_ptr<const Highlight> m_Latest { nullptr };
+};
+
+}
+}
@@ -0,0 +1,274 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "LuaLexer.h"
+
+#include <algorithm>
+
+namespace Snippet
+{
+namespace Common
+{
+
+// A state other than Normal keeps what is open in the high bits and its detail, the
+// level of a long bracket or the quote of a string, in the low bits.
+static constexpr uint32_t LongString { 1u << 16 };
+static constexpr uint32_t LongComment { 2u << 16 };
+static constexpr uint32_t ShortString { 3u << 16 };
+static constexpr uint32_t KindMask { 0xFFFF0000u };
+static constexpr uint32_t DetailMask { 0x0000FFFFu };
+
+static bool IsKeyword(std::string_view Word)
+{
+    static constexpr std::string_view Keywords[] {
+        "and", "break", "do", "else", "elseif", "end", "false", "for", "function", "goto", "if",
+        "in", "local", "nil", "not", "or", "repeat", "return", "then", "true", "until", "while",
+    };
+
+    return std::find(std::begin(Keywords), std::end(Keywords), Word) != std::end(Keywords);
+}
+
+static bool IsIdentifierStart(char Value)
+{
+    return (Value >= 'a' && Value <= 'z') || (Value >= 'A' && Value <= 'Z') || Value == '_';
+}
+
+static bool IsDigit(char Value)
+{
+    return Value >= '0' && Value <= '9';
+}
+
+// Level of a long bracket opening at Offset, such as 0 for "[[" and 2 for "[==[", or -1.
+static int OpeningLevel(std::string_view Line, size_t Offset)
+{
+    if (Offset >= Line.size() || Line[Offset] != '[')
+    {
+        return -1;
+    }
+
+    size_t End { Offset + 1 };
+    while (End < Line.size() && Line[End] == '=')
+    {
+        End++;
+    }
+
+    return End < Line.size() && Line[End] == '[' ? static_cast<int>(End - Offset - 1) : -1;
+}
+
+// Offset just past the long bracket of Level closing at or after Offset, or npos.
+static size_t FindClosing(std::string_view Line, size_t Offset, uint32_t Level)
+{
+    while ((Offset = Line.find(']', Offset)) != std::string_view::npos)
+    {
+        size_t End { Offset + 1 };
+        while (End < Line.size() && Line[End] == '=')
+        {
+            End++;
+        }
+
+        if (End < Line.size() && Line[End] == ']' && End - Offset - 1 == Level)
+        {
+            return End + 1;
+        }
+
+        Offset++;
+    }
+
+    return std::string_view::npos;
+}
+
+// Offset just past the quote closing a string at or after Offset, or npos with Continued
+// set when a backslash carries the string onto the next line.
+static size_t FindQuote(std::string_view Line, size_t Offset, char Quote, bool& Continued)
+{
+    Continued = false;
+
+    while (Offset < Line.size())
+    {
+        if (Line[Offset] == '\\')
+        {
+            if (Offset + 1 == Line.size())
+            {
+                Continued = true;
+                return std::string_view::npos;
+            }
+
+            Offset += 2;
+            continue;
+        }
+
+        if (Line[Offset] == Quote)
+        {
+            return Offset + 1;
+        }
+
+        Offset++;
+    }
+
+    return std::string_view::npos;
+}
+
+static void Add(std::vector<Token>& Tokens, size_t Start, size_t End, TokenKind Kind)
+{
+    Tokens.push_back({ static_cast<uint32_t>(Start), static_cast<uint32_t>(End - Start), Kind });
+}
+
+uint32_t LuaLexer::Lex(std::string_view Line, uint32_t State, std::vector<Token>& Tokens)
+{
+    size_t Offset { 0 };
+
+    // Finish whatever the previous line left open.
+    if (State != Normal)
+    {
+        const uint32_t Detail { State & DetailMask };
+        size_t End { std::string_view::npos };
+        bool Continued { false };
+
+        if ((State & KindMask) == ShortString)
+        {
+            End = FindQuote(Line, 0, static_cast<char>(Detail), Continued);
+        }
+        else
+        {
+            End = FindClosing(Line, 0, Detail);
+        }
+
+        const TokenKind Kind { (State & KindMask) == LongComment ? TokenKind::Comment : TokenKind::String };
+        if (End == std::string_view::npos)
+        {
+            Add(Tokens, 0, Line.size(), Kind);
+            return (State & KindMask) == ShortString && !Continued ? Normal : State;
+        }
+
+        Add(Tokens, 0, End, Kind);
+        Offset = End;
+    }
+
+    while (Offset < Line.size())
+    {
+        const char Current { Line[Offset] };
+        const size_t Start { Offset };
+
+        if (Current == ' ' || Current == '\t' || Current == '\r')
+        {
+            Offset++;
+        }
+        else if (Current == '-' && Offset + 1 < Line.size() && Line[Offset + 1] == '-')
+        {
+            const int Level { OpeningLevel(Line, Offset + 2) };
+
+            if (Level < 0)
+            {
+                Add(Tokens, Start, Line.size(), TokenKind::Comment);
+                return Normal;
+            }
+
+            const size_t End { FindClosing(Line, Offset + 4 + static_cast<size_t>(Level), static_cast<uint32_t>(Level)) };
+            if (End == std::string_view::npos)
+            {
+                Add(Tokens, Start, Line.size(), TokenKind::Comment);
+                return LongComment | static_cast<uint32_t>(Level);
+            }
+
+            Add(Tokens, Start, End, TokenKind::Comment);
+            Offset = End;
+        }
+        else if (Current == '"' || Current == '\'')
+        {
+            bool Continued { false };
+            const size_t End { FindQuote(Line, Offset + 1, Current, Continued) };
+
+            if (End == std::string_view::npos)
+            {
+                Add(Tokens, Start, Line.size(), TokenKind::String);
+                return Continued ? ShortString | static_cast<uint32_t>(static_cast<unsigned char>(Current)) : Normal;
+            }
+
+            Add(Tokens, Start, End, TokenKind::String);
+            Offset = End;
+        }
+        else if (OpeningLevel(Line, Offset) >= 0)
+        {
+            const int Level { OpeningLevel(Line, Offset) };
+            const size_t End { FindClosing(Line, Offset + 2 + static_cast<size_t>(Level), static_cast<uint32_t>(Level)) };
+
+            if (End == std::string_view::npos)
+            {
+                Add(Tokens, Start, Line.size(), TokenKind::String);
+                return LongString | static_cast<uint32_t>(Level);
+            }
+
+            Add(Tokens, Start, End, TokenKind::String);
+            Offset = End;
+        }
+        else if (IsDigit(Current) || (Current == '.' && Offset + 1 < Line.size() && IsDigit(Line[Offset + 1])))
+        {
+            // Close enough for colouring: hex digits, fractions and signed exponents.
+            Offset++;
+            while (Offset < Line.size())
+            {
+                const char Next { Line[Offset] };
+                const bool Exponent { (Next == '+' || Next == '-') && (Line[Offset - 1] == 'e' || Line[Offset - 1] == 'E' || Line[Offset - 1] == 'p' || Line[Offset - 1] == 'P') };
+
+                if (!IsIdentifierStart(Next) && !IsDigit(Next) && Next != '.' && !Exponent)
+                {
+                    break;
+                }
+
+                Offset++;
+            }
+
+            Add(Tokens, Start, Offset, TokenKind::Number);
+        }
+        else if (IsIdentifierStart(Current))
+        {
+            while (Offset < Line.size() && (IsIdentifierStart(Line[Offset]) || IsDigit(Line[Offset])))
+            {
+                Offset++;
+            }
+
+            if (IsKeyword(Line.substr(Start, Offset - Start)))
+            {
+                Add(Tokens, Start, Offset, TokenKind::Keyword);
+            }
+        }
+        else if (static_cast<unsigned char>(Current) >= 0x80)
+        {
+            // Non-ASCII text outside of strings and comments is not Lua, but is left alone.
+            Offset++;
+        }
+        else
+        {
+            Offset++;
+            Add(Tokens, Start, Offset, TokenKind::Operator);
+        }
+    }
+
+    return Normal;
+}
+
+}
+}
@@ -0,0 +1,74 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace Snippet
+{
+namespace Common
+{
+
+enum class TokenKind : uint8_t
+{
+    Text,
+    Keyword,
+    Number,
+    String,
+    Comment,
+    Operator,
+    Error,
+};
+
+struct Token
+{
+    uint32_t Start { 0 };
+    uint32_t Length { 0 };
+    TokenKind Kind { TokenKind::Text };
+};
+
+//
+// Line-at-a-time Lua tokenizer. Long strings, long comments and strings continued with a
+// trailing backslash span lines, so each line starts in the state the previous one ended
+// in. States are small integers that callers cache per line: when a re-lexed line ends
+// in the same state as before, the lines after it are unaffected.
+//
+
+class LuaLexer
+{
+public:
+    static constexpr uint32_t Normal { 0 };
+
+    // Appends the tokens of Line, which excludes its newline, to Tokens and returns the
+    // state the next line starts in. Whitespace and identifiers produce no tokens.
+    static uint32_t Lex(std::string_view Line, uint32_t State, std::vector<Token>& Tokens);
+};
+
+}
+}
@@ -0,0 +1,481 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "TextBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <utility>
+
+namespace Snippet
+{
+namespace Common
+{
+
+struct TextBuffer::Node
+{
+    NodePtr Left { nullptr };
+    NodePtr Right { nullptr };
+    Piece Value {};
+    uint32_t Priority { 0 };
+    size_t Length { 0 };
+    size_t Lines { 0 };
+};
+
+//
+// TextBuffer::Tree
+//
+// Treap operations. None of them modify an existing node, they return new roots that
+// share every untouched subtree with the old ones.
+//
+
+struct TextBuffer::Tree
+{
+    static uint32_t Priority()
+    {
+        thread_local std::minstd_rand Random { std::random_device {}() };
+        return static_cast<uint32_t>(Random());
+    }
+
+    static size_t Length(const NodePtr& Root)
+    {
+        return Root != nullptr ? Root->Length : 0;
+    }
+
+    static size_t Lines(const NodePtr& Root)
+    {
+        return Root != nullptr ? Root->Lines : 0;
+    }
+
+    static size_t CountLines(const char* Data, size_t Length)
+    {
+        return static_cast<size_t>(std::count(Data, Data + Length, '\n'));
+    }
+
+    static Piece Slice(const Piece& Value, size_t Offset, size_t Length)
+    {
+        Piece Result { Value.Chunk, Value.Data + Offset, Length, 0 };
+        Result.Lines = CountLines(Result.Data, Result.Length);
+        return Result;
+    }
+
+    static NodePtr Make(const NodePtr& Left, const Piece& Value, const NodePtr& Right, uint32_t Priority_)
+    {
+        const std::shared_ptr<Node> Result { std::make_shared<Node>() };
+        Result->Left = Left;
+        Result->Right = Right;
+        Result->Value = Value;
+        Result->Priority = Priority_;
+        Result->Length = Length(Left) + Value.Length + Length(Right);
+        Result->Lines = Lines(Left) + Value.Lines + Lines(Right);
+        return Result;
+    }
+
+    static NodePtr Merge(const NodePtr& A, const NodePtr& B)
+    {
+        if (A == nullptr)
+        {
+            return B;
+        }
+
+        if (B == nullptr)
+        {
+            return A;
+        }
+
+        if (A->Priority > B->Priority)
+        {
+            return Make(A->Left, A->Value, Merge(A->Right, B), A->Priority);
+        }
+
+        return Make(Merge(A, B->Left), B->Value, B->Right, B->Priority);
+    }
+
+    // Splits Root into the first Offset bytes and the rest, cutting a piece in two when
+    // Offset falls inside it.
+    static std::pair<NodePtr, NodePtr> Split(const NodePtr& Root, size_t Offset)
+    {
+        if (Root == nullptr)
+        {
+            return { nullptr, nullptr };
+        }
+
+        const size_t Left { Length(Root->Left) };
+        const size_t End { Left + Root->Value.Length };
+
+        if (Offset <= Left)
+        {
+            std::pair<NodePtr, NodePtr> Parts { Split(Root->Left, Offset) };
+            return { Parts.first, Make(Parts.second, Root->Value, Root->Right, Root->Priority) };
+        }
+
+        if (Offset >= End)
+        {
+            std::pair<NodePtr, NodePtr> Parts { Split(Root->Right, Offset - End) };
+            return { Make(Root->Left, Root->Value, Parts.first, Root->Priority), Parts.second };
+        }
+
+        const size_t Cut { Offset - Left };
+        return {
+            Make(Root->Left, Slice(Root->Value, 0, Cut), nullptr, Root->Priority),
+            Make(nullptr, Slice(Root->Value, Cut, Root->Value.Length - Cut), Root->Right, Root->Priority)
+        };
+    }
+
+    static const Piece* Last(const NodePtr& Root)
+    {
+        const Node* Current { Root.get() };
+
+        while (Current != nullptr && Current->Right != nullptr)
+        {
+            Current = Current->Right.get();
+        }
+
+        return Current != nullptr ? &Current->Value : nullptr;
+    }
+
+    // Grows the last piece by Length bytes that directly follow it in its chunk.
+    static NodePtr Extend(const NodePtr& Root, size_t Length_, size_t Lines_)
+    {
+        if (Root->Right != nullptr)
+        {
+            return Make(Root->Left, Root->Value, Extend(Root->Right, Length_, Lines_), Root->Priority);
+        }
+
+        Piece Value { Root->Value };
+        Value.Length += Length_;
+        Value.Lines += Lines_;
+        return Make(Root->Left, Value, nullptr, Root->Priority);
+    }
+
+    static void Read(const Node* Root, size_t Offset, size_t Length_, const ReadSignature& Fn)
+    {
+        if (Root == nullptr || Length_ == 0)
+        {
+            return;
+        }
+
+        const size_t Left { Length(Root->Left) };
+        if (Offset < Left)
+        {
+            Read(Root->Left.get(), Offset, std::min(Length_, Left - Offset), Fn);
+        }
+
+        const size_t End { Left + Root->Value.Length };
+        if (Offset < End && Offset + Length_ > Left)
+        {
+            const size_t Start { Offset > Left ? Offset - Left : 0 };
+            const size_t Stop { std::min(Offset + Length_, End) - Left };
+            Fn({ Root->Value.Data + Start, Stop - Start });
+        }
+
+        if (Offset + Length_ > End)
+        {
+            const size_t Start { Offset > End ? Offset - End : 0 };
+            Read(Root->Right.get(), Start, Offset + Length_ - End - Start, Fn);
+        }
+    }
+};
+
+//
+// TextBuffer
+//
+
+TextBuffer::Splice TextBuffer::Diff(std::string_view Before, std::string_view After)
+{
+    // Typing touches one place at a time, so trimming the common prefix and suffix leaves
+    // just the characters that changed.
+    const size_t Shortest { std::min(Before.size(), After.size()) };
+
+    size_t Prefix { 0 };
+    while (Prefix < Shortest && Before[Prefix] == After[Prefix])
+    {
+        Prefix++;
+    }
+
+    size_t Suffix { 0 };
+    while (Suffix < Shortest - Prefix && Before[Before.size() - Suffix - 1] == After[After.size() - Suffix - 1])
+    {
+        Suffix++;
+    }
+
+    return { Prefix, Before.size() - Prefix - Suffix, After.substr(Prefix, After.size() - Prefix - Suffix) };
+}
+
+TextBuffer::TextBuffer()
+{
+}
+
+TextBuffer::TextBuffer(std::string_view Text)
+{
+    Insert(0, Text);
+}
+
+TextBuffer::TextBuffer(const TextBuffer& Other)
+    : m_Root(Other.m_Root)
+{
+}
+
+TextBuffer& TextBuffer::operator=(const TextBuffer& Other)
+{
+    // The chunk stays with the buffer it belongs to. Two buffers appending to the same
+    // chunk would overwrite each other's text.
+    m_Root = Other.m_Root;
+    m_Chunk = nullptr;
+    m_ChunkUsed = 0;
+    m_ChunkSize = 0;
+    return *this;
+}
+
+TextBuffer& TextBuffer::Assign(std::string_view Text)
+{
+    return Clear().Insert(0, Text);
+}
+
+TextBuffer& TextBuffer::Insert(size_t Offset, std::string_view Text)
+{
+    if (Text.empty())
+    {
+        return *this;
+    }
+
+    Offset = std::min(Offset, Size());
+    const char* Tail { m_Chunk != nullptr ? m_Chunk.get() + m_ChunkUsed : nullptr };
+
+    std::shared_ptr<const char[]> Chunk { nullptr };
+    const char* Data { Store(Text, Chunk) };
+
+    std::pair<NodePtr, NodePtr> Parts { Tree::Split(m_Root, Offset) };
+
+    // Consecutive keystrokes land next to each other in the chunk, so the piece the last
+    // one created can usually just be made longer.
+    const Piece* Previous { Tree::Last(Parts.first) };
+    if (Data == Tail && Previous != nullptr && Previous->Data + Previous->Length == Tail && Previous->Length + Text.size() <= MaxPiece)
+    {
+        Parts.first = Tree::Extend(Parts.first, Text.size(), Tree::CountLines(Data, Text.size()));
+    }
+    else
+    {
+        for (size_t Start = 0; Start < Text.size(); Start += MaxPiece)
+        {
+            const size_t Length { std::min(MaxPiece, Text.size() - Start) };
+            const Piece Value { Chunk, Data + Start, Length, Tree::CountLines(Data + Start, Length) };
+            Parts.first = Tree::Merge(Parts.first, Tree::Make(nullptr, Value, nullptr, Tree::Priority()));
+        }
+    }
+
+    m_Root = Tree::Merge(Parts.first, Parts.second);
+    return *this;
+}
+
+TextBuffer& TextBuffer::Erase(size_t Offset, size_t Length)
+{
+    if (Offset >= Size() || Length == 0)
+    {
+        return *this;
+    }
+
+    const std::pair<NodePtr, NodePtr> Head { Tree::Split(m_Root, Offset) };
+    const std::pair<NodePtr, NodePtr> Tail { Tree::Split(Head.second, Length) };
+    m_Root = Tree::Merge(Head.first, Tail.second);
+    return *this;
+}
+
+TextBuffer& TextBuffer::Replace(size_t Offset, size_t Length, std::string_view Text)
+{
+    return Erase(Offset, Length).Insert(Offset, Text);
+}
+
+TextBuffer& TextBuffer::Apply(const Splice& Edit)
+{
+    return Replace(Edit.Offset, Edit.Removed, Edit.Inserted);
+}
+
+TextBuffer& TextBuffer::Clear()
+{
+    m_Root = nullptr;
+    return *this;
+}
+
+TextBuffer TextBuffer::Snapshot() const
+{
+    return *this;
+}
+
+size_t TextBuffer::Size() const
+{
+    return Tree::Length(m_Root);
+}
+
+bool TextBuffer::Empty() const
+{
+    return Size() == 0;
+}
+
+size_t TextBuffer::LineCount() const
+{
+    return Tree::Lines(m_Root) + 1;
+}
+
+size_t TextBuffer::LineStart(size_t Line) const
+{
+    if (Line == 0)
+    {
+        return 0;
+    }
+
+    // Find the Line-th newline. The line starts just after it.
+    const Node* Current { m_Root.get() };
+    size_t Base { 0 };
+
+    while (Current != nullptr)
+    {
+        const size_t Left { Tree::Lines(Current->Left) };
+
+        if (Line <= Left)
+        {
+            Current = Current->Left.get();
+            continue;
+        }
+
+        Line -= Left;
+        Base += Tree::Length(Current->Left);
+
+        const Piece& Value { Current->Value };
+        if (Line <= Value.Lines)
+        {
+            const char* Position { Value.Data };
+
+            for (size_t I = 0; I < Line; I++)
+            {
+                Position = static_cast<const char*>(std::memchr(Position, '\n', static_cast<size_t>(Value.Data + Value.Length - Position))) + 1;
+            }
+
+            return Base + static_cast<size_t>(Position - Value.Data);
+        }
+
+        Line -= Value.Lines;
+        Base += Value.Length;
+        Current = Current->Right.get();
+    }
+
+    return Size();
+}
+
+size_t TextBuffer::LineOf(size_t Offset) const
+{
+    const Node* Current { m_Root.get() };
+    size_t Result { 0 };
+
+    while (Current != nullptr)
+    {
+        const size_t Left { Tree::Length(Current->Left) };
+
+        if (Offset < Left)
+        {
+            Current = Current->Left.get();
+            continue;
+        }
+
+        Offset -= Left;
+        Result += Tree::Lines(Current->Left);
+
+        const Piece& Value { Current->Value };
+        if (Offset < Value.Length)
+        {
+            return Result + Tree::CountLines(Value.Data, Offset);
+        }
+
+        Offset -= Value.Length;
+        Result += Value.Lines;
+        Current = Current->Right.get();
+    }
+
+    return Result;
+}
+
+void TextBuffer::Read(size_t Offset, size_t Length, const ReadSignature& Fn) const
+{
+    const size_t Total { Size() };
+
+    if (Offset >= Total)
+    {
+        return;
+    }
+
+    Tree::Read(m_Root.get(), Offset, std::min(Length, Total - Offset), Fn);
+}
+
+std::string TextBuffer::Substr(size_t Offset, size_t Length) const
+{
+    std::string Result {};
+    Result.reserve(std::min(Length, Size()));
+
+    Read(Offset, Length, [&Result](std::string_view Text) -> void
+        {
+            Result.append(Text);
+        });
+
+    return Result;
+}
+
+std::string TextBuffer::Line(size_t Line) const
+{
+    const size_t Start { LineStart(Line) };
+
+    if (Line + 1 >= LineCount())
+    {
+        return Substr(Start, Size() - Start);
+    }
+
+    // Leave off the newline that ends the line.
+    return Substr(Start, LineStart(Line + 1) - 1 - Start);
+}
+
+std::string TextBuffer::ToString() const
+{
+    return Substr(0, Size());
+}
+
+const char* TextBuffer::Store(std::string_view Text, std::shared_ptr<const char[]>& Chunk)
+{
+    if (m_Chunk == nullptr || m_ChunkSize - m_ChunkUsed < Text.size())
+    {
+        m_ChunkSize = std::max(ChunkSize, Text.size());
+        m_Chunk = std::shared_ptr<char[]>(new char[m_ChunkSize]);
+        m_ChunkUsed = 0;
+    }
+
+    char* Result { m_Chunk.get() + m_ChunkUsed };
+    std::memcpy(Result, Text.data(), Text.size());
+    m_ChunkUsed += Text.size();
+    Chunk = m_Chunk;
+    return Result;
+}
+
+}
+}
@@ -0,0 +1,129 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace Snippet
+{
+namespace Common
+{
+
+//
+// Piece table for editing large sources. The text is a sequence of pieces, each a slice
+// of an append-only chunk of memory, kept in a treap ordered by position. Every subtree
+// caches its length and newline count, so inserting, erasing and finding a line are all
+// O(log n) in the number of pieces, plus a scan of at most one piece.
+//
+// Tree nodes are immutable and shared. An edit copies only the path it touches, which
+// makes a snapshot just a copy of the root: it can be read on another thread while the
+// original keeps being edited. Offsets are in bytes of UTF-8.
+//
+
+class TextBuffer
+{
+public:
+    // Pieces are capped so that scanning one for a newline stays cheap.
+    static constexpr size_t MaxPiece { 4 * 1024 };
+    static constexpr size_t ChunkSize { 64 * 1024 };
+
+    struct Splice
+    {
+        size_t Offset { 0 };
+        size_t Removed { 0 };
+        std::string_view Inserted {};
+    };
+
+    using ReadSignature = std::function<void(std::string_view)>;
+
+    // The smallest splice that turns Before into After, found by trimming their common
+    // prefix and suffix. Inserted points into After.
+    static Splice Diff(std::string_view Before, std::string_view After);
+
+    TextBuffer();
+    TextBuffer(std::string_view Text);
+    TextBuffer(const TextBuffer& Other);
+    TextBuffer(TextBuffer&& Other) = default;
+
+    TextBuffer& operator=(const TextBuffer& Other);
+    TextBuffer& operator=(TextBuffer&& Other) = default;
+
+    TextBuffer& Assign(std::string_view Text);
+    TextBuffer& Insert(size_t Offset, std::string_view Text);
+    TextBuffer& Erase(size_t Offset, size_t Length);
+    TextBuffer& Replace(size_t Offset, size_t Length, std::string_view Text);
+    TextBuffer& Apply(const Splice& Edit);
+    TextBuffer& Clear();
+
+    // Shares all text with this buffer. Edits to either one afterwards are not seen by
+    // the other.
+    TextBuffer Snapshot() const;
+
+    size_t Size() const;
+    bool Empty() const;
+    size_t LineCount() const;
+
+    // Offset of the first character of Line, or Size() past the last line.
+    size_t LineStart(size_t Line) const;
+    // Zero-based line containing Offset.
+    size_t LineOf(size_t Offset) const;
+
+    // Calls Fn with each contiguous run of text in the range, in order, without copying.
+    void Read(size_t Offset, size_t Length, const ReadSignature& Fn) const;
+    std::string Substr(size_t Offset, size_t Length) const;
+    std::string Line(size_t Line) const;
+    std::string ToString() const;
+
+private:
+    struct Piece
+    {
+        std::shared_ptr<const char[]> Chunk { nullptr };
+        const char* Data { nullptr };
+        size_t Length { 0 };
+        size_t Lines { 0 };
+    };
+
+    struct Node;
+    struct Tree;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    const char* Store(std::string_view Text, std::shared_ptr<const char[]>& Chunk);
+
+    NodePtr m_Root { nullptr };
+    // Chunk that new text is appended to. Text already in a piece is never written again.
+    std::shared_ptr<char[]> m_Chunk { nullptr };
+    size_t m_ChunkUsed { 0 };
+    size_t m_ChunkSize { 0 };
+};
+
+}
+}
@@ -0,0 +1,119 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "TextOp.h"
+
+namespace Snippet
+{
+namespace Common
+{
+
+void TextOp::Transform(TextOp& First, TextOp& Second)
+{
+    const size_t FirstEnd { First.Offset + First.Removed };
+    const size_t SecondEnd { Second.Offset + Second.Removed };
+
+    // Two insertions at the same place. The first one's text goes first.
+    if (First.Removed == 0 && Second.Removed == 0 && First.Offset == Second.Offset)
+    {
+        Second.Offset += First.Inserted.size();
+        return;
+    }
+
+    // Ranges that only touch are kept apart, so an insertion at either end of a removal
+    // survives it.
+    if (FirstEnd <= Second.Offset)
+    {
+        Second.Offset = Second.Offset + First.Inserted.size() - First.Removed;
+        return;
+    }
+
+    if (SecondEnd <= First.Offset)
+    {
+        First.Offset = First.Offset + Second.Inserted.size() - Second.Removed;
+        return;
+    }
+
+    // The same range replaced twice keeps both insertions, the first one's text first.
+    if (First.Offset == Second.Offset && FirstEnd == SecondEnd)
+    {
+        First.Removed = 0;
+        Second.Offset += First.Inserted.size();
+        Second.Removed = 0;
+        return;
+    }
+
+    // A range inside the other's is removed by it, along with what was inserted there.
+    if (Second.Offset <= First.Offset && FirstEnd <= SecondEnd)
+    {
+        Second.Removed = Second.Removed - First.Removed + First.Inserted.size();
+        First = { Second.Offset, 0, {} };
+        return;
+    }
+
+    if (First.Offset <= Second.Offset && SecondEnd <= FirstEnd)
+    {
+        First.Removed = First.Removed - Second.Removed + Second.Inserted.size();
+        Second = { First.Offset, 0, {} };
+        return;
+    }
+
+    // Ranges that partly overlap. Each side removes only what the other left in place,
+    // and both insertions end up next to each other in the order of their ranges. Neither
+    // side takes on text of the other's, so edits transformed many times over stay small.
+    if (First.Offset < Second.Offset)
+    {
+        const size_t Overlap { FirstEnd - Second.Offset };
+        First.Removed -= Overlap;
+        Second.Offset = First.Offset + First.Inserted.size();
+        Second.Removed -= Overlap;
+        return;
+    }
+
+    const size_t Overlap { SecondEnd - First.Offset };
+    Second.Removed -= Overlap;
+    First.Offset = Second.Offset + Second.Inserted.size();
+    First.Removed -= Overlap;
+}
+
+bool TextOp::IsEmpty() const
+{
+    return Removed == 0 && Inserted.empty();
+}
+
+bool TextOp::Apply(std::string& Text) const
+{
+    if (Offset > Text.size() || Removed > Text.size() - Offset)
+    {
+        return false;
+    }
+
+    Text.replace(Offset, Removed, Inserted);
+    return true;
+}
+
+}
+}
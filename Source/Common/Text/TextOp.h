@@ -0,0 +1,65 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace Snippet
+{
+namespace Common
+{
+
+//
+// One edit of a text, as a splice of bytes: Removed bytes at Offset are replaced by
+// Inserted. Edits made concurrently on the same text by different people are brought
+// together with Transform, which is how a server that puts them in order lets every
+// copy of the text converge on the same result (operational transformation).
+//
+
+struct TextOp
+{
+    size_t Offset { 0 };
+    size_t Removed { 0 };
+    std::string Inserted {};
+
+    // Rewrites two edits made against the same text so that First applies after Second
+    // and Second after First, with the same result either way. First is the one ordered
+    // first, and its text goes first where the two touch the same place. A range that
+    // lies inside the other's is removed with it, insertion and all. Ranges that partly
+    // overlap are both removed, and both insertions take their place.
+    static void Transform(TextOp& First, TextOp& Second);
+
+    bool IsEmpty() const;
+
+    // Fails, leaving Text alone, if the splice does not fit inside it.
+    bool Apply(std::string& Text) const;
+};
+
+}
+}
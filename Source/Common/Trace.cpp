@@ -0,0 +1,245 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace Snippet
+{
+namespace Common
+{
+
+static const std::chrono::steady_clock::time_point Epoch { std::chrono::steady_clock::now() };
+
+// Small, stable per-thread numbers read better in a trace viewer than native thread IDs.
+static uint32_t ThreadNumber()
+{
+    static std::atomic<uint32_t> Next { 1 };
+    thread_local const uint32_t Number { Next.fetch_add(1, std::memory_order_relaxed) };
+    return Number;
+}
+
+static double Percentile(std::vector<double>& Samples, double Fraction)
+{
+    const size_t Index { std::min(Samples.size() - 1, static_cast<size_t>(Fraction * static_cast<double>(Samples.size()))) };
+    std::nth_element(Samples.begin(), Samples.begin() + static_cast<std::ptrdiff_t>(Index), Samples.end());
+    return Samples[Index];
+}
+
+static bool SetError(std::string* Error, const char* Message)
+{
+    if (Error != nullptr)
+    {
+        *Error = Message;
+    }
+
+    return false;
+}
+
+//
+// Trace
+//
+
+Trace& Trace::Get()
+{
+    static Trace Instance {};
+    return Instance;
+}
+
+uint64_t Trace::Now()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Epoch).count());
+}
+
+Trace::Trace()
+    : m_Slots(new Slot[Capacity])
+{
+}
+
+Trace& Trace::SetEnabled(bool Enabled)
+{
+    m_Enabled.store(Enabled, std::memory_order_relaxed);
+    return *this;
+}
+
+bool Trace::IsEnabled() const
+{
+    return m_Enabled.load(std::memory_order_relaxed);
+}
+
+void Trace::Record(const char* Name, uint64_t Start, uint64_t Duration)
+{
+    // An odd sequence marks the slot as being written, the following even one as holding
+    // sample Index. Readers compare it before and after copying.
+    const uint64_t Index { m_Head.fetch_add(1, std::memory_order_relaxed) };
+    Slot& Target { m_Slots[Index & (Capacity - 1)] };
+
+    Target.Sequence.store(Index * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    Target.Name.store(Name, std::memory_order_relaxed);
+    Target.Start.store(Start, std::memory_order_relaxed);
+    Target.Duration.store(Duration, std::memory_order_relaxed);
+    Target.Thread.store(ThreadNumber(), std::memory_order_relaxed);
+    Target.Sequence.store(Index * 2 + 2, std::memory_order_release);
+}
+
+std::vector<TraceSample> Trace::Samples(const char* Name) const
+{
+    const uint64_t Head { m_Head.load(std::memory_order_acquire) };
+    const uint64_t First { Head > Capacity ? Head - Capacity : 0 };
+
+    std::vector<TraceSample> Result {};
+    Result.reserve(static_cast<size_t>(Head - First));
+
+    for (uint64_t Index = First; Index < Head; Index++)
+    {
+        const Slot& Source { m_Slots[Index & (Capacity - 1)] };
+        const uint64_t Expected { Index * 2 + 2 };
+
+        if (Source.Sequence.load(std::memory_order_acquire) != Expected)
+        {
+            continue;
+        }
+
+        TraceSample Sample {};
+        Sample.Name = Source.Name.load(std::memory_order_relaxed);
+        Sample.Start = Source.Start.load(std::memory_order_relaxed);
+        Sample.Duration = Source.Duration.load(std::memory_order_relaxed);
+        Sample.Thread = Source.Thread.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (Source.Sequence.load(std::memory_order_relaxed) != Expected)
+        {
+            continue;
+        }
+
+        if (Name == nullptr || (Sample.Name != nullptr && std::strcmp(Sample.Name, Name) == 0))
+        {
+            Result.push_back(Sample);
+        }
+    }
+
+    return Result;
+}
+
+Trace::Summary Trace::Summarize(const char* Name) const
+{
+    const std::vector<TraceSample> Items { Samples(Name) };
+    Summary Result {};
+    Result.Count = Items.size();
+
+    if (Items.empty())
+    {
+        return Result;
+    }
+
+    std::vector<double> Durations {};
+    Durations.reserve(Items.size());
+    for (const TraceSample& Item : Items)
+    {
+        Durations.push_back(static_cast<double>(Item.Duration) / 1e6);
+    }
+
+    Result.Max = *std::max_element(Durations.begin(), Durations.end());
+    Result.P50 = Percentile(Durations, 0.50);
+    Result.P95 = Percentile(Durations, 0.95);
+    Result.P99 = Percentile(Durations, 0.99);
+    return Result;
+}
+
+bool Trace::WriteChromeTrace(const char* Path, std::string* Error) const
+{
+    std::FILE* File { std::fopen(Path, "wb") };
+
+    if (File == nullptr)
+    {
+        return SetError(Error, "failed to create trace file");
+    }
+
+    std::fputs("{\"traceEvents\":[", File);
+
+    bool First { true };
+    for (const TraceSample& Sample : Samples())
+    {
+        std::fprintf(File, "%s\n{\"name\":\"", First ? "" : ",");
+
+        // Names are literals from this code base, but are escaped all the same so a stray
+        // quote cannot break the file.
+        for (const char* Char = Sample.Name != nullptr ? Sample.Name : "?"; *Char != '\0'; Char++)
+        {
+            if (*Char == '"' || *Char == '\\')
+            {
+                std::fputc('\\', File);
+            }
+
+            std::fputc(*Char, File);
+        }
+
+        std::fprintf(File, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            Sample.Thread,
+            static_cast<double>(Sample.Start) / 1e3,
+            static_cast<double>(Sample.Duration) / 1e3);
+        First = false;
+    }
+
+    std::fputs("\n]}\n", File);
+
+    const bool Written { std::ferror(File) == 0 };
+    if (std::fclose(File) != 0 || !Written)
+    {
+        return SetError(Error, "failed to write trace file");
+    }
+
+    return true;
+}
+
+//
+// ScopedTimer
+//
+
+ScopedTimer::ScopedTimer(const char* Name)
+{
+    if (Trace::Get().IsEnabled())
+    {
+        m_Name = Name;
+        m_Start = Trace::Now();
+    }
+}
+
+ScopedTimer::~ScopedTimer()
+{
+    if (m_Name != nullptr)
+    {
+        Trace::Get().Record(m_Name, m_Start, Trace::Now() - m_Start);
+    }
+}
+
+}
+}
@@ -0,0 +1,130 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Snippet
+{
+namespace Common
+{
+
+struct TraceSample
+{
+    // Names are expected to be string literals; only the pointer is stored.
+    const char* Name { nullptr };
+    uint64_t Start { 0 };
+    uint64_t Duration { 0 };
+    uint32_t Thread { 0 };
+};
+
+//
+// Process-wide ring of timing samples. Recording is lock-free: a writer claims a slot by
+// bumping the head and publishes it with a per-slot sequence number, so any thread can
+// record while another reads. Readers skip slots that are mid-write or were overwritten
+// while being copied. Once full, the oldest samples are overwritten, and a writer lapped by
+// the whole ring can overwrite a newer sample with its older one. Nothing is recorded
+// until tracing is enabled, and a disabled ScopedTimer costs one atomic load.
+//
+
+class Trace
+{
+public:
+    static constexpr size_t Capacity { 1 << 16 };
+
+    struct Summary
+    {
+        size_t Count { 0 };
+        double P50 { 0.0 };
+        double P95 { 0.0 };
+        double P99 { 0.0 };
+        double Max { 0.0 };
+    };
+
+    static Trace& Get();
+
+    // Nanoseconds since the trace was created.
+    static uint64_t Now();
+
+    Trace& SetEnabled(bool Enabled);
+    bool IsEnabled() const;
+
+    void Record(const char* Name, uint64_t Start, uint64_t Duration);
+
+    // The samples still in the ring, oldest first. Name, if given, keeps only samples
+    // with that name.
+    std::vector<TraceSample> Samples(const char* Name = nullptr) const;
+
+    // Duration percentiles in milliseconds of the samples named Name still in the ring.
+    Summary Summarize(const char* Name) const;
+
+    // Writes the ring as complete events in the Chrome trace event format, which can be
+    // loaded by chrome://tracing or Perfetto.
+    bool WriteChromeTrace(const char* Path, std::string* Error = nullptr) const;
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> Sequence { 0 };
+        std::atomic<const char*> Name { nullptr };
+        std::atomic<uint64_t> Start { 0 };
+        std::atomic<uint64_t> Duration { 0 };
+        std::atomic<uint32_t> Thread { 0 };
+    };
+
+    Trace();
+
+    std::unique_ptr<Slot[]> m_Slots { nullptr };
+    std::atomic<uint64_t> m_Head { 0 };
+    std::atomic<bool> m_Enabled { false };
+};
+
+//
+// Records the time between its construction and destruction under Name.
+//
+
+class ScopedTimer
+{
+public:
+    ScopedTimer(const char* Name);
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    const char* m_Name { nullptr };
+    uint64_t m_Start { 0 };
+};
+
+}
+}
@@ -0,0 +1,158 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace Snippet
+{
+namespace Common
+{
+
+//
+// Minimal UTF-8 <-> UTF-32 conversion for node names, which the model stores as UTF-32
+// to match the GUI while the wire and Lua deal in UTF-8. Malformed input is replaced with
+// U+FFFD rather than rejected.
+//
+
+inline std::string ToUTF8(std::u32string_view Value)
+{
+    std::string Result {};
+    Result.reserve(Value.size());
+
+    for (char32_t Code : Value)
+    {
+        if (Code > 0x10FFFF || (Code >= 0xD800 && Code <= 0xDFFF))
+        {
+            Code = 0xFFFD;
+        }
+
+        if (Code < 0x80)
+        {
+            Result.push_back(static_cast<char>(Code));
+        }
+        else if (Code < 0x800)
+        {
+            Result.push_back(static_cast<char>(0xC0 | (Code >> 6)));
+            Result.push_back(static_cast<char>(0x80 | (Code & 0x3F)));
+        }
+        else if (Code < 0x10000)
+        {
+            Result.push_back(static_cast<char>(0xE0 | (Code >> 12)));
+            Result.push_back(static_cast<char>(0x80 | ((Code >> 6) & 0x3F)));
+            Result.push_back(static_cast<char>(0x80 | (Code & 0x3F)));
+        }
+        else
+        {
+            Result.push_back(static_cast<char>(0xF0 | (Code >> 18)));
+            Result.push_back(static_cast<char>(0x80 | ((Code >> 12) & 0x3F)));
+            Result.push_back(static_cast<char>(0x80 | ((Code >> 6) & 0x3F)));
+            Result.push_back(static_cast<char>(0x80 | (Code & 0x3F)));
+        }
+    }
+
+    return Result;
+}
+
+// Length in bytes of Value once converted with ToUTF8.
+inline size_t UTF8Length(std::u32string_view Value)
+{
+    size_t Result { 0 };
+
+    for (char32_t Code : Value)
+    {
+        if (Code > 0x10FFFF || (Code >= 0xD800 && Code <= 0xDFFF))
+        {
+            Result += 3;
+        }
+        else
+        {
+            Result += Code < 0x80 ? 1 : Code < 0x800 ? 2 : Code < 0x10000 ? 3 : 4;
+        }
+    }
+
+    return Result;
+}
+
+inline std::u32string ToUTF32(std::string_view Value)
+{
+    std::u32string Result {};
+    Result.reserve(Value.size());
+
+    size_t I { 0 };
+    while (I < Value.size())
+    {
+        const unsigned char Lead { static_cast<unsigned char>(Value[I]) };
+        size_t Length { 0 };
+        char32_t Code { 0 };
+
+        if (Lead < 0x80)
+        {
+            Length = 1;
+            Code = Lead;
+        }
+        else if ((Lead & 0xE0) == 0xC0)
+        {
+            Length = 2;
+            Code = Lead & 0x1F;
+        }
+        else if ((Lead & 0xF0) == 0xE0)
+        {
+            Length = 3;
+            Code = Lead & 0x0F;
+        }
+        else if ((Lead & 0xF8) == 0xF0)
+        {
+            Length = 4;
+            Code = Lead & 0x07;
+        }
+
+        bool Valid { Length > 0 && I + Length <= Value.size() };
+        for (size_t J = 1; Valid && J < Length; J++)
+        {
+            const unsigned char Next { static_cast<unsigned char>(Value[I + J]) };
+            Valid = (Next & 0xC0) == 0x80;
+            Code = (Code << 6) | (Next & 0x3F);
+        }
+
+        if (!Valid)
+        {
+            Result.push_back(0xFFFD);
+            I++;
+            continue;
+        }
+
+        Result.push_back(Code);
+        I += Length;
+    }
+
+    return Result;
+}
+
+}
+}
@@ -0,0 +1,384 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Batch.h"
+#include "../Common/Storage/ProjectFile.h"
+#include "../Common/Unicode.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+
+namespace Snippet
+{
+namespace Server
+{
+
+// Handed to the executor's callbacks, which may outlive the Batch when a run times out.
+struct Progress
+{
+    std::mutex Mutex {};
+    std::condition_variable Condition {};
+    bool Done { false };
+    Common::ExecutionReport Report {};
+    // Reports of nodes that have finished, for a run that never does.
+    std::vector<Common::NodeReport> Finished {};
+};
+
+static const char* ToString(Common::NodeStatus Status)
+{
+    switch (Status)
+    {
+    case Common::NodeStatus::Succeeded: return "succeeded";
+    case Common::NodeStatus::Failed: return "failed";
+    case Common::NodeStatus::Skipped: return "skipped";
+    case Common::NodeStatus::Pending:
+    default: break;
+    }
+
+    return "pending";
+}
+
+static const char* ToString(Batch::Status Status)
+{
+    switch (Status)
+    {
+    case Batch::Status::Succeeded: return "succeeded";
+    case Batch::Status::Failed: return "failed";
+    case Batch::Status::TimedOut: return "timed out";
+    case Batch::Status::Error:
+    default: break;
+    }
+
+    return "error";
+}
+
+static void WriteJsonString(std::FILE* File, const std::string& Value)
+{
+    std::fputc('"', File);
+
+    for (const char Char : Value)
+    {
+        if (Char == '"' || Char == '\\')
+        {
+            std::fprintf(File, "\\%c", Char);
+        }
+        else if (static_cast<unsigned char>(Char) < 0x20)
+        {
+            std::fprintf(File, "\\u%04x", static_cast<unsigned int>(Char));
+        }
+        else
+        {
+            std::fputc(Char, File);
+        }
+    }
+
+    std::fputc('"', File);
+}
+
+static std::string FormatID(Common::NodeID ID)
+{
+    char Result[17] {};
+    std::snprintf(Result, sizeof(Result), "%016llx", static_cast<unsigned long long>(ID));
+    return Result;
+}
+
+// Node names are free text. Anything but letters, digits, '-' and '_' is replaced so the
+// name can be part of a file name, and the node's ID keeps it unique.
+static std::string FileName(const std::string& Name, Common::NodeID ID)
+{
+    std::string Result {};
+
+    for (const char Char : Name)
+    {
+        const bool Safe { (Char >= 'a' && Char <= 'z') || (Char >= 'A' && Char <= 'Z') || (Char >= '0' && Char <= '9') || Char == '-' || Char == '_' };
+        Result += Safe ? Char : '_';
+    }
+
+    return (Result.empty() ? std::string { "Snippet" } : Result) + "-" + FormatID(ID) + ".txt";
+}
+
+Batch::Batch(const Options& Options_)
+    : m_Options(Options_)
+    , m_Pool(Options_.Jobs)
+    , m_Executor(m_Engine, m_Pool)
+{
+}
+
+Batch::Status Batch::Run()
+{
+    Common::ProjectFile Project {};
+    std::string Error {};
+
+    if (!Project.Open(m_Options.Project.c_str(), &Error) || !Project.Load(m_Graph))
+    {
+        std::fprintf(stderr, "Failed to load '%s': %s\n", m_Options.Project.c_str(), Error.empty() ? "invalid project" : Error.c_str());
+        return Status::Error;
+    }
+
+    // Sources have been copied into the graph.
+    Project.Close();
+
+    const std::shared_ptr<Progress> State { std::make_shared<Progress>() };
+
+    Common::Executor::OnCompleteSignature OnComplete { [State](Common::ExecutionReport&& Report) -> void
+        {
+            {
+                std::lock_guard<std::mutex> Lock { State->Mutex };
+                State->Report = std::move(Report);
+                State->Done = true;
+            }
+
+            State->Condition.notify_all();
+        } };
+
+    // Reports are only kept along the way for a run that may not finish.
+    const bool Limited { m_Options.Timeout > 0.0 };
+    Common::Executor::OnProgressSignature OnProgress { [State, Limited](const Common::NodeReport& Node) -> void
+        {
+            if (Limited && Node.Status != Common::NodeStatus::Pending)
+            {
+                std::lock_guard<std::mutex> Lock { State->Mutex };
+                State->Finished.push_back(Node);
+            }
+        } };
+
+    if (!m_Executor.Run(m_Graph, nullptr, 0, std::move(OnComplete), std::move(OnProgress), &Error))
+    {
+        std::fprintf(stderr, "Failed to run '%s': %s\n", m_Options.Project.c_str(), Error.c_str());
+        return Status::Error;
+    }
+
+    std::unique_lock<std::mutex> Lock { State->Mutex };
+    const auto IsDone { [State]() -> bool
+        {
+            return State->Done;
+        } };
+
+    if (Limited)
+    {
+        State->Condition.wait_for(Lock, std::chrono::duration<double>(m_Options.Timeout), IsDone);
+    }
+    else
+    {
+        State->Condition.wait(Lock, IsDone);
+    }
+
+    // Whatever finished in time is still written out.
+    if (!State->Done)
+    {
+        Common::ExecutionReport Partial {};
+        Partial.Valid = true;
+        Partial.Nodes = State->Finished;
+        Partial.Seconds = m_Options.Timeout;
+        Lock.unlock();
+
+        std::fprintf(stderr, "Timed out after %.3f s with %zu of %zu node(s) finished.\n", m_Options.Timeout, Partial.Nodes.size(), m_Graph.NodeCount());
+        WriteOutputs(Partial);
+        WriteReport(Partial, Status::TimedOut, false);
+        return Status::TimedOut;
+    }
+
+    const Common::ExecutionReport Report { std::move(State->Report) };
+    Lock.unlock();
+
+    if (!Report.Valid)
+    {
+        std::fprintf(stderr, "Failed to run '%s': %s\n", m_Options.Project.c_str(), Report.Error.c_str());
+        WriteReport(Report, Status::Error, true);
+        return Status::Error;
+    }
+
+    size_t Counts[4] {};
+    for (const Common::NodeReport& Node : Report.Nodes)
+    {
+        Counts[static_cast<size_t>(Node.Status)]++;
+    }
+
+    const size_t Failed { Counts[static_cast<size_t>(Common::NodeStatus::Failed)] };
+    const size_t Skipped { Counts[static_cast<size_t>(Common::NodeStatus::Skipped)] };
+    Status Result { Failed > 0 || Skipped > 0 ? Status::Failed : Status::Succeeded };
+
+    std::fprintf(stderr, "Ran %zu node(s) in %.3f s: %zu succeeded, %zu failed, %zu skipped. Critical path %.3f s.\n",
+        Report.Nodes.size(),
+        Report.Seconds,
+        Counts[static_cast<size_t>(Common::NodeStatus::Succeeded)],
+        Failed,
+        Skipped,
+        Report.CriticalPathSeconds);
+
+    if (!WriteOutputs(Report))
+    {
+        Result = Status::Error;
+    }
+
+    if (!WriteReport(Report, Result, true))
+    {
+        Result = Status::Error;
+    }
+
+    return Result;
+}
+
+bool Batch::WriteOutputs(const Common::ExecutionReport& Report) const
+{
+    const bool ToFiles { !m_Options.OutputDirectory.empty() };
+
+    if (ToFiles)
+    {
+        std::error_code Error {};
+        std::filesystem::create_directories(m_Options.OutputDirectory, Error);
+
+        if (Error)
+        {
+            std::fprintf(stderr, "Failed to create '%s': %s\n", m_Options.OutputDirectory.c_str(), Error.message().c_str());
+            return false;
+        }
+    }
+
+    bool Success { true };
+
+    for (const Common::NodeReport& Node : Report.Nodes)
+    {
+        const std::string Name { Common::ToUTF8(m_Graph.GetName(Node.Node)) };
+        const Common::NodeID ID { m_Graph.GetID(Node.Node) };
+
+        // Logs and errors always go to stderr, so stdout only ever has outputs on it.
+        if (!Node.Log.empty())
+        {
+            std::fprintf(stderr, "[%s] ", Name.c_str());
+            std::fwrite(Node.Log.data(), 1, Node.Log.size(), stderr);
+        }
+
+        if (Node.Status == Common::NodeStatus::Failed)
+        {
+            std::fprintf(stderr, "[%s] failed: %s\n", Name.c_str(), Node.Error.c_str());
+            continue;
+        }
+
+        if (Node.Status != Common::NodeStatus::Succeeded)
+        {
+            continue;
+        }
+
+        if (!ToFiles)
+        {
+            // Outputs can hold NUL bytes, which printf would stop at.
+            std::printf("== %s ==\n", Name.c_str());
+            std::fwrite(Node.Output.data(), 1, Node.Output.size(), stdout);
+            if (Node.Output.empty() || Node.Output.back() != '\n')
+            {
+                std::putchar('\n');
+            }
+
+            continue;
+        }
+
+        const std::string Path { (std::filesystem::path { m_Options.OutputDirectory } / FileName(Name, ID)).string() };
+        std::FILE* File { std::fopen(Path.c_str(), "wb") };
+
+        if (File == nullptr || std::fwrite(Node.Output.data(), 1, Node.Output.size(), File) != Node.Output.size())
+        {
+            std::fprintf(stderr, "Failed to write '%s'.\n", Path.c_str());
+            Success = false;
+        }
+
+        if (File != nullptr && std::fclose(File) != 0)
+        {
+            Success = false;
+        }
+    }
+
+    std::fflush(stdout);
+    return Success;
+}
+
+bool Batch::WriteReport(const Common::ExecutionReport& Report, Status Result, bool Complete) const
+{
+    if (m_Options.ReportPath.empty())
+    {
+        return true;
+    }
+
+    std::FILE* File { std::fopen(m_Options.ReportPath.c_str(), "wb") };
+
+    if (File == nullptr)
+    {
+        std::fprintf(stderr, "Failed to open '%s'.\n", m_Options.ReportPath.c_str());
+        return false;
+    }
+
+    std::fputs("{\n  \"project\": ", File);
+    WriteJsonString(File, m_Options.Project);
+    std::fputs(",\n  \"status\": ", File);
+    WriteJsonString(File, ToString(Result));
+    std::fprintf(File, ",\n  \"complete\": %s,\n  \"jobs\": %u,\n  \"seconds\": %.9g,\n  \"critical_path_seconds\": %.9g,\n  \"error\": ",
+        Complete ? "true" : "false",
+        m_Pool.Size(),
+        Report.Seconds,
+        Report.CriticalPathSeconds);
+    WriteJsonString(File, Report.Error);
+    std::fputs(",\n  \"nodes\": [", File);
+
+    for (size_t I = 0; I < Report.Nodes.size(); I++)
+    {
+        const Common::NodeReport& Node { Report.Nodes[I] };
+        std::fputs(I == 0 ? "\n    {\"id\": " : ",\n    {\"id\": ", File);
+        WriteJsonString(File, FormatID(m_Graph.GetID(Node.Node)));
+        std::fputs(", \"name\": ", File);
+        WriteJsonString(File, Common::ToUTF8(m_Graph.GetName(Node.Node)));
+        std::fputs(", \"status\": ", File);
+        WriteJsonString(File, ToString(Node.Status));
+        std::fprintf(File, ", \"start\": %.9g, \"seconds\": %.9g, \"output_bytes\": %zu, \"error\": ", Node.Start, Node.Seconds, Node.Output.size());
+        WriteJsonString(File, Node.Error);
+        std::fputc('}', File);
+    }
+
+    std::fputs("\n  ],\n  \"critical_path\": [", File);
+
+    for (size_t I = 0; I < Report.CriticalPath.size(); I++)
+    {
+        std::fputs(I == 0 ? "" : ", ", File);
+        WriteJsonString(File, FormatID(m_Graph.GetID(Report.CriticalPath[I])));
+    }
+
+    std::fputs("]\n}\n", File);
+
+    const bool Success { std::ferror(File) == 0 };
+    if (std::fclose(File) != 0 || !Success)
+    {
+        std::fprintf(stderr, "Failed to write '%s'.\n", m_Options.ReportPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+}
+}
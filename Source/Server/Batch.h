@@ -0,0 +1,92 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "../Common/Execution/Engine.h"
+#include "../Common/Execution/Executor.h"
+#include "../Common/Execution/ThreadPool.h"
+#include "../Common/Graph/Graph.h"
+
+#include <string>
+
+namespace Snippet
+{
+namespace Server
+{
+
+//
+// Runs the graph of a saved project once, without a GUI or any connections, for scripts,
+// cron jobs and CI. Every node's output is written to stdout, or to one file per node in
+// a directory, and the run can be given a time limit and summarized in a JSON report of
+// when each node ran and for how long.
+//
+
+class Batch
+{
+public:
+    // Process exit codes.
+    enum class Status : int
+    {
+        Succeeded = 0,
+        // A node failed, or was skipped because one it depends on did.
+        Failed = 1,
+        // The project could not be loaded or run, or the results could not be written.
+        Error = 2,
+        TimedOut = 3,
+    };
+
+    struct Options
+    {
+        std::string Project {};
+        // Threads to run nodes on. Zero is one per core.
+        unsigned int Jobs { 0 };
+        // In seconds. Zero waits for as long as the run takes.
+        double Timeout { 0.0 };
+        // Empty to write outputs to stdout.
+        std::string OutputDirectory {};
+        std::string ReportPath {};
+    };
+
+    Batch(const Options& Options_);
+
+    // Nodes still running when the time limit runs out can't be stopped. The caller is
+    // expected to exit without destroying the Batch, which would wait for them.
+    Status Run();
+
+private:
+    bool WriteOutputs(const Common::ExecutionReport& Report) const;
+    bool WriteReport(const Common::ExecutionReport& Report, Status Result, bool Complete) const;
+
+    Options m_Options {};
+    Common::Graph m_Graph {};
+    Common::Engine m_Engine {};
+    Common::ThreadPool m_Pool;
+    Common::Executor m_Executor;
+};
+
+}
+}
@@ -1,7 +1,208 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Batch.h"
+#include "Server.h"
+
+#include <csignal>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static Snippet::Server::Server* Instance { nullptr };
 
-int main(int, char**)
+// Server::Stop only sets a flag and wakes the reactors. The rest of the shutdown happens
+// on the main thread once Run notices.
+static void OnSignal(int)
 {
-    printf("Hello Snippet Server\n");
+    if (Instance != nullptr)
+    {
+        Instance->Stop();
+    }
+}
+
+static void PrintUsage()
+{
+    printf("Usage: SnippetServer [options]\n");
+    printf("       SnippetServer --run <project> [--jobs <count>] [--timeout <seconds>] [--output <dir>] [--report <path>]\n");
+    printf("    --host <address>    Address to listen on for TCP connections. Default is 0.0.0.0.\n");
+    printf("    --port <port>       Port to listen on for TCP connections. Default is 7340.\n");
+    printf("    --unix <path>       Also listen on a Unix domain socket at the given path.\n");
+    printf("    --threads <count>   Number of reactor threads. Default is 1.\n");
+    printf("    --jobs <count>      Number of graph execution threads. Default is one per core.\n");
+    printf("    --no-shared-memory  Do not offer shared memory to clients on this host.\n");
+    printf("    --cache-size <MB>   Memory kept for cached snippet results. Default is 256.\n");
+    printf("    --cache-dir <path>  Spill results evicted from memory to this directory.\n");
+    printf("    --cache-disk <MB>   Space the spill directory may use. Default is 1024.\n");
+    printf("\n");
+    printf("With --run, the project's graph is run once and the process exits instead of serving.\n");
+    printf("    --run <project>     Project file to run.\n");
+    printf("    --timeout <seconds> Stop waiting for the run after this long. Default is no limit.\n");
+    printf("    --output <dir>      Write each node's output to a file in this directory instead of stdout.\n");
+    printf("    --report <path>     Write a JSON report of the run's timings to this file.\n");
+    printf("Exits with 0 if every node succeeded, 1 if any failed, 2 on any other error and 3 on timeout.\n");
+}
+
+int main(int argc, char** argv)
+{
+    Snippet::Server::Server::Options Options;
+    Snippet::Server::Batch::Options BatchOptions;
+
+    for (int I = 1; I < argc; I++)
+    {
+        const char* Arg { argv[I] };
+        const char* Value { I + 1 < argc ? argv[I + 1] : nullptr };
+
+        if (std::strcmp(Arg, "--host") == 0 && Value != nullptr)
+        {
+            Options.Host = Value;
+            I++;
+        }
+        else if (std::strcmp(Arg, "--port") == 0 && Value != nullptr)
+        {
+            Options.Port = static_cast<uint16_t>(std::atoi(Value));
+            I++;
+        }
+        else if (std::strcmp(Arg, "--unix") == 0 && Value != nullptr)
+        {
+            Options.UnixPath = Value;
+            I++;
+        }
+        else if (std::strcmp(Arg, "--threads") == 0 && Value != nullptr)
+        {
+            Options.Threads = static_cast<unsigned int>(std::atoi(Value));
+            I++;
+        }
+        else if (std::strcmp(Arg, "--jobs") == 0 && Value != nullptr)
+        {
+            Options.Jobs = static_cast<unsigned int>(std::atoi(Value));
+            I++;
+        }
+        else if (std::strcmp(Arg, "--run") == 0 && Value != nullptr)
+        {
+            BatchOptions.Project = Value;
+            I++;
+        }
+        else if (std::strcmp(Arg, "--timeout") == 0 && Value != nullptr)
+        {
+            BatchOptions.Timeout = std::atof(Value);
+            I++;
+        }
+        else if (std::strcmp(Arg, "--output") == 0 && Value != nullptr)
+        {
+            BatchOptions.OutputDirectory = Value;
+            I++;
+        }
+        else if (std::strcmp(Arg, "--report") == 0 && Value != nullptr)
+        {
+            BatchOptions.ReportPath = Value;
+            I++;
+        }
+        else if (std::strcmp(Arg, "--no-shared-memory") == 0)
+        {
+            Options.SharedMemory = false;
+        }
+        else if (std::strcmp(Arg, "--cache-size") == 0 && Value != nullptr)
+        {
+            Options.Cache.MemoryBytes = static_cast<size_t>(std::strtoull(Value, nullptr, 10)) * 1024 * 1024;
+            I++;
+        }
+        else if (std::strcmp(Arg, "--cache-dir") == 0 && Value != nullptr)
+        {
+            Options.Cache.Directory = Value;
+            I++;
+        }
+        else if (std::strcmp(Arg, "--cache-disk") == 0 && Value != nullptr)
+        {
+            Options.Cache.DiskBytes = std::strtoull(Value, nullptr, 10) * 1024 * 1024;
+            I++;
+        }
+        else
+        {
+            PrintUsage();
+            return std::strcmp(Arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if (!BatchOptions.Project.empty())
+    {
+        BatchOptions.Jobs = Options.Jobs;
+        Snippet::Server::Batch Runner { BatchOptions };
+        const Snippet::Server::Batch::Status Result { Runner.Run() };
+
+        // Nodes still running after a timeout are left behind rather than waited for.
+        if (Result == Snippet::Server::Batch::Status::TimedOut)
+        {
+            std::fflush(stdout);
+            std::fflush(stderr);
+            std::_Exit(static_cast<int>(Result));
+        }
+
+        return static_cast<int>(Result);
+    }
+
+    if (!Snippet::Common::Socket::Initialize())
+    {
+        printf("Failed to initialize sockets.\n");
+        return 1;
+    }
+
+    Snippet::Server::Server Server { Options };
+    if (!Server.Start())
+    {
+        Snippet::Common::Socket::Shutdown();
+        return 1;
+    }
+
+    Instance = &Server;
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+
+    printf("Snippet Server listening on %s:%u", Options.Host.c_str(), Server.Port());
+    if (!Options.UnixPath.empty())
+    {
+        printf(" and %s", Options.UnixPath.c_str());
+    }
+    printf(" with %u thread(s).\n", Options.Threads);
+    fflush(stdout);
+
+    Server.Run();
+    Instance = nullptr;
+
+    const Snippet::Server::Server::Stats Stats { Server.GetStats() };
+    printf("Snippet Server stopped. Accepted %llu connection(s) and ran %llu execution(s).\n",
+        static_cast<unsigned long long>(Stats.Accepted),
+        static_cast<unsigned long long>(Stats.Executions));
+    printf("Result cache: %llu hit(s), %llu miss(es), %llu eviction(s), %llu spilled, %llu read back from disk.\n",
+        static_cast<unsigned long long>(Stats.Cache.Hits),
+        static_cast<unsigned long long>(Stats.Cache.Misses),
+        static_cast<unsigned long long>(Stats.Cache.Evictions),
+        static_cast<unsigned long long>(Stats.Cache.Spills),
+        static_cast<unsigned long long>(Stats.Cache.DiskHits));
+
+    Snippet::Common::Socket::Shutdown();
     return 0;
 }
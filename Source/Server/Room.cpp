@@ -0,0 +1,436 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Room.h"
+#include "../Common/Hash.h"
+#include "../Common/Unicode.h"
+#include "Session.h"
+
+#include <algorithm>
+
+namespace Snippet
+{
+namespace Server
+{
+
+Room::Room(const std::string& Name)
+    : m_Name(Name)
+{
+}
+
+const std::string& Room::Name() const
+{
+    return m_Name;
+}
+
+uint32_t Room::Join(const std::shared_ptr<Session>& Member_, uint32_t Sequence)
+{
+    std::lock_guard<std::mutex> Lock { m_Mutex };
+
+    const uint32_t ID { m_NextMember++ };
+    const uint16_t Site { FreeSite() };
+    m_Members.push_back({ Member_, ID, Site });
+
+    const Common::Graph& Graph { m_Workspace.GetGraph() };
+    Common::Protocol::Joined Reply {};
+    Reply.Member = ID;
+    Reply.Members = static_cast<uint32_t>(m_Members.size());
+    Reply.Site = Site;
+    Reply.Fresh = Graph.NodeCount() == 0;
+
+    // Written under the lock and delivered like any relayed edit, so nothing relayed
+    // after the snapshot can overtake it.
+    Common::Protocol::MessageWriter Frames {};
+    Frames.Write(Reply, Sequence);
+
+    Graph.ForEachNode([&](Common::NodeHandle, const Common::Graph::Node& Node) -> void
+        {
+            const std::string Name { Common::ToUTF8(Node.Name) };
+            Common::Protocol::GraphEdit Edit {};
+            Edit.Kind = Common::Protocol::EditKind::CreateNode;
+            Edit.Node = Node.ID;
+            Edit.X = Node.Position.X;
+            Edit.Y = Node.Position.Y;
+            Edit.Text = Name;
+            Frames.Write(Edit);
+        });
+
+    Graph.ForEachConnection([&](Common::ConnectionHandle, const Common::Graph::Connection& Item) -> void
+        {
+            const Common::Graph::Port* From { Graph.GetPort(Item.From) };
+            const Common::Graph::Port* To { Graph.GetPort(Item.To) };
+
+            if (From == nullptr || To == nullptr)
+            {
+                return;
+            }
+
+            Common::Protocol::GraphEdit Edit {};
+            Edit.Kind = Common::Protocol::EditKind::Connect;
+            Edit.Node = Graph.GetID(From->Owner);
+            Edit.Target = Graph.GetID(To->Owner);
+            Frames.Write(Edit);
+        });
+
+    // A source arrives as one insertion that brings the node to the room's revision.
+    Graph.ForEachNode([&](Common::NodeHandle, const Common::Graph::Node& Node) -> void
+        {
+            const std::unordered_map<Common::NodeID, Text>::const_iterator It { m_Texts.find(Node.ID) };
+
+            if (It == m_Texts.end())
+            {
+                return;
+            }
+
+            Common::Protocol::TextEdit Edit {};
+            Edit.Node = Node.ID;
+            Edit.Revision = It->second.Revision;
+            Edit.Inserted = Node.Source;
+            Frames.Write(Edit);
+        });
+
+    Member_->Deliver(Frames);
+    return ID;
+}
+
+bool Room::Leave(const Session& Member_)
+{
+    std::lock_guard<std::mutex> Lock { m_Mutex };
+
+    const uint32_t ID { Member_.GetMember() };
+    m_Members.erase(std::remove_if(m_Members.begin(), m_Members.end(), [ID](const Member& Item) -> bool
+        {
+            return Item.ID == ID || Item.Target.expired();
+        }), m_Members.end());
+
+    return m_Members.empty();
+}
+
+bool Room::Apply(const Session& Origin, const Common::Protocol::GraphEdit& Edit, uint32_t Sequence, std::string* Error)
+{
+    std::lock_guard<std::mutex> Lock { m_Mutex };
+
+    const uint32_t ID { Origin.GetMember() };
+
+    // Positions are quantized, relayed as offsets and handed to every member, so ones that
+    // do not fit the fixed point are turned away before any of that.
+    if (!Common::Protocol::IsValidPosition(Edit.X) || !Common::Protocol::IsValidPosition(Edit.Y))
+    {
+        if (Error != nullptr)
+        {
+            *Error = "node position out of range";
+        }
+
+        return false;
+    }
+
+    if (Edit.Kind == Common::Protocol::EditKind::MoveNode)
+    {
+        if (!m_Workspace.Find(Edit.Node).IsValid())
+        {
+            return false;
+        }
+
+        const bool First { m_Moves.empty() && m_MoveSequences.empty() };
+        m_Moves[Edit.Node] = { Common::Protocol::Quantize(Edit.X), Common::Protocol::Quantize(Edit.Y), ID };
+        m_MoveSequences[ID] = Sequence;
+        return First;
+    }
+
+    // Positions are kept in the same fixed point moves are sent in, so every member can
+    // follow the offsets in a MoveBatch from the position it was given.
+    Common::Protocol::GraphEdit Applied { Edit };
+    Applied.X = Common::Protocol::Dequantize(Common::Protocol::Quantize(Edit.X));
+    Applied.Y = Common::Protocol::Dequantize(Common::Protocol::Quantize(Edit.Y));
+
+    if (Edit.Kind == Common::Protocol::EditKind::Connect && IsConnected(Edit.Node, Edit.Target))
+    {
+        return false;
+    }
+
+    // Two members can only generate the same ID from sites chosen before they joined, as
+    // when both fill a fresh room at once. The second is told, and joins again to get the
+    // room's graph in place of its own.
+    if (Edit.Kind == Common::Protocol::EditKind::CreateNode && m_Workspace.Find(Edit.Node).IsValid())
+    {
+        if (Error != nullptr)
+        {
+            *Error = "node ID already in use in the room";
+        }
+
+        return false;
+    }
+
+    if (!m_Workspace.Apply(Applied))
+    {
+        return false;
+    }
+
+    if (Edit.Kind == Common::Protocol::EditKind::DeleteNode)
+    {
+        m_Texts.erase(Edit.Node);
+        m_Moves.erase(Edit.Node);
+    }
+
+    Common::Protocol::MessageWriter Frames {};
+    Common::Protocol::MessageWriter Echo {};
+    Frames.Write(Applied);
+    Echo.Write(Applied, Sequence);
+    Broadcast(Frames, ID, &Echo);
+    return false;
+}
+
+bool Room::Edit(const Session& Origin, const Common::Protocol::TextEdit& Edit, uint32_t Sequence, std::string* Error)
+{
+    std::lock_guard<std::mutex> Lock { m_Mutex };
+
+    const Common::NodeHandle Handle { m_Workspace.Find(Edit.Node) };
+
+    // The node was deleted by an edit ordered before this one, which the origin drops its
+    // pending edits for once it arrives.
+    if (!Handle.IsValid())
+    {
+        return true;
+    }
+
+    Text& State { m_Texts[Edit.Node] };
+    const uint32_t Oldest { State.Revision - static_cast<uint32_t>(State.History.size()) };
+
+    if (Edit.Revision > State.Revision || Edit.Revision < Oldest)
+    {
+        if (Error != nullptr)
+        {
+            *Error = "text edit made against a revision the room no longer has";
+        }
+
+        return false;
+    }
+
+    // Edits ordered since the one this was made against are applied first everywhere.
+    Common::TextOp Op { Edit.Offset, Edit.Removed, std::string { Edit.Inserted } };
+    for (size_t I = Edit.Revision - Oldest; I < State.History.size(); I++)
+    {
+        Common::TextOp Past { State.History[I] };
+        Common::TextOp::Transform(Past, Op);
+    }
+
+    std::string Source { m_Workspace.GetGraph().GetSource(Handle) };
+    if (!Op.Apply(Source))
+    {
+        if (Error != nullptr)
+        {
+            *Error = "text edit out of range";
+        }
+
+        return false;
+    }
+
+    Common::Protocol::SnippetSource Updated {};
+    Updated.Node = Edit.Node;
+    Updated.Hash = Common::Hash(Source);
+    Updated.Source = Source;
+    m_Workspace.SetSource(Updated);
+
+    State.Revision++;
+    State.History.push_back(Op);
+    if (State.History.size() > MaxHistory)
+    {
+        State.History.pop_front();
+    }
+
+    Common::Protocol::TextEdit Relayed {};
+    Relayed.Node = Edit.Node;
+    Relayed.Revision = State.Revision;
+    Relayed.Offset = static_cast<uint32_t>(Op.Offset);
+    Relayed.Removed = static_cast<uint32_t>(Op.Removed);
+    Relayed.Inserted = Op.Inserted;
+
+    Common::Protocol::TextEdit Ack {};
+    Ack.Node = Edit.Node;
+    Ack.Revision = State.Revision;
+
+    Common::Protocol::MessageWriter Frames {};
+    Common::Protocol::MessageWriter Echo {};
+    Frames.Write(Relayed);
+    Echo.Write(Ack, Sequence);
+    Broadcast(Frames, Origin.GetMember(), &Echo);
+    return true;
+}
+
+bool Room::Flush()
+{
+    std::lock_guard<std::mutex> Lock { m_Mutex };
+
+    if (m_Moves.empty() && m_MoveSequences.empty())
+    {
+        return false;
+    }
+
+    Common::Protocol::MoveBatch Batch {};
+    Batch.Groups.reserve(m_MoveSequences.size());
+
+    for (const std::pair<const uint32_t, uint32_t>& Item : m_MoveSequences)
+    {
+        Common::Protocol::MoveBatch::Group Group_ {};
+        Group_.Member = Item.first;
+        Group_.Sequence = Item.second;
+        Batch.Groups.push_back(std::move(Group_));
+    }
+
+    for (const std::pair<const Common::NodeID, Move>& Item : m_Moves)
+    {
+        const Common::NodeHandle Handle { m_Workspace.Find(Item.first) };
+        Common::Protocol::MoveBatch::Group* Target { nullptr };
+
+        for (Common::Protocol::MoveBatch::Group& Group_ : Batch.Groups)
+        {
+            if (Group_.Member == Item.second.Member)
+            {
+                Target = &Group_;
+                break;
+            }
+        }
+
+        if (!Handle.IsValid() || Target == nullptr)
+        {
+            continue;
+        }
+
+        const Common::Point Position { m_Workspace.GetGraph().GetPosition(Handle) };
+        const int32_t X { Common::Protocol::Quantize(Position.X) };
+        const int32_t Y { Common::Protocol::Quantize(Position.Y) };
+
+        if (X == Item.second.X && Y == Item.second.Y)
+        {
+            continue;
+        }
+
+        Target->Moves.push_back({ Item.first, static_cast<int64_t>(Item.second.X) - X, static_cast<int64_t>(Item.second.Y) - Y });
+
+        Common::Protocol::GraphEdit Moved {};
+        Moved.Kind = Common::Protocol::EditKind::MoveNode;
+        Moved.Node = Item.first;
+        Moved.X = Common::Protocol::Dequantize(Item.second.X);
+        Moved.Y = Common::Protocol::Dequantize(Item.second.Y);
+        m_Workspace.Apply(Moved);
+    }
+
+    // Sorted by node, so IDs from the same member, which are mostly consecutive, encode
+    // as small deltas.
+    for (Common::Protocol::MoveBatch::Group& Group_ : Batch.Groups)
+    {
+        std::sort(Group_.Moves.begin(), Group_.Moves.end(), [](const Common::Protocol::MoveBatch::Move& A, const Common::Protocol::MoveBatch::Move& B) -> bool
+            {
+                return A.Node < B.Node;
+            });
+    }
+
+    m_Moves.clear();
+    m_MoveSequences.clear();
+
+    Common::Protocol::MessageWriter Frames {};
+    Frames.Write(Batch);
+    Broadcast(Frames, 0, nullptr);
+    return true;
+}
+
+std::mutex& Room::Mutex()
+{
+    return m_Mutex;
+}
+
+Workspace& Room::GetWorkspace()
+{
+    return m_Workspace;
+}
+
+void Room::Broadcast(const Common::Protocol::MessageWriter& Frames, uint32_t Origin, const Common::Protocol::MessageWriter* Echo)
+{
+    for (const Member& Item : m_Members)
+    {
+        const std::shared_ptr<Session> Target { Item.Target.lock() };
+
+        if (Target != nullptr)
+        {
+            Target->Deliver(Item.ID == Origin && Echo != nullptr ? *Echo : Frames);
+        }
+    }
+}
+
+bool Room::IsConnected(Common::NodeID From, Common::NodeID To) const
+{
+    const Common::Graph& Graph { m_Workspace.GetGraph() };
+    const Common::NodeHandle Source { Graph.Find(From) };
+    const Common::NodeHandle Target { Graph.Find(To) };
+
+    if (Graph.GetNode(Source) == nullptr || Graph.GetNode(Target) == nullptr)
+    {
+        return false;
+    }
+
+    // Looked up by kind rather than position, so a node without the usual pair of ports
+    // is simply not connected.
+    for (Common::PortHandle Port : Graph.GetPorts(Source))
+    {
+        const Common::Graph::Port* Output { Graph.GetPort(Port) };
+
+        if (Output == nullptr || Output->Kind != Common::PortKind::Output)
+        {
+            continue;
+        }
+
+        for (Common::ConnectionHandle ID : Output->Connections)
+        {
+            const Common::Graph::Connection* Connection { Graph.GetConnection(ID) };
+            const Common::Graph::Port* Input { Connection != nullptr ? Graph.GetPort(Connection->To) : nullptr };
+
+            if (Input != nullptr && Input->Owner == Target)
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+uint16_t Room::FreeSite() const
+{
+    // A room never has anywhere near as many members as there are sites.
+    uint16_t Site { 1 };
+    while (std::any_of(m_Members.begin(), m_Members.end(), [Site](const Member& Item) -> bool
+        {
+            return Item.Site == Site;
+        }))
+    {
+        Site++;
+    }
+
+    return Site;
+}
+
+}
+}
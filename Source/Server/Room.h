@@ -0,0 +1,131 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "../Common/Network/Protocol.h"
+#include "../Common/Text/TextOp.h"
+#include "Workspace.h"
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Snippet
+{
+namespace Server
+{
+
+class Session;
+
+//
+// A graph shared by every session that joins the room by name. Edits from every member
+// are applied to the room's workspace in the order the room receives them and relayed to
+// all members in that same order, the one that made them included, so every copy of the
+// graph ends up the same.
+//
+// Structural edits are assignments and the last one in the room's order wins. A member
+// holds back relayed edits to anything it has changed itself until its own change comes
+// back, since those were ordered before it. Edits to a node that has since been deleted
+// are dropped. Sources are edited concurrently as splices, which are transformed against
+// the ones the room ordered since the revision they were made on.
+//
+// Moves are most of the traffic while anyone drags, so they are not relayed one by one.
+// The room keeps the latest position of each node moved since the last Flush, and Flush
+// sends them all to every member in one MoveBatch, encoded once.
+//
+
+class Room
+{
+public:
+    // Source edits kept per node. An edit made against an older revision is rejected.
+    static constexpr size_t MaxHistory { 1024 };
+
+    Room(const std::string& Name);
+
+    const std::string& Name() const;
+
+    // Adds Member and sends it the Joined reply, followed by the graph if there is one.
+    uint32_t Join(const std::shared_ptr<Session>& Member, uint32_t Sequence);
+    // Returns true when the room has no members left.
+    bool Leave(const Session& Member);
+
+    // Returns true when Edit is the first move held for the next Flush. Error is set when
+    // the edit is rejected rather than dropped, as one with a position out of range or a
+    // node created with an ID already in use in the room is.
+    bool Apply(const Session& Origin, const Common::Protocol::GraphEdit& Edit, uint32_t Sequence, std::string* Error = nullptr);
+    bool Edit(const Session& Origin, const Common::Protocol::TextEdit& Edit, uint32_t Sequence, std::string* Error = nullptr);
+    // Sends the moves held since the last call. Returns false if there were none.
+    bool Flush();
+
+    // The workspace is shared with runs started by any member, and is only touched while
+    // holding the room's mutex.
+    std::mutex& Mutex();
+    Workspace& GetWorkspace();
+
+private:
+    struct Member
+    {
+        std::weak_ptr<Session> Target {};
+        uint32_t ID { 0 };
+        uint16_t Site { 0 };
+    };
+
+    struct Text
+    {
+        uint32_t Revision { 0 };
+        std::deque<Common::TextOp> History {};
+    };
+
+    struct Move
+    {
+        int32_t X { 0 };
+        int32_t Y { 0 };
+        uint32_t Member { 0 };
+    };
+
+    // Sends Frames to every member but Origin, which gets Echo instead when given.
+    void Broadcast(const Common::Protocol::MessageWriter& Frames, uint32_t Origin, const Common::Protocol::MessageWriter* Echo);
+    bool IsConnected(Common::NodeID From, Common::NodeID To) const;
+    // The lowest site no member holds.
+    uint16_t FreeSite() const;
+
+    std::string m_Name {};
+    std::mutex m_Mutex {};
+    Workspace m_Workspace {};
+    std::vector<Member> m_Members {};
+    uint32_t m_NextMember { 1 };
+    std::unordered_map<Common::NodeID, Text> m_Texts {};
+    std::unordered_map<Common::NodeID, Move> m_Moves {};
+    // The sequence of the last move each member made since the last flush.
+    std::unordered_map<uint32_t, uint32_t> m_MoveSequences {};
+};
+
+}
+}
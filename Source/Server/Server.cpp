@@ -0,0 +1,727 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Server.h"
+
+#include <cstdio>
+#include <mutex>
+
+namespace Snippet
+{
+namespace Server
+{
+
+//
+// ResultStream
+//
+// Node reports of a run waiting to be written to its session. Pool threads append to it
+// and only post a drain to the session's reactor when there was none pending, so a burst
+// of finished nodes costs one post rather than one each.
+//
+
+struct ResultStream
+{
+    struct Update
+    {
+        Common::NodeHandle Node {};
+        Common::Protocol::ResultStatus Status { Common::Protocol::ResultStatus::Running };
+        double Seconds { 0.0 };
+        std::string Output {};
+        std::string Log {};
+    };
+
+    std::mutex Mutex {};
+    std::vector<Update> Pending {};
+    bool Posted { false };
+};
+
+static Common::Protocol::ResultStatus ToStatus(Common::NodeStatus Status)
+{
+    switch (Status)
+    {
+    case Common::NodeStatus::Pending: return Common::Protocol::ResultStatus::Running;
+    case Common::NodeStatus::Succeeded: return Common::Protocol::ResultStatus::Success;
+    case Common::NodeStatus::Failed: return Common::Protocol::ResultStatus::Failed;
+    case Common::NodeStatus::Skipped:
+    default: break;
+    }
+
+    return Common::Protocol::ResultStatus::Cancelled;
+}
+
+//
+// RunWorkspace
+//
+// The workspace a run was started on, held for as long as this is in scope. Members of a
+// room run the room's workspace, which is edited from other reactors as well, so it is
+// locked. A session's own workspace is only touched on its reactor.
+//
+
+struct RunWorkspace
+{
+    RunWorkspace(Session& Owner, const std::shared_ptr<Room>& Shared)
+        : RunWorkspace(&Owner, Shared)
+    {
+    }
+
+    // Owner may only be null when Shared is not.
+    RunWorkspace(Session* Owner, const std::shared_ptr<Room>& Shared)
+        : Lock(Shared != nullptr ? std::unique_lock<std::mutex> { Shared->Mutex() } : std::unique_lock<std::mutex> {})
+        , Target(Shared != nullptr ? Shared->GetWorkspace() : Owner->GetWorkspace())
+    {
+    }
+
+    std::unique_lock<std::mutex> Lock;
+    Workspace& Target;
+};
+
+// Writes every pending update. Only called while holding the workspace the run was
+// started on, so nodes deleted since the run started are dropped.
+static void Drain(ResultStream& Stream, const Workspace& Workspace_, Common::Protocol::MessageWriter& Output, uint32_t Sequence)
+{
+    std::vector<ResultStream::Update> Updates {};
+
+    {
+        std::lock_guard<std::mutex> Lock { Stream.Mutex };
+        Updates.swap(Stream.Pending);
+        Stream.Posted = false;
+    }
+
+    for (const ResultStream::Update& Item : Updates)
+    {
+        Common::Protocol::ExecutionResult Message {};
+
+        if (!Workspace_.ClientID(Item.Node, Message.Node))
+        {
+            continue;
+        }
+
+        Message.Status = Item.Status;
+        Message.Seconds = Item.Seconds;
+        Message.Output = Item.Output;
+        Message.Log = Item.Log;
+        Output.Write(Message, Sequence);
+    }
+}
+
+Server::Server(const Options& Options_)
+    : m_Options(Options_)
+    , m_Cache(Options_.Cache)
+    , m_Pool(Options_.Jobs)
+    , m_Executor(m_Engine, m_Pool, &m_Cache)
+{
+    if (m_Options.Threads == 0)
+    {
+        m_Options.Threads = 1;
+    }
+
+    m_OnMessage = [this](Session& Target, const Common::Protocol::MessageView& Message) -> void
+    {
+        OnMessage(Target, Message);
+    };
+
+    m_OnRemove = [this](uint64_t Scope, Common::NodeHandle Node) -> void
+    {
+        if (!m_Destroying)
+        {
+            m_Executor.Forget(Scope, Node);
+        }
+    };
+}
+
+Server::~Server()
+{
+    Stop();
+
+    if (m_Flusher.joinable())
+    {
+        m_Flusher.join();
+    }
+
+    for (const std::unique_ptr<Worker>& Item : m_Workers)
+    {
+        if (Item->Thread.joinable())
+        {
+            Item->Thread.join();
+        }
+    }
+
+    m_Destroying = true;
+}
+
+bool Server::Start()
+{
+    const bool ReusePort { m_Options.Threads > 1 };
+    m_Port = m_Options.Port;
+
+    for (unsigned int I = 0; I < m_Options.Threads; I++)
+    {
+        std::unique_ptr<Worker> Item { std::make_unique<Worker>() };
+
+        if (!Item->Reactor.IsValid())
+        {
+            printf("Failed to create reactor.\n");
+            return false;
+        }
+
+        Item->TCP = Common::Socket::ListenTCP(m_Options.Host.c_str(), m_Port, ReusePort);
+        if (!Listen(*Item, Item->TCP))
+        {
+            printf("Failed to listen on %s:%u.\n", m_Options.Host.c_str(), m_Port);
+            return false;
+        }
+
+        // When binding to an ephemeral port, the remaining workers share whatever port the
+        // first listener was given.
+        m_Port = Item->TCP.LocalPort();
+
+        if (I == 0 && !m_Options.UnixPath.empty())
+        {
+            Item->Unix = Common::Socket::ListenUnix(m_Options.UnixPath.c_str());
+            if (!Listen(*Item, Item->Unix))
+            {
+                printf("Failed to listen on %s.\n", m_Options.UnixPath.c_str());
+                return false;
+            }
+        }
+
+        // Clients on this host find the server on an abstract socket named after its port,
+        // where they can upgrade to shared memory. Not being able to offer it is not fatal.
+        if (I == 0 && m_Options.SharedMemory && Common::SharedChannel::IsSupported())
+        {
+            const std::string LocalPath { Common::SharedChannel::LocalPath(m_Port) };
+            Item->Local = Common::Socket::ListenUnix(LocalPath.c_str());
+            if (!Listen(*Item, Item->Local))
+            {
+                printf("Failed to listen on %s. Local clients will use TCP.\n", LocalPath.c_str());
+                Item->Local.Close();
+            }
+        }
+
+        m_Workers.push_back(std::move(Item));
+    }
+
+    return true;
+}
+
+void Server::Run()
+{
+    if (m_Workers.empty())
+    {
+        return;
+    }
+
+    m_Flusher = std::thread([this]() -> void
+        {
+            FlushMoves();
+        });
+
+    // Each loop checks the flag Stop sets after every wake up, so a Stop that lands before
+    // a reactor starts polling is not lost.
+    for (size_t I = 1; I < m_Workers.size(); I++)
+    {
+        Worker* Item { m_Workers[I].get() };
+        Item->Thread = std::thread([this, Item]() -> void
+            {
+                while (!m_StopRequested)
+                {
+                    Item->Reactor.Poll(-1);
+                }
+            });
+    }
+
+    while (!m_StopRequested)
+    {
+        m_Workers.front()->Reactor.Poll(-1);
+    }
+
+    for (size_t I = 1; I < m_Workers.size(); I++)
+    {
+        if (m_Workers[I]->Thread.joinable())
+        {
+            m_Workers[I]->Thread.join();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> Lock { m_RoomsMutex };
+        m_Stopping = true;
+    }
+
+    m_MovedCondition.notify_all();
+
+    if (m_Flusher.joinable())
+    {
+        m_Flusher.join();
+    }
+}
+
+void Server::Stop()
+{
+    m_StopRequested = true;
+
+    for (const std::unique_ptr<Worker>& Item : m_Workers)
+    {
+        Item->Reactor.Wake();
+    }
+}
+
+uint16_t Server::Port() const
+{
+    return m_Port;
+}
+
+Server::Stats Server::GetStats() const
+{
+    Stats Result {};
+    Result.Accepted = m_Accepted;
+    Result.Active = m_Active;
+    Result.BytesIn = m_BytesIn;
+    Result.BytesOut = m_BytesOut;
+    Result.Messages = m_Messages;
+    Result.Executions = m_Executions;
+    Result.Cache = m_Cache.GetStats();
+    return Result;
+}
+
+bool Server::Listen(Worker& Item, const Common::Socket& Listener)
+{
+    if (!Listener.IsValid() || !Listener.SetNonBlocking(true))
+    {
+        return false;
+    }
+
+    return Item.Reactor.Add(Listener.Handle(), Common::Reactor::Readable, [this, &Item, &Listener](uint32_t) -> void
+        {
+            Accept(Item, Listener);
+        });
+}
+
+void Server::Accept(Worker& Item, const Common::Socket& Listener)
+{
+    while (true)
+    {
+        Common::Socket Connection { Listener.Accept() };
+
+        if (!Connection.IsValid())
+        {
+            break;
+        }
+
+        if (!Connection.SetNonBlocking(true))
+        {
+            continue;
+        }
+
+        Connection.SetNoDelay(true);
+
+        const Common::NativeSocket Handle { Connection.Handle() };
+        std::shared_ptr<Session> Session_ { std::make_shared<Session>(std::move(Connection), Item.Reactor, m_OnMessage) };
+        Session_->GetWorkspace().SetOnRemove(Workspace::OnRemoveSignature { m_OnRemove });
+        Session* Target { Session_.get() };
+
+        const bool Added { Item.Reactor.Add(Handle, Common::Reactor::Readable, [this, &Item, Target, Handle](uint32_t Events) -> void
+            {
+                if (!Target->OnEvent(Events))
+                {
+                    Close(Item, Handle);
+                }
+            }) };
+
+        if (!Added)
+        {
+            continue;
+        }
+
+        Item.Sessions.emplace(Handle, std::move(Session_));
+        m_Accepted++;
+        m_Active++;
+    }
+}
+
+void Server::Close(Worker& Item, Common::NativeSocket Handle)
+{
+    const std::unordered_map<Common::NativeSocket, std::shared_ptr<Session>>::iterator It { Item.Sessions.find(Handle) };
+
+    if (It == Item.Sessions.end())
+    {
+        return;
+    }
+
+    m_BytesIn += It->second->BytesIn();
+    m_BytesOut += It->second->BytesOut();
+    m_Active--;
+
+    Leave(*It->second);
+
+    Item.Reactor.Remove(Handle);
+    Item.Sessions.erase(It);
+}
+
+void Server::OnMessage(Session& Target, const Common::Protocol::MessageView& Message)
+{
+    m_Messages.fetch_add(1, std::memory_order_relaxed);
+
+    switch (Message.Type)
+    {
+    case Common::Protocol::MessageType::Heartbeat:
+    {
+        // The payload is opaque to the server and echoed back so the client can measure
+        // the round trip from its own timestamp.
+        Target.Output()
+            .Begin(Common::Protocol::MessageType::HeartbeatAck, Message.Sequence)
+            .Bytes(Message.Payload, Message.Size)
+            .End();
+    }
+    break;
+
+    case Common::Protocol::MessageType::GraphEdit:
+    {
+        Common::Protocol::GraphEdit Edit {};
+        const std::shared_ptr<Room>& Shared { Target.GetRoom() };
+        std::string Error {};
+
+        if (!Common::Protocol::Decode(Message, Edit))
+        {
+            SendError(Target, Message.Sequence, "invalid graph edit");
+        }
+        else if (Shared != nullptr)
+        {
+            // Edits that lost a race with another member's are dropped rather than
+            // reported, since the member learns of the winning edit anyway.
+            if (Shared->Apply(Target, Edit, Message.Sequence, &Error))
+            {
+                {
+                    std::lock_guard<std::mutex> Lock { m_RoomsMutex };
+                    m_Moved.push_back(Shared);
+                }
+
+                m_MovedCondition.notify_one();
+            }
+            else if (!Error.empty())
+            {
+                SendError(Target, Message.Sequence, Error);
+            }
+        }
+        else if (!Target.GetWorkspace().Apply(Edit))
+        {
+            SendError(Target, Message.Sequence, "invalid graph edit");
+        }
+    }
+    break;
+
+    case Common::Protocol::MessageType::SnippetSource:
+    {
+        Common::Protocol::SnippetSource Source {};
+
+        if (Target.GetRoom() != nullptr)
+        {
+            SendError(Target, Message.Sequence, "sources in a room are edited with TextEdit");
+        }
+        else if (!Common::Protocol::Decode(Message, Source) || !Target.GetWorkspace().SetSource(Source))
+        {
+            SendError(Target, Message.Sequence, "invalid snippet source");
+        }
+    }
+    break;
+
+    case Common::Protocol::MessageType::TextEdit:
+    {
+        Common::Protocol::TextEdit Edit {};
+        std::string Error { "invalid text edit" };
+
+        if (Target.GetRoom() == nullptr)
+        {
+            SendError(Target, Message.Sequence, "text edits are only accepted in a room");
+        }
+        else if (!Common::Protocol::Decode(Message, Edit) || !Target.GetRoom()->Edit(Target, Edit, Message.Sequence, &Error))
+        {
+            SendError(Target, Message.Sequence, Error);
+        }
+    }
+    break;
+
+    case Common::Protocol::MessageType::Join: Join(Target, Message); break;
+
+    case Common::Protocol::MessageType::Execute: Execute(Target, Message.Sequence); break;
+
+    default: break;
+    }
+}
+
+void Server::Execute(Session& Target, uint32_t Sequence)
+{
+    const std::shared_ptr<Room> Shared { Target.GetRoom() };
+    RunWorkspace Held { Target, Shared };
+    Workspace& Workspace_ { Held.Target };
+
+    if (Workspace_.IsRunning())
+    {
+        SendError(Target, Sequence, "an execution is already in progress");
+        return;
+    }
+
+    // The executor snapshots the graph and the previous results before returning, so
+    // edits that arrive while the run is in flight only apply to the next one. Callbacks
+    // only hold a weak reference in case the session disconnects before the run finishes.
+    const std::weak_ptr<Session> Weak { Target.shared_from_this() };
+    Common::Reactor& Reactor { Target.GetReactor() };
+    const std::shared_ptr<ResultStream> Stream { std::make_shared<ResultStream>() };
+    const uint64_t Scope { Workspace_.Scope() };
+    std::string Error {};
+
+    // Results are streamed as nodes start and finish. Reused nodes are left out, since
+    // the client already has their output from an earlier run in this session.
+    Common::Executor::OnProgressSignature OnProgress { [Weak, &Reactor, Stream, Shared, Sequence](const Common::NodeReport& Node) -> void
+        {
+            if (Node.Reused)
+            {
+                return;
+            }
+
+            const bool Failed { Node.Status == Common::NodeStatus::Failed || Node.Status == Common::NodeStatus::Skipped };
+            bool Post { false };
+
+            {
+                std::lock_guard<std::mutex> Lock { Stream->Mutex };
+                Stream->Pending.push_back({ Node.Node, ToStatus(Node.Status), Node.Seconds, Failed ? Node.Error : Node.Output, Node.Log });
+                Post = !Stream->Posted;
+                Stream->Posted = true;
+            }
+
+            if (Post)
+            {
+                Reactor.Post([Weak, Stream, Shared, Sequence]() -> void
+                    {
+                        const std::shared_ptr<Session> Owner { Weak.lock() };
+
+                        if (Owner != nullptr)
+                        {
+                            {
+                                const RunWorkspace Held { *Owner, Shared };
+                                Drain(*Stream, Held.Target, Owner->Output(), Sequence);
+                            }
+
+                            Owner->RequestFlush();
+                        }
+                    });
+            }
+        } };
+
+    Common::Executor::OnCompleteSignature OnComplete { [this, Weak, &Reactor, Stream, Shared, Sequence, Scope](Common::ExecutionReport&& Report) -> void
+        {
+            std::shared_ptr<Common::ExecutionReport> Result { std::make_shared<Common::ExecutionReport>(std::move(Report)) };
+            Reactor.Post([this, Weak, Stream, Shared, Sequence, Scope, Result]() -> void
+                {
+                    const std::shared_ptr<Session> Owner { Weak.lock() };
+
+                    // The session's own workspace went away with it and forgot its nodes,
+                    // some of which the run may have compiled again since.
+                    if (Owner == nullptr && Shared == nullptr)
+                    {
+                        for (const Common::NodeReport& Node : Result->Nodes)
+                        {
+                            m_OnRemove(Scope, Node.Node);
+                        }
+
+                        return;
+                    }
+
+                    // A room's run is finished even when the member that started it has
+                    // left, or the room could never run again. Only the results go unsent.
+                    // Anything still queued was reported before the run finished and goes
+                    // out ahead of the summary.
+                    RunWorkspace Held { Owner.get(), Shared };
+                    Workspace& Workspace_ { Held.Target };
+                    if (Owner != nullptr)
+                    {
+                        Drain(*Stream, Workspace_, Owner->Output(), Sequence);
+                    }
+
+                    Common::Protocol::ExecutionSummary Summary {};
+                    Summary.Nodes = static_cast<uint32_t>(Result->Nodes.size());
+                    Summary.Reused = Result->Reused;
+                    Summary.Seconds = Result->Seconds;
+                    Summary.CriticalPathSeconds = Result->CriticalPathSeconds;
+
+                    for (const Common::NodeReport& Node : Result->Nodes)
+                    {
+                        Summary.Failed += Node.Status == Common::NodeStatus::Failed ? 1 : 0;
+                        Summary.Skipped += Node.Status == Common::NodeStatus::Skipped ? 1 : 0;
+
+                        // Nodes deleted while the run was in flight may have been compiled
+                        // after the workspace forgot them.
+                        Common::NodeID ID { Common::InvalidNodeID };
+                        if (!Workspace_.ClientID(Node.Node, ID))
+                        {
+                            m_OnRemove(Scope, Node.Node);
+                        }
+                    }
+
+                    for (Common::NodeHandle Node : Result->CriticalPath)
+                    {
+                        Common::NodeID ID { Common::InvalidNodeID };
+
+                        if (Workspace_.ClientID(Node, ID))
+                        {
+                            Summary.CriticalPath.push_back(ID);
+                        }
+                    }
+
+                    Workspace_
+                        .SetRunning(false)
+                        .GetMemo()
+                        .Update(*Result);
+
+                    if (Owner != nullptr)
+                    {
+                        Owner->Output().Write(Summary, Sequence);
+                        Held.Lock = {};
+                        Owner->RequestFlush();
+                    }
+
+                    m_Executions++;
+                });
+        } };
+
+    const bool Started { m_Executor.Run(Workspace_.GetGraph(), &Workspace_.GetMemo(), Scope, std::move(OnComplete), std::move(OnProgress), &Error) };
+
+    if (!Started)
+    {
+        SendError(Target, Sequence, Error);
+        return;
+    }
+
+    Workspace_.SetRunning(true);
+}
+
+void Server::Join(Session& Target, const Common::Protocol::MessageView& Message)
+{
+    Common::Protocol::PayloadReader Payload { Message };
+    std::string_view Name {};
+
+    if (!Payload.String(Name))
+    {
+        SendError(Target, Message.Sequence, "invalid join");
+        return;
+    }
+
+    Leave(Target);
+
+    // Leaving is acknowledged as joining nothing, through the same queue as anything the
+    // room relayed before it.
+    if (Name.empty())
+    {
+        Common::Protocol::MessageWriter Frames {};
+        Frames.Write(Common::Protocol::Joined {}, Message.Sequence);
+        Target.Deliver(Frames);
+        return;
+    }
+
+    std::lock_guard<std::mutex> Lock { m_RoomsMutex };
+    std::shared_ptr<Room>& Shared { m_Rooms[std::string { Name }] };
+
+    if (Shared == nullptr)
+    {
+        Shared = std::make_shared<Room>(std::string { Name });
+        Shared->GetWorkspace().SetOnRemove(Workspace::OnRemoveSignature { m_OnRemove });
+    }
+
+    const uint32_t Member { Shared->Join(Target.shared_from_this(), Message.Sequence) };
+    Target.SetRoom(Shared, Member);
+}
+
+void Server::Leave(Session& Target)
+{
+    const std::shared_ptr<Room> Shared { Target.GetRoom() };
+
+    if (Shared == nullptr)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> Lock { m_RoomsMutex };
+
+        if (Shared->Leave(Target))
+        {
+            const std::unordered_map<std::string, std::shared_ptr<Room>>::const_iterator It { m_Rooms.find(Shared->Name()) };
+
+            if (It != m_Rooms.end() && It->second == Shared)
+            {
+                m_Rooms.erase(It);
+            }
+        }
+    }
+
+    Target.SetRoom(nullptr, 0);
+}
+
+void Server::FlushMoves()
+{
+    std::unique_lock<std::mutex> Lock { m_RoomsMutex };
+
+    while (!m_Stopping)
+    {
+        m_MovedCondition.wait(Lock, [this]() -> bool
+            {
+                return m_Stopping || !m_Moved.empty();
+            });
+
+        // Whatever else is moved within the interval goes out in the same batches.
+        m_MovedCondition.wait_for(Lock, MoveInterval, [this]() -> bool
+            {
+                return m_Stopping;
+            });
+
+        std::vector<std::weak_ptr<Room>> Moved {};
+        Moved.swap(m_Moved);
+        Lock.unlock();
+
+        for (const std::weak_ptr<Room>& Item : Moved)
+        {
+            const std::shared_ptr<Room> Target { Item.lock() };
+
+            if (Target != nullptr)
+            {
+                Target->Flush();
+            }
+        }
+
+        Lock.lock();
+    }
+}
+
+void Server::SendError(Session& Target, uint32_t Sequence, const std::string& Message)
+{
+    Target.Output()
+        .Begin(Common::Protocol::MessageType::Error, Sequence)
+        .String(Message)
+        .End();
+}
+
+}
+}
@@ -0,0 +1,170 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "../Common/Execution/Engine.h"
+#include "../Common/Execution/Executor.h"
+#include "../Common/Execution/ResultCache.h"
+#include "../Common/Execution/ThreadPool.h"
+#include "../Common/Network/Reactor.h"
+#include "../Common/Network/Socket.h"
+#include "Room.h"
+#include "Session.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Snippet
+{
+namespace Server
+{
+
+//
+// Accepts TCP and Unix domain socket connections and services every session with
+// non-blocking I/O. Each worker owns one reactor; with more than one worker, every
+// worker binds its own SO_REUSEPORT listener and the kernel spreads connections
+// between them.
+//
+// Graph executions requested by a session are evaluated on a shared work-stealing
+// pool, off the reactor threads. Node results are posted back to the session's reactor
+// and streamed to the client as nodes finish, followed by a summary of the run. Results
+// are shared between sessions through a content-addressed cache, so a snippet already
+// run with the same inputs by anyone is not run again.
+//
+// On Linux, the first worker also listens on an abstract Unix socket named after the TCP
+// port. Clients on the same host connect there instead and upgrade their session to a
+// SharedChannel, so large results are not copied through the kernel.
+//
+// Sessions that join the same room share one graph and see each other's edits as they
+// are made. Moves in every room are gathered and sent out together once per
+// MoveInterval, by a thread of their own.
+//
+
+class Server
+{
+public:
+    static constexpr std::chrono::milliseconds MoveInterval { 16 };
+
+    struct Options
+    {
+        std::string Host { "0.0.0.0" };
+        uint16_t Port { 7340 };
+        std::string UnixPath {};
+        unsigned int Threads { 1 };
+        unsigned int Jobs { 0 };
+        // Lets clients on the same host move their connection onto shared memory.
+        bool SharedMemory { true };
+        Common::ResultCache::Options Cache {};
+    };
+
+    struct Stats
+    {
+        uint64_t Accepted { 0 };
+        uint64_t Active { 0 };
+        uint64_t BytesIn { 0 };
+        uint64_t BytesOut { 0 };
+        uint64_t Messages { 0 };
+        uint64_t Executions { 0 };
+        Common::ResultCache::Stats Cache {};
+    };
+
+    Server(const Options& Options_);
+    ~Server();
+
+    bool Start();
+    // Serves on the calling thread until Stop is called, then shuts down the other
+    // workers and the move flusher before returning.
+    void Run();
+    // Only sets a flag and wakes the reactors, so it is safe to call from a signal handler.
+    void Stop();
+
+    uint16_t Port() const;
+    Stats GetStats() const;
+
+private:
+    struct Worker
+    {
+        Common::Reactor Reactor {};
+        Common::Socket TCP {};
+        Common::Socket Unix {};
+        Common::Socket Local {};
+        std::unordered_map<Common::NativeSocket, std::shared_ptr<Session>> Sessions {};
+        std::thread Thread {};
+    };
+
+    bool Listen(Worker& Item, const Common::Socket& Listener);
+    void Accept(Worker& Item, const Common::Socket& Listener);
+    void Close(Worker& Item, Common::NativeSocket Handle);
+    void OnMessage(Session& Target, const Common::Protocol::MessageView& Message);
+    void Execute(Session& Target, uint32_t Sequence);
+    void Join(Session& Target, const Common::Protocol::MessageView& Message);
+    void Leave(Session& Target);
+    void FlushMoves();
+    void SendError(Session& Target, uint32_t Sequence, const std::string& Message);
+
+    Options m_Options {};
+    Session::OnMessageSignature m_OnMessage { nullptr };
+    // Forgets the chunks of nodes that leave a workspace. Workspaces that outlive the
+    // engine, as the server is destroyed, have nothing left to forget.
+    Workspace::OnRemoveSignature m_OnRemove { nullptr };
+    std::atomic<bool> m_Destroying { false };
+    uint16_t m_Port { 0 };
+    std::vector<std::unique_ptr<Worker>> m_Workers {};
+
+    // Rooms by name, dropped when their last member leaves. Rooms with moves waiting are
+    // queued for the flusher.
+    std::mutex m_RoomsMutex {};
+    std::unordered_map<std::string, std::shared_ptr<Room>> m_Rooms {};
+    std::vector<std::weak_ptr<Room>> m_Moved {};
+    std::condition_variable m_MovedCondition {};
+    std::thread m_Flusher {};
+    bool m_Stopping { false };
+    std::atomic<bool> m_StopRequested { false };
+
+    // Declared after the workers so the pool is joined, and its in-flight runs have
+    // posted their results, before any reactor is destroyed.
+    Common::Engine m_Engine {};
+    Common::ResultCache m_Cache;
+    Common::ThreadPool m_Pool;
+    Common::Executor m_Executor;
+    std::atomic<uint64_t> m_Accepted { 0 };
+    std::atomic<uint64_t> m_Active { 0 };
+    std::atomic<uint64_t> m_BytesIn { 0 };
+    std::atomic<uint64_t> m_BytesOut { 0 };
+    std::atomic<uint64_t> m_Messages { 0 };
+    std::atomic<uint64_t> m_Executions { 0 };
+};
+
+}
+}
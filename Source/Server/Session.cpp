@@ -0,0 +1,430 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Session.h"
+#include "Room.h"
+
+#include <algorithm>
+
+namespace Snippet
+{
+namespace Server
+{
+
+static constexpr size_t ReadSize { 64 * 1024 };
+
+Session::Session(Common::Socket&& Connection, Common::Reactor& Owner, const OnMessageSignature& OnMessage)
+    : m_Socket(std::move(Connection))
+    , m_Reactor(Owner)
+    , m_OnMessage(OnMessage)
+{
+}
+
+Session::~Session()
+{
+    if (m_Channel.IsValid())
+    {
+        m_Reactor.Remove(m_Channel.Doorbell());
+    }
+}
+
+Common::NativeSocket Session::Handle() const
+{
+    return m_Socket.Handle();
+}
+
+bool Session::OnEvent(uint32_t Events)
+{
+    if ((Events & Common::Reactor::Readable) != 0 && !Read())
+    {
+        return false;
+    }
+
+    if ((Events & Common::Reactor::Writable) != 0 && !Flush())
+    {
+        return false;
+    }
+
+    if ((Events & Common::Reactor::Hangup) != 0 && (Events & Common::Reactor::Readable) == 0)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+Common::Protocol::MessageWriter& Session::Output()
+{
+    return m_Output;
+}
+
+Session& Session::RequestFlush()
+{
+    if (Pending() > MaxBacklog)
+    {
+        m_Socket.Disconnect();
+        return *this;
+    }
+
+    // A channel has no writable event to wait for. Anything that does not fit now is
+    // sent when the client's doorbell says there is room.
+    if (m_Channel.IsValid())
+    {
+        Flush();
+    }
+    else
+    {
+        UpdateInterest();
+    }
+
+    return *this;
+}
+
+Session& Session::Deliver(const Common::Protocol::MessageWriter& Frames)
+{
+    bool Post { false };
+
+    {
+        std::lock_guard<std::mutex> Lock { m_InboxMutex };
+
+        // The reactor thread disconnects the session when it drains the inbox.
+        if (m_Inbox.size() + Frames.Size() > MaxBacklog)
+        {
+            m_InboxOverflow = true;
+        }
+        else
+        {
+            m_Inbox.insert(m_Inbox.end(), Frames.Buffer().begin(), Frames.Buffer().end());
+        }
+
+        Post = !m_InboxPosted;
+        m_InboxPosted = true;
+    }
+
+    // One post drains everything delivered until it runs.
+    if (Post)
+    {
+        const std::weak_ptr<Session> Weak { weak_from_this() };
+        m_Reactor.Post([Weak]() -> void
+            {
+                const std::shared_ptr<Session> Self { Weak.lock() };
+
+                if (Self != nullptr)
+                {
+                    Self->DrainInbox();
+                }
+            });
+    }
+
+    return *this;
+}
+
+Common::Reactor& Session::GetReactor() const
+{
+    return m_Reactor;
+}
+
+Workspace& Session::GetWorkspace()
+{
+    return m_Workspace;
+}
+
+Session& Session::SetRoom(const std::shared_ptr<Room>& Room_, uint32_t Member)
+{
+    m_Room = Room_;
+    m_Member = Member;
+    return *this;
+}
+
+const std::shared_ptr<Room>& Session::GetRoom() const
+{
+    return m_Room;
+}
+
+uint32_t Session::GetMember() const
+{
+    return m_Member;
+}
+
+size_t Session::BytesIn() const
+{
+    return m_BytesIn;
+}
+
+size_t Session::BytesOut() const
+{
+    return m_BytesOut;
+}
+
+bool Session::IsShared() const
+{
+    return m_Channel.IsValid();
+}
+
+bool Session::Read()
+{
+    bool Closed { false };
+
+    while (true)
+    {
+        const size_t Offset { m_Input.size() };
+        m_Input.resize(Offset + ReadSize);
+
+        const Common::IOResult Result { m_Socket.Receive(m_Input.data() + Offset, ReadSize) };
+        m_Input.resize(Offset + Result.Bytes);
+        m_BytesIn += Result.Bytes;
+
+        if (Result.Status == Common::IOStatus::WouldBlock)
+        {
+            break;
+        }
+
+        if (Result.Status != Common::IOStatus::Ok)
+        {
+            Closed = true;
+            break;
+        }
+
+        // Complete messages are handled as they arrive, so all that stays buffered is the
+        // start of one message. A peer that is ahead by more than the largest message
+        // there can be is not speaking the protocol.
+        if (!Process() || m_Input.size() > Common::Protocol::HeaderSize + Common::Protocol::MaxPayload)
+        {
+            return false;
+        }
+
+        // The rest is read once the replies have gone out.
+        if (Result.Bytes < ReadSize || Pending() >= OutputHighWater)
+        {
+            break;
+        }
+    }
+
+    if (!Process())
+    {
+        return false;
+    }
+
+    // Flush whatever the requests produced before giving up on a half-closed peer.
+    if (!Flush())
+    {
+        return false;
+    }
+
+    return !Closed;
+}
+
+bool Session::Flush()
+{
+    const std::vector<uint8_t>& Buffer { m_Output.Buffer() };
+
+    if (m_Channel.IsValid())
+    {
+        const size_t Sent { m_Channel.Send(Buffer.data() + m_OutputOffset, Buffer.size() - m_OutputOffset) };
+        m_OutputOffset += Sent;
+        m_BytesOut += Sent;
+    }
+
+    while (!m_Channel.IsValid() && m_OutputOffset < Buffer.size())
+    {
+        const Common::IOResult Result { m_Socket.Send(Buffer.data() + m_OutputOffset, Buffer.size() - m_OutputOffset) };
+
+        if (Result.Status == Common::IOStatus::WouldBlock)
+        {
+            break;
+        }
+
+        if (Result.Status != Common::IOStatus::Ok)
+        {
+            return false;
+        }
+
+        m_OutputOffset += Result.Bytes;
+        m_BytesOut += Result.Bytes;
+    }
+
+    if (m_OutputOffset == Buffer.size())
+    {
+        m_Output.Clear();
+        m_OutputOffset = 0;
+    }
+
+    UpdateInterest();
+    return Pending() <= MaxBacklog;
+}
+
+bool Session::Process()
+{
+    // Messages are dispatched straight out of the receive buffer. Any replies are batched
+    // into the output buffer and written with a single send once the batch is handled.
+    Common::Protocol::MessageReader Reader { m_Input.data(), m_Input.size() };
+    Common::Protocol::MessageView Message {};
+    Common::Protocol::ParseStatus Status { Common::Protocol::ParseStatus::Ok };
+
+    while ((Status = Reader.Next(Message)) == Common::Protocol::ParseStatus::Ok)
+    {
+        Dispatch(Message);
+    }
+
+    m_Input.erase(m_Input.begin(), m_Input.begin() + Reader.Consumed());
+    return Status != Common::Protocol::ParseStatus::Invalid;
+}
+
+void Session::Dispatch(const Common::Protocol::MessageView& Message)
+{
+    if (Message.Type == Common::Protocol::MessageType::SharedMemory)
+    {
+        Upgrade(Message);
+    }
+    else
+    {
+        m_OnMessage(*this, Message);
+    }
+}
+
+void Session::Upgrade(const Common::Protocol::MessageView& Message)
+{
+    Common::Protocol::PayloadReader Payload { Message };
+    uint32_t Requested { 0 };
+
+    // The reply carrying the handles must not overtake anything already queued for the
+    // socket, so the upgrade is only accepted once the output has drained.
+    if (Payload.U32(Requested) && !m_Channel.IsValid() && m_Socket.IsUnix() && Flush() && m_Output.Empty())
+    {
+        const size_t Capacity { Requested != 0 ? std::min<size_t>(Requested, Common::Protocol::MaxPayload) : Common::SharedChannel::DefaultCapacity };
+        Common::SharedChannel Channel { Common::SharedChannel::Create(Capacity) };
+
+        if (Channel.IsValid())
+        {
+            Common::Protocol::MessageWriter Reply {};
+            Reply
+                .Begin(Common::Protocol::MessageType::SharedMemory, Message.Sequence)
+                .U32(static_cast<uint32_t>(Channel.Capacity()))
+                .End();
+
+            const Common::IOResult Result { m_Socket.SendHandles(Reply.Buffer().data(), Reply.Size(), Channel.Handles(), Common::SharedChannel::HandleCount) };
+            m_BytesOut += Result.Bytes;
+
+            if (Result.Status == Common::IOStatus::Ok && Result.Bytes == Reply.Size())
+            {
+                m_Channel = std::move(Channel);
+                m_Reactor.Add(m_Channel.Doorbell(), Common::Reactor::Readable, [this](uint32_t) -> void
+                    {
+                        OnDoorbell();
+                    });
+                UpdateInterest();
+                return;
+            }
+
+            // Part of the reply is already on its way and the rest cannot follow it.
+            if (Result.Bytes > 0)
+            {
+                m_Socket.Disconnect();
+                return;
+            }
+        }
+    }
+
+    m_Output
+        .Begin(Common::Protocol::MessageType::SharedMemory, Message.Sequence)
+        .U32(0)
+        .End();
+}
+
+void Session::OnDoorbell()
+{
+    m_Channel.ClearDoorbell();
+
+    // The doorbell rings both for new messages and for room to send more, so whatever fits
+    // is sent first. Messages are left in the channel while too much is waiting to be sent,
+    // and taken once the client's next doorbell has made room. Failures hang up the socket
+    // so the session is closed the same way as any other disconnect.
+    bool Valid { Flush() };
+
+    if (Valid && Pending() < OutputHighWater)
+    {
+        Valid = m_Channel.Receive([this](const Common::Protocol::MessageView& Message) -> void
+            {
+                m_BytesIn += Common::Protocol::HeaderSize + Message.Size;
+                Dispatch(Message);
+            })
+            && Flush();
+    }
+
+    if (!Valid)
+    {
+        m_Socket.Disconnect();
+    }
+}
+
+void Session::UpdateInterest()
+{
+    // Over a channel, the socket is only read to notice the peer going away.
+    uint32_t Events { 0 };
+
+    if (m_Channel.IsValid() || Pending() < OutputHighWater)
+    {
+        Events |= Common::Reactor::Readable;
+    }
+
+    if (!m_Output.Empty() && !m_Channel.IsValid())
+    {
+        Events |= Common::Reactor::Writable;
+    }
+
+    m_Reactor.Modify(m_Socket.Handle(), Events);
+}
+
+void Session::DrainInbox()
+{
+    std::vector<uint8_t> Frames {};
+    bool Overflow { false };
+
+    {
+        std::lock_guard<std::mutex> Lock { m_InboxMutex };
+        Frames.swap(m_Inbox);
+        Overflow = m_InboxOverflow;
+        m_InboxPosted = false;
+    }
+
+    // Frames were dropped, so the peer's copy of the room can no longer be kept in step.
+    if (Overflow)
+    {
+        m_Socket.Disconnect();
+        return;
+    }
+
+    m_Output.Append(Frames.data(), Frames.size());
+    RequestFlush();
+}
+
+size_t Session::Pending() const
+{
+    return m_Output.Size() - m_OutputOffset;
+}
+
+}
+}
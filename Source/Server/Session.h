@@ -0,0 +1,125 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "../Common/Network/Protocol.h"
+#include "../Common/Network/Reactor.h"
+#include "../Common/Network/SharedChannel.h"
+#include "../Common/Network/Socket.h"
+#include "Workspace.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Snippet
+{
+namespace Server
+{
+
+class Room;
+
+//
+// One client connection. A client on the same host may ask to move the connection onto a
+// SharedChannel, after which messages go through the channel in both directions and the
+// socket is only watched for the peer going away.
+//
+// A session that joins a room edits and runs the room's workspace instead of its own.
+//
+// Requests are not read while more than OutputHighWater bytes are waiting to be sent, so
+// a peer that does not read its replies stops being served. A session that has more than
+// MaxBacklog waiting anyway, from what its room relays or its runs report, is disconnected.
+//
+
+class Session : public std::enable_shared_from_this<Session>
+{
+public:
+    static constexpr size_t OutputHighWater { 4 * 1024 * 1024 };
+    static constexpr size_t MaxBacklog { 2 * (Common::Protocol::HeaderSize + Common::Protocol::MaxPayload) };
+
+    using OnMessageSignature = std::function<void(Session&, const Common::Protocol::MessageView&)>;
+
+    Session(Common::Socket&& Connection, Common::Reactor& Owner, const OnMessageSignature& OnMessage);
+    ~Session();
+
+    Common::NativeSocket Handle() const;
+
+    bool OnEvent(uint32_t Events);
+    Common::Protocol::MessageWriter& Output();
+
+    // Called after writing to Output from outside of OnEvent, e.g. when an asynchronous
+    // result is posted back to the reactor thread.
+    Session& RequestFlush();
+
+    // Queues messages written on any thread, such as those relayed by a room. They are
+    // sent in the order they were delivered.
+    Session& Deliver(const Common::Protocol::MessageWriter& Frames);
+
+    Common::Reactor& GetReactor() const;
+    Workspace& GetWorkspace();
+
+    Session& SetRoom(const std::shared_ptr<Room>& Room_, uint32_t Member);
+    const std::shared_ptr<Room>& GetRoom() const;
+    uint32_t GetMember() const;
+
+    size_t BytesIn() const;
+    size_t BytesOut() const;
+    bool IsShared() const;
+
+private:
+    bool Read();
+    bool Flush();
+    bool Process();
+    void Dispatch(const Common::Protocol::MessageView& Message);
+    void Upgrade(const Common::Protocol::MessageView& Message);
+    void OnDoorbell();
+    void UpdateInterest();
+    void DrainInbox();
+    // Bytes written to Output and not sent yet.
+    size_t Pending() const;
+
+    Common::Socket m_Socket {};
+    Common::Reactor& m_Reactor;
+    const OnMessageSignature& m_OnMessage;
+    std::vector<uint8_t> m_Input {};
+    Common::Protocol::MessageWriter m_Output {};
+    Common::SharedChannel m_Channel {};
+    Workspace m_Workspace {};
+    std::shared_ptr<Room> m_Room { nullptr };
+    uint32_t m_Member { 0 };
+    std::mutex m_InboxMutex {};
+    std::vector<uint8_t> m_Inbox {};
+    bool m_InboxPosted { false };
+    bool m_InboxOverflow { false };
+    size_t m_OutputOffset { 0 };
+    size_t m_BytesIn { 0 };
+    size_t m_BytesOut { 0 };
+};
+
+}
+}
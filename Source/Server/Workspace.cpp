@@ -0,0 +1,241 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include "Workspace.h"
+#include "../Common/Unicode.h"
+
+#include <atomic>
+
+namespace Snippet
+{
+namespace Server
+{
+
+static std::atomic<uint64_t> NextScope { 0 };
+
+Workspace::Workspace()
+    : m_Scope(++NextScope)
+{
+}
+
+Workspace::~Workspace()
+{
+    if (m_OnRemove)
+    {
+        for (const std::pair<const Common::NodeID, Entry>& Item : m_Entries)
+        {
+            m_OnRemove(m_Scope, Item.second.Node);
+        }
+    }
+}
+
+Workspace& Workspace::SetOnRemove(OnRemoveSignature&& OnRemove)
+{
+    m_OnRemove = std::move(OnRemove);
+    return *this;
+}
+
+uint64_t Workspace::Scope() const
+{
+    return m_Scope;
+}
+
+bool Workspace::Apply(const Common::Protocol::GraphEdit& Edit)
+{
+    if (!Common::Protocol::IsValidPosition(Edit.X) || !Common::Protocol::IsValidPosition(Edit.Y))
+    {
+        return false;
+    }
+
+    switch (Edit.Kind)
+    {
+    case Common::Protocol::EditKind::CreateNode:
+    {
+        if (Edit.Node == Common::InvalidNodeID || m_Entries.find(Edit.Node) != m_Entries.end())
+        {
+            return false;
+        }
+
+        Entry Item {};
+        Item.Node = m_Graph.AddSnippet(Edit.Node);
+        Item.Input = m_Graph.GetPorts(Item.Node)[0];
+        Item.Output = m_Graph.GetPorts(Item.Node)[1];
+        m_Graph
+            .SetPosition(Item.Node, { Edit.X, Edit.Y })
+            .SetName(Item.Node, Common::ToUTF32(Edit.Text));
+
+        m_Entries[Edit.Node] = Item;
+        return true;
+    }
+
+    case Common::Protocol::EditKind::DeleteNode:
+    {
+        const std::unordered_map<Common::NodeID, Entry>::const_iterator It { m_Entries.find(Edit.Node) };
+
+        if (It == m_Entries.end())
+        {
+            return false;
+        }
+
+        const Common::NodeHandle Node { It->second.Node };
+        m_Graph.RemoveNode(Node);
+        m_Entries.erase(It);
+
+        if (m_OnRemove)
+        {
+            m_OnRemove(m_Scope, Node);
+        }
+
+        return true;
+    }
+
+    case Common::Protocol::EditKind::MoveNode:
+    {
+        const Entry* Item { Get(Edit.Node) };
+
+        if (Item == nullptr)
+        {
+            return false;
+        }
+
+        m_Graph.SetPosition(Item->Node, { Edit.X, Edit.Y });
+        return true;
+    }
+
+    case Common::Protocol::EditKind::RenameNode:
+    {
+        const Entry* Item { Get(Edit.Node) };
+
+        if (Item == nullptr)
+        {
+            return false;
+        }
+
+        m_Graph.SetName(Item->Node, Common::ToUTF32(Edit.Text));
+        return true;
+    }
+
+    case Common::Protocol::EditKind::Connect:
+    {
+        const Entry* From { Get(Edit.Node) };
+        const Entry* To { Get(Edit.Target) };
+
+        if (From == nullptr || To == nullptr)
+        {
+            return false;
+        }
+
+        return m_Graph.Connect(From->Output, To->Input).IsValid();
+    }
+
+    case Common::Protocol::EditKind::Disconnect:
+    {
+        const Entry* From { Get(Edit.Node) };
+        const Entry* To { Get(Edit.Target) };
+        const Common::Graph::Port* Output { From != nullptr ? m_Graph.GetPort(From->Output) : nullptr };
+
+        if (Output == nullptr || To == nullptr)
+        {
+            return false;
+        }
+
+        for (Common::ConnectionHandle ID : Output->Connections)
+        {
+            const Common::Graph::Connection* Connection { m_Graph.GetConnection(ID) };
+
+            if (Connection != nullptr && Connection->To == To->Input)
+            {
+                return m_Graph.Disconnect(ID);
+            }
+        }
+
+        return false;
+    }
+
+    default: break;
+    }
+
+    return false;
+}
+
+bool Workspace::SetSource(const Common::Protocol::SnippetSource& Source)
+{
+    const Entry* Item { Get(Source.Node) };
+
+    if (Item == nullptr)
+    {
+        return false;
+    }
+
+    m_Graph.SetSource(Item->Node, std::string { Source.Source });
+    return true;
+}
+
+const Common::Graph& Workspace::GetGraph() const
+{
+    return m_Graph;
+}
+
+Common::NodeHandle Workspace::Find(Common::NodeID ID) const
+{
+    return m_Graph.Find(ID);
+}
+
+bool Workspace::ClientID(Common::NodeHandle Handle, Common::NodeID& ID) const
+{
+    ID = m_Graph.GetID(Handle);
+    return ID != Common::InvalidNodeID;
+}
+
+Common::Memo& Workspace::GetMemo()
+{
+    return m_Memo;
+}
+
+const Common::Memo& Workspace::GetMemo() const
+{
+    return m_Memo;
+}
+
+Workspace& Workspace::SetRunning(bool Running)
+{
+    m_Running = Running;
+    return *this;
+}
+
+bool Workspace::IsRunning() const
+{
+    return m_Running;
+}
+
+const Workspace::Entry* Workspace::Get(Common::NodeID ID) const
+{
+    const std::unordered_map<Common::NodeID, Entry>::const_iterator It { m_Entries.find(ID) };
+    return It != m_Entries.end() ? &It->second : nullptr;
+}
+
+}
+}
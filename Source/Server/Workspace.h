@@ -0,0 +1,98 @@
+/**
+
+MIT License
+
+Copyright (c) 2022-2023 Mitchell Davis <mdavisprog@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "../Common/Execution/Memo.h"
+#include "../Common/Graph/Graph.h"
+#include "../Common/Network/Protocol.h"
+
+#include <functional>
+#include <unordered_map>
+
+namespace Snippet
+{
+namespace Server
+{
+
+//
+// Server-side copy of a client's graph, built up from GraphEdit and SnippetSource
+// messages. Clients refer to nodes by their NodeID, which the graph is created with and
+// indexes, so messages resolve to handles without a mapping of their own. Every node
+// gets one input and one output port, and a Connect edit links the output of Node to
+// the input of Target. The results of the last execution are kept so the next one only
+// re-runs nodes affected by edits made in between.
+//
+// Every workspace has a scope of its own to run its graph with. OnRemove is called with
+// it for each node that is deleted, and for every node left when the workspace goes away.
+//
+
+class Workspace
+{
+public:
+    using OnRemoveSignature = std::function<void(uint64_t, Common::NodeHandle)>;
+
+    Workspace();
+    ~Workspace();
+
+    Workspace& SetOnRemove(OnRemoveSignature&& OnRemove);
+    uint64_t Scope() const;
+
+    // Fails, changing nothing, when the edit does not apply or carries a position that is
+    // not finite or is out of range.
+    bool Apply(const Common::Protocol::GraphEdit& Edit);
+    bool SetSource(const Common::Protocol::SnippetSource& Source);
+
+    const Common::Graph& GetGraph() const;
+    Common::NodeHandle Find(Common::NodeID ID) const;
+    bool ClientID(Common::NodeHandle Handle, Common::NodeID& ID) const;
+
+    Common::Memo& GetMemo();
+    const Common::Memo& GetMemo() const;
+
+    Workspace& SetRunning(bool Running);
+    bool IsRunning() const;
+
+private:
+    struct Entry
+    {
+        Common::NodeHandle Node {};
+        Common::PortHandle Input {};
+        Common::PortHandle Output {};
+    };
+
+    const Entry* Get(Common::NodeID ID) const;
+
+    uint64_t m_Scope { 0 };
+    OnRemoveSignature m_OnRemove { nullptr };
+    Common::Graph m_Graph {};
+    std::unordered_map<Common::NodeID, Entry> m_Entries {};
+    Common::Memo m_Memo {};
+    bool m_Running { false };
+};
+
+}
+}